@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <fcntl.h>
 #include <cstring>
 #include "DataManager.h"
 #include "CustomParameters.h"
@@ -9,21 +10,26 @@
 #endif
 
 #include "gziping.h"
+#include "redpitaya/log.h"
 
 CBooleanParameter IsDemoParam("is_demo", CBaseParameter::RO, false, 1);
 CStringParameter InCommandParam("in_command", CBaseParameter::WO, "", 1);
 CStringParameter OutCommandParam("out_command", CBaseParameter::RO, "", 1);
 
+// Debug messages are written asynchronously and only when the log level
+// (RP_LOG_LEVEL) is LOG_DEBUG, otherwise they are not even formatted
 int dbg_printf(const char * format, ...)
 {
-	static FILE* log = fopen("/var/log/nginx/rp_sdk.log", "wt");
-	if(log)
+	if(LOG_DEBUG > rp_log_level)
+		return 0;
+
+	static int log = rp_LogOpen("/var/log/nginx/rp_sdk.log", O_TRUNC);
+	if(log >= 0)
 	{
 		va_list va;
 		va_start(va, format);
-		vfprintf(log, format, va);
+		rp_LogWriteV(NULL, log, LOG_DEBUG, format, va);
 		va_end(va);
-		fflush(log);
 	}
 
 	return 0;
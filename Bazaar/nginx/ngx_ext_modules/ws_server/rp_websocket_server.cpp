@@ -13,11 +13,13 @@
 #include <future>
 
 #include <math.h>
+#include <fcntl.h>
 
 using websocketpp::lib::thread;
 
 rp_websocket_server::rp_websocket_server()
     : m_params(NULL)
+    , m_log(RP_LOG_SYSLOG)
     , m_OnClosed(false)
 {
 }
@@ -25,10 +27,9 @@ rp_websocket_server::rp_websocket_server()
 rp_websocket_server::rp_websocket_server(struct server_parameters* params)
     : m_params(params)
 {
-    // set up access channels to only log interesting things
+    // websocketpp logs synchronously, everything goes through rp_log instead
     m_endpoint.clear_access_channels(websocketpp::log::alevel::all);
-    m_endpoint.set_access_channels(websocketpp::log::alevel::access_core);
-    m_endpoint.set_access_channels(websocketpp::log::alevel::app);
+    m_log = rp_LogOpen("/var/log/nginx/ws_server.log", O_APPEND);
 
     // Initialize the Asio transport policy
     m_endpoint.init_asio();
@@ -40,13 +41,9 @@ rp_websocket_server::rp_websocket_server(struct server_parameters* params)
     m_endpoint.set_close_handler(bind(&rp_websocket_server::on_close,this,::_1));
     m_endpoint.set_http_handler(bind(&rp_websocket_server::on_http,this,::_1));
     m_endpoint.set_message_handler(bind(&rp_websocket_server::on_message,this,::_1,::_2));
-    m_out.open("/var/log/nginx/ws_server.log", std::ofstream::out | std::ofstream::app);
-    m_endpoint.get_alog().set_ostream(&m_out);
-    m_endpoint.get_alog().write(websocketpp::log::alevel::app, "ws_server constructor");
-
-    std::stringstream ss;
-    ss << "default params: signal_interval = "<< params->signal_interval <<", param_interval =" << params->param_interval;
-    m_endpoint.get_alog().write(websocketpp::log::alevel::app,ss.str());
+    rp_log_to(m_log, LOG_NOTICE, "ws_server constructor");
+    rp_log_to(m_log, LOG_NOTICE, "default params: signal_interval = %d, param_interval = %d",
+              params->signal_interval, params->param_interval);
 }
 
 rp_websocket_server::~rp_websocket_server()
@@ -59,10 +56,7 @@ rp_websocket_server::~rp_websocket_server()
 }
 
 void rp_websocket_server::run(std::string docroot, uint16_t port) {
-	m_endpoint.get_alog().write(websocketpp::log::alevel::app,"run");
-	std::stringstream ss;
-	ss << "Running telemetry server on port "<< port <<" using docroot=" << docroot;
-	m_endpoint.get_alog().write(websocketpp::log::alevel::app,ss.str());
+	rp_log_to(m_log, LOG_NOTICE, "Running telemetry server on port %u using docroot=%s", port, docroot.c_str());
 	m_docroot = docroot;
 
 	m_endpoint.set_reuse_addr(true);
@@ -75,7 +69,7 @@ void rp_websocket_server::run(std::string docroot, uint16_t port) {
 		m_endpoint.run();
 	} catch (websocketpp::exception const & e) {
 		std::cout << e.what() << std::endl;
-		m_endpoint.get_alog().write(websocketpp::log::alevel::app, e.what());
+		rp_log_to(m_log, LOG_ERR, "%s", e.what());
 	}
 }
 
@@ -112,20 +106,19 @@ void rp_websocket_server::set_param_timer() {
 void rp_websocket_server::on_signal_timer(websocketpp::lib::error_code const & ec) {
 
 	if (ec) {
-		m_endpoint.get_alog().write(websocketpp::log::alevel::app,
-				"Timer Error: "+ec.message());
+		rp_log_to(m_log, LOG_ERR, "Timer Error: %s", ec.message().c_str());
 		return;
 	}
 
 	con_list::iterator it;
 	const char* signals = m_params->get_signals_func();
 
-//	m_endpoint.get_alog().write(websocketpp::log::alevel::app, "on_signal_timer");
+//	rp_log_to(m_log, LOG_DEBUG, "on_signal_timer");
 	static int once = 1;
 	if(once)
 	{
 		once = 0;
-		m_endpoint.get_alog().write(websocketpp::log::alevel::app, signals);
+		rp_log_to(m_log, LOG_DEBUG, "%s", signals);
 	}
 
 	std::string js(signals);
@@ -145,19 +138,18 @@ void rp_websocket_server::on_signal_timer(websocketpp::lib::error_code const & e
 void rp_websocket_server::on_param_timer(websocketpp::lib::error_code const & ec) {
 
 	if (ec) {
-		m_endpoint.get_alog().write(websocketpp::log::alevel::app,
-				"Timer Error: "+ec.message());
+		rp_log_to(m_log, LOG_ERR, "Timer Error: %s", ec.message().c_str());
 		return;
 	}
 
 	con_list::iterator it;
 	const char* params = m_params->get_params_func();
-//	m_endpoint.get_alog().write(websocketpp::log::alevel::app, "on_param_timer");
+//	rp_log_to(m_log, LOG_DEBUG, "on_param_timer");
 	static int once = 1;
 	if(once)
 	{
 		once = 0;
-		m_endpoint.get_alog().write(websocketpp::log::alevel::app, params);
+		rp_log_to(m_log, LOG_DEBUG, "%s", params);
 	}
 
 	std::string js(params);
@@ -183,8 +175,7 @@ void rp_websocket_server::on_http(connection_hdl hdl) {
 	std::string filename = con->get_uri()->get_resource();
 	std::string response;
 
-	m_endpoint.get_alog().write(websocketpp::log::alevel::app,
-		"http request1: "+filename);
+	rp_log_to(m_log, LOG_INFO, "http request1: %s", filename.c_str());
 
 	if (filename == "/") {
 		filename = m_docroot+"index.html";
@@ -192,8 +183,7 @@ void rp_websocket_server::on_http(connection_hdl hdl) {
 		filename = m_docroot+filename.substr(1);
 	}
 
-	m_endpoint.get_alog().write(websocketpp::log::alevel::app,
-		"http request2: "+filename);
+	rp_log_to(m_log, LOG_INFO, "http request2: %s", filename.c_str());
 
 	file.open(filename.c_str(), std::ios::in);
 	if (!file) {
@@ -224,12 +214,12 @@ void rp_websocket_server::on_http(connection_hdl hdl) {
 
 void rp_websocket_server::on_open(connection_hdl hdl)
 {
-	m_endpoint.get_alog().write(websocketpp::log::alevel::app, "ws server on connection");
+	rp_log_to(m_log, LOG_INFO, "ws server on connection");
 	m_connections.insert(hdl);
 }
 
 void rp_websocket_server::on_close(connection_hdl hdl) {
-	m_endpoint.get_alog().write(websocketpp::log::alevel::app, "ws server connection closed");
+	rp_log_to(m_log, LOG_INFO, "ws server connection closed");
 	m_connections.erase(hdl);
 
 	if (!m_OnClosed) {
@@ -241,7 +231,7 @@ void rp_websocket_server::on_close(connection_hdl hdl) {
 void rp_websocket_server::on_message(connection_hdl hdl, server::message_ptr msg) {
 //	std::stringstream ss;
 //	ss << "Detected " << msg->get_payload() << " test cases.";
-//	m_endpoint.get_alog().write(websocketpp::log::alevel::app,ss.str());
+//	rp_log_to(m_log, LOG_DEBUG, "%s", ss.str().c_str());
 	//get child, it is always only one: "parameters" or "signals"
 	JSONNode n = libjson::parse(msg->get_payload());
 
@@ -269,7 +259,7 @@ rp_websocket_server* rp_websocket_server::create(struct server_parameters* param
 
 void rp_websocket_server::start(std::string docroot, uint16_t port)
 {
-	m_endpoint.get_alog().write(websocketpp::log::alevel::app, "start ws_server");
+	rp_log_to(m_log, LOG_NOTICE, "start ws_server");
 	m_thread = thread(bind(&rp_websocket_server::run,this, docroot,  port));
 	set_signal_timer();
 	set_param_timer();
@@ -286,7 +276,7 @@ void rp_websocket_server::stop()
 	th.detach();
 	m_OnClosed = true;
 
-	m_endpoint.get_alog().write(websocketpp::log::alevel::app, "stop ws_server");
+	rp_log_to(m_log, LOG_NOTICE, "stop ws_server");
 
 	m_endpoint.stop_listening();
 	m_endpoint.stop();
@@ -301,12 +291,11 @@ void rp_websocket_server::stop()
               		m_endpoint.close(hdl, websocketpp::close::status::normal, "shutdown");
 
                 }catch(websocketpp::lib::error_code ec){
-                    m_endpoint.get_alog().write(websocketpp::log::alevel::app,
-				"Close error: "+ec.message());
+                    rp_log_to(m_log, LOG_ERR, "Close error: %s", ec.message().c_str());
                 }
 
 	}
 	m_connections.clear();
 	join();
-	m_out.close();
+	rp_LogClose();
 }
@@ -4,9 +4,9 @@
 #include <websocketpp/common/thread.hpp>
 //#include <websocketpp/extensions/permessage_deflate/enabled.hpp>
 #include <set>
-#include <fstream>
 
 #include "libjson/_internal/Source/JSONNode.h"
+#include "redpitaya/log.h"
 #include "ws_server.h"
 
 //class config2{};
@@ -51,7 +51,7 @@ private:
     server::timer_ptr m_param_timer;
     websocketpp::lib::thread m_thread;
     std::string m_docroot;
-	std::ofstream m_out;
+	int m_log;
 	volatile bool m_OnClosed;
 };
 
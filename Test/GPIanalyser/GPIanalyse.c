@@ -9,7 +9,7 @@
 #include "fpga_osc.h"
 #include "math.h"
 #include "complex.h"
-#include "linAlg.h"
+#include "redpitaya/rp.h"
 
 double dBfun(double x){
   x=fabs(x) ;
@@ -122,59 +122,25 @@ void impedanceAnalyse(double fMeasure, complex uXX, complex uYY, options_t theOp
 
 void analyseSignal(int size , float **s, double fSample, double fMeasure, FILE *outfp, options_t theOptions){
   int i ;
-  double sigX[SIGNAL_LENGTH] ;
-  double sigY[SIGNAL_LENGTH] ;
-  for(i = 0; i < size ; i++) {
-    sigX[i]=(int)s[1][i] ;
-    sigY[i]=(int)s[2][i] ;
-    }
-  rmatrix matAX ;
-  rmatrix matAY ;
-  clearRmat(matAX,3) ;
-  clearRmat(matAY,3) ;
-  rvector rhsX ;
-  rvector rhsY ;
-  rvector f ;
-  clearRvec(rhsX,3) ;
-  clearRvec(rhsY,3) ;
-
-  for(i = 0; i < size ; i++) {
-    double t=i*2*M_PI*fMeasure/fSample ;
-    f[0]=cos(t) ;
-    f[1]=sin(t) ;
-    f[2]=1 ;
-
-    //sigX[i]=1000.0*co+55.0*si ;
-    //sigY[i]=100.0*co+255.0*si ;
-    for (int j=0 ; j<3 ; j++){ 
-      for(int k=0 ; k<3 ; k++ ){
-        matAX[j][k] += f[j]*f[k] ;
-        matAY[j][k] += f[j]*f[k] ; }
-      rhsX[j] += f[j]*sigX[i] ;
-      rhsY[j] += f[j]*sigY[i] ; }
+  rp_sine_fit_t fitX ;
+  rp_sine_fit_t fitY ;
+  if( rp_AcqSineFit(s[1], s[2], size, fSample, fMeasure, false, &fitX, &fitY) != RP_OK ){
+    fprintf(stderr,"Sine fit failed!\n") ;
+    return ;
     }
+  // signal = u*cos(t) + v*sin(t) + offset
+  double uX=fitX.amplitude*cos(fitX.phase) ;
+  double vX=-fitX.amplitude*sin(fitX.phase) ;
+  double uY=fitY.amplitude*cos(fitY.phase) ;
+  double vY=-fitY.amplitude*sin(fitY.phase) ;
   if( theOptions.v1 ){
-    fprintf(stderr,"\nleast squares matrix:") ;
-    rmdsp(matAX,3) ;
-    fprintf(stderr,"least squares vectors X,Y:\n") ;
-    for(int k=0 ; k<3 ; k++){
-      fprintf(stderr,"%15.5e  %15.5e\n",rhsX[k],rhsY[k]) ;
-      }
-    }
-  rsolv(matAX , rhsX , 3 ) ;
-  rsolv(matAY , rhsY , 3 ) ;
-  if( theOptions.v1 ){
-    fprintf(stderr,"least squares solution vectors X,Y:\n") ;
-    for(int k=0 ; k<3 ; k++){
-      fprintf(stderr,"%15.5e  %15.5e\n",rhsX[k],rhsY[k]) ;
-      }
+    fprintf(stderr,"\nleast squares solution vectors X,Y:\n") ;
+    fprintf(stderr,"%15.5e  %15.5e\n",uX,uY) ;
+    fprintf(stderr,"%15.5e  %15.5e\n",vX,vY) ;
+    fprintf(stderr,"%15.5e  %15.5e\n",fitX.offset,fitY.offset) ;
     }
-  double uX=rhsX[0] ;
-  double vX=rhsX[1] ;
-  double uY=rhsY[0] ;
-  double vY=rhsY[1] ;
-  double eEstiX=sqrt(sqr(uX)+sqr(vX)) ;
-  double eEstiY=sqrt(sqr(uY)+sqr(vY)) ;
+  double eEstiX=fitX.amplitude ;
+  double eEstiY=fitY.amplitude ;
   double argX=atan2(uX,vX) ;
   double argY=atan2(uY,vY) ;
   double phiX=360.0/(2.0*M_PI)*argX ;
@@ -199,32 +165,24 @@ void analyseSignal(int size , float **s, double fSample, double fMeasure, FILE *
   if( theOptions.v1 ){
     double sqSumX=0.0 ;
     double sqSumY=0.0 ; 
-    double sqSumXres=0.0 ;
-    double sqSumYres=0.0 ; 
     double maxX=0.0 ;
     double maxY=0.0 ;
     for(i = 0; i < size ; i++) {
-      double t=i*2*M_PI*fMeasure/fSample ;
-      double co=cos(t) ;
-      double si=sin(t) ;
-      if (abs(sigX[i]) >maxX ){ maxX=abs(sigX[i]) ;  }
-      if (abs(sigY[i]) >maxY ){ maxY=abs(sigY[i]) ;  }
-      sqSumX +=  sqr (sigX[i]) ;
-      sqSumY +=  sqr (sigY[i]) ;
-      sqSumXres +=  sqr (sigX[i]-uX*co-vX*si-rhsX[2]) ;
-      sqSumYres +=  sqr (sigY[i]-uY*co-vY*si-rhsY[2]) ;
+      if (fabs(s[1][i]) >maxX ){ maxX=fabs(s[1][i]) ;  }
+      if (fabs(s[2][i]) >maxY ){ maxY=fabs(s[2][i]) ;  }
+      sqSumX +=  sqr (s[1][i]) ;
+      sqSumY +=  sqr (s[2][i]) ;
       }
     sqSumX=sqrt(sqSumX/size) ;
     sqSumY=sqrt(sqSumY/size) ;
-    sqSumXres=sqrt(sqSumXres/size) ;
-    sqSumYres=sqrt(sqSumYres/size) ;
     fprintf(stderr,"\n") ;
     fprintf(stderr,"A1=%8.2f phi1=%8.2f A2=%8.2f phi2=%8.2f\n",eEstiX,phiX,eEstiY,phiY) ;
     fprintf(stderr,"\n") ;
     fprintf(stderr,"maxX     =%15.3f maxY     =%15.3f\n",maxX,maxY) ;
     fprintf(stderr,"sqSumX   =%15.3f sqSumY   =%15.3f\n",sqSumX,sqSumY) ;
-    fprintf(stderr,"residual energy after subtracting a*cos+b*sin+c\n") ;
-    fprintf(stderr,"sqSumXres=%15.3f sqSumYres=%15.3f\n",sqSumXres,sqSumYres) ;
+    fprintf(stderr,"residual rms after subtracting a*cos+b*sin+c\n") ;
+    fprintf(stderr,"sqSumXres=%15.3f sqSumYres=%15.3f\n",fitX.residual_rms,fitY.residual_rms) ;
+    fprintf(stderr,"SINAD X  =%12.2f dB SINAD Y  =%12.2f dB\n",fitX.sinad,fitY.sinad) ;
     }
   }
 
@@ -35,6 +35,7 @@
 #include "fpga_osc.h"
 #include "fpga_awg.h"
 #include "version.h"
+#include "redpitaya/rp.h"
 
 #define M_PI 3.14159265358979323846
 
@@ -766,72 +767,19 @@ int bode_data_analysis(float **s ,
                        float *Phase,
                        double w_out,
                        int f) {
-    int i2, i3;
-    float **U_acq = create_2D_table_size(SIGNALS_NUM, SIGNAL_LENGTH);
-    /* Signals multiplied by the reference signal (sin) */
-    float *U1_sampled_X = (float *) malloc( size * sizeof( float ) );
-    float *U1_sampled_Y = (float *) malloc( size * sizeof( float ) );
-    float *U2_sampled_X = (float *) malloc( size * sizeof( float ) );
-    float *U2_sampled_Y = (float *) malloc( size * sizeof( float ) );
-    /* Signals return by trapezoidal method in complex */
-    float *X_component_lock_in_1 = (float *) malloc( size * sizeof( float ) );
-    float *X_component_lock_in_2 = (float *) malloc( size * sizeof( float ) );
-    float *Y_component_lock_in_1 = (float *) malloc( size * sizeof( float ) );
-    float *Y_component_lock_in_2 = (float *) malloc( size * sizeof( float ) );
-    /* Voltage, current and their phases calculated */
-    float U1_amp;
-    float Phase_U1_amp;
-    float U2_amp;
-    float Phase_U2_amp;
+    /* Voltage amplitudes and phases fitted to both channels */
+    rp_sine_fit_t U1_fit;
+    rp_sine_fit_t U2_fit;
     float Phase_internal;
-    //float Z_phase_deg_imag;  // may cuse errors because not complex
-    float T; // Sampling time in seconds
-    float *t = create_table_size(16384);
 
-    T = ( g_dec[f] / 125e6 );
-    //printf("T = %f;\n",T );
-
-    for(i2 = 0; i2 < (size - 1); i2++) {
-        t[i2] = i2;
-    }
-    //printf("size1 = %d\n", size);
-
-    /* Transform signals from  AD - 14 bit to voltage [ ( s / 2^14 ) * 2 ] */
-    for (i2 = 0; i2 < SIGNALS_NUM; i2++) { // only the 1 and 2 are used for i2
-        for(i3 = 0; i3 < size; i3 ++ ) { 
-            U_acq[i2][i3] = ( ( s[i2][i3] ) * (float)( 2 - DC_bias ) ) / (float)16384 ; //division comes after multiplication, this way no accuracy is lost
-            //printf("data(%d,%d) = %f;\n",(i2+1), (i3+1), U_acq[i2][i3] );
-        }
-    }
-
-    /* Acquired signals must be multiplied by the reference signals, used for lock in metod */
-    float ang;
-    for( i2 = 0; i2 < size; i2++) {
-        ang = (i2 * T * w_out);
-        //printf("ang(%d) = %f \n", (i2+1), ang);
-        U1_sampled_X[i2] = U_acq[1][i2] * sin( ang );
-        U1_sampled_Y[i2] = U_acq[1][i2] * sin( ang+ (M_PI/2) );
-
-        U2_sampled_X[i2] = U_acq[2][i2] * sin( ang );
-        U2_sampled_Y[i2] = U_acq[2][i2] * sin( ang +(M_PI/2) );
+    /* Both channels are in ADC counts, their ratio and phase difference do not
+     * depend on the conversion to voltage */
+    if (rp_AcqSineFit(s[1], s[2], size, 125e6 / g_dec[f], w_out / (2 * M_PI), false,
+                      &U1_fit, &U2_fit) != RP_OK) {
+        return -1;
     }
 
-    /* Trapezoidal method for calculating the approximation of an integral */
-    X_component_lock_in_1[1] = trapz( U1_sampled_X, (float)T, size );
-    Y_component_lock_in_1[1] = trapz( U1_sampled_Y, (float)T, size );
-
-    X_component_lock_in_2[1] = trapz( U2_sampled_X, (float)T, size );
-    Y_component_lock_in_2[1] = trapz( U2_sampled_Y, (float)T, size );
-    
-    /* Calculating voltage amplitude and phase */
-    U1_amp = (float)2 * (sqrtf( powf( X_component_lock_in_1[ 1 ] , (float)2 ) + powf( Y_component_lock_in_1[ 1 ] , (float)2 )));
-    Phase_U1_amp = atan2f( Y_component_lock_in_1[ 1 ], X_component_lock_in_1[ 1 ] );
-
-    /* Calculating current amplitude and phase */
-    U2_amp = (float)2 * (sqrtf( powf( X_component_lock_in_2[ 1 ], (float)2 ) + powf( Y_component_lock_in_2[ 1 ] , (float)2 ) ) );
-    Phase_U2_amp = atan2f( Y_component_lock_in_2[1], X_component_lock_in_2[1] );
-    
-    Phase_internal = Phase_U2_amp - Phase_U1_amp ;
+    Phase_internal = U2_fit.phase - U1_fit.phase;
 
     if (Phase_internal <=  (-M_PI) )
     {
@@ -841,12 +789,8 @@ int bode_data_analysis(float **s ,
     {
         Phase_internal = Phase_internal -(2*M_PI) ;
     }
-    else 
-    {
-        Phase_internal = Phase_internal;
-    }
-   
-    *Amplitude = 10*log( U2_amp / U1_amp );
+
+    *Amplitude = 10*log( U2_fit.amplitude / U1_fit.amplitude );
     *Phase = Phase_internal * ( 180/M_PI );
 
     return 1;
@@ -0,0 +1,158 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya calibration sampler test.
+ *
+ * Fills the ADC buffers of the simulated backend with known samples and
+ * plays the FPGA, clearing the trigger source once librp has set it, so
+ * the calibration sees complete captures. Checks the mean, the median and
+ * the trimmed mean over several buffers against values worked out here.
+ * Run it with RP_SIMULATE=1 on a PC, nothing is written to the EEPROM.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "redpitaya/rp.h"
+
+#define BUFFERS         3
+#define ADC_BITS_MASK   0x3FFF
+/* Part of the samples dropped at each end by RP_CALIB_TRIMMED */
+#define TRIM            0.1
+
+/* librp internals, the FPGA memory of the simulated backend */
+const volatile uint32_t* osc_GetDataBufferChA();
+const volatile uint32_t* osc_GetDataBufferChB();
+
+static volatile int running = 1;
+static int32_t samples[2][ADC_BUFFER_SIZE];
+static int failed = 0;
+
+static void check(const char *what, int ok)
+{
+    printf("%s: %s\n", ok ? "PASS" : "FAIL", what);
+    if (!ok) {
+        failed++;
+    }
+}
+
+/* The FPGA clears the trigger source when the capture is complete */
+static void *fpgaThread(void *arg)
+{
+    rp_acq_trig_src_t source;
+
+    while (running) {
+        if (rp_AcqGetTriggerSrc(&source) == RP_OK && source != RP_TRIG_SRC_DISABLED) {
+            rp_AcqSetTriggerSrc(RP_TRIG_SRC_DISABLED);
+        }
+        usleep(100);
+    }
+    return NULL;
+}
+
+/* Outliers at one end and two levels, so that the mean, the median and the
+ * trimmed mean all differ */
+static void fillBuffers()
+{
+    volatile uint32_t *raw[2] = {
+        (volatile uint32_t *)osc_GetDataBufferChA(),
+        (volatile uint32_t *)osc_GetDataBufferChB()
+    };
+
+    for (int i = 0; i < ADC_BUFFER_SIZE; i++) {
+        samples[0][i] = i % 16 == 0 ? 4000 : (i % 3 ? 100 : 130);
+        samples[1][i] = i % 16 == 0 ? -5000 : (i % 2 ? -200 : -100);
+        for (int ch = 0; ch < 2; ch++) {
+            raw[ch][i] = samples[ch][i] & ADC_BITS_MASK;
+        }
+    }
+}
+
+static int cmp(const void *a, const void *b)
+{
+    int32_t x = *(const int32_t *)a, y = *(const int32_t *)b;
+    return (x > y) - (x < y);
+}
+
+/* Mean of the sorted samples of rank first to last, all buffers */
+static double rankMean(int32_t *sorted, uint64_t first, uint64_t last)
+{
+    double sum = 0;
+    for (uint64_t r = first; r <= last; r++) {
+        sum += sorted[r / BUFFERS];
+    }
+    return sum / (last - first + 1);
+}
+
+static int32_t expected(int ch, rp_calib_reduce_t reduce)
+{
+    static int32_t sorted[ADC_BUFFER_SIZE];
+    uint64_t n = (uint64_t)ADC_BUFFER_SIZE * BUFFERS;
+    double sum = 0;
+
+    memcpy(sorted, samples[ch], sizeof(sorted));
+    qsort(sorted, ADC_BUFFER_SIZE, sizeof(int32_t), cmp);
+    switch (reduce) {
+    case RP_CALIB_MEDIAN:
+        return rankMean(sorted, (n - 1) / 2, n / 2);
+    case RP_CALIB_TRIMMED: {
+        uint64_t trim = (uint64_t)(n * TRIM);
+        return rankMean(sorted, trim, n - 1 - trim);
+    }
+    default:
+        for (int i = 0; i < ADC_BUFFER_SIZE; i++) {
+            sum += samples[ch][i];
+        }
+        return sum / ADC_BUFFER_SIZE;
+    }
+}
+
+static void testReduce(rp_calib_reduce_t reduce, const char *name)
+{
+    rp_calib_params_t p;
+    char what[64];
+
+    memset(&p, 0, sizeof(p));
+    check(name, rp_CalibrationSetSampling(BUFFERS, reduce) == RP_OK
+                && rp_CalibrateFrontEndOffsetBoth(RP_LOW, &p) == RP_OK);
+    snprintf(what, sizeof(what), "%s, channel A", name);
+    check(what, p.fe_ch1_lo_offs == expected(0, reduce));
+    snprintf(what, sizeof(what), "%s, channel B", name);
+    check(what, p.fe_ch2_lo_offs == expected(1, reduce));
+}
+
+int main(int argc, char **argv)
+{
+    pthread_t fpga;
+
+    if (rp_Init() != RP_OK) {
+        fprintf(stderr, "Red Pitaya API init failed!\n");
+        return 1;
+    }
+
+    fillBuffers();
+    pthread_create(&fpga, NULL, fpgaThread, NULL);
+
+    testReduce(RP_CALIB_MEAN, "mean");
+    testReduce(RP_CALIB_MEDIAN, "median");
+    testReduce(RP_CALIB_TRIMMED, "trimmed mean");
+
+    running = 0;
+    pthread_join(fpga, NULL);
+    rp_Release();
+
+    printf("%s\n", failed ? "FAILED" : "OK");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,230 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya calibration store test.
+ *
+ * Keeps the calibration in a plain file laid out as the EEPROM (parameters
+ * at 0x08, the librp checksum in the reserved bytes in front of them) and
+ * checks how librp reads it back: with a matching checksum, without one,
+ * and with one that no longer matches, as left by Test/calib or the
+ * applications, which write the parameters only. Parameters that are only
+ * read must never be written back. No EEPROM is touched, run it with
+ * RP_SIMULATE=1 on a PC or on the board.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "redpitaya/rp.h"
+
+#define STORE_OFFSET    0x08
+#define CHECK_MAGIC     0x52
+#define CALIB_MAGIC     0xAABBCCDD
+
+typedef struct __attribute__((packed)) {
+    uint8_t  magic;
+    uint8_t  version;
+    uint32_t crc;
+} check_t;
+
+#define CHECK_OFFSET    (STORE_OFFSET - sizeof(check_t))
+
+static char path[] = "/tmp/calibStoreTestXXXXXX";
+static int failed = 0;
+
+static uint32_t crc32(const void *data, size_t len)
+{
+    const uint8_t *p = data;
+    uint32_t crc = 0xFFFFFFFF;
+    while (len--) {
+        crc ^= *p++;
+        for (int i = 0; i < 8; i++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+static void check(const char *what, int ok)
+{
+    printf("%s: %s\n", ok ? "PASS" : "FAIL", what);
+    if (!ok) {
+        failed++;
+    }
+}
+
+static rp_calib_params_t makeParams(uint32_t seed)
+{
+    rp_calib_params_t p;
+    memset(&p, 0, sizeof(p));
+    p.fe_ch1_fs_g_hi = seed + 1;
+    p.fe_ch2_fs_g_hi = seed + 2;
+    p.fe_ch1_fs_g_lo = seed + 3;
+    p.fe_ch2_fs_g_lo = seed + 4;
+    p.fe_ch1_lo_offs = seed + 5;
+    p.fe_ch2_lo_offs = seed + 6;
+    p.be_ch1_fs = seed + 7;
+    p.be_ch2_fs = seed + 8;
+    p.be_ch1_dc_offs = seed + 9;
+    p.be_ch2_dc_offs = seed + 10;
+    p.magic = CALIB_MAGIC;
+    p.fe_ch1_hi_offs = seed + 11;
+    p.fe_ch2_hi_offs = seed + 12;
+    return p;
+}
+
+/* Writes the parameters only, as the other calibration tools do */
+static void writeParams(const rp_calib_params_t *p)
+{
+    int fd = open(path, O_WRONLY);
+    if (fd < 0 || pwrite(fd, p, sizeof(*p), STORE_OFFSET) != sizeof(*p)) {
+        perror(path);
+        exit(1);
+    }
+    close(fd);
+}
+
+static void writeCheck(const check_t *c)
+{
+    int fd = open(path, O_WRONLY);
+    if (fd < 0 || pwrite(fd, c, sizeof(*c), CHECK_OFFSET) != sizeof(*c)) {
+        perror(path);
+        exit(1);
+    }
+    close(fd);
+}
+
+static check_t readCheck()
+{
+    check_t c;
+    memset(&c, 0, sizeof(c));
+    int fd = open(path, O_RDONLY);
+    if (fd >= 0) {
+        pread(fd, &c, sizeof(c), CHECK_OFFSET);
+        close(fd);
+    }
+    return c;
+}
+
+static int checkMatches(const rp_calib_params_t *p)
+{
+    check_t c = readCheck();
+    return c.magic == CHECK_MAGIC && c.crc == crc32(p, sizeof(*p));
+}
+
+/* Whole file, to see that nothing is written */
+static size_t readFile(uint8_t *buf, size_t len)
+{
+    int fd = open(path, O_RDONLY);
+    ssize_t size = fd < 0 ? -1 : pread(fd, buf, len, 0);
+    close(fd);
+    return size < 0 ? 0 : size;
+}
+
+/* Selecting the store again drops what librp has read */
+static int readBack(const rp_calib_params_t *expected)
+{
+    if (rp_CalibrationSetStore(path, STORE_OFFSET) != RP_OK) {
+        return 0;
+    }
+    rp_calib_params_t p = rp_GetCalibrationSettings();
+    return memcmp(&p, expected, sizeof(p)) == 0;
+}
+
+int main(int argc, char **argv)
+{
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        perror("mkstemp");
+        return 1;
+    }
+    close(fd);
+
+    if (rp_Init() != RP_OK) {
+        fprintf(stderr, "Red Pitaya API init failed!\n");
+        return 1;
+    }
+
+    uint8_t before[256], after[256];
+    size_t before_len, after_len;
+
+    check("offset without room for the checksum", rp_CalibrationSetStore(path, 2) == RP_EOOR);
+
+    // Written by librp, with its checksum
+    rp_calib_params_t p1 = makeParams(100);
+    rp_CalibrationSetStore(path, STORE_OFFSET);
+    check("write through librp", rp_CalibrationWriteParams(p1) == RP_OK);
+    check("checksum written", checkMatches(&p1));
+    check("read back", readBack(&p1));
+    before_len = readFile(before, sizeof(before));
+    check("nothing written after the parameters", before_len == STORE_OFFSET + sizeof(p1));
+
+    // Rewritten by another tool, the checksum no longer matches
+    rp_calib_params_t p2 = makeParams(200);
+    writeParams(&p2);
+    check("parameters without their checksum are used", readBack(&p2));
+    rp_Release();
+    rp_Init();
+    check("release does not rewrite the checksum", !checkMatches(&p2));
+    check("explicit commit", rp_CalibrationCommit() == RP_OK);
+    check("commit rewrites the checksum", checkMatches(&p2));
+    check("read back after the commit", readBack(&p2));
+
+    // Checksum of another version
+    check_t c = readCheck();
+    c.version++;
+    writeCheck(&c);
+    check("checksum of another version is ignored", readBack(&p2));
+
+    // Written before the checksum existed, Test/calib clears the reserved bytes
+    memset(&c, 0, sizeof(c));
+    writeCheck(&c);
+    rp_calib_params_t p3 = makeParams(300);
+    writeParams(&p3);
+    check("parameters without a checksum are used", readBack(&p3));
+
+    // Changes are written with a new checksum
+    p3.be_ch1_dc_offs = 42;
+    check("write changes", rp_CalibrationWriteParams(p3) == RP_OK);
+    check("checksum of the changes", checkMatches(&p3));
+    check("read back the changes", readBack(&p3));
+
+    // Written before the high gain offsets existed, they are taken from the
+    // low gain ones but not written back by reading alone
+    rp_calib_params_t p4 = makeParams(400);
+    p4.magic = 0;
+    memset(&c, 0, sizeof(c));
+    writeCheck(&c);
+    writeParams(&p4);
+    before_len = readFile(before, sizeof(before));
+    rp_CalibrationSetStore(path, STORE_OFFSET);
+    rp_calib_params_t legacy = rp_GetCalibrationSettings();
+    check("legacy high gain offsets", legacy.fe_ch1_hi_offs == p4.fe_ch1_lo_offs
+                                      && legacy.fe_ch2_hi_offs == p4.fe_ch2_lo_offs);
+    rp_Release();
+    rp_Init();
+    rp_GetCalibrationSettings();
+    rp_CalibrationSetStore(path, STORE_OFFSET);
+    after_len = readFile(after, sizeof(after));
+    check("legacy parameters are not rewritten",
+          after_len == before_len && memcmp(before, after, before_len) == 0);
+
+    rp_CalibrationSetStore(NULL, 0);
+    rp_Release();
+    unlink(path);
+
+    printf("%s\n", failed ? "FAILED" : "OK");
+    return failed ? 1 : 0;
+}
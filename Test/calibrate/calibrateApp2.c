@@ -99,61 +99,38 @@ int main(int argc, char **argv) {
 
     puts("Calibration proces started.");
 
-    puts("Connect CH1 LV to ground.");
+    puts("Connect CH1 and CH2 LV to ground.");
     waitForUser();
-    ECHECK(rp_CalibrateFrontEndOffset(RP_CH_1, RP_LOW, NULL));
+    ECHECK(rp_CalibrateFrontEndOffsetBoth(RP_LOW, NULL));
 
-    puts("Connect CH1 HV to ground.");
+    puts("Connect CH1 and CH2 HV to ground.");
     waitForUser();
-    ECHECK(rp_CalibrateFrontEndOffset(RP_CH_1, RP_HIGH, NULL));
+    ECHECK(rp_CalibrateFrontEndOffsetBoth(RP_HIGH, NULL));
 
     do {
-        puts("Connect CH1 to reference voltage source and set jumpers to HV.");
+        puts("Connect CH1 and CH2 to reference voltage source and set jumpers to HV.");
         puts("Enter reference voltage: ");
         ret = scanf("%f", &value);
     } while ((ret != 1) && (value <= 0.f) && (value > 20.f));
     printf("Calibrating to %f V\n", value);
-    ECHECK(rp_CalibrateFrontEndScaleHV(RP_CH_1, value, NULL));
+    ECHECK(rp_CalibrateFrontEndScaleHVBoth(value, NULL));
 
     do {
-        puts("Connect CH1 to reference voltage source and set jumpers to LV.");
+        puts("Connect CH1 and CH2 to reference voltage source and set jumpers to LV.");
         puts("Enter reference voltage: ");
         ret = scanf("%f", &value);
     } while ((ret != 1) && (value <= 0.f) && (value > 1.f));
     printf("Calibrating to %f V\n", value);
-    ECHECK(rp_CalibrateFrontEndScaleLV(RP_CH_1, value, NULL));
+    ECHECK(rp_CalibrateFrontEndScaleLVBoth(value, NULL));
 
     puts("Connect CH1 Outout to CH1 Input. Press any key to continue.");
     waitForUser();
     ECHECK(rp_CalibrateBackEnd(RP_CH_1, NULL));
 
-    puts("Connect CH2 LV to ground.");
-    waitForUser();
-    ECHECK(rp_CalibrateFrontEndOffset(RP_CH_2, RP_LOW, NULL));
-
-    puts("Connect CH2 HV to ground.");
-    waitForUser();
-    ECHECK(rp_CalibrateFrontEndOffset(RP_CH_2, RP_HIGH, NULL));
-
-    do {
-        puts("Connect CH2 to reference voltage source and set jumpers to HV.");
-        puts("Enter reference voltage: ");
-        ret = scanf("%f", &value);
-    } while ((ret != 1) && (value <= 0.f) && (value > 20.f));
-    printf("Calibrating to %f V\n", value);
-    ECHECK(rp_CalibrateFrontEndScaleHV(RP_CH_2, value, NULL));
-
-    do {
-        puts("Connect CH2 to reference voltage source and set jumpers to LV.");
-        puts("Enter reference voltage: ");
-        ret = scanf("%f", &value);
-    } while ((ret != 1) && (value <= 0.f) && (value > 1.f));
-    printf("Calibrating to %f V\n", value);
-    ECHECK(rp_CalibrateFrontEndScaleLV(RP_CH_2, value, NULL));
-
     puts("Connect CH2 Outout to CH2 Input.");
     waitForUser();
     ECHECK(rp_CalibrateBackEnd(RP_CH_2, NULL));
+    ECHECK(rp_CalibrationCommit());
 
     printParams(NULL);
     backupParams();
@@ -0,0 +1,148 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya I2C transfer test.
+ *
+ * Runs the librp I2C functions against the fake adapter of the simulated
+ * backend, where every address is a device with 256 registers and an
+ * auto-incrementing register pointer. Covers combined transactions,
+ * register reads, the pointer wrap-around, separate devices and buses,
+ * argument checks and the release of the fake registers. Run it with
+ * RP_SIMULATE=1 on a PC or on the board.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "redpitaya/rp.h"
+
+#define DEV_A           0x50
+#define DEV_B           0x51
+/* Most messages in one transfer, see rp_I2cTransfer() */
+#define MAX_MSGS        42
+
+static int failed = 0;
+
+static void check(const char *what, int ok)
+{
+    printf("%s: %s\n", ok ? "PASS" : "FAIL", what);
+    if (!ok) {
+        failed++;
+    }
+}
+
+static int writeRegs(int bus, uint8_t addr, uint8_t reg, const uint8_t *data, uint16_t len)
+{
+    uint8_t buf[257];
+    rp_i2c_msg_t msg = { addr, 0, len + 1, buf };
+
+    buf[0] = reg;
+    memcpy(buf + 1, data, len);
+    return rp_I2cTransfer(bus, &msg, 1);
+}
+
+static void testRegisters()
+{
+    static const uint8_t data[] = { 0x11, 0x22, 0x33, 0x44 };
+    uint8_t r[4];
+
+    check("registers: write", writeRegs(0, DEV_A, 0x10, data, 4) == RP_OK);
+    memset(r, 0, sizeof(r));
+    check("registers: read", rp_I2cReadRegs(0, DEV_A, 0x10, r, 4) == RP_OK && memcmp(r, data, 4) == 0);
+    memset(r, 0, sizeof(r));
+    check("registers: read from the middle", rp_I2cReadRegs(0, DEV_A, 0x12, r, 2) == RP_OK
+                                             && r[0] == 0x33 && r[1] == 0x44);
+}
+
+static void testCombined()
+{
+    uint8_t reg = 0x11, first[1], rest[2];
+    rp_i2c_msg_t msgs[3] = {
+        { DEV_A, 0, 1, &reg },
+        { DEV_A, RP_I2C_READ, 1, first },
+        { DEV_A, RP_I2C_READ, 2, rest }
+    };
+
+    check("combined: transfer", rp_I2cTransfer(0, msgs, 3) == RP_OK);
+    check("combined: first read", first[0] == 0x22);
+    check("combined: pointer carried to the next read", rest[0] == 0x33 && rest[1] == 0x44);
+}
+
+static void testWrap()
+{
+    static const uint8_t data[] = { 0xAA, 0xBB, 0xCC };
+    uint8_t r[3];
+
+    check("wrap: write across the end", writeRegs(0, DEV_A, 0xFF, data, 3) == RP_OK);
+    check("wrap: last register", rp_I2cReadRegs(0, DEV_A, 0xFF, r, 1) == RP_OK && r[0] == 0xAA);
+    check("wrap: first registers", rp_I2cReadRegs(0, DEV_A, 0x00, r, 2) == RP_OK
+                                   && r[0] == 0xBB && r[1] == 0xCC);
+    check("wrap: read across the end", rp_I2cReadRegs(0, DEV_A, 0xFF, r, 3) == RP_OK
+                                       && memcmp(r, data, 3) == 0);
+}
+
+static void testSeparate()
+{
+    uint8_t v = 0x5A, r;
+
+    check("separate: other device", writeRegs(0, DEV_B, 0x10, &v, 1) == RP_OK);
+    check("separate: device kept", rp_I2cReadRegs(0, DEV_A, 0x10, &r, 1) == RP_OK && r == 0x11);
+    check("separate: other device read", rp_I2cReadRegs(0, DEV_B, 0x10, &r, 1) == RP_OK && r == 0x5A);
+    check("separate: other bus", rp_I2cReadRegs(1, DEV_A, 0x10, &r, 1) == RP_OK && r == 0);
+}
+
+static void testArguments()
+{
+    uint8_t b = 0;
+    rp_i2c_msg_t msgs[MAX_MSGS + 1];
+
+    for (int i = 0; i <= MAX_MSGS; i++) {
+        msgs[i] = (rp_i2c_msg_t){ DEV_A, RP_I2C_READ, 1, &b };
+    }
+    check("arguments: no messages", rp_I2cTransfer(0, msgs, 0) == RP_OK);
+    check("arguments: most messages", rp_I2cTransfer(0, msgs, MAX_MSGS) == RP_OK);
+    check("arguments: too many messages", rp_I2cTransfer(0, msgs, MAX_MSGS + 1) == RP_EOOR);
+    check("arguments: bus", rp_I2cReadRegs(8, DEV_A, 0, &b, 1) == RP_EOOR);
+    check("arguments: address", rp_I2cReadRegs(0, 0x80, 0, &b, 1) == RP_UIA);
+    msgs[0].buf = NULL;
+    check("arguments: no buffer", rp_I2cTransfer(0, msgs, 1) == RP_UIA);
+    check("arguments: no messages array", rp_I2cTransfer(0, NULL, 1) == RP_UIA);
+}
+
+static void testRelease()
+{
+    uint8_t r = 0xFF;
+
+    check("release", rp_I2cRelease() == RP_OK);
+    check("release: registers dropped", rp_I2cReadRegs(0, DEV_A, 0x10, &r, 1) == RP_OK && r == 0);
+}
+
+int main(int argc, char **argv)
+{
+    if (rp_Init() != RP_OK) {
+        fprintf(stderr, "Red Pitaya API init failed!\n");
+        return 1;
+    }
+
+    testRegisters();
+    testCombined();
+    testWrap();
+    testSeparate();
+    testArguments();
+    testRelease();
+
+    rp_Release();
+
+    printf("%s\n", failed ? "FAILED" : "OK");
+    return failed ? 1 : 0;
+}
@@ -4,6 +4,7 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <math.h>
+#include <complex.h>
 #include "redpitaya/rp.h"
 
 int main(int argc, char **argv){
@@ -64,98 +65,24 @@ int main(int argc, char **argv){
         rp_AcqGetOldestDataV(RP_CH_2, &buff_size, buff_in2);
         
 
-        double *U_dut = (double *) malloc( buff_size * sizeof( double ) );
-        double *I_dut = (double *) malloc( buff_size * sizeof( double ) );
-        
-        double *U_dut_sampled_X = (double *) malloc( buff_size * sizeof( double ) );
-        double *U_dut_sampled_Y = (double *) malloc( buff_size * sizeof( double ) );
-        double *I_dut_sampled_X = (double *) malloc( buff_size * sizeof( double ) );
-        double *I_dut_sampled_Y = (double *) malloc( buff_size * sizeof( double ) );
-   
-        double *X_component_lock_in_U = (double *) malloc( buff_size * sizeof( double ) );
-        double *Y_component_lock_in_U = (double *) malloc( buff_size * sizeof( double ) );
-        double *X_component_lock_in_I = (double *) malloc( buff_size * sizeof( double ) );
-        double *Y_component_lock_in_I = (double *) malloc( buff_size * sizeof( double ) );       
-        double d_T=signal_decimation/125E6;
-
-        int i;
-        double sum_buff_in1;
-        double sum_buff_in2;
-
-        for(i = 0; i < buff_size; i++){
-
-        sum_buff_in1 += buff_in1[i];
-        sum_buff_in2 += buff_in2[i];
-               
-        }
-        double mean_buff_in1=sum_buff_in1/buff_size;
-        double mean_buff_in2=sum_buff_in2/buff_size;
-
         float R_shunt=7458.0;
-        float PI=3.14;
-        double d_angle;
-
-        for(i = 0; i < buff_size; i++){
-                       
-               U_dut[ i ] = ((buff_in1[i]-mean_buff_in1) - (buff_in2[i]-mean_buff_in2)); 
-               I_dut[ i ] = ((buff_in2[i]-mean_buff_in2) / R_shunt);
-
-               d_angle = (i * d_T * selected_frequency * 2 * PI );
-               
-               U_dut_sampled_X[ i ] = U_dut[ i ] * sin( d_angle );
-               U_dut_sampled_Y[ i ] = U_dut[ i ] * sin( d_angle+ ( PI/2 ) );
-
-               I_dut_sampled_X[ i ] = I_dut[ i ] * sin( d_angle );
-               I_dut_sampled_Y[ i ] = I_dut[ i ] * sin( d_angle +( PI/2 ) );               
-    
-        }
-    
-        /*Trapezoidal method for integration */
-        double trapz(double *arrayptr, double d_T, int buff_size) {
-        double result = 0;
-        int i;
-            for (i =0; i < buff_size - 1 ; i++)     { result += ( arrayptr[i] + arrayptr[ i+1 ]); }
-            result = (d_T / (double)2) * result;
-            return result;
+        rp_sine_fit_t fit_in1;
+        rp_sine_fit_t fit_in2;
+
+        if(rp_AcqSineFit(buff_in1, buff_in2, buff_size, 125e6/signal_decimation, selected_frequency, false,
+                         &fit_in1, &fit_in2) != RP_OK){
+                fprintf(stderr, "Sine fit failed!\n");
+                rp_Release();
+                return 1;
         }
 
+        /* Voltage on the load is the potential difference, current trough the load is the one trough R_shunt */
+        double complex U_dut = fit_in1.amplitude*cexp(I*fit_in1.phase) - fit_in2.amplitude*cexp(I*fit_in2.phase);
+        double complex I_dut = fit_in2.amplitude*cexp(I*fit_in2.phase) / R_shunt;
+        double complex Z = U_dut / I_dut;
 
-        X_component_lock_in_U[ 1 ] = trapz( U_dut_sampled_X, (double)d_T, buff_size );
-        Y_component_lock_in_U[ 1 ] = trapz( U_dut_sampled_Y, (double)d_T, buff_size );
-        
-        X_component_lock_in_I[ 1 ] = trapz( I_dut_sampled_X, (double)d_T, buff_size );
-        Y_component_lock_in_I[ 1 ] = trapz( I_dut_sampled_Y, (double)d_T, buff_size );
-
-
-        double U_dut_amp;
-        double I_dut_amp;
-        double Phase_I_dut_amp;
-        double Phase_U_dut_amp;
-
-        double Z_abs;
-        double Phase_Z_rad;
-        double Phase;
-        
-
-        /* Calculating voltage amplitude and phase */
-        U_dut_amp = (double)2 * (sqrtf( powf( X_component_lock_in_U[ 1 ] , (double)2 ) + powf( Y_component_lock_in_U[ 1 ] , (double)2 )));
-        Phase_U_dut_amp = atan2f( Y_component_lock_in_U[ 1 ], X_component_lock_in_U[ 1 ] );
-
-        /* Calculating current amplitude and phase */  
-        I_dut_amp = (double)2 * (sqrtf( powf( X_component_lock_in_I[ 1 ], (double)2 ) + powf( Y_component_lock_in_I[ 1 ] , (double)2 ) ) );
-        Phase_I_dut_amp = atan2f( Y_component_lock_in_I[1], X_component_lock_in_I[1] );
-
-        
-        Phase_Z_rad =  Phase_U_dut_amp - Phase_I_dut_amp;
-        Z_abs = U_dut_amp / I_dut_amp; 
-
-
-        /* Phase has to be limited between Pi and -Pi. */
-        if (Phase_Z_rad <=  (-PI) )       { Phase_Z_rad = Phase_Z_rad +(2*PI);  }
-        else if ( Phase_Z_rad >= PI )     { Phase_Z_rad = Phase_Z_rad -(2*PI);  }
-        else                                { Phase_Z_rad = Phase_Z_rad;            }       
-        
-        Phase = (double)180*(Phase_Z_rad /((double)2*PI));
+        double Z_abs = cabs(Z);
+        double Phase = carg(Z)*180/M_PI;
 
         printf("%f\n", Z_abs);
         printf("%f\n", Phase);
@@ -35,6 +35,7 @@
 #include "fpga_osc.h"
 #include "fpga_awg.h"
 #include "version.h"
+#include "redpitaya/rp.h"
 
 #define M_PI 3.14159265358979323846
 
@@ -385,7 +386,6 @@ int main(int argc, char *argv[]) {
     int transientEffectFlag = 1;
     int stepsTE = 10; // number of steps for transient effect(TE) elimination
     int TE_step_counter;
-    int progress_int = 0;
     //char command[70];
     // if user sets less than 10 steps than stepsTE is decresed
     // for transient efect to be eliminated only 10 steps of measurements is eliminated
@@ -501,17 +501,11 @@ int main(int argc, char *argv[]) {
         return -1;
     }
 
-    float *calib_data_combine = (float *)malloc( 2 * sizeof(float)); // 0=f, 1=Zreal, 2=Zimag
+    float *calib_data_combine = (float *)malloc( 3 * sizeof(float)); // 0=f, 1=Zreal, 2=Zimag
     if (calib_data_combine == NULL){
         fprintf(stderr,"error allocating memory for calib_data_combine\n");
         return -1;
     }
-    float complex *Z_final  = (float complex *)malloc( end_results_dimension * sizeof(float complex));
-    if (Z_final == NULL){
-        fprintf(stderr,"error allocating memory for Z_final\n");
-        return -1;
-    }
-
     float *PhaseZ = (float *)malloc((end_results_dimension + 1) * sizeof(float) );
     if (PhaseZ == NULL){
         fprintf(stderr,"error allocating memory for PhaseZ\n");
@@ -548,13 +542,6 @@ int main(int argc, char *argv[]) {
         return -1;
     }
 
-    float complex *Y  = (float complex *)malloc( end_results_dimension * sizeof(float complex));
-    if (Y == NULL){
-        fprintf(stderr,"error allocating memory for Z_final\n");
-        return -1;
-    }
-
-
     float *Y_abs  = (float *)malloc((end_results_dimension + 1) * sizeof(float) );
     if (Y_abs == NULL){
         fprintf(stderr,"error allocating memory for Y_abs\n");
@@ -642,7 +629,6 @@ int main(int argc, char *argv[]) {
     * there are 4 sorts of measurement purposes , 3 pof them reprisent calibration sequence
     * [h=0] - calibration open connections, [h=1] - calibration short circuited, [h=2] calibration load, [h=3] actual measurment
     */
-    //FILE *progress_file = fopen("/tmp/lcr_data/progress.txt", "w");
     for (h = 0; h <= 3 ; h++) {
         if (!calib_function) {
             h = 3;
@@ -720,41 +706,6 @@ int main(int argc, char *argv[]) {
             */
             for (i = 0; i < measurement_sweep; i++ ) {
 
-                /*Opens, empties a file and inuts the prorgress number*/
-                if(sweep_function == 0 ){
-                    //printf("transient flag = %d\n", transientEffectFlag);
-                    if(transientEffectFlag == 1){
-                        progress_int = (int)(100*(  ( i)   / (measurement_sweep_user_defined + stepsTE -1)));
-
-                    }
-                    else if (transientEffectFlag == 0){
-                        progress_int = (int)(100*( (i + stepsTE)  / (measurement_sweep + stepsTE - 1 )));
-                    }
-                }
-                else if(sweep_function == 1 ){
-                    if (TE_step_counter > 0){
-                        progress_int = (int)(100*(( stepsTE - TE_step_counter )/( frequency_steps_number + stepsTE - 1 )) );
-                    }
-                    else  if (TE_step_counter < 1){
-                        progress_int = (int)(100*((fr + stepsTE  )/( frequency_steps_number + stepsTE - 1 )) );
-                    }
-
-                }
-
-                // writing data to a file
-                FILE *progress_file = fopen("/tmp/progress", "w");
-                if (progress_int <= 100){
-                    fprintf(progress_file , "%d \n" ,  progress_int );
-
-                    //sprintf(command, "/opt/redpitaya/bin/monitor 0x40000030 0x%x", (1 << (8*progress_int/100)) - 1);
-                    //system(command);
-                    fprintf(progress_file , "%d \n" ,  progress_int );
-                    //system("clear");
-                    //printf(" progress: %d  \n",progress_int);
-                     
-                    fclose(progress_file);
-                }
-
                 int repeat = 0;
                 do {
                     for ( i1 = 0; i1 < averaging_num; i1++ ) {
@@ -910,64 +861,12 @@ int main(int argc, char *argv[]) {
     }
     */
 
-    /** Opening frequency data */
-    FILE *try_open = fopen("/tmp/lcr_data/data_frequency", "w");
-
-    /* If files don't exists yet, we first have to create them (First boot), as we are storing them in /tmp */
-    if(try_open == NULL){
-
-        int f_number;
-        char command[100];
-
-        strcpy(command, "mkdir /tmp/lcr_data");
-        system(command);
-
-        /* We loop X (Where X is the number of data we want to have) times and create a file for each data type */
-        for(f_number = 0; f_number < 16; f_number++){
-            switch(f_number){
-                case  0:  strcpy(command, "touch /tmp/lcr_data/data_frequency");  break;
-                case  1:  strcpy(command, "touch /tmp/lcr_data/data_amplitude");  break;
-                case  2:  strcpy(command, "touch /tmp/lcr_data/data_phase");      break;
-                case  3:  strcpy(command, "touch /tmp/lcr_data/data_R_s");        break;
-                case  4:  strcpy(command, "touch /tmp/lcr_data/data_X_s");        break;
-                case  5:  strcpy(command, "touch /tmp/lcr_data/data_G_p");        break;
-                case  6:  strcpy(command, "touch /tmp/lcr_data/data_B_p");        break;
-                case  7:  strcpy(command, "touch /tmp/lcr_data/data_C_s");        break;
-                case  8:  strcpy(command, "touch /tmp/lcr_data/data_C_p");        break;
-                case  9:  strcpy(command, "touch /tmp/lcr_data/data_L_s");        break;
-                case 10:  strcpy(command, "touch /tmp/lcr_data/data_L_p");        break;
-                case 11:  strcpy(command, "touch /tmp/lcr_data/data_R_p");        break;
-                case 12:  strcpy(command, "touch /tmp/lcr_data/data_Q");          break;
-                case 13:  strcpy(command, "touch /tmp/lcr_data/data_D");          break;
-                case 14:  strcpy(command, "touch /tmp/lcr_data/data_Y_abs");      break;
-                case 15:  strcpy(command, "touch /tmp/lcr_data/data_phaseY");     break;
-            }
-        }
-        /* We change the mode to write and add permission. */
-        system(command);
-        strcpy(command, "chmod -R 777 /tmp/lcr_data");
-
-        /* Command execution for before the next loop */
-        system(command);
-    }
-
-    /** Opening files */
-    FILE *file_frequency = fopen("/tmp/lcr_data/data_frequency", "w");
-    FILE *file_phase     = fopen("/tmp/lcr_data/data_phase", "w");
-    FILE *file_amplitude = fopen("/tmp/lcr_data/data_amplitude", "w");
-    FILE *file_Y_abs     = fopen("/tmp/lcr_data/data_Y_abs", "w");
-    FILE *file_PhaseY    = fopen("/tmp/lcr_data/data_phaseY", "w");
-    FILE *file_R_s       = fopen("/tmp/lcr_data/data_R_s", "w");
-    FILE *file_X_s       = fopen("/tmp/lcr_data/data_X_s", "w");
-    FILE *file_G_p       = fopen("/tmp/lcr_data/data_G_p", "w");
-    FILE *file_B_p       = fopen("/tmp/lcr_data/data_B_p", "w");
-    FILE *file_C_s       = fopen("/tmp/lcr_data/data_C_s", "w");
-    FILE *file_C_p       = fopen("/tmp/lcr_data/data_C_p", "w");
-    FILE *file_L_s       = fopen("/tmp/lcr_data/data_L_s", "w");
-    FILE *file_L_p       = fopen("/tmp/lcr_data/data_L_p", "w");
-    FILE *file_R_p       = fopen("/tmp/lcr_data/data_R_p", "w");
-    FILE *file_Q         = fopen("/tmp/lcr_data/data_Q", "w");
-    FILE *file_D         = fopen("/tmp/lcr_data/data_D", "w");
+    /* Derived quantities are stored straight into the output arrays */
+    rp_imp_result_t result = {
+        .z_abs = AmplitudeZ, .z_phase = PhaseZ, .y_abs = Y_abs, .y_phase = PhaseY,
+        .r_s = R_s, .x_s = X_s, .g_p = G_p, .b_p = B_p, .c_s = C_s, .c_p = C_p,
+        .l_s = L_s, .l_p = L_p, .r_p = R_p, .q = Q, .d = D
+    };
 
     /** Combining all the data and printing it to stdout
      * depending on calibration argument output data is calculated
@@ -998,27 +897,7 @@ int main(int argc, char *argv[]) {
         w_out = 2 * M_PI * Frequency[ i ]; // angular velocity
         }  
 
-        PhaseZ[ i ] = ( 180 / M_PI) * (atan2f( calib_data_combine[ 2 ], calib_data_combine[ 1 ] ));
-        AmplitudeZ[ i ] = sqrtf( powf( calib_data_combine[ 1 ], 2 ) + powf(calib_data_combine[ 2 ], 2 ) );
-
-        Z_final[ i ] = calib_data_combine[ 1 ] + calib_data_combine[ 2 ]*I;//Z=Z_abs*exp(i*Phase_rad);;
-        R_s[ i ] =  calib_data_combine[ 1 ];//R_s=real(Z);
-        X_s[ i ] = calib_data_combine[ 2 ];//X_s=imag(Z);
-
-        Y [ i ] = 1 / Z_final[ i ];//Y=1/Z;
-        Y_abs [ i ] = sqrtf( powf( creal(Y[ i ]), 2 ) + powf(cimag(Y[ i ]), 2 ) );//Y_abs=abs(Y);
-        PhaseY[ i ] = -PhaseZ[ i ];// PhaseY=-Phase_rad;
-        G_p [ i ] = creal(Y[ i ]);//G_p=real(Y);;
-        B_p [ i ] = cimag(Y[ i ]);//B_p=imag(Y);
-
-        C_s [ i ] = -1 / (w_out * X_s[ i ]);//C_s=-1/(w*X_s);
-        C_p [ i ] = B_p[ i ] / w_out;//C_p=B_p/w; //inf
-        L_s [ i ] = X_s[ i ] / w_out;//L_s=X_s/w; //inf
-        L_p [ i ] = -1 / (w_out * B_p[ i ]);//L_p=-1/(w*B_p); //inf
-        R_p [ i ] = 1 / G_p [ i ]; //R_p=1/G_p;
-
-        Q[ i ] =X_s[ i ] / R_s[ i ]; //Q=X_s/R_s;
-        D[ i ] = -1 / Q [ i ]; //D=-1/Q;
+        rp_ImpDerive( w_out / (2 * M_PI), calib_data_combine[ 1 ], calib_data_combine[ 2 ], &result, i );
 
         /// Output
         /*printf(" %.1f    %.3f    %.1f    %.10f    %.10f    %.10f    %.10f    %.10f    %.10f    %.10f    %.10f    %.10f    %.10f    %.10f    %.10f    %.10f\n",*/
@@ -1046,92 +925,8 @@ int main(int argc, char *argv[]) {
 
 
  
-        /** Saving files */
-        if (!sweep_function) {
-            fprintf(file_frequency, "%.1f\n", Frequency[0]);
-        } else {
-            fprintf(file_frequency, "%.1f\n", Frequency[i]);
-            
-        }
-
-        fprintf(file_amplitude, "%.3f\n", AmplitudeZ[i]);        
-        fprintf(file_phase, "%.2f\n", PhaseZ[i]);
-        
-        fprintf(file_L_s, "%.15f\n", L_s[i]);
-        fprintf(file_C_s, "%.15f\n", C_s[i]);
-        fprintf(file_R_s, "%.15f\n", R_s[i]);
-
-        fprintf(file_L_p, "%.15f\n", L_p[i]);
-        fprintf(file_C_p, "%.15f\n", C_p[i]);
-        fprintf(file_R_p, "%.15f\n", R_p[i]);
-
-        fprintf(file_Q, "%.15f\n", Q[i]);
-        fprintf(file_D, "%.15f\n", D[i]);
-
-        fprintf(file_X_s, "%.15f\n", X_s[i]);
-        fprintf(file_G_p, "%.15f\n", G_p[i]);
-        fprintf(file_B_p, "%.15f\n", B_p[i]);
-
-        fprintf(file_Y_abs, "%.15f\n", Y_abs[i]);
-        fprintf(file_PhaseY, "%.15f\n", PhaseY[i]);
-
-        /*Dummy data*/
-        
-/*
-        fprintf(file_amplitude, "%.15f\n", 1.0e-15*powf((i-5),3.0));        
-        fprintf(file_phase, "%.2f\n", -90.0);
-        
-        fprintf(file_L_s, "%.15f\n", 1.0e12*powf((i-5),3.0));
-        fprintf(file_C_s, "%.15f\n", -110.0);
-        fprintf(file_R_s, "%.15f\n", 90.0);
-
-        fprintf(file_L_p, "%.15f\n", 100.0);
-        fprintf(file_C_p, "%.15f\n", 80.0);
-        fprintf(file_R_p, "%.15f\n", 99.0);
-
-        fprintf(file_Q, "%.15f\n", -95.0);
-        fprintf(file_D, "%.15f\n", -1000.0);
-
-        fprintf(file_X_s, "%.15f\n", 1100.0);
-        fprintf(file_G_p, "%.15f\n", 1200.0);
-        fprintf(file_B_p, "%.15f\n", 1300.0);
-
-        fprintf(file_Y_abs, "%.15f\n", 1400.0);
-        fprintf(file_PhaseY, "%.15f\n", 1500.0);*/
-          
-        
-        
-      
     }
 
-
-    /** Closing files */
-    fclose(file_frequency);
-    
-    fclose(file_amplitude);
-    fclose(file_phase);
-
-    fclose(file_L_s);
-    fclose(file_C_s);
-    fclose(file_R_s);
-
-    fclose(file_L_p);
-    fclose(file_C_p);
-    fclose(file_R_p);
-
-    fclose(file_Q);
-    fclose(file_D);
-    
-    fclose(file_X_s);
-    fclose(file_G_p);
-    fclose(file_B_p);
-    
-    fclose(file_Y_abs);
-    fclose(file_PhaseY);
-    
-    
-    
-
     /** All's well that ends well. */
     return 1;
 
@@ -1366,113 +1161,26 @@ int LCR_data_analysis(float **s,
                       float complex *Z,
                       double w_out,
                       int f) {
-    int i2, i3;
-    float **U_acq = create_2D_table_size(SIGNALS_NUM, SIGNAL_LENGTH);
-    /* Used for storing the Voltage and current on the load */
-    float *U_dut = create_table_size( SIGNAL_LENGTH );
-    float *I_dut = create_table_size( SIGNAL_LENGTH );
-    /* Signals multiplied by the reference signal (sin) */
-    float *U_dut_sampled_X = (float *) malloc( size * sizeof( float ) );
-    float *U_dut_sampled_Y = (float *) malloc( size * sizeof( float ) );
-    float *I_dut_sampled_X = (float *) malloc( size * sizeof( float ) );
-    float *I_dut_sampled_Y = (float *) malloc( size * sizeof( float ) );
-    /* Signals return by trapezoidal method in complex */
-    float *X_component_lock_in_1 = (float *) malloc( size * sizeof( float ) );
-    float *X_component_lock_in_2 = (float *) malloc( size * sizeof( float ) );
-    float *Y_component_lock_in_1 = (float *) malloc( size * sizeof( float ) );
-    float *Y_component_lock_in_2 = (float *) malloc( size * sizeof( float ) );
-    /* Voltage, current and their phases calculated */
-    float U_dut_amp;
-    float Phase_U_dut_amp;
-    float I_dut_amp;
-    float Phase_I_dut_amp;
-    float Phase_Z_rad;
-    float Z_amp;
-    //float Z_phase_deg_imag;  // may cuse errors because not complex
-    float T; // Sampling time in seconds
-    float *t = create_table_size(16384);
-
-    T = ( g_dec[ f ] / 125e6 );
-    //printf("T = %f;\n",T );
-
-    for( i2 = 0; i2 < ( size - 1 ); i2++ ) {
-        t[ i2 ] = i2;
-    }
-
-    /* Transform signals from  AD - 14 bit to voltage [ ( s / 2^14 ) * 2 ] */
-    for ( i2 = 0; i2 < SIGNALS_NUM; i2++) { // only the 1 and 2 are used for i2
-        for( i3 = 0; i3 < size; i3 ++ ) {
-            //division comes after multiplication, this way no accuracy is lost
-            U_acq[i2][i3] = ( ( s[ i2 ][ i3 ] ) * (float)( 2 ) ) / (float)16384 ;
-            /*printf("%f\n",U_acq[i2][i3]);*/
-        }
-    }
-
-        int i;
-        float sum_buff_in1;
-        float sum_buff_in2;
-
-        for(i = 0; i < size; i++){
-
-        sum_buff_in1 += U_acq[1][i];
-        sum_buff_in2 += U_acq[2][i];
-               
-        }
-        float mean_buff_in1=sum_buff_in1/size;
-        float mean_buff_in2=sum_buff_in2/size;
-
-      
-    /* Voltage and current on the load can be calculated from gathered data */
-    for (i2 = 0; i2 < size; i2++) {
-        U_dut[ i2 ] = (((U_acq[ 1 ][ i2 ])- mean_buff_in1) - ((U_acq[ 2 ][ i2 ])- mean_buff_in2)); // potencial difference gives the voltage
-        // Curent trough the load is the same as trough thr R_shunt. ohm's law is used to calculate the current
-        I_dut[ i2 ] = (((U_acq[ 2 ][ i2 ])- mean_buff_in2) / R_shunt);
-    }
-
-    /* Acquired signals must be multiplied by the reference signals, used for lock in metod */
-    float ang;
-    for( i2 = 0; i2 < size; i2++) {
-        ang = (i2 * T * w_out);
-        //printf("ang(%d) = %f \n", (i2+1), ang);
-        U_dut_sampled_X[ i2 ] = U_dut[ i2 ] * sin( ang );
-        U_dut_sampled_Y[ i2 ] = U_dut[ i2 ] * sin( ang+ ( M_PI/2 ) );
-
-        I_dut_sampled_X[ i2 ] = I_dut[ i2 ] * sin( ang );
-        I_dut_sampled_Y[ i2 ] = I_dut[ i2 ] * sin( ang +( M_PI/2 ) );
+    /* Voltage amplitudes and phases fitted to both channels */
+    rp_sine_fit_t U1_fit;
+    rp_sine_fit_t U2_fit;
+
+    /* Both channels are in ADC counts, the conversion to voltage cancels out
+     * in the impedance, which is a ratio of the two */
+    if (rp_AcqSineFit(s[1], s[2], size, 125e6 / g_dec[f], w_out / (2 * M_PI), false,
+                      &U1_fit, &U2_fit) != RP_OK) {
+        return -1;
     }
+    float complex U1 = U1_fit.amplitude * cexpf( I * U1_fit.phase );
+    float complex U2 = U2_fit.amplitude * cexpf( I * U2_fit.phase );
 
-    /* Trapezoidal method for calculating the approximation of an integral */
-    X_component_lock_in_1[ 1 ] = trapz( U_dut_sampled_X, (float)T, size );
-    Y_component_lock_in_1[ 1 ] = trapz( U_dut_sampled_Y, (float)T, size );
-
-    X_component_lock_in_2[ 1 ] = trapz( I_dut_sampled_X, (float)T, size );
-    Y_component_lock_in_2[ 1 ] = trapz( I_dut_sampled_Y, (float)T, size );
-
-    /* Calculating voltage amplitude and phase */
-    U_dut_amp = (float)2 * (sqrtf( powf( X_component_lock_in_1[ 1 ] , (float)2 ) + powf( Y_component_lock_in_1[ 1 ] , (float)2 )));
-    Phase_U_dut_amp = atan2f( Y_component_lock_in_1[ 1 ], X_component_lock_in_1[ 1 ] );
-
-    /* Calculating current amplitude and phase */
-    I_dut_amp = (float)2 * (sqrtf( powf( X_component_lock_in_2[ 1 ], (float)2 ) + powf( Y_component_lock_in_2[ 1 ] , (float)2 ) ) );
-    Phase_I_dut_amp = atan2f( Y_component_lock_in_2[1], X_component_lock_in_2[1] );
-
-    /* Asigning impedance  values (complex value) */
-    Phase_Z_rad =  Phase_U_dut_amp - Phase_I_dut_amp;
-    Z_amp = U_dut_amp / I_dut_amp; // forming resistance
-
-
-    /* Phase has to be limited between 180 and -180 deg. */
-    if (Phase_Z_rad <=  (-M_PI) ) {
-        Phase_Z_rad = Phase_Z_rad +(2*M_PI);
-    }
-    else if ( Phase_Z_rad >= M_PI ) {
-        Phase_Z_rad = Phase_Z_rad -(2*M_PI) ;
-    }
-    else {
-        Phase_Z_rad = Phase_Z_rad;
-    }
+    /* Voltage on the load is the potential difference, the current trough the
+     * load is the same as trough the R_shunt (ohm's law). Offsets are fitted
+     * separately and do not enter the phasors. */
+    float complex U_dut = U1 - U2;
+    float complex I_dut = U2 / (float)R_shunt;
 
-    *Z =  ( ( Z_amp ) * cosf( Phase_Z_rad ) )  +  ( ( Z_amp ) * sinf( Phase_Z_rad ) ) * I; // R + jX
+    *Z = U_dut / I_dut; // R + jX
 
     return 1;
 }
@@ -0,0 +1,211 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya SPI transfer test.
+ *
+ * Runs the librp SPI functions against a fake spidev: the device is a
+ * plain temporary file and the ioctl() calls librp makes on it are served
+ * here, answering every byte with its complement. Checks that a transfer
+ * is one message with the segments as given, that transfers over the
+ * message limits are refused without sending anything, and that the
+ * settings are only written when they change. Needs neither a board nor
+ * an SPI device.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/spi/spidev.h>
+
+#include "redpitaya/rp.h"
+
+/* Limits of one message, see rp_SpiTransfer() */
+#define MAX_SEGMENTS    128
+#define MAX_BYTES       4096
+
+static char path[] = "/tmp/spiTestXXXXXX";
+static dev_t fake_dev;
+static ino_t fake_ino;
+static int failed = 0;
+
+/* What the fake device was asked to do */
+static struct {
+    int settings;
+    int messages;
+    int segments;
+    int cs_changes;
+    uint32_t speed;
+    bool fail;
+} fake;
+
+static void check(const char *what, int ok)
+{
+    printf("%s: %s\n", ok ? "PASS" : "FAIL", what);
+    if (!ok) {
+        failed++;
+    }
+}
+
+static bool isFake(int fd)
+{
+    struct stat st;
+    return fstat(fd, &st) == 0 && st.st_dev == fake_dev && st.st_ino == fake_ino;
+}
+
+/* Takes the place of the C library one, librp calls it through its PLT */
+int ioctl(int fd, unsigned long request, ...)
+{
+    va_list ap;
+    va_start(ap, request);
+    void *arg = va_arg(ap, void *);
+    va_end(ap);
+
+    if (!isFake(fd)) {
+        return syscall(SYS_ioctl, fd, request, arg);
+    }
+    if (request == SPI_IOC_WR_MODE || request == SPI_IOC_WR_BITS_PER_WORD) {
+        fake.settings++;
+        return 0;
+    }
+    if (request == SPI_IOC_WR_MAX_SPEED_HZ) {
+        fake.settings++;
+        fake.speed = *(uint32_t *)arg;
+        return 0;
+    }
+    if (_IOC_TYPE(request) == SPI_IOC_MAGIC && _IOC_NR(request) == 0 && _IOC_DIR(request) == _IOC_WRITE) {
+        struct spi_ioc_transfer *msg = arg;
+        int n = _IOC_SIZE(request) / sizeof(struct spi_ioc_transfer);
+        if (fake.fail) {
+            return -1;
+        }
+        fake.messages++;
+        for (int i = 0; i < n; i++) {
+            const uint8_t *tx = (const uint8_t *)(uintptr_t)msg[i].tx_buf;
+            uint8_t *rx = (uint8_t *)(uintptr_t)msg[i].rx_buf;
+            for (uint32_t b = 0; b < msg[i].len && rx; b++) {
+                rx[b] = tx ? ~tx[b] : 0xFF;
+            }
+            fake.segments++;
+            fake.cs_changes += msg[i].cs_change;
+        }
+        return n;
+    }
+    return -1;
+}
+
+static void reset()
+{
+    memset(&fake, 0, sizeof(fake));
+}
+
+static void testSettings()
+{
+    uint8_t tx = 0x5A, rx = 0;
+    rp_spi_xfer_t x = { &tx, &rx, 1, 0, 0 };
+
+    reset();
+    check("settings: first transfer", rp_SpiTransfer(&x, 1) == RP_OK);
+    check("settings: written to the new device", fake.settings == 3);
+    check("settings: answer", rx == 0xA5);
+    reset();
+    rp_SpiTransfer(&x, 1);
+    check("settings: not written again", fake.settings == 0);
+    rp_SpiSetSpeed(2000000);
+    rp_SpiTransfer(&x, 1);
+    check("settings: written after a change", fake.settings == 3 && fake.speed == 2000000);
+}
+
+static void testSegments()
+{
+    uint8_t tx[3][4] = { { 1, 2, 3, 4 }, { 5, 6 }, { 7 } };
+    uint8_t rx[3][4];
+    rp_spi_xfer_t x[3] = {
+        { tx[0], rx[0], 4, 0, 0 },
+        { tx[1], rx[1], 2, 10, 1 },
+        { tx[2], rx[2], 1, 0, 0 }
+    };
+
+    reset();
+    memset(rx, 0, sizeof(rx));
+    check("segments: transfer", rp_SpiTransfer(x, 3) == RP_OK);
+    check("segments: one message", fake.messages == 1 && fake.segments == 3);
+    check("segments: chip select released where asked", fake.cs_changes == 1);
+    check("segments: answers", rx[0][3] == (uint8_t)~4 && rx[1][1] == (uint8_t)~6 && rx[2][0] == (uint8_t)~7);
+}
+
+static void testLimits()
+{
+    static uint8_t tx[MAX_BYTES + 1], rx[MAX_BYTES + 1];
+    static rp_spi_xfer_t x[MAX_SEGMENTS + 1];
+
+    for (int i = 0; i <= MAX_SEGMENTS; i++) {
+        x[i] = (rp_spi_xfer_t){ &tx[i], &rx[i], 1, 0, 0 };
+    }
+    reset();
+    check("limits: most segments", rp_SpiTransfer(x, MAX_SEGMENTS) == RP_OK);
+    check("limits: most segments in one message", fake.messages == 1 && fake.segments == MAX_SEGMENTS);
+    reset();
+    check("limits: too many segments refused", rp_SpiTransfer(x, MAX_SEGMENTS + 1) == RP_EOOR);
+    check("limits: nothing sent", fake.messages == 0);
+
+    x[0] = (rp_spi_xfer_t){ tx, rx, MAX_BYTES, 0, 0 };
+    reset();
+    check("limits: most bytes", rp_SpiTransfer(x, 1) == RP_OK && fake.messages == 1);
+    x[0].len = MAX_BYTES - 1;
+    x[1] = (rp_spi_xfer_t){ tx, rx, 2, 0, 0 };
+    reset();
+    check("limits: too many bytes refused", rp_SpiTransfer(x, 2) == RP_EOOR);
+    check("limits: nothing sent for the bytes", fake.messages == 0);
+}
+
+static void testErrors()
+{
+    uint8_t tx = 1;
+    rp_spi_xfer_t x = { &tx, NULL, 1, 0, 0 };
+
+    check("errors: no segments", rp_SpiTransfer(&x, 0) == RP_OK);
+    check("errors: no buffer", rp_SpiTransfer(NULL, 1) == RP_UIA);
+    reset();
+    fake.fail = true;
+    check("errors: driver failure", rp_SpiTransfer(&x, 1) == RP_EFWB);
+}
+
+int main(int argc, char **argv)
+{
+    struct stat st;
+
+    int fd = mkstemp(path);
+    if (fd < 0 || fstat(fd, &st) < 0) {
+        perror(path);
+        return 1;
+    }
+    close(fd);
+    fake_dev = st.st_dev;
+    fake_ino = st.st_ino;
+
+    check("device", rp_SpiSetDevice(path) == RP_OK);
+    testSettings();
+    testSegments();
+    testLimits();
+    testErrors();
+
+    rp_SpiRelease();
+    unlink(path);
+
+    printf("%s\n", failed ? "FAILED" : "OK");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,131 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya Teslameter LED field indicator test.
+ *
+ * Builds the indicator of apps-free/teslameter and runs it on the
+ * simulated backend, where rp_LEDGetState() reads back the LEDs. Checks
+ * the level thresholds, the LED lit for each level, that the register is
+ * only written when the level changes, and that shutting the indicator
+ * down leaves a calibration written before the high gain offsets as it
+ * was. Run it with RP_SIMULATE=1 on a PC or on the board.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "redpitaya/rp.h"
+#include "hw_monitor.h"
+
+#define STORE_OFFSET    0x08
+
+static char path[] = "/tmp/hwMonitorTestXXXXXX";
+static int failed = 0;
+
+static void check(const char *what, int ok)
+{
+    printf("%s: %s\n", ok ? "PASS" : "FAIL", what);
+    if (!ok) {
+        failed++;
+    }
+}
+
+static uint32_t leds()
+{
+    uint32_t state = 0xFFFFFFFF;
+    rp_LEDGetState(&state);
+    return state;
+}
+
+static size_t readFile(uint8_t *buf, size_t len)
+{
+    int fd = open(path, O_RDONLY);
+    ssize_t size = fd < 0 ? -1 : pread(fd, buf, len, 0);
+    close(fd);
+    return size < 0 ? 0 : size;
+}
+
+static void testLevels()
+{
+    check("level: none", hw_monitor_level(0) == 0);
+    check("level: negative", hw_monitor_level(-1) == 0);
+    check("level: at the first threshold", hw_monitor_level(0.1) == 0);
+    check("level: above the first threshold", hw_monitor_level(0.11) == 1);
+    check("level: between thresholds", hw_monitor_level(0.6) == 3);
+    check("level: at the last threshold", hw_monitor_level(1.0) == HW_MONITOR_LEDS - 2);
+    check("level: full scale", hw_monitor_level(1.5) == HW_MONITOR_LEDS - 1);
+}
+
+static void testLeds()
+{
+    hw_monitor_update(0.2);
+    check("leds: level 1", leds() == 1 << 1);
+    hw_monitor_update(1.2);
+    check("leds: top level", leds() == 1 << (HW_MONITOR_LEDS - 1));
+    hw_monitor_update(0);
+    check("leds: level 0", leds() == 1);
+
+    // Only a level change writes the register
+    rp_LEDSetState(0x55);
+    hw_monitor_update(0.05);
+    check("leds: same level not written", leds() == 0x55);
+    hw_monitor_update(0.4);
+    check("leds: level change written", leds() == 1 << 2);
+}
+
+int main(int argc, char **argv)
+{
+    uint8_t before[256], after[256];
+    size_t before_len, after_len;
+
+    // Calibration written before the high gain offsets existed
+    rp_calib_params_t params;
+    memset(&params, 0, sizeof(params));
+    params.fe_ch1_lo_offs = 10;
+    params.fe_ch2_lo_offs = 20;
+    params.fe_ch1_hi_offs = params.fe_ch2_hi_offs = 0x7777;
+    int fd = mkstemp(path);
+    if (fd < 0 || pwrite(fd, &params, sizeof(params), STORE_OFFSET) != sizeof(params)) {
+        perror(path);
+        return 1;
+    }
+    close(fd);
+    before_len = readFile(before, sizeof(before));
+
+    testLevels();
+
+    // Not initialised, nothing is written
+    hw_monitor_update(0.5);
+
+    check("init", hw_monitor_init() == 0);
+    check("init: store", rp_CalibrationSetStore(path, STORE_OFFSET) == RP_OK);
+    rp_calib_params_t read = rp_GetCalibrationSettings();
+    check("init: calibration read", read.fe_ch1_lo_offs == 10 && read.fe_ch1_hi_offs == 10);
+    check("init: leds untouched", leds() == 0);
+
+    testLeds();
+
+    hw_monitor_exit();
+    after_len = readFile(after, sizeof(after));
+    check("exit: calibration not rewritten",
+          after_len == before_len && memcmp(before, after, before_len) == 0);
+    // Released, nothing is written
+    hw_monitor_update(1.5);
+
+    unlink(path);
+
+    printf("%s\n", failed ? "FAILED" : "OK");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,231 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya UART receive service test.
+ *
+ * Runs the librp UART service on the slave side of a pty pair and writes
+ * the test data to the master side, so it needs neither a board nor a
+ * loopback cable. Covers the delimiter and length prefix framing,
+ * truncation, the ring wrap-around and frames dropped to a full ring.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <time.h>
+#include <pty.h>
+
+#include "redpitaya/rp.h"
+
+/* Longest wait for a frame [ms] */
+#define FRAME_TIMEOUT_MS    1000
+
+static int master = -1;
+static char slave_name[64];
+static int failed = 0;
+
+static void check(const char *what, int ok)
+{
+    printf("%s: %s\n", ok ? "PASS" : "FAIL", what);
+    if (!ok) {
+        failed++;
+    }
+}
+
+static void sleepMs(int ms)
+{
+    struct timespec t = { ms / 1000, (ms % 1000) * 1000000L };
+    nanosleep(&t, NULL);
+}
+
+static void send(const void *data, size_t len)
+{
+    if (write(master, data, len) != len) {
+        perror("write");
+        exit(1);
+    }
+}
+
+static int openService(rp_uart_framing_t framing, uint32_t max_frame, uint32_t ring_size)
+{
+    rp_uart_cfg_t cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.baud = 115200;
+    cfg.framing = framing;
+    cfg.delimiter = '\n';
+    cfg.max_frame = max_frame;
+    cfg.ring_size = ring_size;
+    return rp_UartOpen(slave_name, &cfg);
+}
+
+/* Waits for the next frame, copies it and consumes it */
+static int nextFrame(rp_uart_frame_t *frame, uint8_t *buf)
+{
+    for (int t = 0; t < FRAME_TIMEOUT_MS; t++) {
+        bool ready;
+        if (rp_UartPeek(frame, &ready) != RP_OK) {
+            return 0;
+        }
+        if (ready) {
+            memcpy(buf, frame->data, frame->len);
+            frame->data = buf;
+            return rp_UartConsume() == RP_OK;
+        }
+        sleepMs(1);
+    }
+    return 0;
+}
+
+static int isFrame(const rp_uart_frame_t *frame, const void *data, uint32_t len, uint16_t flags)
+{
+    return frame->len == len && frame->flags == flags && memcmp(frame->data, data, len) == 0;
+}
+
+static void testDelimiter()
+{
+    rp_uart_frame_t f;
+    uint8_t buf[4096];
+
+    check("delimiter: open", openService(RP_UART_FRAME_DELIM, 8, 0) == RP_OK);
+    send("abc\n", 4);
+    check("delimiter: frame", nextFrame(&f, buf) && isFrame(&f, "abc\n", 4, 0));
+    check("delimiter: time", f.time_ns != 0);
+    send("0123456789\n", 11);
+    check("delimiter: truncated at max_frame",
+          nextFrame(&f, buf) && isFrame(&f, "01234567", 8, RP_UART_F_TRUNCATED));
+    check("delimiter: rest of the line", nextFrame(&f, buf) && isFrame(&f, "89\n", 3, 0));
+    send("\n", 1);
+    check("delimiter: delimiter only", nextFrame(&f, buf) && isFrame(&f, "\n", 1, 0));
+    rp_UartClose();
+}
+
+static void testLength8()
+{
+    static const uint8_t data[] = { 3, 'x', 'y', 'z', 0, 2, 'a', 'b', 12, 'l', 'o', 'n', 'g', 'e', 'r', ' ', 'f', 'r', 'a', 'm', 'e' };
+    rp_uart_frame_t f;
+    uint8_t buf[4096];
+
+    check("8 bit length: open", openService(RP_UART_FRAME_LEN8, 8, 0) == RP_OK);
+    send(data, sizeof(data));
+    check("8 bit length: frame", nextFrame(&f, buf) && isFrame(&f, "xyz", 3, 0));
+    check("8 bit length: zero length frame", nextFrame(&f, buf) && isFrame(&f, "", 0, 0));
+    check("8 bit length: frame after the empty one", nextFrame(&f, buf) && isFrame(&f, "ab", 2, 0));
+    check("8 bit length: truncated at max_frame",
+          nextFrame(&f, buf) && isFrame(&f, "longer f", 8, RP_UART_F_TRUNCATED));
+    send("\x01!", 2);
+    check("8 bit length: framing kept after truncation", nextFrame(&f, buf) && isFrame(&f, "!", 1, 0));
+    rp_UartClose();
+}
+
+static void testLength16()
+{
+    uint8_t data[2 + 300 + 2 + 2 + 1];
+    uint8_t payload[300];
+    rp_uart_frame_t f;
+    uint8_t buf[4096];
+
+    for (int i = 0; i < sizeof(payload); i++) {
+        payload[i] = i * 7;
+    }
+    // Most significant length byte first
+    data[0] = sizeof(payload) >> 8;
+    data[1] = sizeof(payload) & 0xFF;
+    memcpy(data + 2, payload, sizeof(payload));
+    data[302] = 0;
+    data[303] = 0;
+    data[304] = 0;
+    data[305] = 1;
+    data[306] = 'q';
+
+    check("16 bit length: open", openService(RP_UART_FRAME_LEN16, 0, 0) == RP_OK);
+    send(data, sizeof(data));
+    check("16 bit length: frame over 255 bytes",
+          nextFrame(&f, buf) && isFrame(&f, payload, sizeof(payload), 0));
+    check("16 bit length: zero length frame", nextFrame(&f, buf) && isFrame(&f, "", 0, 0));
+    check("16 bit length: frame after the empty one", nextFrame(&f, buf) && isFrame(&f, "q", 1, 0));
+    rp_UartClose();
+}
+
+/* A 50 byte frame takes 80 bytes of a 256 byte ring, the fourth one in a
+ * row does not fit before the end and goes behind a wrap marker */
+static void testWrap()
+{
+    uint8_t data[51];
+    rp_uart_frame_t f;
+    uint8_t buf[4096];
+    int ok = 1;
+
+    check("wrap: open", openService(RP_UART_FRAME_LEN8, 64, 256) == RP_OK);
+    data[0] = 50;
+    for (int n = 0; n < 20 && ok; n++) {
+        memset(data + 1, 'A' + n, 50);
+        send(data, sizeof(data));
+        ok = nextFrame(&f, buf) && isFrame(&f, data + 1, 50, 0) && f.dropped == 0;
+    }
+    check("wrap: frames across the ring end", ok);
+    rp_UartClose();
+}
+
+/* Three 50 byte frames fill the ring, the other seven are dropped and
+ * reported with the next frame that fits */
+static void testOverflow()
+{
+    uint8_t data[51 * 10];
+    rp_uart_frame_t f;
+    uint8_t buf[4096];
+    int ok = 1;
+
+    check("overflow: open", openService(RP_UART_FRAME_LEN8, 64, 256) == RP_OK);
+    for (int n = 0; n < 10; n++) {
+        data[51 * n] = 50;
+        memset(data + 51 * n + 1, 'a' + n, 50);
+    }
+    send(data, sizeof(data));
+    // Let the reader take all of it before anything is consumed
+    sleepMs(200);
+    for (int n = 0; n < 3 && ok; n++) {
+        ok = nextFrame(&f, buf) && isFrame(&f, data + 51 * n + 1, 50, 0) && f.dropped == 0;
+    }
+    check("overflow: frames that fit", ok);
+
+    bool ready = true;
+    check("overflow: nothing else kept", rp_UartPeek(&f, &ready) == RP_OK && !ready);
+    send("\x02ok", 3);
+    check("overflow: next frame", nextFrame(&f, buf) && isFrame(&f, "ok", 2, 0));
+    check("overflow: dropped frames reported", f.dropped == 7);
+    send("\x02ok", 3);
+    check("overflow: dropped count reset", nextFrame(&f, buf) && f.dropped == 0);
+    rp_UartClose();
+}
+
+int main(int argc, char **argv)
+{
+    int slave;
+
+    if (openpty(&master, &slave, slave_name, NULL, NULL) < 0) {
+        perror("openpty");
+        return 1;
+    }
+
+    testDelimiter();
+    testLength8();
+    testLength16();
+    testWrap();
+    testOverflow();
+
+    close(slave);
+    close(master);
+
+    printf("%s\n", failed ? "FAILED" : "OK");
+    return failed ? 1 : 0;
+}
@@ -23,6 +23,7 @@ extern "C" {
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 #define ADC_BUFFER_SIZE             (16*1024)
 
@@ -77,6 +78,8 @@ extern "C" {
 #define RP_EFRB   21
 /** Failed to write to the bus */
 #define RP_EFWB   22
+/** Timeout */
+#define RP_ETMO   23
 
 #define SPECTR_OUT_SIG_LEN (2*1024)
 
@@ -246,6 +249,248 @@ typedef struct {
     int32_t  fe_ch2_hi_offs; //!< Front end DC offset, channel B
 } rp_calib_params_t;
 
+/**
+ * How the calibration sampler reduces the samples of all its buffers,
+ * see rp_CalibrationSetSampling()
+ */
+typedef enum {
+    RP_CALIB_MEAN,          //!< Mean
+    RP_CALIB_MEDIAN,        //!< Median
+    RP_CALIB_TRIMMED        //!< Mean without the lowest and the highest tenth
+} rp_calib_reduce_t;
+
+/** Number of latency histogram buckets, see rp_StatsBucketNs() */
+#define RP_STATS_BUCKETS    144
+
+/**
+ * Call statistics of one library function
+ */
+typedef struct {
+    const char *name;       //!< Function name
+    uint64_t calls;         //!< Number of calls
+    uint64_t total_ns;      //!< Sum of call durations
+    uint64_t max_ns;        //!< Longest call
+    uint64_t mmio;          //!< FPGA register reads and writes made by the calls
+    uint64_t buckets[RP_STATS_BUCKETS]; //!< Latency histogram
+} rp_stats_t;
+
+/**
+ * Result of a sine fit, the signal is offset + amplitude * cos(2*pi*frequency*t + phase)
+ */
+typedef struct {
+    double amplitude;       //!< Amplitude in input units
+    double phase;           //!< Phase at the first sample in radians
+    double offset;          //!< DC offset in input units
+    double frequency;       //!< Frequency in Hz, fitted or as given
+    double residual_rms;    //!< RMS of the fit residual (noise and distortion)
+    double sinad;           //!< Signal to noise and distortion ratio in dB
+    double enob;            //!< Effective number of bits, (sinad - 1.76) / 6.02
+} rp_sine_fit_t;
+
+/**
+ * Mask test counters, see rp_AcqMaskGetStats()
+ */
+typedef struct {
+    uint64_t tested;        //!< Captures tested
+    uint64_t passed;        //!< Captures within the masks of all channels
+    uint64_t failed;        //!< Captures with at least one violating sample
+    uint64_t violations;    //!< Violating samples of all captures
+    int32_t fail_channel;   //!< First failing channel of the last failed capture, -1 if none
+    int32_t fail_first;     //!< Mask index of its first violating sample, -1 if none
+    int32_t fail_last;      //!< Mask index of its last violating sample, -1 if none
+    bool running;           //!< Whether the background test runs
+} rp_mask_stats_t;
+
+/**
+ * Autoscale result, see rp_AcqAutoScale()
+ */
+typedef struct {
+    bool signal;                        //!< Whether a channel swings above the noise
+    rp_channel_t channel;               //!< Channel with the larger swing, the settings follow it
+    float period;                       //!< Dominant period of the channel in seconds, 0 if not found
+    float time_span;                    //!< Time to show after the trigger in seconds
+    rp_acq_decimation_t decimation;     //!< Lowest decimation that covers time_span after the trigger
+    rp_acq_trig_src_t trigger_source;   //!< Positive edge of the channel, RP_TRIG_SRC_NOW without a signal
+    float trigger_level;                //!< Midpoint of the channel in volts
+    float min[2];                       //!< Minimum of each channel in volts
+    float max[2];                       //!< Maximum of each channel in volts
+    rp_pinState_t gain[2];              //!< Input range (jumper setting) that suits each channel
+    uint32_t captures;                  //!< Captures made, 1 or 2
+} rp_auto_scale_t;
+
+/**
+ * Serial protocols of the decoder, see rp_AcqDecode()
+ */
+typedef enum {
+    RP_DECODE_UART,     //!< Asynchronous serial on the data channel
+    RP_DECODE_I2C,      //!< SDA on the data channel, SCL on the other one
+    RP_DECODE_SPI       //!< MOSI or MISO on the data channel, SCK on the other one
+} rp_decode_protocol_t;
+
+/**
+ * UART parity
+ */
+typedef enum {
+    RP_DECODE_PARITY_NONE,  //!< No parity bit
+    RP_DECODE_PARITY_EVEN,  //!< Even parity
+    RP_DECODE_PARITY_ODD    //!< Odd parity
+} rp_decode_parity_t;
+
+/**
+ * Decoder settings
+ */
+typedef struct {
+    rp_decode_protocol_t protocol;  //!< Protocol
+    rp_channel_t channel;           //!< Data channel, the clock (SCL, SCK) is on the other one
+    float level[2];                 //!< Logic threshold of each channel in volts
+    float hyst[2];                  //!< Hysteresis of each channel in volts, centred on the threshold
+    uint32_t baud;                  //!< UART bit rate, 0 to estimate it from the pulse widths
+    uint8_t data_bits;              //!< UART data bits (5 to 9), SPI word bits (1 to 16), 0 for 8
+    rp_decode_parity_t parity;      //!< UART parity
+    bool invert;                    //!< UART idle low, e.g. RS-232 levels without a transceiver
+    uint8_t spi_mode;               //!< SPI mode 0 to 3 (CPOL * 2 + CPHA)
+    bool lsb_first;                 //!< SPI bit order
+} rp_decode_cfg_t;
+
+/** @name Decoder event flags
+ */
+///@{
+/** I2C start or repeated start condition, no data */
+#define RP_DECODE_F_START       0x01
+/** I2C stop condition, no data */
+#define RP_DECODE_F_STOP        0x02
+/** I2C address byte, the first after a start */
+#define RP_DECODE_F_ADDRESS     0x04
+/** I2C byte not acknowledged */
+#define RP_DECODE_F_NACK        0x08
+/** UART parity error */
+#define RP_DECODE_F_PARITY_ERR  0x10
+/** UART stop bit not at the idle level */
+#define RP_DECODE_F_FRAME_ERR   0x20
+/** UART line active over the whole frame */
+#define RP_DECODE_F_BREAK       0x40
+/** Word cut short by a start, stop or clock pause, or by the end of data */
+#define RP_DECODE_F_PARTIAL     0x80
+///@}
+
+/**
+ * Decoded byte, word or condition
+ */
+typedef struct {
+    uint32_t time;      //!< First sample of the event, from the first decoded sample
+    uint16_t data;      //!< Byte or word, LSB aligned, 0 for conditions
+    uint16_t flags;     //!< RP_DECODE_F_* flags
+} rp_decode_event_t;
+
+/**
+ * Impedance measurement settings, see rp_ImpMeasure(). The generator output drives the
+ * device under test in series with the shunt resistor, input 1 measures the generator
+ * side of the device and input 2 the voltage across the shunt.
+ */
+typedef struct {
+    rp_channel_t channel;   //!< Generator output that drives the device
+    float amplitude;        //!< Sine amplitude in volts
+    float dc_bias;          //!< DC bias in volts
+    float r_shunt;          //!< Shunt resistance in ohms
+    uint32_t averaging;     //!< Captures averaged into each point, 0 for 1
+    uint32_t periods;       //!< Least periods per capture, 0 for 8
+} rp_imp_cfg_t;
+
+/**
+ * Impedance results as a structure of arrays, one element per point, see rp_ImpDerive().
+ * Any array may be NULL if the quantity is not needed.
+ */
+typedef struct {
+    float* frequency;       //!< Frequency in Hz
+    float* z_abs;           //!< |Z| in ohms
+    float* z_phase;         //!< Phase of Z in degrees
+    float* y_abs;           //!< |Y| in siemens
+    float* y_phase;         //!< Phase of Y in degrees
+    float* r_s;             //!< Series resistance in ohms
+    float* x_s;             //!< Series reactance in ohms
+    float* g_p;             //!< Parallel conductance in siemens
+    float* b_p;             //!< Parallel susceptance in siemens
+    float* c_s;             //!< Series capacitance in farads
+    float* c_p;             //!< Parallel capacitance in farads
+    float* l_s;             //!< Series inductance in henries
+    float* l_p;             //!< Parallel inductance in henries
+    float* r_p;             //!< Parallel resistance in ohms
+    float* q;               //!< Quality factor
+    float* d;               //!< Dissipation factor
+} rp_imp_result_t;
+
+/**
+ * SPI clock polarity and phase, see rp_SpiSetMode()
+ */
+typedef enum {
+    RP_SPI_MODE_0,          //!< Clock idles low, data sampled on the rising edge
+    RP_SPI_MODE_1,          //!< Clock idles low, data sampled on the falling edge
+    RP_SPI_MODE_2,          //!< Clock idles high, data sampled on the falling edge
+    RP_SPI_MODE_3           //!< Clock idles high, data sampled on the rising edge
+} rp_spi_mode_t;
+
+/**
+ * One segment of an SPI transfer, see rp_SpiTransfer()
+ */
+typedef struct {
+    const uint8_t* tx;      //!< Data to send, NULL sends zeros
+    uint8_t* rx;            //!< Received data, NULL to discard it
+    uint32_t len;           //!< Length of both buffers in bytes
+    uint16_t delay_us;      //!< Delay after the segment in microseconds
+    uint8_t cs_change;      //!< Releases the chip select after the segment
+} rp_spi_xfer_t;
+
+/** Message of an I2C transfer reads from the device, see rp_I2cTransfer() */
+#define RP_I2C_READ     0x0001
+
+/**
+ * One message of an I2C transfer, see rp_I2cTransfer()
+ */
+typedef struct {
+    uint16_t addr;          //!< 7 bit device address
+    uint16_t flags;         //!< RP_I2C_READ to read, 0 to write
+    uint16_t len;           //!< Length of the buffer in bytes
+    uint8_t* buf;           //!< Data to write or buffer to read into
+} rp_i2c_msg_t;
+
+/**
+ * How the UART service splits the received bytes into frames, see rp_UartOpen()
+ */
+typedef enum {
+    RP_UART_FRAME_NONE,     //!< Whatever one read returns
+    RP_UART_FRAME_DELIM,    //!< Up to and including the delimiter
+    RP_UART_FRAME_LEN8,     //!< One length byte, then as many data bytes
+    RP_UART_FRAME_LEN16     //!< Two length bytes, most significant first, then the data
+} rp_uart_framing_t;
+
+/**
+ * UART service settings, see rp_UartOpen()
+ */
+typedef struct {
+    uint32_t baud;                  //!< Bit rate, a standard rate from 1200 to 4000000
+    uint8_t data_bits;              //!< Data bits (5 to 8), 0 for 8
+    rp_decode_parity_t parity;      //!< Parity
+    uint8_t stop_bits;              //!< Stop bits (1 or 2), 0 for 1
+    rp_uart_framing_t framing;      //!< Framing of the received bytes
+    uint8_t delimiter;              //!< Last byte of a frame with RP_UART_FRAME_DELIM
+    uint32_t max_frame;             //!< Longest frame in bytes, 0 for 4096
+    uint32_t ring_size;             //!< Receive ring size in bytes, rounded up to a power of two, 0 for 64 KiB
+} rp_uart_cfg_t;
+
+/** Frame was cut at rp_uart_cfg_t::max_frame bytes */
+#define RP_UART_F_TRUNCATED     0x0001
+
+/**
+ * Received frame, it points into the receive ring, see rp_UartPeek()
+ */
+typedef struct {
+    const uint8_t* data;    //!< Data, valid until rp_UartConsume()
+    uint32_t len;           //!< Length of the data in bytes
+    uint16_t flags;         //!< RP_UART_F_* flags
+    uint32_t dropped;       //!< Frames lost to a full ring just before this one
+    uint64_t time_ns;       //!< CLOCK_MONOTONIC time of the read that completed the frame
+} rp_uart_frame_t;
+
 typedef struct wf_func_table_t {
     int (*rp_spectr_wf_init)();
     int (*rp_spectr_wf_clean)();
@@ -267,6 +512,16 @@ typedef struct wf_func_table_t {
  */
 int rp_Init();
 
+/**
+ * Initializes the library like rp_Init(), optionally without resetting the
+ * modules. Tools that only read the state or drive a few registers start
+ * faster without the reset, which also skips the calibration read.
+ * @param reset Reset the modules to their default settings.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_InitReset(bool reset);
+
 int rp_CalibInit();
 
 /**
@@ -285,6 +540,19 @@ int rp_Release();
 */
 int rp_Reset();
 
+/**
+ * Rereads the configuration registers from the FPGA. The library keeps a copy
+ * of all configuration registers and serves the getters from it, so changes
+ * made by another process, or directly through /dev/mem, are not seen by the
+ * getters until this is called. Status registers such as the trigger state and
+ * the write pointers are always read from the FPGA, and setters that change
+ * part of a register read it from the FPGA first, so they keep the other
+ * fields as they are.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_SyncFromHardware();
+
 /**
  * Retrieves the library version number
  * @return Library version
@@ -299,6 +567,48 @@ const char* rp_GetVersion();
 const char* rp_GetError(int errorCode);
 
 
+///@}
+/** @name Statistics
+ * Call counters and latency histograms of the acquisition and generation
+ * functions. Available only when the library is built with ENABLE_STATS=true,
+ * otherwise all functions return RP_EUF and nothing is recorded.
+ */
+///@{
+
+/**
+ * Gets the statistics of all instrumented functions.
+ * @param stats Array the statistics are written to, NULL to only query the count.
+ * @param count Array size on input, number of instrumented functions on output.
+ * @return If the function is successful, the return value is RP_OK.
+ * RP_BTS if the array is too small, RP_EUF if statistics are not compiled in.
+ */
+int rp_StatsGet(rp_stats_t *stats, uint32_t *count);
+
+/**
+ * Clears all counters and histograms.
+ * @return If the function is successful, the return value is RP_OK.
+ * RP_EUF if statistics are not compiled in.
+ */
+int rp_StatsReset();
+
+/**
+ * Writes the statistics of all called functions as a JSON object, keyed by
+ * function name, with call count, mean, 50th/90th/99th percentile and maximum
+ * duration in nanoseconds, and mean number of FPGA register accesses per call.
+ * @param buffer Destination of the NUL terminated JSON text.
+ * @param size Buffer size.
+ * @return If the function is successful, the return value is RP_OK.
+ * RP_BTS if the buffer is too small, RP_EUF if statistics are not compiled in.
+ */
+int rp_StatsJson(char *buffer, size_t size);
+
+/**
+ * Lower bound of a latency histogram bucket.
+ * @param index Bucket index, 0 to RP_STATS_BUCKETS - 1.
+ * @return Shortest call duration in nanoseconds counted in this bucket.
+ */
+uint64_t rp_StatsBucketNs(uint32_t index);
+
 ///@}
 /** @name Digital loop
 */
@@ -320,15 +630,17 @@ int rp_EnableDigitalLoop(bool enable);
 
 /**
 * Returns calibration settings.
-* These calibration settings are populated only once from EEPROM at rp_Init().
+* These calibration settings are read from EEPROM on first use after rp_Init().
 * Each rp_GetCalibrationSettings call returns the same cached setting values.
+* If the EEPROM can not be read the defaults are returned, while the calls
+* that convert with the calibration return the read error.
 * @return Calibration settings
 */
 rp_calib_params_t rp_GetCalibrationSettings();
 
 /**
 * Calibrates input channel offset. This input channel must be grounded to calibrate properly.
-* Calibration data is written to EPROM and repopulated so that rp_GetCalibrationSettings works properly.
+* Calibration data is kept until rp_CalibrationCommit() and repopulated so that rp_GetCalibrationSettings works properly.
 * @param channel Channel witch is going to be calibrated
 * @return If the function is successful, the return value is RP_OK.
 * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
@@ -338,7 +650,7 @@ int rp_CalibrateFrontEndOffset(rp_channel_t channel, rp_pinState_t gain, rp_cali
 /**
 * Calibrates input channel low voltage scale. Jumpers must be set to LV.
 * This input channel must be connected to stable positive source.
-* Calibration data is written to EPROM and repopulated so that rp_GetCalibrationSettings works properly.
+* Calibration data is kept until rp_CalibrationCommit() and repopulated so that rp_GetCalibrationSettings works properly.
 * @param channel Channel witch is going to be calibrated
 * @param referentialVoltage Voltage of the source.
 * @return If the function is successful, the return value is RP_OK.
@@ -349,7 +661,7 @@ int rp_CalibrateFrontEndScaleLV(rp_channel_t channel, float referentialVoltage,
 /**
 * Calibrates input channel high voltage scale. Jumpers must be set to HV.
 * This input channel must be connected to stable positive source.
-* Calibration data is written to EPROM and repopulated so that rp_GetCalibrationSettings works properly.
+* Calibration data is kept until rp_CalibrationCommit() and repopulated so that rp_GetCalibrationSettings works properly.
 * @param channel Channel witch is going to be calibrated
 * @param referentialVoltage Voltage of the source.
 * @return If the function is successful, the return value is RP_OK.
@@ -360,7 +672,7 @@ int rp_CalibrateFrontEndScaleHV(rp_channel_t channel, float referentialVoltage,
 /**
 * Calibrates output channel offset.
 * This input channel must be connected to calibrated input channel with came number (CH1 to CH1 and CH2 to CH2).
-* Calibration data is written to EPROM and repopulated so that rp_GetCalibrationSettings works properly.
+* Calibration data is kept until rp_CalibrationCommit() and repopulated so that rp_GetCalibrationSettings works properly.
 * @param channel Channel witch is going to be calibrated
 * @return If the function is successful, the return value is RP_OK.
 * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
@@ -370,7 +682,7 @@ int rp_CalibrateBackEndOffset(rp_channel_t channel);
 /**
 * Calibrates output channel voltage scale.
 * This input channel must be connected to calibrated input channel with came number (CH1 to CH1 and CH2 to CH2).
-* Calibration data is written to EPROM and repopulated so that rp_GetCalibrationSettings works properly.
+* Calibration data is kept until rp_CalibrationCommit() and repopulated so that rp_GetCalibrationSettings works properly.
 * @param channel Channel witch is going to be calibrated
 * @return If the function is successful, the return value is RP_OK.
 * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
@@ -380,16 +692,57 @@ int rp_CalibrateBackEndScale(rp_channel_t channel);
 /**
 * Calibrates output channel.
 * This input channel must be connected to calibrated input channel with came number (CH1 to CH1 and CH2 to CH2).
-* Calibration data is written to EPROM and repopulated so that rp_GetCalibrationSettings works properly.
+* Calibration data is kept until rp_CalibrationCommit() and repopulated so that rp_GetCalibrationSettings works properly.
 * @param channel Channel witch is going to be calibrated
 * @return If the function is successful, the return value is RP_OK.
 * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
 */
 int rp_CalibrateBackEnd(rp_channel_t channel, rp_calib_params_t* out_params);
 
+/**
+* Calibrates the offsets of both input channels from one capture. Both inputs must be grounded.
+* Calibration data is kept until rp_CalibrationCommit() and repopulated so that rp_GetCalibrationSettings works properly.
+* @param gain Jumper setting of both channels.
+* @param out_params If not NULL, receives the offsets instead of the EEPROM.
+* @return If the function is successful, the return value is RP_OK.
+* If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+*/
+int rp_CalibrateFrontEndOffsetBoth(rp_pinState_t gain, rp_calib_params_t* out_params);
+
+/**
+* Calibrates the low voltage scale of both input channels from one capture. Jumpers must be set to LV.
+* Both inputs must be connected to the same stable positive source.
+* Calibration data is kept until rp_CalibrationCommit() and repopulated so that rp_GetCalibrationSettings works properly.
+* @param referentialVoltage Voltage of the source.
+* @param out_params If not NULL, receives the scales instead of the EEPROM.
+* @return If the function is successful, the return value is RP_OK.
+* If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+*/
+int rp_CalibrateFrontEndScaleLVBoth(float referentialVoltage, rp_calib_params_t* out_params);
+
+/**
+* Calibrates the high voltage scale of both input channels from one capture. Jumpers must be set to HV.
+* Both inputs must be connected to the same stable positive source.
+* Calibration data is kept until rp_CalibrationCommit() and repopulated so that rp_GetCalibrationSettings works properly.
+* @param referentialVoltage Voltage of the source.
+* @param out_params If not NULL, receives the scales instead of the EEPROM.
+* @return If the function is successful, the return value is RP_OK.
+* If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+*/
+int rp_CalibrateFrontEndScaleHVBoth(float referentialVoltage, rp_calib_params_t* out_params);
+
+/**
+* Calibrates the offsets of both output channels from one capture.
+* Each output must be connected to the calibrated input with the same number.
+* Calibration data is kept until rp_CalibrationCommit() and repopulated so that rp_GetCalibrationSettings works properly.
+* @return If the function is successful, the return value is RP_OK.
+* If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+*/
+int rp_CalibrateBackEndOffsetBoth();
+
 /**
 * Set default calibration values.
-* Calibration data is written to EPROM and repopulated so that rp_GetCalibrationSettings works properly.
+* Calibration data is kept until rp_CalibrationCommit() and repopulated so that rp_GetCalibrationSettings works properly.
 * @return If the function is successful, the return value is RP_OK.
 * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
 */
@@ -410,6 +763,39 @@ int rp_CalibrationSetCachedParams();
 * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
 */
 int rp_CalibrationWriteParams(rp_calib_params_t calib_params);
+
+/**
+* Writes the calibration data changed since the last commit. Only the changed words are
+* written, followed by a checksum of the parameters in the reserved bytes in front of them.
+* The checksum is also rewritten when it does not match, e.g. after the parameters were
+* written by other tools. rp_Release() commits the changes as well, parameters read but
+* not changed are never written back.
+* @return If the function is successful, the return value is RP_OK.
+* If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+*/
+int rp_CalibrationCommit();
+
+/**
+* Keeps the calibration data in a plain file instead of the EEPROM, for tests and backups.
+* Pending changes are committed to the previous store first.
+* @param path File, created on the first commit. NULL selects the EEPROM again.
+* @param offset Position of the parameters in the file, at least 6 as the checksum is kept
+* in the 6 bytes in front of them.
+* @return If the function is successful, the return value is RP_OK.
+* If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+*/
+int rp_CalibrationSetStore(const char *path, long offset);
+
+/**
+* Sets how the calibration functions sample their inputs. Each buffer is captured at
+* decimation 64 as soon as the previous one is read, the samples of all buffers are
+* reduced to one value per channel. The default is a single buffer and the mean.
+* @param buffers Number of buffers, 1 to 1024.
+* @param reduce Reduction of the samples.
+* @return If the function is successful, the return value is RP_OK.
+* If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+*/
+int rp_CalibrationSetSampling(uint32_t buffers, rp_calib_reduce_t reduce);
 ///@}
 
 
@@ -501,6 +887,153 @@ int rp_DpinGetDirection(rp_dpin_t pin, rp_pinDirection_t* direction);
 ///@}
 
 
+/** @name Serial buses
+ */
+///@{
+
+/**
+ * Sets the spidev device of the SPI functions, /dev/spidev1.0 by default.
+ * The device is opened again on the next transfer.
+ * @param path Device path, NULL for the default.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_SpiSetDevice(const char* path);
+
+/**
+ * Sets the SPI clock polarity and phase, mode 0 by default.
+ * @param mode SPI mode.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_SpiSetMode(rp_spi_mode_t mode);
+
+/**
+ * Sets the SPI clock frequency, 1 MHz by default.
+ * @param speed Clock frequency in Hz.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_SpiSetSpeed(uint32_t speed);
+
+/**
+ * Sets the SPI word length, 8 bits by default.
+ * @param bits Bits per word, 1 to 32.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_SpiSetWordLen(uint8_t bits);
+
+/**
+ * Runs the segments of an SPI transfer. The chip select stays asserted from the first to the
+ * last segment, unless a segment releases it. The segments are passed to the driver in one
+ * message, which holds up to 128 segments and 4096 bytes, the spidev default buffer size.
+ * Longer transfers are refused with RP_EOOR, nothing is sent. The device stays open and the
+ * settings are only written to it when they changed.
+ * @param xfers Segments.
+ * @param n Number of segments.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_SpiTransfer(rp_spi_xfer_t* xfers, int n);
+
+/**
+ * Closes the SPI device, the settings are kept. rp_Release() closes it as well.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_SpiRelease();
+
+/**
+ * Sets the device of an I2C bus, /dev/i2c-<bus> by default. With the simulated backend a bus
+ * without a device is a fake adapter, on which every address is a device with 256 registers.
+ * The device is opened again on the next transfer.
+ * @param bus Bus number, 0 to 7.
+ * @param path Device path, NULL for the default.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_I2cSetDevice(int bus, const char* path);
+
+/**
+ * Runs the messages of an I2C transfer as one combined transaction, with a repeated start
+ * between the messages and one stop at the end. The whole transfer is a single system call.
+ * Each bus is opened on its first transfer and stays open.
+ * @param bus Bus number, 0 to 7.
+ * @param msgs Messages, read messages receive their data.
+ * @param n Number of messages, at most 42.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_I2cTransfer(int bus, rp_i2c_msg_t* msgs, int n);
+
+/**
+ * Reads consecutive registers of a device with 8 bit register addresses, as the register
+ * address write and a repeated start read in one transfer.
+ * @param bus Bus number, 0 to 7.
+ * @param addr 7 bit device address.
+ * @param reg First register.
+ * @param buf Register values.
+ * @param len Number of registers.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_I2cReadRegs(int bus, uint8_t addr, uint8_t reg, uint8_t* buf, uint16_t len);
+
+/**
+ * Closes all I2C buses and drops the registers of the fake adapters. rp_Release() does so as well.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_I2cRelease();
+
+/**
+ * Opens a serial port and starts the UART service. A reader thread receives in the background,
+ * splits the bytes into frames and keeps them with their arrival time in a ring, from which
+ * rp_UartPeek() reads them in place.
+ * @param path Device path, NULL for /dev/ttyPS1.
+ * @param cfg Port and framing settings.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_UartOpen(const char* path, const rp_uart_cfg_t* cfg);
+
+/**
+ * Stops the UART service and closes the port, unread frames are lost. rp_Release() closes it as well.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_UartClose();
+
+/**
+ * Sends data, waiting while the transmit buffer is full.
+ * @param data Data.
+ * @param len Length of the data in bytes.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_UartWrite(const uint8_t* data, uint32_t len);
+
+/**
+ * Gets the oldest received frame without copying or waiting. The frame stays in the ring, and
+ * is returned again, until rp_UartConsume(). Only one thread may read the frames.
+ * @param frame Frame, valid if ready is set.
+ * @param ready Whether a frame was received.
+ * @return If the function is successful, the return value is RP_OK. Once all frames have been
+ * read, RP_EFRB if the reader stopped because the port failed or was closed by the other side.
+ */
+int rp_UartPeek(rp_uart_frame_t* frame, bool* ready);
+
+/**
+ * Frees the frame returned by the last rp_UartPeek().
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_UartConsume();
+
+///@}
+
+
 /** @name Analog Inputs/Outputs
  */
 ///@{
@@ -745,6 +1278,16 @@ int rp_AcqGetTriggerSrc(rp_acq_trig_src_t* source);
  */
 int rp_AcqGetTriggerState(rp_acq_trig_state_t* state);
 
+/**
+ * Waits until the capture is complete. The FPGA clears the trigger source once the trigger
+ * delay has run out after the trigger, which rp_AcqGetTriggerState() may miss at low decimations.
+ * @param timeout_us Longest wait in microseconds.
+ * @return If the function is successful, the return value is RP_OK.
+ * RP_ETMO if the capture is not complete within timeout_us.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqWaitCaptureDone(uint32_t timeout_us);
+
 /**
  * Sets the number of decimated data after trigger written into memory.
  * @param decimated_data_num Number of decimated data. It must not be higher than the ADC buffer size.
@@ -1016,6 +1559,191 @@ int rp_AcqGetLatestDataV(rp_channel_t channel, uint32_t* size, float* buffer);
 
 int rp_AcqGetBufSize(uint32_t* size);
 
+/**
+ * Fits a sine to one or two acquired buffers (IEEE Std 1057).
+ * With fit_frequency false the 3-parameter fit at the given frequency is made, both
+ * channels share its reference and Gram matrix. With fit_frequency true the iterative
+ * 4-parameter fit also estimates the frequency of each channel, starting at the given
+ * one, which must then be accurate to a fraction of sample_rate / size.
+ * @param ch1 Samples of the first channel, e.g. from rp_AcqGetDataV2().
+ * @param ch2 Samples of the second channel, or NULL to fit ch1 only.
+ * @param size Number of samples in each buffer.
+ * @param sample_rate Sampling rate in Hz, see rp_AcqGetSamplingRateHz().
+ * @param frequency Signal frequency (or its estimate) in Hz, below sample_rate / 2.
+ * @param fit_frequency Whether to estimate the frequency as well.
+ * @param fit1 Result for ch1.
+ * @param fit2 Result for ch2, may be NULL when ch2 is NULL.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqSineFit(const float* ch1, const float* ch2, uint32_t size, double sample_rate,
+                  double frequency, bool fit_frequency, rp_sine_fit_t* fit1, rp_sine_fit_t* fit2);
+
+/**
+ * Sets the mask of a channel for mask testing. Mask sample i applies to the captured
+ * sample at trigger position + offset + i and passes if min[i] <= sample <= max[i],
+ * in calibrated counts as returned by rp_AcqGetDataRaw(). The captured window must
+ * cover the mask, see rp_AcqSetTriggerDelay(), otherwise testing fails with RP_EOOR.
+ * Clears the violation counts of the channel.
+ * @param channel Channel A or B.
+ * @param offset Position of the first mask sample relative to the trigger.
+ * @param min Lower bounds.
+ * @param max Upper bounds.
+ * @param size Number of mask samples, at most ADC_BUFFER_SIZE.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqMaskSet(rp_channel_t channel, int32_t offset, const int16_t* min, const int16_t* max, uint32_t size);
+
+/**
+ * Sets the mask of a channel to a golden capture plus/minus a tolerance, see rp_AcqMaskSet().
+ * @param channel Channel A or B.
+ * @param offset Position of the first mask sample relative to the trigger.
+ * @param golden Golden waveform in calibrated counts.
+ * @param size Number of mask samples, at most ADC_BUFFER_SIZE.
+ * @param tolerance Allowed deviation from the golden waveform in counts.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqMaskSetFromGolden(rp_channel_t channel, int32_t offset, const int16_t* golden, uint32_t size, uint16_t tolerance);
+
+/**
+ * Removes the mask of a channel, the channel is no longer tested.
+ * @param channel Channel A or B.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqMaskClear(rp_channel_t channel);
+
+/**
+ * Tests the last triggered capture against the masks and updates the statistics.
+ * Not available while the background test runs.
+ * @param pass Whether all masked channels passed.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqMaskTest(bool* pass);
+
+/**
+ * Starts the background mask test. It arms the acquisition, triggers from the given
+ * source and tests every capture until stopped. It owns the acquisition while it runs,
+ * the acquisition settings must not be changed meanwhile. It stops on its own when
+ * the FPGA does not complete a capture in time after the trigger.
+ * @param source Trigger source of the captures.
+ * @param stop_on_fail Whether to stop at the first failed capture, which is then kept,
+ * see rp_AcqMaskGetFailData().
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqMaskStart(rp_acq_trig_src_t source, bool stop_on_fail);
+
+/**
+ * Stops the background mask test.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqMaskStop();
+
+/**
+ * Returns the mask test counters.
+ * @param stats Mask test counters.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqMaskGetStats(rp_mask_stats_t* stats);
+
+/**
+ * Clears the mask test counters, the violation counts and the kept failed captures.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqMaskResetStats();
+
+/**
+ * Returns how many times each mask sample of a channel was violated.
+ * @param channel Channel A or B.
+ * @param counts Violation count per mask sample.
+ * @param size Size of counts on input, mask size on output.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqMaskGetViolations(rp_channel_t channel, uint32_t* counts, uint32_t* size);
+
+/**
+ * Returns the masked window of a channel from the last failed capture.
+ * @param channel Channel A or B.
+ * @param buffer Samples in calibrated counts.
+ * @param size Size of buffer on input, mask size on output.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqMaskGetFailData(rp_channel_t channel, int16_t* buffer, uint32_t* size);
+
+/**
+ * Finds the settings that show the input signals, from one or two captures that trigger
+ * immediately. The first at full rate gives the extremes and, from the spectrum, the
+ * dominant period. Only if it holds less than 3 periods a second one follows at decimation
+ * 1024 with averaging. Without a periodic signal the time span is 2 s.
+ * With apply the decimation, averaging, trigger delay (0) and the threshold of the channel
+ * are set, the trigger source is not, as that arms the trigger, and neither is the gain,
+ * which follows the jumpers. Otherwise the acquisition settings are restored.
+ * The acquisition must not be used meanwhile, e.g. by the background mask test.
+ * @param apply Whether to apply the settings found.
+ * @param result Settings found and the measured extremes.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqAutoScale(bool apply, rp_auto_scale_t* result);
+
+/**
+ * Decodes a serial bus from the acquired buffer. Each used channel is turned into logic
+ * levels with its threshold and hysteresis in a single pass, then the protocol is decoded
+ * from the edges only. UART frames have 1 start bit, LSB first data, optional parity and
+ * a stop bit. I2C is decoded from the first start condition on. SPI words are made of
+ * data_bits clock edges, a clock pause of 8 periods ends a word, there is no chip select.
+ * @param cfg Decoder settings.
+ * @param pos Position of the first sample in the buffer, e.g. rp_AcqGetWritePointerAtTrig().
+ * @param size Number of samples to decode, at most ADC_BUFFER_SIZE.
+ * @param events Decoded events in time order.
+ * @param count Size of events on input, number of events on output. If more events were
+ * decoded, events holds the first ones and RP_BTS is returned.
+ * @param rate Bit or clock rate in Hz: the given or estimated UART rate, the mean I2C or
+ * SPI clock rate within words. May be NULL.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqDecode(const rp_decode_cfg_t* cfg, uint32_t pos, uint32_t size,
+                 rp_decode_event_t* events, uint32_t* count, float* rate);
+
+/**
+ * Measures the impedance of a device at one frequency. The generator output is set to a
+ * sine of the given frequency, amplitude and bias and left running, so that a sweep only
+ * waits for the device to settle between points. Each capture uses the lowest decimation
+ * that holds cfg->periods periods, both inputs are sine fitted at the known frequency and
+ * Z = (U1 - U2) / U2 * r_shunt is averaged over cfg->averaging captures. The decimation,
+ * averaging and trigger delay of the acquisition are restored afterwards.
+ * @param cfg Measurement settings.
+ * @param frequency Frequency in Hz, below half the full sampling rate.
+ * @param z_re Real part of the impedance in ohms.
+ * @param z_im Imaginary part of the impedance in ohms.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_ImpMeasure(const rp_imp_cfg_t* cfg, float frequency, double* z_re, double* z_im);
+
+/**
+ * Computes every quantity derived from an impedance and stores it at element index of
+ * the non-NULL arrays of result.
+ * @param frequency Frequency of the measurement in Hz.
+ * @param z_re Real part of the impedance in ohms.
+ * @param z_im Imaginary part of the impedance in ohms.
+ * @param result Arrays to store into.
+ * @param index Element to store.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_ImpDerive(float frequency, double z_re, double z_im, rp_imp_result_t* result, uint32_t index);
+
 
 ///@}
 /** @name Generate
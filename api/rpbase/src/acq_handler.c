@@ -20,6 +20,7 @@
 #include "calib.h"
 #include "oscilloscope.h"
 #include "acq_handler.h"
+#include "stats.h"
 
 
 // Decimation constants
@@ -249,6 +250,45 @@ int acq_GetGainV(rp_channel_t channel, float* voltage)
     return RP_OK;
 }
 
+/**
+ * Returns the calibrated DC offset in counts for the current gain, as
+ * subtracted by acq_GetDataRaw()
+ */
+int acq_GetCalibOffset(rp_channel_t channel, int32_t* dc_offs)
+{
+    rp_pinState_t gain;
+    ECHECK(acq_GetGain(channel, &gain));
+
+    rp_calib_params_t calib;
+
+    ECHECK(calib_GetParams(&calib));
+    *dc_offs = GET_OFFSET(channel, gain, calib);
+    return RP_OK;
+}
+
+/**
+ * Converts a voltage to a signed raw count, the domain the trigger
+ * comparators and the raw buffer samples are in
+ */
+int acq_CnvVToRawCnt(rp_channel_t channel, float voltage, int32_t* cnts)
+{
+    float gainV;
+    rp_pinState_t gain;
+
+    ECHECK(acq_GetGainV(channel, &gainV));
+    ECHECK(acq_GetGain(channel, &gain));
+
+    rp_calib_params_t calib;
+
+    ECHECK(calib_GetParams(&calib));
+    int32_t dc_offs = GET_OFFSET(channel, gain, calib);
+    uint32_t calibScale = calib_GetFrontEndScale(channel, gain);
+
+    uint32_t cnt = cmn_CnvVToCnt(ADC_BITS, voltage, gainV, gain == RP_HIGH ? false : true, calibScale, dc_offs, 0.0);
+    *cnts = (int32_t)((cnt & ADC_BITS_MAK) ^ (1 << (ADC_BITS - 1))) - (1 << (ADC_BITS - 1));
+    return RP_OK;
+}
+
 int acq_SetDecimation(rp_acq_decimation_t decimation)
 {
     int64_t time_ns = 0;
@@ -442,9 +482,17 @@ int acq_GetAveraging(bool* enable)
     return osc_GetAveraging(enable);
 }
 
+#ifdef RP_STATS
+/* Time the trigger was armed, 0 when not armed */
+static uint64_t trig_armed_ns = 0;
+#endif
+
 int acq_SetTriggerSrc(rp_acq_trig_src_t source)
 {
     last_trig_src = source;
+#ifdef RP_STATS
+    trig_armed_ns = source == RP_TRIG_SRC_DISABLED ? 0 : stats_Now();
+#endif
     return osc_SetTriggerSource(source);
 }
 
@@ -460,6 +508,13 @@ int acq_GetTriggerState(rp_acq_trig_state_t* state)
 
     if (stateB) {
         *state=RP_TRIG_STATE_TRIGGERED;
+#ifdef RP_STATS
+        // Arm to trigger latency, as seen by the polling caller
+        if (trig_armed_ns) {
+            stats_Record(STAT_ACQ_TRIGGER_WAIT, stats_Now() - trig_armed_ns, 0);
+            trig_armed_ns = 0;
+        }
+#endif
     }
     else{
         *state=RP_TRIG_STATE_WAITING;
@@ -546,7 +601,9 @@ int acq_SetChannelThreshold(rp_channel_t channel, float voltage)
         return RP_EOOR;
     }
 
-    rp_calib_params_t calib = calib_GetParams();
+    rp_calib_params_t calib;
+
+    ECHECK(calib_GetParams(&calib));
     int32_t dc_offs = GET_OFFSET(channel, gain, calib);
     uint32_t calibScale = calib_GetFrontEndScale(channel, gain);
 
@@ -579,7 +636,9 @@ int acq_GetChannelThreshold(rp_channel_t channel, float* voltage)
     ECHECK(acq_GetGainV(channel, &gainV));
     ECHECK(acq_GetGain(channel, &gain));
 
-    rp_calib_params_t calib = calib_GetParams();
+    rp_calib_params_t calib;
+
+    ECHECK(calib_GetParams(&calib));
     int32_t dc_offs = GET_OFFSET(channel, gain, calib);
     uint32_t calibScale = calib_GetFrontEndScale(channel, gain);
 
@@ -614,7 +673,9 @@ int acq_SetChannelThresholdHyst(rp_channel_t channel, float voltage)
         return RP_EOOR;
     }
 
-    rp_calib_params_t calib = calib_GetParams();
+    rp_calib_params_t calib;
+
+    ECHECK(calib_GetParams(&calib));
     int32_t dc_offs = GET_OFFSET(channel, gain, calib);
     uint32_t calibScale = calib_GetFrontEndScale(channel, gain);
 
@@ -643,7 +704,9 @@ int acq_GetChannelThresholdHyst(rp_channel_t channel, float* voltage)
     ECHECK(acq_GetGainV(channel, &gainV));
     ECHECK(acq_GetGain(channel, &gain));
 
-    rp_calib_params_t calib = calib_GetParams();
+    rp_calib_params_t calib;
+
+    ECHECK(calib_GetParams(&calib));
     int32_t dc_offs = GET_OFFSET(channel, gain, calib);
     uint32_t calibScale = calib_GetFrontEndScale(channel, gain);
 
@@ -709,7 +772,9 @@ int acq_GetDataRaw(rp_channel_t channel, uint32_t pos, uint32_t* size, int16_t*
     rp_pinState_t gain;
     ECHECK(acq_GetGain(channel, &gain));
 
-    rp_calib_params_t calib = calib_GetParams();
+    rp_calib_params_t calib;
+
+    ECHECK(calib_GetParams(&calib));
     int32_t dc_offs = GET_OFFSET(channel, gain, calib);
 
     for (uint32_t i = 0; i < (*size); ++i) {
@@ -788,7 +853,9 @@ int acq_GetDataV(rp_channel_t channel,  uint32_t pos, uint32_t* size, float* buf
     ECHECK(acq_GetGainV(channel, &gainV));
     ECHECK(acq_GetGain(channel, &gain));
 
-    rp_calib_params_t calib = calib_GetParams();
+    rp_calib_params_t calib;
+
+    ECHECK(calib_GetParams(&calib));
     int32_t dc_offs = GET_OFFSET(channel, gain, calib);
     uint32_t calibScale = calib_GetFrontEndScale(channel, gain);
 
@@ -814,7 +881,9 @@ int acq_GetDataV2(uint32_t pos, uint32_t* size, float* buffer1, float* buffer2)
     ECHECK(acq_GetGainV(RP_CH_2, &gainV2));
     ECHECK(acq_GetGain(RP_CH_2, &gain2));
 
-    rp_calib_params_t calib = calib_GetParams();
+    rp_calib_params_t calib;
+
+    ECHECK(calib_GetParams(&calib));
     int32_t dc_offs1 = gain1 == RP_HIGH ? calib.fe_ch1_hi_offs : calib.fe_ch1_lo_offs;
     uint32_t calibScale1 = calib_GetFrontEndScale(RP_CH_1, gain1);
 
@@ -887,23 +956,56 @@ int acq_GetBufferSize(uint32_t *size) {
     return RP_OK;
 }
 
+/**
+ * Twice the time the FPGA takes to write samples at the decimation, plus
+ * ACQ_TIMEOUT_NS
+ */
+uint64_t acq_DeadlineNs(uint32_t samples, uint32_t decimation) {
+    return cmn_NowNs() + 2ULL * samples * decimation * ADC_SAMPLE_PERIOD + ACQ_TIMEOUT_NS;
+}
+
+/**
+ * Waits for the end of the capture. The FPGA clears the trigger source once
+ * the trigger delay has run out and the buffer is written. The triggered
+ * state is only set while the delay runs, at low decimations for less than
+ * a poll period, so it does not tell the end.
+ * @return RP_ETMO if the trigger source is still set at deadline_ns.
+ */
+int acq_WaitCaptureDone(uint64_t deadline_ns) {
+    rp_acq_trig_src_t source;
+
+    for (;;) {
+        ECHECK(acq_GetTriggerSrc(&source));
+        if (source == RP_TRIG_SRC_DISABLED) {
+            return RP_OK;
+        }
+        if (cmn_NowNs() > deadline_ns) {
+            return RP_ETMO;
+        }
+        cmn_SleepNs(ACQ_POLL_NS);
+    }
+}
+
 /**
  * Sets default configuration
  * @return
  */
 int acq_SetDefault() {
+    // The gain is only software state, so it is set before the thresholds
+    // instead of converting them back and forth in acq_SetGain()
+    gain_ch_a = RP_LOW;
+    gain_ch_b = RP_LOW;
+    ECHECK(setEqFilters(RP_CH_1));
+    ECHECK(setEqFilters(RP_CH_2));
+
     ECHECK(acq_SetChannelThreshold(RP_CH_1, 0.0));
     ECHECK(acq_SetChannelThreshold(RP_CH_2, 0.0));
     ECHECK(acq_SetChannelThresholdHyst(RP_CH_1, 0.0));
     ECHECK(acq_SetChannelThresholdHyst(RP_CH_2, 0.0));
 
-    ECHECK(acq_SetGain(RP_CH_1, RP_LOW));
-    ECHECK(acq_SetGain(RP_CH_2, RP_LOW));
-    ECHECK(acq_SetDecimation(RP_DEC_1));
-    ECHECK(acq_SetSamplingRate(RP_SMP_125M));
+    ECHECK(osc_SetDecimation(DEC_1));
     ECHECK(acq_SetAveraging(true));
     ECHECK(acq_SetTriggerSrc(RP_TRIG_SRC_DISABLED));
-    ECHECK(acq_SetTriggerDelay(0, false));
     ECHECK(acq_SetTriggerDelayNs(0, false));
 
     return RP_OK;
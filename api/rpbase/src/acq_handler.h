@@ -23,6 +23,8 @@ int acq_SetArmKeep(bool enable);
 int acq_SetGain(rp_channel_t channel, rp_pinState_t state);
 int acq_GetGain(rp_channel_t channel, rp_pinState_t* state);
 int acq_GetGainV(rp_channel_t channel, float* voltage);
+int acq_GetCalibOffset(rp_channel_t channel, int32_t* dc_offs);
+int acq_CnvVToRawCnt(rp_channel_t channel, float voltage, int32_t* cnts);
 int acq_SetDecimation(rp_acq_decimation_t decimation);
 int acq_GetDecimation(rp_acq_decimation_t* decimation);
 int acq_GetDecimationFactor(uint32_t* decimation);
@@ -67,6 +69,14 @@ int acq_GetLatestDataV(rp_channel_t channel, uint32_t* size, float* buffer);
 
 int acq_GetBufferSize(uint32_t *size);
 
+/* Polling period while waiting for the FPGA [ns] */
+#define ACQ_POLL_NS         20000
+/* Margin on the time the FPGA takes to write the samples [ns] */
+#define ACQ_TIMEOUT_NS      100000000ULL
+
+uint64_t acq_DeadlineNs(uint32_t samples, uint32_t decimation);
+int acq_WaitCaptureDone(uint64_t deadline_ns);
+
 int acq_SetDefault();
 
 
@@ -40,10 +40,13 @@ static volatile analog_mixed_signals_control_t *ams = NULL;
 
 static int ams_Init() {
     ECHECK(cmn_Map(ANALOG_MIXED_SIGNALS_BASE_SIZE, ANALOG_MIXED_SIGNALS_BASE_ADDR, (void**)&ams));
+    // Only the DAC registers are shadowed, the inputs and reserved ones are live
+    ECHECK(cmn_AddShadow(ams, sizeof(analog_mixed_signals_control_t), 0xFF, NULL));
     return RP_OK;
 }
 
 static int ams_Release() {
+    ECHECK(cmn_RemoveShadow(ams));
     ECHECK(cmn_Unmap(ANALOG_MIXED_SIGNALS_BASE_SIZE, (void**)&ams));
     return RP_OK;
 }
@@ -0,0 +1,290 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library autoscale module implementation
+ *
+ * Instead of stepping through the timebases capture by capture, the signal
+ * is captured once at full rate. Its extremes give the amplitude and the
+ * peak of its Hann windowed spectrum the dominant period. Only when that
+ * capture holds too few periods (or no signal) a second one is made with
+ * decimation 1024 and averaging, which covers the slower signals. The final
+ * timebase, trigger level and input range are then computed in one go.
+ *
+ * Both captures trigger immediately and use the raw decimation and trigger
+ * delay registers, so that the settings of the caller can be restored
+ * exactly.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdlib.h>
+#include <math.h>
+
+#include "common.h"
+#include "oscilloscope.h"
+#include "acq_handler.h"
+#include "kiss_fftr.h"
+#include "autoscale.h"
+
+#define SAMPLE_PERIOD_NS    8
+#define SPEC_LEN            (ADC_BUFFER_SIZE / 2 + 1)
+/* Bins next to the peak that belong to the main lobe of the Hann window */
+#define PEAK_LOBE           2
+
+static const uint32_t dec_factors[] = { 1, 8, 64, 1024, 8192, 65536 };
+
+typedef struct {
+    float *data[2];
+    double *win;
+    kiss_fft_scalar *in;
+    kiss_fft_cpx *out;
+    double *power;
+    kiss_fftr_cfg cfg;
+} work_t;
+
+static void freeWork(work_t *w)
+{
+    free(w->data[0]);
+    free(w->data[1]);
+    free(w->win);
+    free(w->in);
+    free(w->out);
+    free(w->power);
+    kiss_fftr_free(w->cfg);
+}
+
+static int allocWork(work_t *w)
+{
+    w->data[0] = malloc(ADC_BUFFER_SIZE * sizeof(float));
+    w->data[1] = malloc(ADC_BUFFER_SIZE * sizeof(float));
+    w->win = malloc(ADC_BUFFER_SIZE * sizeof(double));
+    w->in = malloc(ADC_BUFFER_SIZE * sizeof(kiss_fft_scalar));
+    w->out = malloc(SPEC_LEN * sizeof(kiss_fft_cpx));
+    w->power = malloc(SPEC_LEN * sizeof(double));
+    w->cfg = kiss_fftr_alloc(ADC_BUFFER_SIZE, 0, NULL, NULL);
+    if (!w->data[0] || !w->data[1] || !w->win || !w->in || !w->out || !w->power || !w->cfg) {
+        return RP_EOOR;
+    }
+    for (int i = 0; i < ADC_BUFFER_SIZE; i++) {
+        w->win[i] = 0.5 - 0.5 * cos(2 * M_PI * i / ADC_BUFFER_SIZE);
+    }
+    return RP_OK;
+}
+
+/* Captures both channels with the trigger in the middle of the buffer,
+ * the same sequence as the mask test capture */
+static int capture(uint32_t dec, bool averaging, work_t *w)
+{
+    const uint32_t half = ADC_BUFFER_SIZE / 2;
+    uint64_t deadline = acq_DeadlineNs(ADC_BUFFER_SIZE, dec);
+    uint32_t cnt, trig_pos, size;
+
+    ECHECK(osc_SetDecimation(dec));
+    ECHECK(osc_SetAveraging(averaging));
+    ECHECK(osc_SetTriggerDelay(half));
+    ECHECK(acq_Start());
+
+    do {
+        if (cmn_NowNs() > deadline) {
+            return RP_ETMO;
+        }
+        cmn_SleepNs(ACQ_POLL_NS);
+        ECHECK(acq_GetPreTriggerCounter(&cnt));
+    } while (cnt < half);
+    ECHECK(acq_SetTriggerSrc(RP_TRIG_SRC_NOW));
+    ECHECK(acq_WaitCaptureDone(deadline));
+    ECHECK(acq_GetWritePointerAtTrig(&trig_pos));
+
+    for (int ch = 0; ch < 2; ch++) {
+        size = ADC_BUFFER_SIZE;
+        ECHECK(acq_GetDataV(ch, (trig_pos + half) % ADC_BUFFER_SIZE, &size, w->data[ch]));
+    }
+    return RP_OK;
+}
+
+static void minMax(const float *data, float *min, float *max)
+{
+    for (int i = 0; i < ADC_BUFFER_SIZE; i++) {
+        *min = MIN(*min, data[i]);
+        *max = MAX(*max, data[i]);
+    }
+}
+
+/* Dominant period in samples, 0 if the spectrum has no dominant peak or
+ * the capture holds less than AUTOSCALE_MIN_PERIODS of it */
+static double dominantPeriod(work_t *w, const float *data)
+{
+    double *p = w->power;
+    double mean = 0, total = 0, peak_power;
+    int peak = 1;
+
+    for (int i = 0; i < ADC_BUFFER_SIZE; i++) {
+        mean += data[i];
+    }
+    mean /= ADC_BUFFER_SIZE;
+    for (int i = 0; i < ADC_BUFFER_SIZE; i++) {
+        w->in[i] = (data[i] - mean) * w->win[i];
+    }
+    kiss_fftr(w->cfg, w->in, w->out);
+
+    for (int k = 1; k < SPEC_LEN; k++) {
+        p[k] = w->out[k].r * w->out[k].r + w->out[k].i * w->out[k].i;
+        total += p[k];
+        if (p[k] > p[peak]) {
+            peak = k;
+        }
+    }
+    if (peak < AUTOSCALE_MIN_PERIODS || peak >= SPEC_LEN - 1 || total <= 0) {
+        return 0;
+    }
+
+    peak_power = 0;
+    for (int k = MAX(1, peak - PEAK_LOBE); k <= MIN(SPEC_LEN - 1, peak + PEAK_LOBE); k++) {
+        peak_power += p[k];
+    }
+    if (peak_power < AUTOSCALE_PEAK_POWER * total) {
+        return 0;
+    }
+
+    // Parabolic interpolation of the log magnitude, the power ratios
+    // give twice the log magnitude which cancels out
+    double a = log(p[peak - 1] + 1e-30), b = log(p[peak]), c = log(p[peak + 1] + 1e-30);
+    double den = a - 2 * b + c;
+    double delta = den < 0 ? 0.5 * (a - c) / den : 0;
+    return ADC_BUFFER_SIZE / (peak + delta);
+}
+
+/* Input range that suits the swing, the current one unless the signal clips
+ * the low range or fits the low range while on the high one */
+static int suggestGain(rp_channel_t channel, float min, float max, rp_pinState_t *gain)
+{
+    float gainV;
+    ECHECK(acq_GetGain(channel, gain));
+    ECHECK(acq_GetGainV(channel, &gainV));
+
+    float peak = MAX(fabs(min), fabs(max));
+    if (*gain == RP_LOW && peak >= 0.95 * gainV) {
+        *gain = RP_HIGH;
+    }
+    else if (*gain == RP_HIGH && peak < 0.8) {
+        *gain = RP_LOW;
+    }
+    return RP_OK;
+}
+
+/* Picks the channel with the larger swing relative to its range, checks it
+ * against the noise and estimates its period */
+static int analyze(work_t *w, uint32_t dec, rp_auto_scale_t *r, bool *found)
+{
+    float swing[2];
+
+    for (int ch = 0; ch < 2; ch++) {
+        float gainV;
+        ECHECK(acq_GetGainV(ch, &gainV));
+        minMax(w->data[ch], &r->min[ch], &r->max[ch]);
+        swing[ch] = (r->max[ch] - r->min[ch]) / (2 * gainV);
+    }
+    r->channel = swing[RP_CH_1] >= swing[RP_CH_2] ? RP_CH_1 : RP_CH_2;
+    r->signal = swing[r->channel] >= AUTOSCALE_NOISE_FS;
+
+    double period = r->signal ? dominantPeriod(w, w->data[r->channel]) : 0;
+    r->period = period * dec * SAMPLE_PERIOD_NS * 1e-9;
+    *found = period > 0;
+    return RP_OK;
+}
+
+static int run(work_t *w, rp_auto_scale_t *r)
+{
+    bool found;
+
+    for (int ch = 0; ch < 2; ch++) {
+        r->min[ch] = INFINITY;
+        r->max[ch] = -INFINITY;
+    }
+
+    // Full rate, averaging makes no difference
+    ECHECK(capture(1, false, w));
+    r->captures = 1;
+    ECHECK(analyze(w, 1, r, &found));
+
+    // Too slow (or nothing) at full rate, the extremes of both are kept
+    if (!found) {
+        ECHECK(capture(1024, true, w));
+        r->captures = 2;
+        ECHECK(analyze(w, 1024, r, &found));
+    }
+
+    for (int ch = 0; ch < 2; ch++) {
+        ECHECK(suggestGain(ch, r->min[ch], r->max[ch], &r->gain[ch]));
+    }
+
+    if (!r->signal) {
+        r->decimation = RP_DEC_1;
+        r->time_span = ADC_BUFFER_SIZE / 2 * SAMPLE_PERIOD_NS * 1e-9;
+        r->trigger_source = RP_TRIG_SRC_NOW;
+        r->trigger_level = 0;
+        return RP_OK;
+    }
+
+    r->trigger_source = r->channel == RP_CH_1 ? RP_TRIG_SRC_CHA_PE : RP_TRIG_SRC_CHB_PE;
+    r->trigger_level = (r->min[r->channel] + r->max[r->channel]) / 2;
+    // Calibration may take the extremes a bit beyond the range
+    float gainV;
+    ECHECK(acq_GetGainV(r->channel, &gainV));
+    r->trigger_level = MAX(-gainV, MIN(gainV, r->trigger_level));
+    r->time_span = found ? AUTOSCALE_SPAN_PERIODS * r->period : AUTOSCALE_SLOW_SPAN;
+
+    // Lowest decimation whose samples after the trigger cover the span
+    r->decimation = RP_DEC_65536;
+    for (int i = 0; i <= RP_DEC_65536; i++) {
+        if (ADC_BUFFER_SIZE / 2 * SAMPLE_PERIOD_NS * 1e-9 * dec_factors[i] >= r->time_span) {
+            r->decimation = i;
+            break;
+        }
+    }
+    return RP_OK;
+}
+
+int autoscale_Run(bool apply, rp_auto_scale_t* result)
+{
+    uint32_t dec, delay;
+    bool averaging;
+    work_t w = { { NULL, NULL } };
+
+    if (result == NULL) {
+        return RP_UIA;
+    }
+
+    ECHECK(osc_GetDecimation(&dec));
+    ECHECK(osc_GetAveraging(&averaging));
+    ECHECK(osc_GetTriggerDelay(&delay));
+
+    int ret = allocWork(&w);
+    if (ret == RP_OK) {
+        ret = run(&w, result);
+    }
+    freeWork(&w);
+
+    if (ret != RP_OK || !apply) {
+        ECHECK(osc_SetDecimation(dec));
+        ECHECK(osc_SetAveraging(averaging));
+        ECHECK(osc_SetTriggerDelay(delay));
+        return ret;
+    }
+
+    // The gain is a jumper setting and is only suggested, the trigger
+    // source is left to the caller as setting it arms the trigger
+    ECHECK(acq_SetDecimation(result->decimation));
+    ECHECK(acq_SetAveraging(true));
+    ECHECK(acq_SetTriggerDelay(0, false));
+    if (result->signal) {
+        ECHECK(acq_SetChannelThreshold(result->channel, result->trigger_level));
+    }
+    return RP_OK;
+}
@@ -0,0 +1,39 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library autoscale module interface
+ *
+ * Single shot autoscale: amplitude from a min/max pass and the dominant
+ * period from the spectrum of at most two captures.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef __AUTOSCALE_H
+#define __AUTOSCALE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "redpitaya/rp.h"
+
+/* Smallest swing of a signal, relative to the full scale of its range */
+#define AUTOSCALE_NOISE_FS      0.02
+/* Periods a capture must hold for the period to be taken from it */
+#define AUTOSCALE_MIN_PERIODS   3
+/* Share of the AC power the spectral peak must hold to be dominant */
+#define AUTOSCALE_PEAK_POWER    0.05
+/* Periods shown after the trigger */
+#define AUTOSCALE_SPAN_PERIODS  1.5
+/* Time span when a signal has no detectable period [s] */
+#define AUTOSCALE_SLOW_SPAN     2.0
+
+int autoscale_Run(bool apply, rp_auto_scale_t* result);
+
+#endif /* __AUTOSCALE_H */
@@ -12,41 +12,277 @@
  * for more details on the language used herein.
  */
 
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include "redpitaya/rp.h"
 #include "common.h"
 #include "generate.h"
+#include "oscilloscope.h"
+#include "acq_handler.h"
 #include "calib.h"
 
 #define CALIB_MAGIC 0xAABBCCDD
+/* Checksum in front of the parameters, "R" */
+#define CALIB_CHECK_MAGIC   0x52
+#define CALIB_CHECK_VERSION 1
+#define CALIB_WORDS         (sizeof(rp_calib_params_t) / sizeof(uint32_t))
 
 int calib_ReadParams(rp_calib_params_t *calib_params);
 
 static const char eeprom_device[]="/sys/bus/i2c/devices/0-0050/eeprom";
 static const int  eeprom_calib_off=0x0008;
 
-// Cached parameter values.
+/* Kept in the six reserved bytes of the EEPROM header, just before the
+ * parameters. Test/calib clears them, which reads as no checksum, the
+ * applications read and write the parameters only. */
+typedef struct __attribute__((packed)) {
+    uint8_t  magic;
+    uint8_t  version;
+    uint32_t crc;
+} calib_check_t;
+
+// Store contents from the checksum on
+#define CALIB_CHECK_SIZE    sizeof(calib_check_t)
+#define CALIB_IMAGE_SIZE    (CALIB_CHECK_SIZE + sizeof(rp_calib_params_t))
+
+// Cached parameter values, read on first use
 static rp_calib_params_t calib, failsafa_params;
+static bool calib_loaded = false;
+
+/* Parameters of the store as set by the calibration, and as last read or
+ * written. Only the words that differ are written on calib_Commit(). */
+static rp_calib_params_t store, flushed;
+static bool store_loaded = false;
+static bool flushed_valid = false;
+// Set by the calibration, the store is not written back otherwise
+static bool store_changed = false;
+// The checksum read does not match the parameters, see loadStore()
+static bool check_stale = false;
+
+// Plain file used instead of the EEPROM, see calib_SetStore()
+static char *store_path = NULL;
+static long store_offset = 0x0008;
+
+// EEPROM contents of the simulated backend
+static uint8_t sim_image[CALIB_IMAGE_SIZE];
+static bool sim_image_valid = false;
+
+static void simDefaultParams(rp_calib_params_t *calib_params)
+{
+    calib_params->be_ch1_dc_offs = 0;
+    calib_params->be_ch2_dc_offs = 0;
+    calib_params->fe_ch1_lo_offs = 0;
+    calib_params->fe_ch2_lo_offs = 0;
+    calib_params->fe_ch1_hi_offs = 0;
+    calib_params->fe_ch2_hi_offs = 0;
+
+    calib_params->be_ch1_fs      = cmn_CalibFullScaleFromVoltage(1);
+    calib_params->be_ch2_fs      = cmn_CalibFullScaleFromVoltage(1);
+    calib_params->fe_ch1_fs_g_lo = cmn_CalibFullScaleFromVoltage(20);
+    calib_params->fe_ch1_fs_g_hi = cmn_CalibFullScaleFromVoltage(1);
+    calib_params->fe_ch2_fs_g_lo = cmn_CalibFullScaleFromVoltage(20);
+    calib_params->fe_ch2_fs_g_hi = cmn_CalibFullScaleFromVoltage(1);
+    calib_params->magic          = CALIB_MAGIC;
+}
+
+static uint32_t crc32(const void *data, size_t len)
+{
+    const uint8_t *p = data;
+    uint32_t crc = 0xFFFFFFFF;
+    while (len--) {
+        crc ^= *p++;
+        for (int i = 0; i < 8; i++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+static calib_check_t makeCheck(const rp_calib_params_t *calib_params)
+{
+    calib_check_t check = {
+        .magic   = CALIB_CHECK_MAGIC,
+        .version = CALIB_CHECK_VERSION,
+        .crc     = crc32(calib_params, sizeof(rp_calib_params_t))
+    };
+    return check;
+}
+
+/* The simulated backend keeps its EEPROM in memory, unless a file is set */
+static bool simStore()
+{
+    return store_path == NULL && cmn_IsSimulated();
+}
+
+static void setParams(rp_calib_params_t params)
+{
+    calib = params;
+    calib_loaded = true;
+}
+
+/* Reads the parameters on first use. A failed read is returned to the
+ * calibrated call that needed them and tried again on the next one, the
+ * defaults are kept meanwhile for rp_GetCalibrationSettings(). */
+static int loadParams()
+{
+    if (calib_loaded) {
+        return RP_OK;
+    }
+    int ret = calib_ReadParams(&calib);
+    if (ret != RP_OK) {
+        calib_SetToZero();
+        calib_loaded = false;
+        return ret;
+    }
+    calib_loaded = true;
+    return RP_OK;
+}
 
+/* The EEPROM is read lazily, see loadParams(). A store without pending
+ * changes is read again, to see what other processes committed. */
 int calib_Init()
 {
-    ECHECK(calib_ReadParams(&calib));
+    calib_loaded = false;
+    if (!store_changed) {
+        store_loaded = false;
+    }
     return RP_OK;
 }
 
+/* Writes the pending changes, a stale checksum alone is left to an
+ * explicit commit */
 int calib_Release()
 {
+    if (store_changed) {
+        ECHECK(calib_Commit());
+    }
+    store_loaded = false;
     return RP_OK;
 }
 
 /**
  * Returns cached parameter values
- * @return Cached parameters.
+ * @param params Cached parameters, the defaults if the read failed.
+ * @return RP_OK or the error of reading the parameters.
  */
-rp_calib_params_t calib_GetParams()
+int calib_GetParams(rp_calib_params_t *params)
+{
+    int ret = loadParams();
+    *params = calib;
+    return ret;
+}
+
+/* Reads the checksum and the parameters in one transfer */
+static int readImage(calib_check_t *check, rp_calib_params_t *params)
+{
+    uint8_t image[CALIB_IMAGE_SIZE];
+
+    if(simStore()) {
+        if(!sim_image_valid) {
+            rp_calib_params_t defaults;
+            simDefaultParams(&defaults);
+            calib_check_t sim_check = makeCheck(&defaults);
+            memcpy(sim_image, &sim_check, CALIB_CHECK_SIZE);
+            memcpy(sim_image + CALIB_CHECK_SIZE, &defaults, sizeof(defaults));
+            sim_image_valid = true;
+        }
+        memcpy(image, sim_image, CALIB_IMAGE_SIZE);
+    }
+    else {
+        int fd = open(store_path ? store_path : eeprom_device, O_RDONLY);
+        if(fd < 0) {
+            return RP_EOED;
+        }
+        ssize_t size = pread(fd, image, CALIB_IMAGE_SIZE, store_offset - CALIB_CHECK_SIZE);
+        close(fd);
+        if(size < 0) {
+            return RP_FCA;
+        }
+        if(size < CALIB_IMAGE_SIZE) {
+            return RP_RCA;
+        }
+    }
+    memcpy(check, image, CALIB_CHECK_SIZE);
+    memcpy(params, image + CALIB_CHECK_SIZE, sizeof(rp_calib_params_t));
+    return RP_OK;
+}
+
+/* Writes at pos from the checksum, the parameters follow at CALIB_CHECK_SIZE */
+static int writeAt(int fd, const void *data, size_t len, size_t pos)
 {
-    return calib;
+    if(fd < 0) {
+        memcpy(sim_image + pos, data, len);
+        return RP_OK;
+    }
+    return pwrite(fd, data, len, store_offset - CALIB_CHECK_SIZE + pos) == len ? RP_OK : RP_RCA;
+}
+
+/* Reads the store once. Parameters written before the checksum existed
+ * are taken as they are. So are parameters with a checksum that does not
+ * match them, as other tools (Test/calib, the applications) write the
+ * parameters only; the checksum is rewritten on the next commit. Nothing
+ * read is written back unless the calibration changes it. */
+static int loadStore()
+{
+    calib_check_t check;
+    rp_calib_params_t params;
+
+    if(store_loaded) {
+        return RP_OK;
+    }
+    ECHECK(readImage(&check, &params));
+
+    check_stale = check.magic != CALIB_CHECK_MAGIC
+                  || check.version != CALIB_CHECK_VERSION
+                  || check.crc != crc32(&params, sizeof(rp_calib_params_t));
+    if(check_stale && check.magic == CALIB_CHECK_MAGIC) {
+        fprintf(stderr, "Calibration parameters changed without their checksum, using them as they are\n");
+    }
+
+    store = flushed = params;
+    flushed_valid = true;
+    store_changed = false;
+    if (store.magic != CALIB_MAGIC) {
+        // The stored high gain offsets are not valid, they are written with the next change
+        store.fe_ch1_hi_offs = store.fe_ch1_lo_offs;
+        store.fe_ch2_hi_offs = store.fe_ch2_lo_offs;
+    }
+    store_loaded = true;
+    return RP_OK;
+}
+
+/* Replaces the parameters of the store, they are written on calib_Commit().
+ * A store that could not be read is written whole. */
+static int storeParams(rp_calib_params_t calib_params)
+{
+    if(loadStore() != RP_OK) {
+        flushed_valid = false;
+    }
+    store = calib_params;
+    store.magic = CALIB_MAGIC;
+    store_loaded = true;
+    store_changed = true;
+    return RP_OK;
+}
+
+static uint32_t dirtyWords()
+{
+    const uint32_t *cur = (const uint32_t *)&store;
+    const uint32_t *old = (const uint32_t *)&flushed;
+    uint32_t dirty = 0;
+
+    if(!store_loaded) {
+        return 0;
+    }
+    for(int i = 0; i < CALIB_WORDS; i++) {
+        if(!flushed_valid || cur[i] != old[i]) {
+            dirty |= 1 << i;
+        }
+    }
+    return dirty;
 }
 
 /**
@@ -55,7 +291,8 @@ rp_calib_params_t calib_GetParams()
  * Function reads calibration parameters from EEPROM device and stores them to the
  * specified buffer. Communication to the EEPROM device is taken place through
  * appropriate system driver accessed through the file system device
- * /sys/bus/i2c/devices/0-0050/eeprom.
+ * /sys/bus/i2c/devices/0-0050/eeprom. Once read, the parameters come from
+ * memory, including changes not yet committed.
  *
  * @param[out]   calib_params  Pointer to destination buffer.
  * @retval       0 Success
@@ -64,39 +301,13 @@ rp_calib_params_t calib_GetParams()
  */
 int calib_ReadParams(rp_calib_params_t *calib_params)
 {
-    FILE   *fp;
-    size_t  size;
-
     /* sanity check */
     if(calib_params == NULL) {
         return RP_UIA;
     }
 
-    /* open EEPROM device */
-    fp = fopen(eeprom_device, "r");
-    if(fp == NULL) {
-        return RP_EOED;
-    }
-
-    /* ...and seek to the appropriate storage offset */
-    if(fseek(fp, eeprom_calib_off, SEEK_SET) < 0) {
-        fclose(fp);
-        return RP_FCA;
-    }
-
-    /* read data from EEPROM component and store it to the specified buffer */
-    size = fread(calib_params, sizeof(char), sizeof(rp_calib_params_t), fp);
-    if(size != sizeof(rp_calib_params_t)) {
-        fclose(fp);
-        return RP_RCA;
-    }
-    fclose(fp);
-
-    if (calib_params->magic != CALIB_MAGIC) {
-		calib_params->fe_ch1_hi_offs = calib_params->fe_ch1_lo_offs;
-		calib_params->fe_ch2_hi_offs = calib_params->fe_ch2_lo_offs;
-	}
-
+    ECHECK(loadStore());
+    *calib_params = store;
     return 0;
 }
 
@@ -123,35 +334,91 @@ int calib_GetDefaultParams(rp_calib_params_t *calib_params)
 }
  */
 
-int calib_WriteParams(rp_calib_params_t calib_params) {
-    FILE   *fp;
-    size_t  size;
+/**
+ * Writes the words changed since the last commit, each run of adjacent
+ * words in one transfer, followed by the checksum. A stale checksum is
+ * written even without changes, over the parameters as they are stored.
+ */
+int calib_Commit() {
+    uint32_t dirty = store_changed ? dirtyWords() : 0;
+    const uint32_t *words = (const uint32_t *)&store;
+    calib_check_t check;
+    int fd = -1;
+    int ret = RP_OK;
+
+    if(dirty == 0 && !(store_loaded && check_stale)) {
+        store_changed = false;
+        return RP_OK;
+    }
 
-    /* open EEPROM device */
-    fp = fopen(eeprom_device, "w+");
-    if(fp == NULL) {
-        return RP_EOED;
+    if(!simStore()) {
+        fd = open(store_path ? store_path : eeprom_device, store_path ? O_WRONLY | O_CREAT : O_WRONLY, 0644);
+        if(fd < 0) {
+            return RP_EOED;
+        }
     }
 
-    /* ...and seek to the appropriate storage offset */
-    if(fseek(fp, eeprom_calib_off, SEEK_SET) < 0) {
-        fclose(fp);
-        return RP_FCA;
+    for(int i = 0; i < CALIB_WORDS && ret == RP_OK; i++) {
+        if(!(dirty & (1 << i))) {
+            continue;
+        }
+        int first = i;
+        while(i + 1 < CALIB_WORDS && (dirty & (1 << (i + 1)))) {
+            i++;
+        }
+        ret = writeAt(fd, &words[first], (i - first + 1) * sizeof(uint32_t),
+                      CALIB_CHECK_SIZE + first * sizeof(uint32_t));
     }
+    if(ret == RP_OK) {
+        check = makeCheck(store_changed ? &store : &flushed);
+        ret = writeAt(fd, &check, CALIB_CHECK_SIZE, 0);
+    }
+    if(fd >= 0 && close(fd) != 0 && ret == RP_OK) {
+        ret = RP_RCA;
+    }
+
+    if(ret != RP_OK) {
+        return ret;
+    }
+    if(store_changed) {
+        flushed = store;
+        flushed_valid = true;
+        store_changed = false;
+    }
+    check_stale = false;
+    return RP_OK;
+}
+
+int calib_WriteParams(rp_calib_params_t calib_params) {
+    ECHECK(storeParams(calib_params));
+    return calib_Commit();
+}
 
-    /* write data to EEPROM component */
-    calib_params.magic = CALIB_MAGIC;
-    size = fwrite(&calib_params, sizeof(char), sizeof(rp_calib_params_t), fp);
-    if(size != sizeof(rp_calib_params_t)) {
-        fclose(fp);
-        return RP_RCA;
+int calib_SetStore(const char *path, long offset) {
+    // The checksum goes in front of the parameters
+    if(path != NULL && offset < (long)CALIB_CHECK_SIZE) {
+        return RP_EOOR;
+    }
+    if(store_changed) {
+        ECHECK(calib_Commit());
     }
-    fclose(fp);
 
+    char *copy = NULL;
+    if(path != NULL && (copy = strdup(path)) == NULL) {
+        return RP_EOOR;
+    }
+    free(store_path);
+    store_path = copy;
+    store_offset = path ? offset : eeprom_calib_off;
+    store_loaded = false;
+    flushed_valid = false;
+    store_changed = false;
+    calib_loaded = false;
     return RP_OK;
 }
 
 void calib_SetToZero() {
+    calib_loaded = true;
     calib.be_ch1_dc_offs = 0;
     calib.be_ch2_dc_offs = 0;
     calib.fe_ch1_lo_offs = 0;
@@ -168,6 +435,7 @@ void calib_SetToZero() {
 }
 
 uint32_t calib_GetFrontEndScale(rp_channel_t channel, rp_pinState_t gain) {
+    loadParams();
     if (gain == RP_HIGH) {
         return (channel == RP_CH_1 ? calib.fe_ch1_fs_g_hi : calib.fe_ch2_fs_g_hi);
     }
@@ -192,7 +460,7 @@ int calib_SetFrontEndOffset(rp_channel_t channel, rp_pinState_t gain, rp_calib_p
             params.fe_ch2_hi_offs = 0)
 	}
     /* Acquire uses this calibration parameters - reset them */
-    calib = params;
+    setParams(params);
 
 	if (gain == RP_LOW) {
 		CHANNEL_ACTION(channel,
@@ -218,7 +486,7 @@ int calib_SetFrontEndOffset(rp_channel_t channel, rp_pinState_t gain, rp_calib_p
 		}
 	}
     else
-		ECHECK(calib_WriteParams(params));
+		ECHECK(storeParams(params));
     return calib_Init();
 }
 
@@ -232,7 +500,7 @@ int calib_SetFrontEndScaleLV(rp_channel_t channel, float referentialVoltage, rp_
             params.fe_ch1_fs_g_lo = cmn_CalibFullScaleFromVoltage(20),
             params.fe_ch2_fs_g_lo = cmn_CalibFullScaleFromVoltage(20))
     /* Acquire uses this calibration parameters - reset them */
-    calib = params;
+    setParams(params);
 
     /* Calculate real max adc voltage */
     float value = calib_GetDataMedianFloat(channel, RP_LOW);
@@ -250,7 +518,7 @@ int calib_SetFrontEndScaleLV(rp_channel_t channel, float referentialVoltage, rp_
 				out_params->fe_ch2_fs_g_lo = params.fe_ch2_fs_g_lo)
 	}
     else
-		ECHECK(calib_WriteParams(params));
+		ECHECK(storeParams(params));
     return calib_Init();
 }
 
@@ -264,7 +532,7 @@ int calib_SetFrontEndScaleHV(rp_channel_t channel, float referentialVoltage, rp_
             params.fe_ch1_fs_g_hi = cmn_CalibFullScaleFromVoltage(1),
             params.fe_ch2_fs_g_hi = cmn_CalibFullScaleFromVoltage(1))
     /* Acquire uses this calibration parameters - reset them */
-    calib = params;
+    setParams(params);
 
     /* Calculate real max adc voltage */
     float value = calib_GetDataMedianFloat(channel, RP_HIGH);
@@ -282,7 +550,7 @@ int calib_SetFrontEndScaleHV(rp_channel_t channel, float referentialVoltage, rp_
 				out_params->fe_ch2_fs_g_hi = params.fe_ch2_fs_g_hi)
 	}
     else
-		ECHECK(calib_WriteParams(params));
+		ECHECK(storeParams(params));
     return calib_Init();
 }
 
@@ -296,7 +564,7 @@ int calib_SetBackEndOffset(rp_channel_t channel) {
             params.be_ch1_dc_offs = 0,
             params.be_ch2_dc_offs = 0)
     /* Generate uses this calibration parameters - reset them */
-    calib = params;
+    setParams(params);
 
     /* Generate zero signal */
     ECHECK(rp_GenReset());
@@ -310,7 +578,7 @@ int calib_SetBackEndOffset(rp_channel_t channel) {
             params.be_ch2_dc_offs = -calib_GetDataMedian(channel, RP_LOW))
 
     /* Set new local parameter */
-	ECHECK(calib_WriteParams(params));
+	ECHECK(storeParams(params));
     return calib_Init();
 }
 
@@ -324,7 +592,7 @@ int calib_SetBackEndScale(rp_channel_t channel) {
             params.be_ch1_fs = cmn_CalibFullScaleFromVoltage(1),
             params.be_ch2_fs = cmn_CalibFullScaleFromVoltage(1))
     /* Generate uses this calibration parameters - reset them */
-    calib = params;
+    setParams(params);
 
     /* Generate constant signal signal */
     ECHECK(rp_GenReset());
@@ -343,7 +611,7 @@ int calib_SetBackEndScale(rp_channel_t channel) {
             params.be_ch2_fs = calibValue)
 
     /* Set new local parameter */
-	ECHECK(calib_WriteParams(params));
+	ECHECK(storeParams(params));
     return calib_Init();
 }
 
@@ -381,7 +649,7 @@ int calib_CalibrateBackEnd(rp_channel_t channel, rp_calib_params_t* out_params)
             params.be_ch2_dc_offs = 0)
 
     /* Generate uses this calibration parameters - reset them */
-    calib = params;
+    setParams(params);
 
     float value1, value2;
     getGenAmp(channel, CONSTANT_SIGNAL_AMPLITUDE, &value1, &value2);
@@ -416,95 +684,332 @@ int calib_CalibrateBackEnd(rp_channel_t channel, rp_calib_params_t* out_params)
 				out_params->be_ch2_dc_offs = params.be_ch2_dc_offs)
 	}
     else
-		ECHECK(calib_WriteParams(params));
+		ECHECK(storeParams(params));
     return calib_Init();
 }
 
 int calib_Reset() {
     calib_SetToZero();
-    ECHECK(calib_WriteParams(calib));
+    ECHECK(storeParams(calib));
     return calib_Init();
 }
 
-int32_t calib_GetDataMedian(rp_channel_t channel, rp_pinState_t gain) {
-    /* Acquire data */
-    ECHECK(rp_AcqReset());
-    ECHECK(rp_AcqSetGain(channel, gain));
-    ECHECK(rp_AcqSetDecimation(RP_DEC_64));
+#define ADC_BITS            14
+#define ADC_BITS_MASK       0x3FFF
+/* Calibrated counts -CALIB_HIST_HALF to CALIB_HIST_HALF, see cmn_CalibCnts() */
+#define CALIB_HIST_HALF     (1 << (ADC_BITS - 1))
+#define CALIB_HIST_LEN      (2 * CALIB_HIST_HALF + 1)
+
+static uint32_t sample_buffers = 1;
+static rp_calib_reduce_t sample_reduce = RP_CALIB_MEAN;
+
+/* Samples of both channels, the histogram is only kept for the median
+ * and the trimmed mean */
+typedef struct {
+    int64_t sum[2];
+    uint64_t count;
+    int32_t min[2];
+    int32_t max[2];
+    uint32_t *hist[2];
+} calib_sample_t;
+
+int calib_SetSampling(uint32_t buffers, rp_calib_reduce_t reduce) {
+    if (buffers < 1 || buffers > CALIB_MAX_BUFFERS) {
+        return RP_EOOR;
+    }
+    if (reduce != RP_CALIB_MEAN && reduce != RP_CALIB_MEDIAN && reduce != RP_CALIB_TRIMMED) {
+        return RP_EOOR;
+    }
+    sample_buffers = buffers;
+    sample_reduce = reduce;
+    return RP_OK;
+}
+
+/* Fills the buffer after an immediate trigger, at decimation 64. The
+ * simulated backend has no acquisition, the buffer holds whatever was put
+ * there and the trigger source is cleared by the test, see
+ * Test/calibrate/calibSampleTest.c. */
+static int captureBuffer() {
+    ECHECK(osc_SetTriggerDelay(ADC_BUFFER_SIZE));
     ECHECK(rp_AcqStart());
     ECHECK(rp_AcqSetTriggerSrc(RP_TRIG_SRC_NOW));
-    usleep(1000000);
-    ECHECK(rp_AcqStop());
+    return acq_WaitCaptureDone(acq_DeadlineNs(ADC_BUFFER_SIZE, 64));
+}
 
-    int16_t data[BUFFER_LENGTH];
-    uint32_t bufferSize = (uint32_t) BUFFER_LENGTH;
-    ECHECK(rp_AcqGetDataRaw(channel, 0, &bufferSize, data));
+/* Accumulates the buffer straight from the FPGA memory */
+static void accumulate(calib_sample_t *smp) {
+    const volatile uint32_t *raw[2] = { osc_GetDataBufferChA(), osc_GetDataBufferChB() };
+
+    for (int ch = 0; ch < 2; ch++) {
+        int32_t dc_offs;
+        acq_GetCalibOffset(ch, &dc_offs);
+        int64_t sum = 0;
+        int32_t min = smp->min[ch], max = smp->max[ch];
+        uint32_t *hist = smp->hist[ch];
+        for (int i = 0; i < ADC_BUFFER_SIZE; i++) {
+            int32_t m = cmn_CalibCnts(ADC_BITS, raw[ch][i] & ADC_BITS_MASK, dc_offs);
+            sum += m;
+            min = MIN(min, m);
+            max = MAX(max, m);
+            if (hist) {
+                hist[m + CALIB_HIST_HALF]++;
+            }
+        }
+        smp->sum[ch] += sum;
+        smp->min[ch] = min;
+        smp->max[ch] = max;
+    }
+    smp->count += ADC_BUFFER_SIZE;
+}
 
-    long long avg = 0;
-    for(int i = 0; i < BUFFER_LENGTH; ++i)
-        avg += data[i];
+/* Mean of the samples of rank first to last (0 based, inclusive) */
+static double rankMean(const uint32_t *hist, uint64_t first, uint64_t last) {
+    uint64_t rank = 0;
+    double sum = 0;
+    for (int i = 0; i < CALIB_HIST_LEN && rank <= last; i++) {
+        if (hist[i] == 0) {
+            continue;
+        }
+        uint64_t lo = MAX(rank, first);
+        uint64_t hi = MIN(rank + hist[i] - 1, last);
+        if (lo <= hi) {
+            sum += (double)(hi - lo + 1) * (i - CALIB_HIST_HALF);
+        }
+        rank += hist[i];
+    }
+    return sum / (last - first + 1);
+}
 
-    avg /= BUFFER_LENGTH;
-    fprintf(stderr, "\ncalib_GetDataMedian: avg = %d\n", (int32_t)avg);
-    return avg;
+static double reduce(const calib_sample_t *smp, rp_channel_t channel) {
+    uint64_t n = smp->count;
+    switch (sample_reduce) {
+    case RP_CALIB_MEDIAN:
+        return rankMean(smp->hist[channel], (n - 1) / 2, n / 2);
+    case RP_CALIB_TRIMMED: {
+        uint64_t trim = (uint64_t)(n * CALIB_TRIM);
+        return rankMean(smp->hist[channel], trim, n - 1 - trim);
+    }
+    default:
+        return (double)smp->sum[channel] / n;
+    }
 }
 
-float calib_GetDataMedianFloat(rp_channel_t channel, rp_pinState_t gain) {
-    ECHECK(rp_AcqReset());
-    ECHECK(rp_AcqSetGain(channel, gain));
-    ECHECK(rp_AcqSetDecimation(RP_DEC_64));
-    ECHECK(rp_AcqStart());
-    ECHECK(rp_AcqSetTriggerSrc(RP_TRIG_SRC_NOW));
-    usleep(1000000);
-    int BUF_SIZE = BUFFER_LENGTH;
+static void freeSample(calib_sample_t *smp) {
+    free(smp->hist[0]);
+    free(smp->hist[1]);
+}
 
-    ECHECK(rp_AcqStop());
+/* Captures the configured number of buffers of both inputs with the given gain */
+static int sample(rp_pinState_t gain, calib_sample_t *smp) {
+    smp->sum[0] = smp->sum[1] = 0;
+    smp->count = 0;
+    smp->min[0] = smp->min[1] = INT32_MAX;
+    smp->max[0] = smp->max[1] = INT32_MIN;
+    smp->hist[0] = smp->hist[1] = NULL;
+    if (sample_reduce != RP_CALIB_MEAN) {
+        smp->hist[0] = calloc(CALIB_HIST_LEN, sizeof(uint32_t));
+        smp->hist[1] = calloc(CALIB_HIST_LEN, sizeof(uint32_t));
+        if (!smp->hist[0] || !smp->hist[1]) {
+            freeSample(smp);
+            return RP_EOOR;
+        }
+    }
+
+    int ret = rp_AcqReset();
+    for (int ch = 0; ch < 2 && ret == RP_OK; ch++) {
+        ret = rp_AcqSetGain(ch, gain);
+    }
+    if (ret == RP_OK) {
+        ret = rp_AcqSetDecimation(RP_DEC_64);
+    }
+    for (uint32_t b = 0; b < sample_buffers && ret == RP_OK; b++) {
+        ret = captureBuffer();
+        if (ret == RP_OK) {
+            accumulate(smp);
+        }
+    }
+    if (ret == RP_OK) {
+        ret = rp_AcqStop();
+    }
+    if (ret != RP_OK) {
+        freeSample(smp);
+    }
+    return ret;
+}
 
-    float data[BUF_SIZE];
-    uint32_t bufferSize = (uint32_t) BUF_SIZE;
-    ECHECK(rp_AcqGetDataV(channel, 0, &bufferSize, data));
+/* Calibrated counts to volts, cmn_CnvCalibCntToV() without rounding the counts */
+static float cntsToV(rp_channel_t channel, rp_pinState_t gain, double cnts) {
+    float gainV;
+    acq_GetGainV(channel, &gainV);
+    double scaleV = cmn_CalibFullScaleToVoltage(calib_GetFrontEndScale(channel, gain));
+    return cnts * gainV / CALIB_HIST_HALF * scaleV / (FULL_SCALE_NORM / gainV);
+}
 
-    double avg = 0;
-    for(int i = 0; i < BUFFER_LENGTH; ++i)
-        avg += data[i];
+int32_t calib_GetDataMedian(rp_channel_t channel, rp_pinState_t gain) {
+    calib_sample_t smp;
+    ECHECK(sample(gain, &smp));
+    double cnts = reduce(&smp, channel);
+    freeSample(&smp);
 
-    avg /= BUFFER_LENGTH;
-    fprintf(stderr, "\ncalib_GetDataMedianFloat: avg = %f\n", (float)avg);
-    return avg;
+    fprintf(stderr, "\ncalib_GetDataMedian: avg = %d\n", (int32_t)cnts);
+    return cnts;
+}
+
+float calib_GetDataMedianFloat(rp_channel_t channel, rp_pinState_t gain) {
+    calib_sample_t smp;
+    ECHECK(sample(gain, &smp));
+    float value = cntsToV(channel, gain, reduce(&smp, channel));
+    freeSample(&smp);
+
+    fprintf(stderr, "\ncalib_GetDataMedianFloat: avg = %f\n", value);
+    return value;
 }
 
 int calib_GetDataMinMaxFloat(rp_channel_t channel, rp_pinState_t gain, float* min, float* max) {
-    ECHECK(rp_AcqReset());
-    ECHECK(rp_AcqSetGain(channel, gain));
-    ECHECK(rp_AcqSetDecimation(RP_DEC_64));
-    ECHECK(rp_AcqStart());
-    ECHECK(rp_AcqSetTriggerSrc(RP_TRIG_SRC_NOW));
-    usleep(1000000);
-    int BUF_SIZE = BUFFER_LENGTH;
+    calib_sample_t smp;
+    ECHECK(sample(gain, &smp));
+    *min = cntsToV(channel, gain, smp.min[channel]);
+    *max = cntsToV(channel, gain, smp.max[channel]);
+    freeSample(&smp);
+
+    fprintf(stderr, "\ncalib_GetDataMinMaxFloat: min = %f, max = %f\n", *min, *max);
+    return RP_OK;
+}
 
-    ECHECK(rp_AcqStop());
+/* Both inputs from the same buffers, in calibrated counts */
+static int sampleBoth(rp_pinState_t gain, double cnts[2]) {
+    calib_sample_t smp;
+    ECHECK(sample(gain, &smp));
+    cnts[RP_CH_1] = reduce(&smp, RP_CH_1);
+    cnts[RP_CH_2] = reduce(&smp, RP_CH_2);
+    freeSample(&smp);
+    return RP_OK;
+}
 
-    float data[BUF_SIZE];
-    uint32_t bufferSize = (uint32_t) BUF_SIZE;
-    ECHECK(rp_AcqGetDataV(channel, 0, &bufferSize, data));
+int calib_SetFrontEndOffsetBoth(rp_pinState_t gain, rp_calib_params_t* out_params) {
+    rp_calib_params_t params;
+    double cnts[2];
+    ECHECK(calib_ReadParams(&params));
+    failsafa_params = params;
 
-    float _min = data[0];
-    float _max = data[0];
-    for(int i = 1; i < BUFFER_LENGTH; ++i) {
-        _min = (_min > data[i]) ? data[i] : _min;
-        _max = (_max < data[i]) ? data[i] : _max;
+    /* Reset current calibration parameters*/
+    if (gain == RP_LOW) {
+        params.fe_ch1_lo_offs = params.fe_ch2_lo_offs = 0;
+    } else {
+        params.fe_ch1_hi_offs = params.fe_ch2_hi_offs = 0;
     }
+    /* Acquire uses this calibration parameters - reset them */
+    setParams(params);
 
-    fprintf(stderr, "\ncalib_GetDataMinMaxFloat: min = %f, max = %f\n", _min, _max);
-    *min = _min;
-    *max = _max;
-    return RP_OK;
+    ECHECK(sampleBoth(gain, cnts));
+    if (gain == RP_LOW) {
+        params.fe_ch1_lo_offs = cnts[RP_CH_1];
+        params.fe_ch2_lo_offs = cnts[RP_CH_2];
+    } else {
+        params.fe_ch1_hi_offs = cnts[RP_CH_1];
+        params.fe_ch2_hi_offs = cnts[RP_CH_2];
+    }
+
+    /* Set new local parameter */
+    if (out_params) {
+        if (gain == RP_LOW) {
+            out_params->fe_ch1_lo_offs = params.fe_ch1_lo_offs;
+            out_params->fe_ch2_lo_offs = params.fe_ch2_lo_offs;
+        } else {
+            out_params->fe_ch1_hi_offs = params.fe_ch1_hi_offs;
+            out_params->fe_ch2_hi_offs = params.fe_ch2_hi_offs;
+        }
+    }
+    else
+        ECHECK(storeParams(params));
+    return calib_Init();
+}
+
+int calib_SetFrontEndScaleLVBoth(float referentialVoltage, rp_calib_params_t* out_params) {
+    rp_calib_params_t params;
+    double cnts[2];
+    ECHECK(calib_ReadParams(&params));
+    failsafa_params = params;
+
+    /* Reset current calibration parameters*/
+    params.fe_ch1_fs_g_lo = params.fe_ch2_fs_g_lo = cmn_CalibFullScaleFromVoltage(20);
+    /* Acquire uses this calibration parameters - reset them */
+    setParams(params);
+
+    /* Calculate real max adc voltage */
+    ECHECK(sampleBoth(RP_LOW, cnts));
+    params.fe_ch1_fs_g_lo = cmn_CalibFullScaleFromVoltage(20.f * referentialVoltage / cntsToV(RP_CH_1, RP_LOW, cnts[RP_CH_1]));
+    params.fe_ch2_fs_g_lo = cmn_CalibFullScaleFromVoltage(20.f * referentialVoltage / cntsToV(RP_CH_2, RP_LOW, cnts[RP_CH_2]));
+
+    /* Set new local parameter */
+    if (out_params) {
+        out_params->fe_ch1_fs_g_lo = params.fe_ch1_fs_g_lo;
+        out_params->fe_ch2_fs_g_lo = params.fe_ch2_fs_g_lo;
+    }
+    else
+        ECHECK(storeParams(params));
+    return calib_Init();
+}
+
+int calib_SetFrontEndScaleHVBoth(float referentialVoltage, rp_calib_params_t* out_params) {
+    rp_calib_params_t params;
+    double cnts[2];
+    ECHECK(calib_ReadParams(&params));
+    failsafa_params = params;
+
+    /* Reset current calibration parameters*/
+    params.fe_ch1_fs_g_hi = params.fe_ch2_fs_g_hi = cmn_CalibFullScaleFromVoltage(1);
+    /* Acquire uses this calibration parameters - reset them */
+    setParams(params);
+
+    /* Calculate real max adc voltage */
+    ECHECK(sampleBoth(RP_HIGH, cnts));
+    params.fe_ch1_fs_g_hi = cmn_CalibFullScaleFromVoltage(referentialVoltage / cntsToV(RP_CH_1, RP_HIGH, cnts[RP_CH_1]));
+    params.fe_ch2_fs_g_hi = cmn_CalibFullScaleFromVoltage(referentialVoltage / cntsToV(RP_CH_2, RP_HIGH, cnts[RP_CH_2]));
+
+    /* Set new local parameter */
+    if (out_params) {
+        out_params->fe_ch1_fs_g_hi = params.fe_ch1_fs_g_hi;
+        out_params->fe_ch2_fs_g_hi = params.fe_ch2_fs_g_hi;
+    }
+    else
+        ECHECK(storeParams(params));
+    return calib_Init();
+}
+
+int calib_SetBackEndOffsetBoth() {
+    rp_calib_params_t params;
+    double cnts[2];
+    ECHECK(calib_ReadParams(&params));
+    failsafa_params = params;
+
+    /* Reset current calibration parameters*/
+    params.be_ch1_dc_offs = params.be_ch2_dc_offs = 0;
+    /* Generate uses this calibration parameters - reset them */
+    setParams(params);
+
+    /* Generate zero signal on both outputs */
+    ECHECK(rp_GenReset());
+    for (int ch = 0; ch < 2; ch++) {
+        ECHECK(rp_GenWaveform(ch, RP_WAVEFORM_SINE));
+        ECHECK(rp_GenAmp(ch, 0));
+        ECHECK(rp_GenOffset(ch, 0));
+        ECHECK(rp_GenOutEnable(ch));
+    }
+
+    ECHECK(sampleBoth(RP_LOW, cnts));
+    params.be_ch1_dc_offs = -(int32_t)cnts[RP_CH_1];
+    params.be_ch2_dc_offs = -(int32_t)cnts[RP_CH_2];
+
+    /* Set new local parameter */
+    ECHECK(storeParams(params));
+    return calib_Init();
 }
 
 int calib_setCachedParams() {
 	fprintf(stderr, "write FAILSAFE PARAMS\n");
     ECHECK(calib_WriteParams(failsafa_params));
-    calib = failsafa_params;
+    setParams(failsafa_params);
 
     return 0;
 }
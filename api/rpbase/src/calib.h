@@ -21,11 +21,19 @@
 
 #define CONSTANT_SIGNAL_AMPLITUDE 0.8
 
+/* Most buffers a calibration sample may gather */
+#define CALIB_MAX_BUFFERS   1024
+/* Part of the samples dropped at each end by RP_CALIB_TRIMMED */
+#define CALIB_TRIM          0.1
+
 int calib_Init();
 int calib_Release();
 
-rp_calib_params_t calib_GetParams();
+int calib_GetParams(rp_calib_params_t *params);
 int calib_WriteParams(rp_calib_params_t calib_params);
+/* The calibration functions change the parameters in memory, this writes them */
+int calib_Commit();
+int calib_SetStore(const char *path, long offset);
 void calib_SetToZero();
 
 uint32_t calib_GetFrontEndScale(rp_channel_t channel, rp_pinState_t gain);
@@ -37,11 +45,18 @@ int calib_SetBackEndOffset(rp_channel_t channel);
 int calib_SetBackEndScale(rp_channel_t channel);
 int calib_CalibrateBackEnd(rp_channel_t channel, rp_calib_params_t* out_params);
 
+/* Both channels from one capture, with one EEPROM write */
+int calib_SetFrontEndOffsetBoth(rp_pinState_t gain, rp_calib_params_t* out_params);
+int calib_SetFrontEndScaleLVBoth(float referentialVoltage, rp_calib_params_t* out_params);
+int calib_SetFrontEndScaleHVBoth(float referentialVoltage, rp_calib_params_t* out_params);
+int calib_SetBackEndOffsetBoth();
+
 int calib_Reset();
 
 int32_t calib_GetDataMedian(rp_channel_t channel, rp_pinState_t gain);
 float calib_GetDataMedianFloat(rp_channel_t channel, rp_pinState_t gain);
 int calib_GetDataMinMaxFloat(rp_channel_t channel, rp_pinState_t gain, float* min, float* max);
+int calib_SetSampling(uint32_t buffers, rp_calib_reduce_t reduce);
 
 int calib_setCachedParams();
 #endif //__CALIB_H
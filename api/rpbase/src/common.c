@@ -13,45 +13,120 @@
  */
 
 #include <fcntl.h>
+#include <stdlib.h>
 #include <unistd.h>
 #include <sys/mman.h>
 #include <stdio.h>
 #include <math.h>
+#include <time.h>
 
 #include "common.h"
 
-static int fd = NULL;
+static int fd = -1;
+
+/* Registers are backed by plain memory instead of /dev/mem */
+static bool simulated = false;
+
+/* The whole register window, mapped once and shared by all modules */
+static void *regs = NULL;
+
+#ifdef RP_STATS
+__thread uint64_t cmn_mmio = 0;
+#endif
+
+/* Oscilloscope, generator, housekeeping and analog mixed signals */
+#define SHADOW_REGIONS  4
+#define SHADOW_WORDS    64
+
+/* Write-through copy of the configuration registers at the start of a
+ * mapping, it serves the getters. The registers the FPGA changes by itself
+ * (status, counters, pointers, inputs) are marked live and always read from
+ * the hardware. Other processes write the registers too, so the setters
+ * that change part of a register read it from the hardware first. */
+typedef struct {
+    volatile uint32_t *regs;
+    uint32_t words;
+    uint64_t live;
+    uint32_t shadow[SHADOW_WORDS];
+} shadow_region_t;
+
+static shadow_region_t shadows[SHADOW_REGIONS];
 
 int cmn_Init()
 {
-    if (!fd) {
+    if (regs != NULL) {
+        return RP_OK;
+    }
+    if (getenv("RP_SIMULATE") != NULL) {
+        simulated = true;
+        // Zero filled, shared so that forked servers see the same registers
+        regs = mmap(NULL, CMN_REGS_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    }
+    else {
         if((fd = open("/dev/mem", O_RDWR | O_SYNC)) == -1) {
             return RP_EOMD;
         }
+        regs = mmap(NULL, CMN_REGS_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, CMN_REGS_ADDR);
+    }
+    if (regs == MAP_FAILED) {
+        regs = NULL;
+        return RP_EMMD;
     }
     return RP_OK;
 }
 
 int cmn_Release()
 {
-    if (fd) {
+    if (regs != NULL) {
+        if (munmap(regs, CMN_REGS_SIZE) < 0) {
+            return RP_EUMD;
+        }
+        regs = NULL;
+    }
+    simulated = false;
+    if (fd != -1) {
         if(close(fd) < 0) {
             return RP_ECMD;
         }
+        fd = -1;
     }
 
     return RP_OK;
 }
 
+bool cmn_IsSimulated()
+{
+    return simulated;
+}
+
+static bool inWindow(size_t size, size_t offset)
+{
+    return offset >= CMN_REGS_ADDR && offset + size <= CMN_REGS_ADDR + CMN_REGS_SIZE;
+}
+
+/**
+ * Maps a register block. Blocks in the register window are handed out from
+ * the mapping made by cmn_Init(), others get a mapping of their own.
+ */
 int cmn_Map(size_t size, size_t offset, void** mapped)
 {
+    if (regs != NULL && inWindow(size, offset)) {
+        *mapped = (char*)regs + (offset - CMN_REGS_ADDR);
+        return RP_OK;
+    }
+
+    if (simulated) {
+        *mapped = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        return *mapped == MAP_FAILED ? RP_EMMD : RP_OK;
+    }
+
     if(fd == -1) {
         return RP_EMMD;
     }
 
     *mapped = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, offset);
 
-    if(mapped == (void *) -1) {
+    if(*mapped == MAP_FAILED) {
         return RP_EMMD;
     }
 
@@ -60,16 +135,13 @@ int cmn_Map(size_t size, size_t offset, void** mapped)
 
 int cmn_Unmap(size_t size, void** mapped)
 {
-    if(fd == -1) {
+    if((mapped == NULL) || (*mapped == MAP_FAILED) || (*mapped == NULL)) {
         return RP_EUMD;
     }
 
-    if((mapped == (void *) -1) || (mapped == NULL)) {
-        return RP_EUMD;
-    }
-
-    if((*mapped == (void *) -1) || (*mapped == NULL)) {
-        return RP_EUMD;
+    if (regs != NULL && (char*)*mapped >= (char*)regs && (char*)*mapped < (char*)regs + CMN_REGS_SIZE) {
+        *mapped = NULL;
+        return RP_OK;
     }
 
     if(munmap(*mapped, size) < 0){
@@ -79,14 +151,122 @@ int cmn_Unmap(size_t size, void** mapped)
     return RP_OK;
 }
 
+static void syncRegion(shadow_region_t *r)
+{
+    for (uint32_t i = 0; i < r->words; i++) {
+        if (!((r->live >> i) & 1)) {
+            r->shadow[i] = ioread32(&r->regs[i]);
+        }
+    }
+}
+
+/* Shadow copy of a register, NULL if it is live or not shadowed */
+static uint32_t* shadowOf(volatile uint32_t* field)
+{
+    for (int i = 0; i < SHADOW_REGIONS; i++) {
+        shadow_region_t *r = &shadows[i];
+        if (r->regs != NULL && field >= r->regs && field < r->regs + r->words) {
+            uint32_t word = field - r->regs;
+            return (r->live >> word) & 1 ? NULL : &r->shadow[word];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Shadows the first size bytes of a register mapping. The shadow is filled
+ * from the hardware; from then on the cmn_* register functions serve reads
+ * of the shadowed registers from memory and write through. Modules that use
+ * the register structure directly get the shadow in the same layout and
+ * write it back with cmn_WriteThrough().
+ *
+ * @param[in] regs Mapped registers
+ * @param[in] size Shadowed size in bytes, at most 64 registers
+ * @param[in] live Registers never shadowed, one bit per register, see SHADOW_LIVE()
+ * @param[out] shadow Shadow copy, may be NULL
+ */
+int cmn_AddShadow(volatile void* regs, size_t size, uint64_t live, void** shadow)
+{
+    if (size > SHADOW_WORDS * sizeof(uint32_t)) {
+        return RP_EOOR;
+    }
+    for (int i = 0; i < SHADOW_REGIONS; i++) {
+        shadow_region_t *r = &shadows[i];
+        if (r->regs == NULL) {
+            r->regs = regs;
+            r->words = size / sizeof(uint32_t);
+            r->live = live;
+            syncRegion(r);
+            if (shadow != NULL) {
+                *shadow = r->shadow;
+            }
+            return RP_OK;
+        }
+    }
+    return RP_EOOR;
+}
+
+int cmn_RemoveShadow(volatile void* regs)
+{
+    for (int i = 0; i < SHADOW_REGIONS; i++) {
+        if (shadows[i].regs == regs) {
+            shadows[i].regs = NULL;
+        }
+    }
+    return RP_OK;
+}
+
+/* Rereads all shadowed registers, for changes made by other processes */
+int cmn_SyncShadows()
+{
+    for (int i = 0; i < SHADOW_REGIONS; i++) {
+        if (shadows[i].regs != NULL) {
+            syncRegion(&shadows[i]);
+        }
+    }
+    return RP_OK;
+}
+
+/* Rereads the register holding a field of a shadow from the hardware, before
+ * a field of it is changed */
+int cmn_ReadThrough(void* shadow_field)
+{
+    for (int i = 0; i < SHADOW_REGIONS; i++) {
+        shadow_region_t *r = &shadows[i];
+        uint32_t *word = (uint32_t*)((uintptr_t)shadow_field & ~(uintptr_t)3);
+        if (r->regs != NULL && word >= r->shadow && word < r->shadow + r->words) {
+            *word = ioread32(&r->regs[word - r->shadow]);
+            return RP_OK;
+        }
+    }
+    return RP_EOOR;
+}
+
+/* Writes the register holding a field of a shadow to the hardware */
+int cmn_WriteThrough(const void* shadow_field)
+{
+    for (int i = 0; i < SHADOW_REGIONS; i++) {
+        shadow_region_t *r = &shadows[i];
+        const uint32_t *word = (const uint32_t*)((uintptr_t)shadow_field & ~(uintptr_t)3);
+        if (r->regs != NULL && word >= r->shadow && word < r->shadow + r->words) {
+            iowrite32(*word, &r->regs[word - r->shadow]);
+            return RP_OK;
+        }
+    }
+    return RP_EOOR;
+}
+
 int cmn_SetShiftedValue(volatile uint32_t* field, uint32_t value, uint32_t mask, uint32_t bitsToSetShift)
 {
     VALIDATE_BITS(value, mask);
-    uint32_t currentValue;
-    cmn_GetValue(field, &currentValue, 0xffffffff);
+    uint32_t *shadow = shadowOf(field);
+    uint32_t currentValue = ioread32(field);
     currentValue &=  ~(mask << bitsToSetShift); // Clear all bits at specified location
     currentValue +=  (value << bitsToSetShift); // Set value at specified location
-    SET_VALUE(*field, currentValue);
+    if (shadow) {
+        *shadow = currentValue;
+    }
+    iowrite32(currentValue, field);
     return RP_OK;
 }
 
@@ -97,7 +277,8 @@ int cmn_SetValue(volatile uint32_t* field, uint32_t value, uint32_t mask)
 
 int cmn_GetShiftedValue(volatile uint32_t* field, uint32_t* value, uint32_t mask, uint32_t bitsToSetShift)
 {
-    *value = (*field >> bitsToSetShift) & mask;
+    uint32_t *shadow = shadowOf(field);
+    *value = ((shadow ? *shadow : ioread32(field)) >> bitsToSetShift) & mask;
     return RP_OK;
 }
 
@@ -109,21 +290,34 @@ int cmn_GetValue(volatile uint32_t* field, uint32_t* value, uint32_t mask)
 int cmn_SetBits(volatile uint32_t* field, uint32_t bits, uint32_t mask)
 {
     VALIDATE_BITS(bits, mask);
-    SET_BITS(*field, bits);
+    uint32_t *shadow = shadowOf(field);
+    uint32_t currentValue = ioread32(field);
+    SET_BITS(currentValue, bits);
+    if (shadow) {
+        *shadow = currentValue;
+    }
+    iowrite32(currentValue, field);
     return RP_OK;
 }
 
 int cmn_UnsetBits(volatile uint32_t* field, uint32_t bits, uint32_t mask)
 {
     VALIDATE_BITS(bits, mask);
-    UNSET_BITS(*field, bits);
+    uint32_t *shadow = shadowOf(field);
+    uint32_t currentValue = ioread32(field);
+    UNSET_BITS(currentValue, bits);
+    if (shadow) {
+        *shadow = currentValue;
+    }
+    iowrite32(currentValue, field);
     return RP_OK;
 }
 
-int cmn_AreBitsSet(volatile uint32_t field, uint32_t bits, uint32_t mask, bool* result)
+int cmn_AreBitsSet(volatile uint32_t* field, uint32_t bits, uint32_t mask, bool* result)
 {
     VALIDATE_BITS(bits, mask);
-    *result = ARE_BITS_SET(field, bits);
+    uint32_t *shadow = shadowOf(field);
+    *result = ARE_BITS_SET(shadow ? *shadow : ioread32(field), bits);
     return RP_OK;
 }
 
@@ -146,6 +340,19 @@ int floatCmp(const void *a, const void *b) {
     return (fa > fb) - (fa < fb);
 }
 
+uint64_t cmn_NowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void cmn_SleepNs(uint64_t ns) {
+    struct timespec t = { ns / 1000000000ULL, ns % 1000000000ULL };
+    while (nanosleep(&t, &t) != 0) {
+        ;
+    }
+}
+
 /*----------------------------------------------------------------------------*/
 
 /**
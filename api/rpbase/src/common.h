@@ -16,6 +16,7 @@
 #define COMMON_H_
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 
@@ -40,9 +41,20 @@ else { \
     return RP_EPN; \
 }
 
+#ifdef RP_STATS
+// Register accesses of the calling thread, reported by the call statistics
+extern __thread uint64_t cmn_mmio;
+#define MMIO_COUNT() (cmn_mmio++)
+#else
+#define MMIO_COUNT() ((void)0)
+#endif
+
 // unmasked IO read/write (p - pointer, v - value)
-#define ioread32(p) (*(volatile uint32_t *)(p))
-#define iowrite32(v,p) (*(volatile uint32_t *)(p) = (v))
+#define ioread32(p) (MMIO_COUNT(), *(volatile uint32_t *)(p))
+#define iowrite32(v,p) (MMIO_COUNT(), *(volatile uint32_t *)(p) = (v))
+
+// Bit of a register in the live mask of cmn_AddShadow()
+#define SHADOW_LIVE(type, field) (1ULL << (offsetof(type, field) / sizeof(uint32_t)))
 
 #define SET_BITS(x,b) ((x) |= (b))
 #define UNSET_BITS(x,b) ((x) &= ~(b))
@@ -60,24 +72,39 @@ else { \
 
 #define FULL_SCALE_NORM     20.0    // V
 
+// Register window from housekeeping to the analog mixed signals block
+#define CMN_REGS_ADDR       0x40000000
+#define CMN_REGS_SIZE       0x00401000
+
 int cmn_Init();
 int cmn_Release();
+bool cmn_IsSimulated();
 
 int cmn_Map(size_t size, size_t offset, void** mapped);
 int cmn_Unmap(size_t size, void** mapped);
 
+int cmn_AddShadow(volatile void* regs, size_t size, uint64_t live, void** shadow);
+int cmn_RemoveShadow(volatile void* regs);
+int cmn_SyncShadows();
+int cmn_ReadThrough(void* shadow_field);
+int cmn_WriteThrough(const void* shadow_field);
+
 int cmn_SetBits(volatile uint32_t* field, uint32_t bits, uint32_t mask);
 int cmn_UnsetBits(volatile uint32_t* field, uint32_t bits, uint32_t mask);
 int cmn_SetValue(volatile uint32_t* field, uint32_t value, uint32_t mask);
 int cmn_SetShiftedValue(volatile uint32_t* field, uint32_t value, uint32_t mask, uint32_t bitsToSet);
 int cmn_GetValue(volatile uint32_t* field, uint32_t* value, uint32_t mask);
 int cmn_GetShiftedValue(volatile uint32_t* field, uint32_t* value, uint32_t mask, uint32_t bitsToSetShift);
-int cmn_AreBitsSet(volatile uint32_t field, uint32_t bits, uint32_t mask, bool* result);
+int cmn_AreBitsSet(volatile uint32_t* field, uint32_t bits, uint32_t mask, bool* result);
 
 int intcmp(const void *a, const void *b);
 int int16cmp(const void *aa, const void *bb);
 int floatCmp(const void *a, const void *b);
 
+// Monotonic time [ns]
+uint64_t cmn_NowNs();
+void cmn_SleepNs(uint64_t ns);
+
 float cmn_CalibFullScaleToVoltage(uint32_t fullScaleGain);
 uint32_t cmn_CalibFullScaleFromVoltage(float voltageScale);
 
@@ -0,0 +1,406 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library serial protocol decoder module implementation
+ *
+ * Decoding has two stages. A single pass over the buffer turns the used
+ * channels into one edge list, in time order, with a Schmitt trigger per
+ * channel whose thresholds are converted to raw counts once, so samples are
+ * compared as they are. The protocol state machines then only walk the
+ * edges: UART samples the line in the middle of every bit from the start
+ * edge on, I2C and SPI sample the data line at the clock edges.
+ *
+ * Times are in samples from the first decoded sample, at the current
+ * sampling rate.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdlib.h>
+#include <math.h>
+
+#include "common.h"
+#include "oscilloscope.h"
+#include "acq_handler.h"
+#include "decode.h"
+
+#define ADC_BITS_MASK   0x3FFF
+#define ADC_SIGN        0x2000
+
+typedef struct {
+    uint32_t time;
+    uint8_t ch;
+    uint8_t level;
+} edge_t;
+
+typedef struct {
+    edge_t *edges;
+    uint32_t n;
+    uint32_t size;          // decoded samples
+    uint8_t init[2];        // levels at the first sample
+} edges_t;
+
+typedef struct {
+    rp_decode_event_t *events;
+    uint32_t size;
+    uint32_t n;
+    bool overflow;
+} out_t;
+
+static inline int32_t rawCnts(uint32_t raw)
+{
+    return (int32_t)((raw & ADC_BITS_MASK) ^ ADC_SIGN) - ADC_SIGN;
+}
+
+static void emit(out_t *o, uint32_t time, uint16_t data, uint16_t flags)
+{
+    if (o->n < o->size) {
+        o->events[o->n].time = time;
+        o->events[o->n].data = data;
+        o->events[o->n].flags = flags;
+        o->n++;
+    }
+    else {
+        o->overflow = true;
+    }
+}
+
+/* The single pass, levels are high from level + hyst / 2 on and low below
+ * level - hyst / 2 */
+static int extract(const rp_decode_cfg_t *cfg, const bool used[2], uint32_t pos, edges_t *e)
+{
+    // The capture is complete, the buffers are read as plain memory
+    const uint32_t *buf[2] = { (const uint32_t *)osc_GetDataBufferChA(),
+                               (const uint32_t *)osc_GetDataBufferChB() };
+    int32_t hi[2] = { 0, 0 }, lo[2] = { 0, 0 };
+    uint8_t state[2] = { 0, 0 };
+    uint32_t idx = pos % ADC_BUFFER_SIZE;
+
+    for (int ch = 0; ch < 2; ch++) {
+        if (used[ch]) {
+            ECHECK(acq_CnvVToRawCnt(ch, cfg->level[ch] + cfg->hyst[ch] / 2, &hi[ch]));
+            ECHECK(acq_CnvVToRawCnt(ch, cfg->level[ch] - cfg->hyst[ch] / 2, &lo[ch]));
+            state[ch] = rawCnts(buf[ch][idx]) >= (hi[ch] + lo[ch]) / 2;
+            e->init[ch] = state[ch];
+        }
+    }
+
+    const int data_ch = cfg->channel, clk_ch = !cfg->channel;
+    e->n = 0;
+    for (uint32_t i = 0; i < e->size; i++) {
+        bool toggle[2] = { false, false };
+        for (int ch = 0; ch < 2; ch++) {
+            if (used[ch]) {
+                int32_t v = rawCnts(buf[ch][idx]);
+                toggle[ch] = state[ch] ? v < lo[ch] : v >= hi[ch];
+            }
+        }
+        // Edges in the same sample: a falling clock goes before the data and
+        // a rising one after it, the data is taken as stable at clock edges
+        int order[2] = { data_ch, clk_ch };
+        if (toggle[clk_ch] && state[clk_ch]) {
+            order[0] = clk_ch;
+            order[1] = data_ch;
+        }
+        for (int j = 0; j < 2; j++) {
+            int ch = order[j];
+            if (toggle[ch]) {
+                state[ch] = !state[ch];
+                e->edges[e->n].time = i;
+                e->edges[e->n].ch = ch;
+                e->edges[e->n].level = state[ch];
+                e->n++;
+            }
+        }
+        if (++idx == ADC_BUFFER_SIZE) {
+            idx = 0;
+        }
+    }
+    return RP_OK;
+}
+
+/* Bit period in samples from the pulse widths: the shortest pulse is one
+ * bit, the other pulses refine the estimate by their bit counts */
+static double uartBitPeriod(const edges_t *e)
+{
+    uint32_t min = UINT32_MAX;
+    double sum = 0, bits = 0;
+
+    for (uint32_t k = 1; k < e->n; k++) {
+        min = MIN(min, e->edges[k].time - e->edges[k - 1].time);
+    }
+    if (min == UINT32_MAX) {
+        return 0;
+    }
+    for (uint32_t k = 1; k < e->n; k++) {
+        uint32_t width = e->edges[k].time - e->edges[k - 1].time;
+        double n = round((double)width / min);
+        // Idle time between frames need not be whole bits
+        if (n <= DECODE_UART_MAX_BITS && fabs(width - n * min) <= DECODE_UART_BIT_TOL * min) {
+            sum += width;
+            bits += n;
+        }
+    }
+    return sum / bits;
+}
+
+typedef struct {
+    const edges_t *e;
+    uint32_t next;
+    uint8_t level;
+} cursor_t;
+
+/* Line level at time t, t must not decrease between calls */
+static uint8_t levelAt(cursor_t *c, double t)
+{
+    while (c->next < c->e->n && c->e->edges[c->next].time <= t) {
+        c->level = c->e->edges[c->next++].level;
+    }
+    return c->level;
+}
+
+static void decodeUart(const rp_decode_cfg_t *cfg, const edges_t *e, double fs, out_t *o, float *rate)
+{
+    const uint8_t idle = cfg->invert ? 0 : 1;
+    const uint32_t bits = cfg->data_bits ? cfg->data_bits : 8;
+    const uint32_t frame = bits + (cfg->parity != RP_DECODE_PARITY_NONE) + 2;
+    double period = cfg->baud ? fs / cfg->baud : uartBitPeriod(e);
+    cursor_t c = { e, 0, e->init[cfg->channel] };
+
+    *rate = period > 0 ? fs / period : 0;
+    if (period <= 0) {
+        return;
+    }
+
+    while (true) {
+        // Start edge, from idle to active
+        while (c.next < e->n && e->edges[c.next].level == idle) {
+            c.level = e->edges[c.next++].level;
+        }
+        if (c.next == e->n) {
+            break;
+        }
+        double t0 = e->edges[c.next].time;
+        if (t0 + (frame - 0.5) * period >= e->size) {
+            break;
+        }
+        if (levelAt(&c, t0 + 0.5 * period) == idle) {
+            continue;   // glitch
+        }
+
+        uint16_t data = 0, flags = 0;
+        uint32_t ones = 0;
+        for (uint32_t b = 0; b < bits; b++) {
+            uint32_t bit = levelAt(&c, t0 + (1.5 + b) * period) == idle;
+            data |= bit << b;
+            ones += bit;
+        }
+        if (cfg->parity != RP_DECODE_PARITY_NONE) {
+            ones += levelAt(&c, t0 + (1.5 + bits) * period) == idle;
+            if ((ones & 1) != (cfg->parity == RP_DECODE_PARITY_ODD)) {
+                flags |= RP_DECODE_F_PARITY_ERR;
+            }
+        }
+        if (levelAt(&c, t0 + (frame - 0.5) * period) != idle) {
+            flags |= ones ? RP_DECODE_F_FRAME_ERR : RP_DECODE_F_BREAK;
+        }
+        emit(o, t0, data, flags);
+    }
+}
+
+static void decodeI2c(const rp_decode_cfg_t *cfg, const edges_t *e, double fs, out_t *o, float *rate)
+{
+    const uint8_t sda_ch = cfg->channel;
+    uint8_t sda = e->init[sda_ch], scl = e->init[!sda_ch];
+    int bit = -1;               // bit in the byte, -1 until a start
+    uint16_t byte = 0;
+    uint32_t byte_time = 0, last_rise = 0;
+    bool address = false;
+    double sum = 0;
+    uint32_t periods = 0;
+
+    for (uint32_t k = 0; k < e->n; k++) {
+        const edge_t *edge = &e->edges[k];
+        if (edge->ch != sda_ch) {
+            scl = edge->level;
+            if (!scl || bit < 0) {
+                continue;
+            }
+            if (bit == 0) {
+                byte_time = edge->time;
+                byte = 0;
+            }
+            else {
+                sum += edge->time - last_rise;
+                periods++;
+            }
+            last_rise = edge->time;
+            if (bit < 8) {
+                byte = (byte << 1) | sda;
+                bit++;
+            }
+            else {
+                emit(o, byte_time, byte, (sda ? RP_DECODE_F_NACK : 0) | (address ? RP_DECODE_F_ADDRESS : 0));
+                address = false;
+                bit = 0;
+            }
+            continue;
+        }
+
+        sda = edge->level;
+        if (!scl) {
+            continue;
+        }
+        // Data changing while the clock is high, start or stop. Their own
+        // clock pulse reads as a first bit, a byte is only cut after that
+        if (bit > 1) {
+            emit(o, byte_time, byte, RP_DECODE_F_PARTIAL);
+        }
+        if (!sda) {
+            emit(o, edge->time, 0, RP_DECODE_F_START);
+            address = true;
+            bit = 0;
+        }
+        else {
+            emit(o, edge->time, 0, RP_DECODE_F_STOP);
+            bit = -1;
+        }
+    }
+    *rate = periods ? fs * periods / sum : 0;
+}
+
+static void decodeSpi(const rp_decode_cfg_t *cfg, const edges_t *e, double fs, out_t *o, float *rate)
+{
+    const uint8_t data_ch = cfg->channel;
+    // Modes 0 and 3 sample on the rising edge, 1 and 2 on the falling one
+    const uint8_t sample_level = cfg->spi_mode == 0 || cfg->spi_mode == 3;
+    const uint32_t bits = cfg->data_bits ? cfg->data_bits : 8;
+    uint8_t data = e->init[data_ch];
+    uint32_t n = 0, word_time = 0, last = 0, period = 0;
+    uint16_t word = 0;
+    bool first = true;
+    double sum = 0;
+    uint32_t periods = 0;
+
+    for (uint32_t k = 0; k < e->n; k++) {
+        const edge_t *edge = &e->edges[k];
+        if (edge->ch == data_ch) {
+            data = edge->level;
+            continue;
+        }
+        if (edge->level != sample_level) {
+            continue;
+        }
+
+        if (!first) {
+            uint32_t interval = edge->time - last;
+            if (period && interval > DECODE_SPI_GAP * period) {
+                // Clock pause, the word is over
+                if (n) {
+                    emit(o, word_time, word, RP_DECODE_F_PARTIAL);
+                    n = 0;
+                }
+            }
+            else {
+                period = interval;
+                sum += interval;
+                periods++;
+            }
+        }
+        last = edge->time;
+        first = false;
+
+        if (n == 0) {
+            word_time = edge->time;
+            word = 0;
+        }
+        if (cfg->lsb_first) {
+            word |= data << n;
+        }
+        else {
+            word = (word << 1) | data;
+        }
+        if (++n == bits) {
+            emit(o, word_time, word, 0);
+            n = 0;
+        }
+    }
+    if (n) {
+        emit(o, word_time, word, RP_DECODE_F_PARTIAL);
+    }
+    *rate = periods ? fs * periods / sum : 0;
+}
+
+static int checkCfg(const rp_decode_cfg_t *cfg)
+{
+    if (cfg->channel != RP_CH_1 && cfg->channel != RP_CH_2) {
+        return RP_EPN;
+    }
+    switch (cfg->protocol) {
+    case RP_DECODE_UART:
+        return cfg->data_bits <= 9 && (cfg->data_bits == 0 || cfg->data_bits >= 5) &&
+               cfg->parity <= RP_DECODE_PARITY_ODD ? RP_OK : RP_EOOR;
+    case RP_DECODE_I2C:
+        return RP_OK;
+    case RP_DECODE_SPI:
+        return cfg->data_bits <= 16 && cfg->spi_mode <= 3 ? RP_OK : RP_EOOR;
+    default:
+        return RP_EOOR;
+    }
+}
+
+int decode_Run(const rp_decode_cfg_t* cfg, uint32_t pos, uint32_t size,
+               rp_decode_event_t* events, uint32_t* count, float* rate)
+{
+    bool used[2] = { true, true };
+    float fs, r = 0;
+
+    if (cfg == NULL || events == NULL || count == NULL) {
+        return RP_UIA;
+    }
+    if (size == 0 || size > ADC_BUFFER_SIZE) {
+        return RP_EOOR;
+    }
+    ECHECK(checkCfg(cfg));
+    ECHECK(acq_GetSamplingRateHz(&fs));
+
+    if (cfg->protocol == RP_DECODE_UART) {
+        used[!cfg->channel] = false;
+    }
+    edges_t e = { .size = size };
+    e.edges = malloc(2 * size * sizeof(edge_t));
+    if (e.edges == NULL) {
+        return RP_EOOR;
+    }
+    int ret = extract(cfg, used, pos, &e);
+    if (ret != RP_OK) {
+        free(e.edges);
+        return ret;
+    }
+
+    out_t o = { events, *count, 0, false };
+    switch (cfg->protocol) {
+    case RP_DECODE_UART:
+        decodeUart(cfg, &e, fs, &o, &r);
+        break;
+    case RP_DECODE_I2C:
+        decodeI2c(cfg, &e, fs, &o, &r);
+        break;
+    case RP_DECODE_SPI:
+        decodeSpi(cfg, &e, fs, &o, &r);
+        break;
+    }
+    free(e.edges);
+
+    *count = o.n;
+    if (rate) {
+        *rate = r;
+    }
+    return o.overflow ? RP_BTS : RP_OK;
+}
@@ -0,0 +1,36 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library serial protocol decoder module interface
+ *
+ * UART, I2C and SPI decoding of captured logic levels into compact event
+ * lists.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef __DECODE_H
+#define __DECODE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "redpitaya/rp.h"
+
+/* Longest UART pulse, in bits, used by the bit rate estimate */
+#define DECODE_UART_MAX_BITS    12
+/* Deviation from whole bits, in bits, of a pulse used by the estimate */
+#define DECODE_UART_BIT_TOL     0.25
+/* SPI clock pause, in clock periods, that ends a word */
+#define DECODE_SPI_GAP          8
+
+int decode_Run(const rp_decode_cfg_t* cfg, uint32_t pos, uint32_t size,
+               rp_decode_event_t* events, uint32_t* count, float* rate);
+
+#endif /* __DECODE_H */
@@ -17,6 +17,7 @@
 #include "common.h"
 #include "generate.h"
 #include "gen_handler.h"
+#include "stats.h"
 
 // global variables
 // TODO: should be organized into a system status structure
@@ -35,34 +36,62 @@ uint32_t      chA_arb_size = BUFFER_LENGTH, chB_arb_size = BUFFER_LENGTH;
 float chA_arbitraryData[BUFFER_LENGTH];
 float chB_arbitraryData[BUFFER_LENGTH];
 
+// Default sine in DAC counts, computed on the first reset
+static int32_t default_sine[BUFFER_LENGTH];
+static bool default_sine_valid = false;
+
+static void defaultSine() {
+    if (default_sine_valid) {
+        return;
+    }
+    // Quarter wave, the rest follows from the symmetry of the sine
+    for(int i = 0; i <= BUFFER_LENGTH / 4; i++) {
+        float value = (float) sin(2 * M_PI * (float) i / (float) BUFFER_LENGTH);
+        // Converted separately, the positive full scale is clipped one count lower
+        int32_t cnt = cmn_CnvVToCnt(DATA_BIT_LENGTH, value, AMPLITUDE_MAX, false, 0, 0, 0.0);
+        int32_t neg = cmn_CnvVToCnt(DATA_BIT_LENGTH, -value, AMPLITUDE_MAX, false, 0, 0, 0.0);
+        default_sine[i] = cnt;
+        default_sine[BUFFER_LENGTH / 2 - i] = cnt;
+        default_sine[(BUFFER_LENGTH / 2 + i) % BUFFER_LENGTH] = neg;
+        default_sine[(BUFFER_LENGTH - i) % BUFFER_LENGTH] = neg;
+    }
+    default_sine_valid = true;
+}
+
+static int setDefaultChannel(rp_channel_t channel) {
+    ECHECK(generate_setFrequency(channel, 1000));
+    ECHECK(generate_setGatedBurst(channel, 0));
+    ECHECK(generate_setBurstDelay(channel, 0));
+    ECHECK(generate_setBurstRepetitions(channel, 0));
+    ECHECK(generate_setBurstCount(channel, 0));
+    ECHECK(generate_setDCOffset(channel, 0));
+    ECHECK(generate_setAmplitude(channel, 1));
+    ECHECK(generate_writeDataRaw(channel, default_sine));
+    return generate_setTriggerSource(channel, RP_GEN_TRIG_SRC_INTERNAL);
+}
+
+/**
+ * Writes the registers and buffers the gen_set* defaults would end in
+ * directly: continuous 1 kHz sine of 1 V, outputs disabled.
+ */
 int gen_SetDefaultValues() {
+    chA_amplitude = chB_amplitude = 1;
+    chA_offset = chB_offset = 0;
+    chA_dutyCycle = chB_dutyCycle = 0.5;
+    chA_frequency = chB_frequency = 1000;
+    chA_phase = chB_phase = 0;
+    chA_burstCount = chB_burstCount = 1;
+    chA_burstRepetition = chB_burstRepetition = 1;
+    chA_burstPeriod = chB_burstPeriod = BURST_PERIOD_MIN;
+    chA_waveform = chB_waveform = RP_WAVEFORM_SINE;
+    chA_size = chB_size = BUFFER_LENGTH;
+
+    defaultSine();
     ECHECK(gen_Disable(RP_CH_1));
     ECHECK(gen_Disable(RP_CH_2));
-    ECHECK(gen_setFrequency(RP_CH_1, 1000));
-    ECHECK(gen_setFrequency(RP_CH_2, 1000));
-    ECHECK(gen_setBurstRepetitions(RP_CH_1, 1));
-    ECHECK(gen_setBurstRepetitions(RP_CH_2, 1));
-    ECHECK(gen_setBurstPeriod(RP_CH_1, (uint32_t) (1 / 1000.0 * MICRO)));   // period = 1/frequency in us
-    ECHECK(gen_setBurstPeriod(RP_CH_2, (uint32_t) (1 / 1000.0 * MICRO)));   // period = 1/frequency in us
-    ECHECK(gen_setWaveform(RP_CH_1, RP_WAVEFORM_SINE));
-    ECHECK(gen_setWaveform(RP_CH_2, RP_WAVEFORM_SINE));
-    ECHECK(gen_setOffset(RP_CH_1, 0));
-    ECHECK(gen_setOffset(RP_CH_2, 0));
-    ECHECK(gen_setAmplitude(RP_CH_1, 1));
-    ECHECK(gen_setAmplitude(RP_CH_2, 1));
-    ECHECK(gen_setDutyCycle(RP_CH_1, 0.5));
-    ECHECK(gen_setDutyCycle(RP_CH_2, 0.5));
-    ECHECK(gen_setGenMode(RP_CH_1, RP_GEN_MODE_CONTINUOUS));
-    ECHECK(gen_setGenMode(RP_CH_2, RP_GEN_MODE_CONTINUOUS));
-    ECHECK(gen_setBurstCount(RP_CH_1, 1));
-    ECHECK(gen_setBurstCount(RP_CH_2, 1));
-    ECHECK(gen_setBurstPeriod(RP_CH_1, BURST_PERIOD_MIN));
-    ECHECK(gen_setBurstPeriod(RP_CH_2, BURST_PERIOD_MIN));
-    ECHECK(gen_setTriggerSource(RP_CH_1, RP_GEN_TRIG_SRC_INTERNAL));
-    ECHECK(gen_setTriggerSource(RP_CH_2, RP_GEN_TRIG_SRC_INTERNAL));
-    ECHECK(gen_setPhase(RP_CH_1, 0.0));
-    ECHECK(gen_setPhase(RP_CH_2, 0.0));
-    return RP_OK;
+    ECHECK(setDefaultChannel(RP_CH_1));
+    ECHECK(setDefaultChannel(RP_CH_2));
+    return gen_Synchronise();
 }
 
 int gen_Disable(rp_channel_t channel) {
@@ -446,7 +475,7 @@ int gen_Synchronise() {
     return generate_Synchronise();
 }
 
-int synthesize_signal(rp_channel_t channel) {
+static int synthesizeSignal(rp_channel_t channel) {
     float data[BUFFER_LENGTH];
     rp_waveform_t waveform;
     float dutyCycle, frequency;
@@ -576,3 +605,7 @@ int triggerIfInternal(rp_channel_t channel) {
     }
     return RP_OK;
 }
+
+int synthesize_signal(rp_channel_t channel) {
+    STATS_CALL(STAT_GEN_SYNTHESIZE, synthesizeSignal(channel))
+}
@@ -25,67 +25,82 @@ static volatile generate_control_t *generate = NULL;
 static volatile int32_t *data_chA = NULL;
 static volatile int32_t *data_chB = NULL;
 
+// Write-through shadow of the registers, all reads are served from it. The
+// bitfields share registers, which are reread before one of them is set.
+static generate_control_t *shadow = NULL;
+
 
 int generate_Init() {
 //  ECHECK(cmn_Init());
     ECHECK(cmn_Map(GENERATE_BASE_SIZE, GENERATE_BASE_ADDR, (void **) &generate));
+    ECHECK(cmn_AddShadow(generate, sizeof(generate_control_t),
+                         READ_POINTER_LIVE(properties_chA) | READ_POINTER_LIVE(properties_chB),
+                         (void **) &shadow));
     data_chA = (int32_t *) ((char *) generate + (CHA_DATA_OFFSET));
     data_chB = (int32_t *) ((char *) generate + (CHB_DATA_OFFSET));
     return RP_OK;
 }
 
 int generate_Release() {
+    ECHECK(cmn_RemoveShadow(generate));
     ECHECK(cmn_Unmap(GENERATE_BASE_SIZE, (void **) &generate));
 //  ECHECK(cmn_Release());
+    shadow = NULL;
     data_chA = NULL;
     data_chB = NULL;
     return RP_OK;
 }
 
-int getChannelPropertiesAddress(volatile ch_properties_t **ch_properties, rp_channel_t channel) {
+int getChannelPropertiesAddress(ch_properties_t **ch_properties, rp_channel_t channel) {
     CHANNEL_ACTION(channel,
-            *ch_properties = &generate->properties_chA,
-            *ch_properties = &generate->properties_chB)
+            *ch_properties = &shadow->properties_chA,
+            *ch_properties = &shadow->properties_chB)
     return RP_OK;
 }
 
 int generate_setOutputDisable(rp_channel_t channel, bool disable) {
+    ECHECK(cmn_ReadThrough(shadow));
     if (channel == RP_CH_1) {
-        generate->AsetOutputTo0 = disable ? 1 : 0;
+        shadow->AsetOutputTo0 = disable ? 1 : 0;
     }
     else if (channel == RP_CH_2) {
-        generate->BsetOutputTo0 = disable ? 1 : 0;
+        shadow->BsetOutputTo0 = disable ? 1 : 0;
     }
     else {
         return RP_EPN;
     }
-    return RP_OK;
+    return cmn_WriteThrough(shadow);
 }
 
 int generate_getOutputEnabled(rp_channel_t channel, bool *enabled) {
     uint32_t value;
     CHANNEL_ACTION(channel,
-            value = generate->AsetOutputTo0,
-            value = generate->BsetOutputTo0)
+            value = shadow->AsetOutputTo0,
+            value = shadow->BsetOutputTo0)
     *enabled = value == 1 ? false : true;
     return RP_OK;
 }
 
 int generate_setAmplitude(rp_channel_t channel, float amplitude) {
-    volatile ch_properties_t *ch_properties;
+    ch_properties_t *ch_properties;
 
-    rp_calib_params_t calib = calib_GetParams();
+    rp_calib_params_t calib;
+
+    ECHECK(calib_GetParams(&calib));
     uint32_t amp_max = channel == RP_CH_1 ? calib.be_ch1_fs: calib.be_ch2_fs;
 
     ECHECK(getChannelPropertiesAddress(&ch_properties, channel));
+    ECHECK(cmn_ReadThrough(ch_properties));
     ch_properties->amplitudeScale = cmn_CnvVToCnt(DATA_BIT_LENGTH, amplitude, AMPLITUDE_MAX, false, amp_max, 0, 0.0);
-    return RP_OK;
+    return cmn_WriteThrough(ch_properties);
 }
 
 int generate_getAmplitude(rp_channel_t channel, float *amplitude) {
-    volatile ch_properties_t *ch_properties;
+    ch_properties_t *ch_properties;
 
-    rp_calib_params_t calib = calib_GetParams();
+    rp_calib_params_t calib;
+
+    ECHECK(calib_GetParams(&calib));
     uint32_t amp_max = channel == RP_CH_1 ? calib.be_ch1_fs: calib.be_ch2_fs;
 
     ECHECK(getChannelPropertiesAddress(&ch_properties, channel));
@@ -94,21 +109,26 @@ int generate_getAmplitude(rp_channel_t channel, float *amplitude) {
 }
 
 int generate_setDCOffset(rp_channel_t channel, float offset) {
-    volatile ch_properties_t *ch_properties;
+    ch_properties_t *ch_properties;
+
+    rp_calib_params_t calib;
 
-    rp_calib_params_t calib = calib_GetParams();
+    ECHECK(calib_GetParams(&calib));
     int dc_offs = channel == RP_CH_1 ? calib.be_ch1_dc_offs: calib.be_ch2_dc_offs;
     uint32_t amp_max = channel == RP_CH_1 ? calib.be_ch1_fs: calib.be_ch2_fs;
 
     ECHECK(getChannelPropertiesAddress(&ch_properties, channel));
+    ECHECK(cmn_ReadThrough(ch_properties));
     ch_properties->amplitudeOffset = cmn_CnvVToCnt(DATA_BIT_LENGTH, offset, (float) (OFFSET_MAX/2.f), false, amp_max, dc_offs, 0);
-    return RP_OK;
+    return cmn_WriteThrough(ch_properties);
 }
 
 int generate_getDCOffset(rp_channel_t channel, float *offset) {
-    volatile ch_properties_t *ch_properties;
+    ch_properties_t *ch_properties;
 
-    rp_calib_params_t calib = calib_GetParams();
+    rp_calib_params_t calib;
+
+    ECHECK(calib_GetParams(&calib));
     int dc_offs = channel == RP_CH_1 ? calib.be_ch1_dc_offs: calib.be_ch2_dc_offs;
     uint32_t amp_max = channel == RP_CH_1 ? calib.be_ch1_fs: calib.be_ch2_fs;
 
@@ -118,92 +138,96 @@ int generate_getDCOffset(rp_channel_t channel, float *offset) {
 }
 
 int generate_setFrequency(rp_channel_t channel, float frequency) {
-    volatile ch_properties_t *ch_properties;
+    ch_properties_t *ch_properties;
     ECHECK(getChannelPropertiesAddress(&ch_properties, channel));
     ch_properties->counterStep = (uint32_t) round(65536 * frequency / DAC_FREQUENCY * BUFFER_LENGTH);
-    channel == RP_CH_1 ? (generate->ASM_WrapPointer = 1) : (generate->BSM_WrapPointer = 1);
-    return RP_OK;
+    ECHECK(cmn_WriteThrough(&ch_properties->counterStep));
+    ECHECK(cmn_ReadThrough(shadow));
+    channel == RP_CH_1 ? (shadow->ASM_WrapPointer = 1) : (shadow->BSM_WrapPointer = 1);
+    return cmn_WriteThrough(shadow);
 }
 
 int generate_getFrequency(rp_channel_t channel, float *frequency) {
-    volatile ch_properties_t *ch_properties;
+    ch_properties_t *ch_properties;
     ECHECK(getChannelPropertiesAddress(&ch_properties, channel));
     *frequency = (float) round((ch_properties->counterStep * DAC_FREQUENCY) / (65536 * BUFFER_LENGTH));
     return RP_OK;
 }
 
 int generate_setWrapCounter(rp_channel_t channel, uint32_t size) {
-    CHANNEL_ACTION(channel,
-            generate->properties_chA.counterWrap = 65536 * size - 1,
-            generate->properties_chB.counterWrap = 65536 * size - 1)
-    return RP_OK;
+    ch_properties_t *ch_properties;
+    ECHECK(getChannelPropertiesAddress(&ch_properties, channel));
+    ch_properties->counterWrap = 65536 * size - 1;
+    return cmn_WriteThrough(&ch_properties->counterWrap);
 }
 
 int generate_setTriggerSource(rp_channel_t channel, unsigned short value) {
+    ECHECK(cmn_ReadThrough(shadow));
     CHANNEL_ACTION(channel,
-            generate->AtriggerSelector = value,
-            generate->BtriggerSelector = value)
-    return RP_OK;
+            shadow->AtriggerSelector = value,
+            shadow->BtriggerSelector = value)
+    return cmn_WriteThrough(shadow);
 }
 
 int generate_getTriggerSource(rp_channel_t channel, uint32_t *value) {
     CHANNEL_ACTION(channel,
-            *value = generate->AtriggerSelector,
-            *value = generate->BtriggerSelector)
+            *value = shadow->AtriggerSelector,
+            *value = shadow->BtriggerSelector)
     return RP_OK;
 }
 
 int generate_setGatedBurst(rp_channel_t channel, uint32_t value) {
+    ECHECK(cmn_ReadThrough(shadow));
     CHANNEL_ACTION(channel,
-            generate->AgatedBursts = value,
-            generate->BgatedBursts = value)
-    return RP_OK;
+            shadow->AgatedBursts = value,
+            shadow->BgatedBursts = value)
+    return cmn_WriteThrough(shadow);
 }
 
 int generate_getGatedBurst(rp_channel_t channel, uint32_t *value) {
     CHANNEL_ACTION(channel,
-            *value = generate->AgatedBursts,
-            *value = generate->BgatedBursts)
+            *value = shadow->AgatedBursts,
+            *value = shadow->BgatedBursts)
     return RP_OK;
 }
 
 int generate_setBurstCount(rp_channel_t channel, uint32_t num) {
-    volatile ch_properties_t *ch_properties;
+    ch_properties_t *ch_properties;
     ECHECK(getChannelPropertiesAddress(&ch_properties, channel));
     ch_properties->cyclesInOneBurst = num;
-    return RP_OK;
+    return cmn_WriteThrough(&ch_properties->cyclesInOneBurst);
 }
 
 int generate_getBurstCount(rp_channel_t channel, uint32_t *num) {
-    volatile ch_properties_t *ch_properties;
+    ch_properties_t *ch_properties;
     ECHECK(getChannelPropertiesAddress(&ch_properties, channel));
     *num = ch_properties->cyclesInOneBurst;
     return RP_OK;
 }
 
 int generate_setBurstRepetitions(rp_channel_t channel, uint32_t repetitions) {
-    volatile ch_properties_t *ch_properties;
+    ch_properties_t *ch_properties;
     ECHECK(getChannelPropertiesAddress(&ch_properties, channel));
     ch_properties->burstRepetitions = repetitions;
-    return RP_OK;
+    return cmn_WriteThrough(&ch_properties->burstRepetitions);
 }
 
 int generate_getBurstRepetitions(rp_channel_t channel, uint32_t *repetitions) {
-    volatile ch_properties_t *ch_properties;
+    ch_properties_t *ch_properties;
     ECHECK(getChannelPropertiesAddress(&ch_properties, channel));
     *repetitions = ch_properties->burstRepetitions;
     return RP_OK;
 }
 
 int generate_setBurstDelay(rp_channel_t channel, uint32_t delay) {
-    volatile ch_properties_t *ch_properties;
+    ch_properties_t *ch_properties;
     ECHECK(getChannelPropertiesAddress(&ch_properties, channel));
     ch_properties->delayBetweenBurstRepetitions = delay;
-    return RP_OK;
+    return cmn_WriteThrough(&ch_properties->delayBetweenBurstRepetitions);
 }
 
 int generate_getBurstDelay(rp_channel_t channel, uint32_t *delay) {
-    volatile ch_properties_t *ch_properties;
+    ch_properties_t *ch_properties;
     ECHECK(getChannelPropertiesAddress(&ch_properties, channel));
     *delay = ch_properties->delayBetweenBurstRepetitions;
     return RP_OK;
@@ -228,8 +252,6 @@ int generate_writeData(rp_channel_t channel, float *data, uint32_t start, uint32
             dataOut = data_chA,
             dataOut = data_chB)
 
-    volatile ch_properties_t *properties;
-    ECHECK(getChannelPropertiesAddress(&properties, channel));
     generate_setWrapCounter(channel, length);
 
     //rp_calib_params_t calib = calib_GetParams();
@@ -241,3 +263,17 @@ int generate_writeData(rp_channel_t channel, float *data, uint32_t start, uint32
     }
     return RP_OK;
 }
+
+/* Writes a whole buffer of DAC counts, for waveforms kept in counts */
+int generate_writeDataRaw(rp_channel_t channel, const int32_t *cnts) {
+    volatile int32_t *dataOut;
+    CHANNEL_ACTION(channel,
+            dataOut = data_chA,
+            dataOut = data_chB)
+
+    ECHECK(generate_setWrapCounter(channel, BUFFER_LENGTH));
+    for(int i = 0; i < BUFFER_LENGTH; i++) {
+        dataOut[i] = cnts[i];
+    }
+    return RP_OK;
+}
@@ -53,9 +53,11 @@ typedef struct ch_properties {
     uint32_t counterWrap;
     uint32_t startOffset;
     uint32_t counterStep;
-    unsigned int                    :2;
-    uint32_t buffReadPointer        :14;
-    unsigned int                    :16;
+    struct {
+        unsigned int                :2;
+        uint32_t buffReadPointer    :14;
+        unsigned int                :16;
+    } readPointer;
     uint32_t cyclesInOneBurst;
     uint32_t burstRepetitions;
     uint32_t delayBetweenBurstRepetitions;
@@ -82,6 +84,10 @@ typedef struct generate_control_s {
     ch_properties_t properties_chB;
 } generate_control_t;
 
+// Buffer read pointer of a channel, the only register the FPGA changes
+#define READ_POINTER_LIVE(ch) \
+    (1ULL << ((offsetof(generate_control_t, ch) + offsetof(ch_properties_t, readPointer)) / sizeof(uint32_t)))
+
 int generate_Init();
 int generate_Release();
 
@@ -109,5 +115,6 @@ int generate_simultaneousTrigger();
 int generate_Synchronise();
 
 int generate_writeData(rp_channel_t channel, float *data, uint32_t start, uint32_t length);
+int generate_writeDataRaw(rp_channel_t channel, const int32_t *cnts);
 
 #endif //__GENERATE_H
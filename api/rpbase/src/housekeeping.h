@@ -57,10 +57,16 @@ static volatile housekeeping_control_t *hk = NULL;
 
 static int hk_Init() {
     ECHECK(cmn_Map(HOUSEKEEPING_BASE_SIZE, HOUSEKEEPING_BASE_ADDR, (void**)&hk));
+    ECHECK(cmn_AddShadow(hk, sizeof(housekeeping_control_t),
+                         SHADOW_LIVE(housekeeping_control_t, ex_ci_p) |
+                         SHADOW_LIVE(housekeeping_control_t, ex_ci_n) |
+                         SHADOW_LIVE(housekeeping_control_t, reserved_2) |
+                         SHADOW_LIVE(housekeeping_control_t, reserved_3), NULL));
     return RP_OK;
 }
 
 static int hk_Release() {
+    ECHECK(cmn_RemoveShadow(hk));
     ECHECK(cmn_Unmap(HOUSEKEEPING_BASE_SIZE, (void**)&hk));
     return RP_OK;
 }
@@ -0,0 +1,173 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library I2C module implementation
+ *
+ * All messages of a transfer go to the adapter in one I2C_RDWR ioctl,
+ * with a repeated start between them, so that a register read is one
+ * system call instead of a write() and a read(). Each bus stays open
+ * after its first transfer.
+ *
+ * With the simulated backend, a bus without a device set is a fake
+ * adapter. Every address answers as a device with I2C_FAKE_REGS 8 bit
+ * registers: the first byte written sets the register pointer, the
+ * following bytes are stored from it on and reads continue from it, both
+ * wrapping around. The registers are dropped on release.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+#include "common.h"
+#include "i2c.h"
+
+static char *i2c_path[I2C_BUSES];
+static int i2c_fd[I2C_BUSES] = { -1, -1, -1, -1, -1, -1, -1, -1 };
+
+// Fake adapter registers and register pointers, by 7 bit address
+static uint8_t *fake_regs[I2C_BUSES][128];
+static uint8_t fake_ptr[I2C_BUSES][128];
+
+static int fakeTransfer(int bus, rp_i2c_msg_t *msgs, int n)
+{
+    for (int i = 0; i < n; i++) {
+        rp_i2c_msg_t *m = &msgs[i];
+        uint8_t **regs = &fake_regs[bus][m->addr];
+        uint8_t *ptr = &fake_ptr[bus][m->addr];
+
+        if (*regs == NULL && (*regs = calloc(I2C_FAKE_REGS, 1)) == NULL) {
+            return RP_EOOR;
+        }
+        for (int j = 0; j < m->len; j++) {
+            if (m->flags & RP_I2C_READ) {
+                m->buf[j] = (*regs)[*ptr];
+                *ptr = (*ptr + 1) % I2C_FAKE_REGS;
+            } else if (j == 0) {
+                *ptr = m->buf[0];
+            } else {
+                (*regs)[*ptr] = m->buf[j];
+                *ptr = (*ptr + 1) % I2C_FAKE_REGS;
+            }
+        }
+    }
+    return RP_OK;
+}
+
+static int busOpen(int bus)
+{
+    char path[32];
+
+    if (i2c_fd[bus] >= 0) {
+        return RP_OK;
+    }
+    snprintf(path, sizeof(path), I2C_DEVICE, bus);
+    i2c_fd[bus] = open(i2c_path[bus] ? i2c_path[bus] : path, O_RDWR);
+    return i2c_fd[bus] < 0 ? RP_EFOB : RP_OK;
+}
+
+static int busClose(int bus)
+{
+    int ret = RP_OK;
+
+    if (i2c_fd[bus] >= 0 && close(i2c_fd[bus]) < 0) {
+        ret = RP_EFCB;
+    }
+    i2c_fd[bus] = -1;
+    return ret;
+}
+
+/* The next transfer on the bus opens the new device */
+int i2c_SetDevice(int bus, const char *path)
+{
+    char *copy = NULL;
+
+    if (bus < 0 || bus >= I2C_BUSES) {
+        return RP_EOOR;
+    }
+    if (path != NULL && (copy = strdup(path)) == NULL) {
+        return RP_EOOR;
+    }
+    ECHECK(busClose(bus));
+    free(i2c_path[bus]);
+    i2c_path[bus] = copy;
+    return RP_OK;
+}
+
+int i2c_Transfer(int bus, rp_i2c_msg_t *msgs, int n)
+{
+    struct i2c_msg msg[I2C_MAX_MSGS];
+    struct i2c_rdwr_ioctl_data data = { msg, n };
+    bool read = false;
+
+    if (bus < 0 || bus >= I2C_BUSES || n < 0 || n > I2C_MAX_MSGS) {
+        return RP_EOOR;
+    }
+    if (msgs == NULL && n > 0) {
+        return RP_UIA;
+    }
+    for (int i = 0; i < n; i++) {
+        if (msgs[i].addr > 0x7F || (msgs[i].buf == NULL && msgs[i].len > 0)) {
+            return RP_UIA;
+        }
+    }
+    if (n == 0) {
+        return RP_OK;
+    }
+    if (i2c_path[bus] == NULL && cmn_IsSimulated()) {
+        return fakeTransfer(bus, msgs, n);
+    }
+    ECHECK(busOpen(bus));
+
+    for (int i = 0; i < n; i++) {
+        msg[i].addr = msgs[i].addr;
+        msg[i].flags = msgs[i].flags & RP_I2C_READ ? I2C_M_RD : 0;
+        msg[i].len = msgs[i].len;
+        msg[i].buf = msgs[i].buf;
+        read |= msgs[i].flags & RP_I2C_READ;
+    }
+    if (ioctl(i2c_fd[bus], I2C_RDWR, &data) < 0) {
+        return read ? RP_EFRB : RP_EFWB;
+    }
+    return RP_OK;
+}
+
+/* Register address write and read, with a repeated start between them */
+int i2c_ReadRegs(int bus, uint8_t addr, uint8_t reg, uint8_t *buf, uint16_t len)
+{
+    rp_i2c_msg_t msgs[2] = {
+        { addr, 0, 1, &reg },
+        { addr, RP_I2C_READ, len, buf }
+    };
+    return i2c_Transfer(bus, msgs, 2);
+}
+
+int i2c_Release()
+{
+    int ret = RP_OK;
+
+    for (int bus = 0; bus < I2C_BUSES; bus++) {
+        if (busClose(bus) != RP_OK) {
+            ret = RP_EFCB;
+        }
+        for (int addr = 0; addr < 128; addr++) {
+            free(fake_regs[bus][addr]);
+            fake_regs[bus][addr] = NULL;
+            fake_ptr[bus][addr] = 0;
+        }
+    }
+    return ret;
+}
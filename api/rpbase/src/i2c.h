@@ -0,0 +1,34 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library I2C module interface
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef __I2C_H
+#define __I2C_H
+
+#include <stdint.h>
+
+#include "redpitaya/rp.h"
+
+#define I2C_DEVICE          "/dev/i2c-%d"
+#define I2C_BUSES           8
+/* Most messages in one I2C_RDWR transaction, I2C_RDWR_IOCTL_MAX_MSGS */
+#define I2C_MAX_MSGS        42
+/* Registers of each device on a fake adapter */
+#define I2C_FAKE_REGS       256
+
+int i2c_SetDevice(int bus, const char *path);
+int i2c_Transfer(int bus, rp_i2c_msg_t *msgs, int n);
+int i2c_ReadRegs(int bus, uint8_t addr, uint8_t reg, uint8_t *buf, uint16_t len);
+int i2c_Release();
+
+#endif //__I2C_H
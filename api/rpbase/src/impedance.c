@@ -0,0 +1,196 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library impedance module implementation
+ *
+ * The generator drives the device under test in series with a shunt
+ * resistor. Input 1 sees the generator side of the device, input 2 the
+ * shunt, so that U1 - U2 is across the device and U2 / r_shunt is the
+ * current through it. Both inputs are fitted with a sine at the known
+ * frequency, which leaves the offsets and the noise out of the phasors.
+ *
+ * Only the samples after an immediate trigger are used, so a capture takes
+ * no longer than the samples it holds. The generator is left running and
+ * the device is only given time to settle when the generator changed.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdlib.h>
+#include <math.h>
+
+#include "common.h"
+#include "oscilloscope.h"
+#include "acq_handler.h"
+#include "gen_handler.h"
+#include "sinefit.h"
+#include "impedance.h"
+
+#define SAMPLE_RATE         125e6
+/* Longest capture, a full buffer would wrap the write pointer distance */
+#define CAPTURE_MAX         (ADC_BUFFER_SIZE - 1)
+
+static const uint32_t dec_factors[] = { 1, 8, 64, 1024, 8192, 65536 };
+
+/* Sets up the sine, returns whether anything changed */
+static int setGenerator(const rp_imp_cfg_t *cfg, float frequency, bool *changed)
+{
+    bool enabled;
+    float freq, amp, offs;
+    rp_waveform_t wave;
+
+    ECHECK(gen_IsEnable(cfg->channel, &enabled));
+    ECHECK(gen_getFrequency(cfg->channel, &freq));
+    ECHECK(gen_getAmplitude(cfg->channel, &amp));
+    ECHECK(gen_getOffset(cfg->channel, &offs));
+    ECHECK(gen_getWaveform(cfg->channel, &wave));
+    *changed = !enabled || wave != RP_WAVEFORM_SINE || freq != frequency
+            || amp != cfg->amplitude || offs != cfg->dc_bias;
+    if (!*changed) {
+        return RP_OK;
+    }
+
+    ECHECK(gen_setGenMode(cfg->channel, RP_GEN_MODE_CONTINUOUS));
+    ECHECK(gen_setWaveform(cfg->channel, RP_WAVEFORM_SINE));
+    ECHECK(gen_setFrequency(cfg->channel, frequency));
+    ECHECK(gen_setAmplitude(cfg->channel, cfg->amplitude));
+    ECHECK(gen_setOffset(cfg->channel, cfg->dc_bias));
+    ECHECK(gen_Enable(cfg->channel));
+    return RP_OK;
+}
+
+/* Captures size samples of both channels from an immediate trigger on */
+static int capture(uint32_t dec, uint32_t size, float *data[2])
+{
+    uint32_t trig_pos, len;
+
+    ECHECK(osc_SetDecimation(dec));
+    ECHECK(osc_SetAveraging(true));
+    ECHECK(osc_SetTriggerDelay(size));
+    ECHECK(acq_Start());
+    ECHECK(acq_SetTriggerSrc(RP_TRIG_SRC_NOW));
+    ECHECK(acq_WaitCaptureDone(acq_DeadlineNs(size, dec)));
+    ECHECK(acq_GetWritePointerAtTrig(&trig_pos));
+
+    for (int ch = 0; ch < 2; ch++) {
+        len = size;
+        ECHECK(acq_GetDataV(ch, trig_pos, &len, data[ch]));
+    }
+    return RP_OK;
+}
+
+static int measure(const rp_imp_cfg_t *cfg, float frequency, float *data[2], double *z_re, double *z_im)
+{
+    uint32_t periods = cfg->periods ? cfg->periods : IMPEDANCE_PERIODS;
+    uint32_t averaging = cfg->averaging ? cfg->averaging : 1;
+    uint32_t dec = dec_factors[sizeof(dec_factors) / sizeof(dec_factors[0]) - 1];
+    bool changed;
+
+    // Lowest decimation that holds the periods, the most samples per period
+    for (int i = 0; i < sizeof(dec_factors) / sizeof(dec_factors[0]); i++) {
+        if (CAPTURE_MAX * dec_factors[i] / SAMPLE_RATE * frequency >= periods) {
+            dec = dec_factors[i];
+            break;
+        }
+    }
+    // Whole periods fill the buffer best, slow signals take all of it
+    double period = SAMPLE_RATE / dec / frequency;
+    uint32_t size = CAPTURE_MAX;
+    if (CAPTURE_MAX >= period) {
+        size = (uint32_t)(floor(CAPTURE_MAX / period) * period);
+    }
+
+    ECHECK(setGenerator(cfg, frequency, &changed));
+    if (changed) {
+        cmn_SleepNs(MAX(IMPEDANCE_SETTLE_PERIODS * 1e9 / frequency, IMPEDANCE_SETTLE_MIN_NS));
+    }
+
+    double re = 0, im = 0;
+    for (uint32_t n = 0; n < averaging; n++) {
+        rp_sine_fit_t u1, u2;
+        ECHECK(capture(dec, size, data));
+        ECHECK(sinefit_Fit(data[0], data[1], size, SAMPLE_RATE / dec, frequency, false, &u1, &u2));
+        if (u2.amplitude <= 0) {
+            return RP_EOOR;
+        }
+        // Z = (U1 / U2 - 1) * r_shunt
+        double ratio = u1.amplitude / u2.amplitude;
+        re += (ratio * cos(u1.phase - u2.phase) - 1) * cfg->r_shunt;
+        im += ratio * sin(u1.phase - u2.phase) * cfg->r_shunt;
+    }
+    *z_re = re / averaging;
+    *z_im = im / averaging;
+    return RP_OK;
+}
+
+int impedance_Measure(const rp_imp_cfg_t *cfg, float frequency, double *z_re, double *z_im)
+{
+    uint32_t dec, delay;
+    bool averaging;
+    float *data[2];
+
+    if (cfg == NULL || z_re == NULL || z_im == NULL) {
+        return RP_UIA;
+    }
+    if (cfg->channel != RP_CH_1 && cfg->channel != RP_CH_2) {
+        return RP_EPN;
+    }
+    if (!(frequency > 0 && frequency < SAMPLE_RATE / 2) || !(cfg->r_shunt > 0)) {
+        return RP_EOOR;
+    }
+
+    // Applications also set the scope without librp, save what the FPGA has
+    ECHECK(cmn_SyncShadows());
+    ECHECK(osc_GetDecimation(&dec));
+    ECHECK(osc_GetAveraging(&averaging));
+    ECHECK(osc_GetTriggerDelay(&delay));
+
+    data[0] = malloc(CAPTURE_MAX * sizeof(float));
+    data[1] = malloc(CAPTURE_MAX * sizeof(float));
+    int ret = data[0] && data[1] ? measure(cfg, frequency, data, z_re, z_im) : RP_EOOR;
+    free(data[0]);
+    free(data[1]);
+
+    ECHECK(osc_SetDecimation(dec));
+    ECHECK(osc_SetAveraging(averaging));
+    ECHECK(osc_SetTriggerDelay(delay));
+    return ret;
+}
+
+int impedance_Derive(float frequency, double z_re, double z_im, rp_imp_result_t *result, uint32_t index)
+{
+    if (result == NULL) {
+        return RP_UIA;
+    }
+
+    double w = 2 * M_PI * frequency;
+    double z2 = z_re * z_re + z_im * z_im;
+    double z_phase = atan2(z_im, z_re) * 180 / M_PI;
+    // Y = 1 / Z
+    double g_p = z_re / z2;
+    double b_p = -z_im / z2;
+
+    if (result->frequency) result->frequency[index] = frequency;
+    if (result->z_abs)     result->z_abs[index] = sqrt(z2);
+    if (result->z_phase)   result->z_phase[index] = z_phase;
+    if (result->y_abs)     result->y_abs[index] = 1 / sqrt(z2);
+    if (result->y_phase)   result->y_phase[index] = -z_phase;
+    if (result->r_s)       result->r_s[index] = z_re;
+    if (result->x_s)       result->x_s[index] = z_im;
+    if (result->g_p)       result->g_p[index] = g_p;
+    if (result->b_p)       result->b_p[index] = b_p;
+    if (result->c_s)       result->c_s[index] = -1 / (w * z_im);
+    if (result->c_p)       result->c_p[index] = b_p / w;
+    if (result->l_s)       result->l_s[index] = z_im / w;
+    if (result->l_p)       result->l_p[index] = -1 / (w * b_p);
+    if (result->r_p)       result->r_p[index] = 1 / g_p;
+    if (result->q)         result->q[index] = z_im / z_re;
+    if (result->d)         result->d[index] = -z_re / z_im;
+    return RP_OK;
+}
@@ -0,0 +1,36 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library impedance module interface
+ *
+ * Impedance of a device in series with a shunt resistor from sine fits
+ * of both inputs, and the quantities derived from it.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef __IMPEDANCE_H
+#define __IMPEDANCE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "redpitaya/rp.h"
+
+/* Default least number of periods per capture */
+#define IMPEDANCE_PERIODS           8
+/* Periods the device is given to settle after the generator changed */
+#define IMPEDANCE_SETTLE_PERIODS    10
+/* Least settling time, covers the analog front ends [ns] */
+#define IMPEDANCE_SETTLE_MIN_NS     1000000
+
+int impedance_Measure(const rp_imp_cfg_t *cfg, float frequency, double *z_re, double *z_im);
+int impedance_Derive(float frequency, double z_re, double z_im, rp_imp_result_t *result, uint32_t index);
+
+#endif /* __IMPEDANCE_H */
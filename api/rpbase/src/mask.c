@@ -0,0 +1,477 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library mask test module implementation
+ *
+ * Masks are given in calibrated counts (as returned by rp_AcqGetDataRaw()).
+ * Before a test they are translated once into bounds on the raw ADC counts
+ * for the current calibration offset, so a capture is tested in a single
+ * branch-free pass straight over the FPGA buffer, which also accumulates
+ * the violations per mask sample. Only failed captures take a second pass,
+ * to locate the violations and keep the waveform.
+ *
+ * The background test owns the acquisition while it runs: it arms, waits
+ * for the pre-trigger samples, enables the trigger, waits for the FPGA to
+ * clear the trigger source after the post-trigger samples and tests,
+ * capture after capture. Masks outside the captured window are rejected.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "common.h"
+#include "oscilloscope.h"
+#include "acq_handler.h"
+#include "mask.h"
+
+#define ADC_BITS_MASK   0x3FFF
+#define ADC_SIGN        0x2000
+#define ADC_FS          (1 << 13)
+/* Bound that every raw count satisfies */
+#define BOUND_NONE      (1 << 16)
+
+typedef struct {
+    uint32_t size;
+    int32_t offset;         // first mask sample relative to the trigger
+    int16_t *min;           // mask in calibrated counts
+    int16_t *max;
+    int32_t *lo;            // mask in raw counts for calib_offs
+    int32_t *hi;
+    int32_t calib_offs;
+    bool bounds_valid;
+    uint32_t *violations;   // violations per mask sample, all captures
+    int16_t *fail;          // last failed capture
+    bool fail_valid;
+} mask_t;
+
+static mask_t masks[2];
+static rp_mask_stats_t stats = { .fail_channel = -1, .fail_first = -1, .fail_last = -1 };
+static pthread_mutex_t mask_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_t worker;
+static volatile bool running = false;
+static bool worker_started = false;
+static rp_acq_trig_src_t trig_source;
+static bool stop_on_fail;
+
+static void freeMask(mask_t *m)
+{
+    free(m->min);
+    free(m->max);
+    free(m->lo);
+    free(m->hi);
+    free(m->violations);
+    free(m->fail);
+    memset(m, 0, sizeof(*m));
+}
+
+static int checkChannel(rp_channel_t channel)
+{
+    return (channel == RP_CH_1 || channel == RP_CH_2) ? RP_OK : RP_EPN;
+}
+
+/* Raw count bounds, mask bounds at full scale or beyond never fail, as the
+ * calibrated counts are clamped there */
+static int updateBounds(rp_channel_t channel, mask_t *m)
+{
+    int32_t offs;
+    ECHECK(acq_GetCalibOffset(channel, &offs));
+    if (m->bounds_valid && offs == m->calib_offs) {
+        return RP_OK;
+    }
+    for (uint32_t i = 0; i < m->size; i++) {
+        m->lo[i] = m->min[i] <= -ADC_FS ? -BOUND_NONE : m->min[i] + offs;
+        m->hi[i] = m->max[i] >= ADC_FS ? BOUND_NONE : m->max[i] + offs;
+    }
+    m->calib_offs = offs;
+    m->bounds_valid = true;
+    return RP_OK;
+}
+
+static uint32_t startPos(uint32_t trig_pos, int32_t offset)
+{
+    int64_t pos = ((int64_t)trig_pos + offset) % ADC_BUFFER_SIZE;
+    return pos < 0 ? pos + ADC_BUFFER_SIZE : pos;
+}
+
+static inline int32_t rawCnts(uint32_t raw)
+{
+    return (int32_t)((raw & ADC_BITS_MASK) ^ ADC_SIGN) - ADC_SIGN;
+}
+
+/* The single pass - returns the number of violating samples */
+static uint32_t testChannel(mask_t *m, const volatile uint32_t *buffer, uint32_t pos)
+{
+    // The capture is complete, the FPGA no longer writes the buffer, so it is
+    // read as plain memory to let the loop vectorize
+    const uint32_t *raw = (const uint32_t *)buffer;
+    uint32_t count = 0;
+    uint32_t n = 0;
+
+    // Split at the buffer end, so that the loop has no wrap-around check
+    while (n < m->size) {
+        uint32_t part = MIN(ADC_BUFFER_SIZE - pos, m->size - n);
+        const uint32_t *r = &raw[pos];
+        const int32_t *lo = &m->lo[n];
+        const int32_t *hi = &m->hi[n];
+        uint32_t *v = &m->violations[n];
+
+        for (uint32_t i = 0; i < part; i++) {
+            int32_t x = rawCnts(r[i]);
+            uint32_t bad = (x < lo[i]) | (x > hi[i]);
+            v[i] += bad;
+            count += bad;
+        }
+        n += part;
+        pos = 0;
+    }
+    return count;
+}
+
+static void locateViolations(mask_t *m, const volatile uint32_t *buffer, uint32_t pos,
+                             int32_t *first, int32_t *last)
+{
+    *first = *last = -1;
+    for (uint32_t i = 0; i < m->size; i++) {
+        int32_t x = rawCnts(buffer[(pos + i) % ADC_BUFFER_SIZE]);
+        if (x < m->lo[i] || x > m->hi[i]) {
+            if (*first < 0) {
+                *first = i;
+            }
+            *last = i;
+        }
+    }
+}
+
+/* The capture holds samples delay - ADC_BUFFER_SIZE to delay - 1 relative
+ * to the trigger, each mask must lie within them; mask_mutex must be held */
+static int checkWindow()
+{
+    uint32_t delay;
+    ECHECK(osc_GetTriggerDelay(&delay));
+    for (int ch = 0; ch < 2; ch++) {
+        mask_t *m = &masks[ch];
+        if (m->size == 0) {
+            continue;
+        }
+        if (m->offset < (int64_t)delay - ADC_BUFFER_SIZE || m->offset + (int64_t)m->size > delay) {
+            return RP_EOOR;
+        }
+    }
+    return RP_OK;
+}
+
+/* Tests the current capture, mask_mutex must be held */
+static int evaluate(bool *pass)
+{
+    const volatile uint32_t *buffers[2] = { osc_GetDataBufferChA(), osc_GetDataBufferChB() };
+    uint32_t trig_pos;
+    uint32_t count[2] = { 0, 0 };
+    bool any = false;
+
+    ECHECK(checkWindow());
+    ECHECK(acq_GetWritePointerAtTrig(&trig_pos));
+
+    for (int ch = 0; ch < 2; ch++) {
+        mask_t *m = &masks[ch];
+        if (m->size == 0) {
+            continue;
+        }
+        any = true;
+        ECHECK(updateBounds(ch, m));
+        count[ch] = testChannel(m, buffers[ch], startPos(trig_pos, m->offset));
+    }
+    if (!any) {
+        return RP_EOOR;
+    }
+
+    *pass = count[0] == 0 && count[1] == 0;
+    stats.tested++;
+    stats.violations += count[0] + count[1];
+    if (*pass) {
+        stats.passed++;
+        return RP_OK;
+    }
+
+    stats.failed++;
+    stats.fail_channel = -1;
+    for (int ch = 0; ch < 2; ch++) {
+        mask_t *m = &masks[ch];
+        if (m->size == 0) {
+            continue;
+        }
+        uint32_t pos = startPos(trig_pos, m->offset);
+        if (count[ch] && stats.fail_channel < 0) {
+            stats.fail_channel = ch;
+            locateViolations(m, buffers[ch], pos, &stats.fail_first, &stats.fail_last);
+        }
+        uint32_t size = m->size;
+        ECHECK(acq_GetDataRaw(ch, pos, &size, m->fail));
+        m->fail_valid = true;
+    }
+    return RP_OK;
+}
+
+/* Arms and waits for a complete capture, returns RP_OK with *done false
+ * when stopped meanwhile */
+static int capture(bool *done)
+{
+    uint32_t pre = 0, cnt, delay, dec;
+    uint64_t deadline;
+    rp_acq_trig_src_t source;
+    rp_acq_trig_state_t state;
+
+    *done = false;
+    pthread_mutex_lock(&mask_mutex);
+    for (int ch = 0; ch < 2; ch++) {
+        if (masks[ch].size && masks[ch].offset < 0) {
+            pre = MAX(pre, (uint32_t)-masks[ch].offset);
+        }
+    }
+    pthread_mutex_unlock(&mask_mutex);
+    pre = MIN(pre, ADC_BUFFER_SIZE);
+    ECHECK(osc_GetTriggerDelay(&delay));
+    ECHECK(osc_GetDecimation(&dec));
+
+    ECHECK(acq_Start());
+    deadline = acq_DeadlineNs(pre, dec);
+    while (running) {
+        ECHECK(acq_GetPreTriggerCounter(&cnt));
+        if (cnt >= pre) {
+            break;
+        }
+        if (cmn_NowNs() > deadline) {
+            return RP_ETMO;
+        }
+        cmn_SleepNs(ACQ_POLL_NS);
+    }
+    ECHECK(acq_SetTriggerSrc(trig_source));
+
+    // The trigger may take any time, the trigger delay is timed from when
+    // the trigger is seen, or the capture is already done
+    while (running) {
+        ECHECK(acq_GetTriggerSrc(&source));
+        ECHECK(acq_GetTriggerState(&state));
+        if (source == RP_TRIG_SRC_DISABLED || state == RP_TRIG_STATE_TRIGGERED) {
+            break;
+        }
+        cmn_SleepNs(ACQ_POLL_NS);
+    }
+    if (!running) {
+        return RP_OK;
+    }
+    ECHECK(acq_WaitCaptureDone(acq_DeadlineNs(delay, dec)));
+    *done = true;
+    return RP_OK;
+}
+
+static void *workerThread(void *arg)
+{
+    while (running) {
+        bool done, pass = true;
+        if (capture(&done) != RP_OK || !done) {
+            break;
+        }
+        pthread_mutex_lock(&mask_mutex);
+        int result = evaluate(&pass);
+        pthread_mutex_unlock(&mask_mutex);
+        if (result != RP_OK || (!pass && stop_on_fail)) {
+            break;
+        }
+    }
+    running = false;
+    return NULL;
+}
+
+int mask_Release()
+{
+    ECHECK(mask_Stop());
+    pthread_mutex_lock(&mask_mutex);
+    freeMask(&masks[RP_CH_1]);
+    freeMask(&masks[RP_CH_2]);
+    pthread_mutex_unlock(&mask_mutex);
+    return RP_OK;
+}
+
+int mask_Set(rp_channel_t channel, int32_t offset, const int16_t* min, const int16_t* max, uint32_t size)
+{
+    ECHECK(checkChannel(channel));
+    if (min == NULL || max == NULL || size == 0 || size > ADC_BUFFER_SIZE) {
+        return RP_EOOR;
+    }
+    if (offset <= -ADC_BUFFER_SIZE || offset + (int64_t)size > ADC_BUFFER_SIZE) {
+        return RP_EOOR;
+    }
+
+    mask_t m = { .size = size, .offset = offset };
+    m.min = malloc(size * sizeof(int16_t));
+    m.max = malloc(size * sizeof(int16_t));
+    m.lo = malloc(size * sizeof(int32_t));
+    m.hi = malloc(size * sizeof(int32_t));
+    m.violations = calloc(size, sizeof(uint32_t));
+    m.fail = malloc(size * sizeof(int16_t));
+    if (!m.min || !m.max || !m.lo || !m.hi || !m.violations || !m.fail) {
+        freeMask(&m);
+        return RP_EOOR;
+    }
+    memcpy(m.min, min, size * sizeof(int16_t));
+    memcpy(m.max, max, size * sizeof(int16_t));
+
+    pthread_mutex_lock(&mask_mutex);
+    freeMask(&masks[channel]);
+    masks[channel] = m;
+    pthread_mutex_unlock(&mask_mutex);
+    return RP_OK;
+}
+
+int mask_SetFromGolden(rp_channel_t channel, int32_t offset, const int16_t* golden, uint32_t size, uint16_t tolerance)
+{
+    if (golden == NULL || size == 0 || size > ADC_BUFFER_SIZE) {
+        return RP_EOOR;
+    }
+
+    int16_t *min = malloc(size * sizeof(int16_t));
+    int16_t *max = malloc(size * sizeof(int16_t));
+    if (!min || !max) {
+        free(min);
+        free(max);
+        return RP_EOOR;
+    }
+    for (uint32_t i = 0; i < size; i++) {
+        min[i] = MAX(golden[i] - tolerance, INT16_MIN);
+        max[i] = MIN(golden[i] + tolerance, INT16_MAX);
+    }
+    int result = mask_Set(channel, offset, min, max, size);
+    free(min);
+    free(max);
+    return result;
+}
+
+int mask_Clear(rp_channel_t channel)
+{
+    ECHECK(checkChannel(channel));
+    pthread_mutex_lock(&mask_mutex);
+    freeMask(&masks[channel]);
+    pthread_mutex_unlock(&mask_mutex);
+    return RP_OK;
+}
+
+int mask_Test(bool* pass)
+{
+    if (running) {
+        return RP_EOOR;
+    }
+    pthread_mutex_lock(&mask_mutex);
+    int result = evaluate(pass);
+    pthread_mutex_unlock(&mask_mutex);
+    return result;
+}
+
+int mask_Start(rp_acq_trig_src_t source, bool stop)
+{
+    if (running) {
+        return RP_EOOR;
+    }
+    pthread_mutex_lock(&mask_mutex);
+    bool any = masks[RP_CH_1].size || masks[RP_CH_2].size;
+    int window = checkWindow();
+    pthread_mutex_unlock(&mask_mutex);
+    if (!any) {
+        return RP_EOOR;
+    }
+    ECHECK(window);
+    // Join a worker which stopped on its own
+    if (worker_started) {
+        pthread_join(worker, NULL);
+        worker_started = false;
+    }
+
+    trig_source = source;
+    stop_on_fail = stop;
+    running = true;
+    if (pthread_create(&worker, NULL, workerThread, NULL) != 0) {
+        running = false;
+        return RP_EOOR;
+    }
+    worker_started = true;
+    return RP_OK;
+}
+
+int mask_Stop()
+{
+    running = false;
+    if (worker_started) {
+        pthread_join(worker, NULL);
+        worker_started = false;
+    }
+    return RP_OK;
+}
+
+int mask_GetStats(rp_mask_stats_t* s)
+{
+    pthread_mutex_lock(&mask_mutex);
+    *s = stats;
+    s->running = running;
+    pthread_mutex_unlock(&mask_mutex);
+    return RP_OK;
+}
+
+int mask_ResetStats()
+{
+    pthread_mutex_lock(&mask_mutex);
+    memset(&stats, 0, sizeof(stats));
+    stats.fail_channel = stats.fail_first = stats.fail_last = -1;
+    for (int ch = 0; ch < 2; ch++) {
+        if (masks[ch].size) {
+            memset(masks[ch].violations, 0, masks[ch].size * sizeof(uint32_t));
+        }
+        masks[ch].fail_valid = false;
+    }
+    pthread_mutex_unlock(&mask_mutex);
+    return RP_OK;
+}
+
+int mask_GetViolations(rp_channel_t channel, uint32_t* counts, uint32_t* size)
+{
+    ECHECK(checkChannel(channel));
+    pthread_mutex_lock(&mask_mutex);
+    mask_t *m = &masks[channel];
+    int result = RP_OK;
+    if (m->size == 0) {
+        result = RP_EOOR;
+    } else if (*size < m->size) {
+        result = RP_BTS;
+    } else {
+        memcpy(counts, m->violations, m->size * sizeof(uint32_t));
+        *size = m->size;
+    }
+    pthread_mutex_unlock(&mask_mutex);
+    return result;
+}
+
+int mask_GetFailData(rp_channel_t channel, int16_t* buffer, uint32_t* size)
+{
+    ECHECK(checkChannel(channel));
+    pthread_mutex_lock(&mask_mutex);
+    mask_t *m = &masks[channel];
+    int result = RP_OK;
+    if (!m->fail_valid) {
+        result = RP_EOOR;
+    } else if (*size < m->size) {
+        result = RP_BTS;
+    } else {
+        memcpy(buffer, m->fail, m->size * sizeof(int16_t));
+        *size = m->size;
+    }
+    pthread_mutex_unlock(&mask_mutex);
+    return result;
+}
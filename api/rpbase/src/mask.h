@@ -0,0 +1,41 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library mask test module interface
+ *
+ * Pass/fail testing of triggered captures against per sample min/max masks,
+ * either on demand or continuously from a background thread.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef __MASK_H
+#define __MASK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "redpitaya/rp.h"
+
+int mask_Release();
+
+int mask_Set(rp_channel_t channel, int32_t offset, const int16_t* min, const int16_t* max, uint32_t size);
+int mask_SetFromGolden(rp_channel_t channel, int32_t offset, const int16_t* golden, uint32_t size, uint16_t tolerance);
+int mask_Clear(rp_channel_t channel);
+
+int mask_Test(bool* pass);
+int mask_Start(rp_acq_trig_src_t source, bool stop_on_fail);
+int mask_Stop();
+
+int mask_GetStats(rp_mask_stats_t* stats);
+int mask_ResetStats();
+int mask_GetViolations(rp_channel_t channel, uint32_t* counts, uint32_t* size);
+int mask_GetFailData(rp_channel_t channel, int16_t* buffer, uint32_t* size);
+
+#endif /* __MASK_H */
@@ -33,6 +33,13 @@ int osc_Init()
 {
 //    ECHECK(cmn_Init());
     ECHECK(cmn_Map(OSC_BASE_SIZE, OSC_BASE_ADDR, (void**)&osc_reg));
+    // The trigger source clears itself when the trigger fires
+    ECHECK(cmn_AddShadow(osc_reg, offsetof(osc_control_t, cha_axi_low),
+                         SHADOW_LIVE(osc_control_t, conf) |
+                         SHADOW_LIVE(osc_control_t, trig_source) |
+                         SHADOW_LIVE(osc_control_t, wr_ptr_cur) |
+                         SHADOW_LIVE(osc_control_t, wr_ptr_trigger) |
+                         SHADOW_LIVE(osc_control_t, pre_trigger_counter), NULL));
     osc_cha = (uint32_t*)((char*)osc_reg + OSC_CHA_OFFSET);
     osc_chb = (uint32_t*)((char*)osc_reg + OSC_CHB_OFFSET);
     return RP_OK;
@@ -40,6 +47,7 @@ int osc_Init()
 
 int osc_Release()
 {
+    ECHECK(cmn_RemoveShadow(osc_reg));
     ECHECK(cmn_Unmap(OSC_BASE_SIZE, (void**)&osc_reg));
     osc_cha = NULL;
     osc_chb = NULL;
@@ -74,7 +82,7 @@ int osc_SetAveraging(bool enable)
 
 int osc_GetAveraging(bool* enable)
 {
-    return cmn_AreBitsSet(osc_reg->other, 0x1, DATA_AVG_MASK, enable);
+    return cmn_AreBitsSet(&osc_reg->other, 0x1, DATA_AVG_MASK, enable);
 }
 
 /**
@@ -116,7 +124,7 @@ int osc_SetArmKeep(bool enable)
 
 int osc_GetTriggerState(bool *received)
 {
-    return cmn_AreBitsSet(osc_reg->conf, (0x1 << 2), TRIG_ST_MCH_MASK, received);
+    return cmn_AreBitsSet(&osc_reg->conf, (0x1 << 2), TRIG_ST_MCH_MASK, received);
 }
 
 int osc_GetPreTriggerCounter(uint32_t *value)
@@ -24,6 +24,15 @@
 #include "calib.h"
 #include "generate.h"
 #include "gen_handler.h"
+#include "sinefit.h"
+#include "mask.h"
+#include "autoscale.h"
+#include "decode.h"
+#include "impedance.h"
+#include "spi.h"
+#include "i2c.h"
+#include "uart.h"
+#include "stats.h"
 
 static char version[50];
 
@@ -31,7 +40,7 @@ static char version[50];
  * Global methods
  */
 
-int rp_Init()
+static int init(bool reset)
 {
     ECHECK(cmn_Init());
 	
@@ -43,11 +52,23 @@ int rp_Init()
     // TODO: Place other module initializations here
 
     // Set default configuration per handler
-    ECHECK(rp_Reset());
+    if (reset) {
+        ECHECK(rp_Reset());
+    }
 
     return RP_OK;
 }
 
+int rp_Init()
+{
+    STATS_CALL(STAT_INIT, init(true))
+}
+
+int rp_InitReset(bool reset)
+{
+    STATS_CALL(STAT_INIT, init(reset))
+}
+
 int rp_CalibInit()
 {
     ECHECK(calib_Init());
@@ -57,17 +78,21 @@ int rp_CalibInit()
 
 int rp_Release()
 {
+    ECHECK(mask_Release());
     ECHECK(osc_Release())
     ECHECK(generate_Release());
     ECHECK(ams_Release());
     ECHECK(hk_Release());
     ECHECK(calib_Release());
+    ECHECK(spi_Release());
+    ECHECK(i2c_Release());
+    ECHECK(uart_Close());
     ECHECK(cmn_Release());
     // TODO: Place other module releasing here (in reverse order)
     return RP_OK;
 }
 
-int rp_Reset()
+static int reset()
 {
     ECHECK(rp_DpinReset());
     ECHECK(rp_AOpinReset());
@@ -77,6 +102,36 @@ int rp_Reset()
     return 0;
 }
 
+int rp_Reset()
+{
+    STATS_CALL(STAT_RESET, reset())
+}
+
+int rp_SyncFromHardware()
+{
+    return cmn_SyncShadows();
+}
+
+int rp_StatsGet(rp_stats_t *stats, uint32_t *count)
+{
+    return stats_Get(stats, count);
+}
+
+int rp_StatsReset()
+{
+    return stats_Reset();
+}
+
+int rp_StatsJson(char *buffer, size_t size)
+{
+    return stats_Json(buffer, size);
+}
+
+uint64_t rp_StatsBucketNs(uint32_t index)
+{
+    return stats_BucketNs(index);
+}
+
 const char* rp_GetVersion()
 {
     sprintf(version, "%s (%s)", VERSION_STR, REVISION_STR);
@@ -131,6 +186,8 @@ const char* rp_GetError(int errorCode) {
             return "Failed to read from the bus";
         case RP_EFWB:
             return "Failed to write to the bus";
+        case RP_ETMO:
+            return "Timeout";
         default:
             return "Unknown error";
     }
@@ -142,7 +199,9 @@ const char* rp_GetError(int errorCode) {
 
 rp_calib_params_t rp_GetCalibrationSettings()
 {
-    return calib_GetParams();
+    rp_calib_params_t calib;
+    calib_GetParams(&calib);
+    return calib;
 }
 
 int rp_CalibrateFrontEndOffset(rp_channel_t channel, rp_pinState_t gain, rp_calib_params_t* out_params) {
@@ -169,6 +228,22 @@ int rp_CalibrateBackEnd(rp_channel_t channel, rp_calib_params_t* out_params) {
     return calib_CalibrateBackEnd(channel, out_params);
 }
 
+int rp_CalibrateFrontEndOffsetBoth(rp_pinState_t gain, rp_calib_params_t* out_params) {
+    return calib_SetFrontEndOffsetBoth(gain, out_params);
+}
+
+int rp_CalibrateFrontEndScaleLVBoth(float referentialVoltage, rp_calib_params_t* out_params) {
+    return calib_SetFrontEndScaleLVBoth(referentialVoltage, out_params);
+}
+
+int rp_CalibrateFrontEndScaleHVBoth(float referentialVoltage, rp_calib_params_t* out_params) {
+    return calib_SetFrontEndScaleHVBoth(referentialVoltage, out_params);
+}
+
+int rp_CalibrateBackEndOffsetBoth() {
+    return calib_SetBackEndOffsetBoth();
+}
+
 int rp_CalibrationReset() {
     return calib_Reset();
 }
@@ -181,18 +256,31 @@ int rp_CalibrationWriteParams(rp_calib_params_t calib_params) {
     return calib_WriteParams(calib_params);
 }
 
+int rp_CalibrationCommit() {
+    return calib_Commit();
+}
+
+int rp_CalibrationSetStore(const char *path, long offset) {
+    return calib_SetStore(path, offset);
+}
+
+int rp_CalibrationSetSampling(uint32_t buffers, rp_calib_reduce_t reduce) {
+    return calib_SetSampling(buffers, reduce);
+}
+
 /**
  * Identification
  */
 
 int rp_IdGetID(uint32_t *id) {
-    *id = ioread32(&hk->id);
-    return RP_OK;
+    return cmn_GetValue(&hk->id, id, 0xFFFFFFFF);
 }
 
 int rp_IdGetDNA(uint64_t *dna) {
-    *dna = ((uint64_t) ioread32(&hk->dna_hi) << 32)
-         | ((uint64_t) ioread32(&hk->dna_lo) <<  0);
+    uint32_t dna_hi, dna_lo;
+    ECHECK(cmn_GetValue(&hk->dna_hi, &dna_hi, 0xFFFFFFFF));
+    ECHECK(cmn_GetValue(&hk->dna_lo, &dna_lo, 0xFFFFFFFF));
+    *dna = ((uint64_t) dna_hi << 32) | dna_lo;
     return RP_OK;
 }
 
@@ -201,13 +289,11 @@ int rp_IdGetDNA(uint64_t *dna) {
  */
 
 int rp_LEDSetState(uint32_t state) {
-    iowrite32(state, &hk->led_control);
-    return RP_OK;
+    return cmn_SetValue(&hk->led_control, state, 0xFFFFFFFF);
 }
 
 int rp_LEDGetState(uint32_t *state) {
-    *state = ioread32(&hk->led_control);
-    return RP_OK;
+    return cmn_GetValue(&hk->led_control, state, 0xFFFFFFFF);
 }
 
 /**
@@ -215,43 +301,35 @@ int rp_LEDGetState(uint32_t *state) {
  */
 
 int rp_GPIOnSetDirection(uint32_t direction) {
-    iowrite32(direction, &hk->ex_cd_n);
-    return RP_OK;
+    return cmn_SetValue(&hk->ex_cd_n, direction, 0xFFFFFFFF);
 }
 
 int rp_GPIOnGetDirection(uint32_t *direction) {
-    *direction = ioread32(&hk->ex_cd_n);
-    return RP_OK;
+    return cmn_GetValue(&hk->ex_cd_n, direction, 0xFFFFFFFF);
 }
 
 int rp_GPIOnSetState(uint32_t state) {
-    iowrite32(state, &hk->ex_co_n);
-    return RP_OK;
+    return cmn_SetValue(&hk->ex_co_n, state, 0xFFFFFFFF);
 }
 
 int rp_GPIOnGetState(uint32_t *state) {
-    *state = ioread32(&hk->ex_ci_n);
-    return RP_OK;
+    return cmn_GetValue(&hk->ex_ci_n, state, 0xFFFFFFFF);
 }
 
 int rp_GPIOpSetDirection(uint32_t direction) {
-    iowrite32(direction, &hk->ex_cd_p);
-    return RP_OK;
+    return cmn_SetValue(&hk->ex_cd_p, direction, 0xFFFFFFFF);
 }
 
 int rp_GPIOpGetDirection(uint32_t *direction) {
-    *direction = ioread32(&hk->ex_cd_p);
-    return RP_OK;
+    return cmn_GetValue(&hk->ex_cd_p, direction, 0xFFFFFFFF);
 }
 
 int rp_GPIOpSetState(uint32_t state) {
-    iowrite32(state, &hk->ex_co_p);
-    return RP_OK;
+    return cmn_SetValue(&hk->ex_co_p, state, 0xFFFFFFFF);
 }
 
 int rp_GPIOpGetState(uint32_t *state) {
-    *state = ioread32(&hk->ex_ci_p);
-    return RP_OK;
+    return cmn_GetValue(&hk->ex_ci_p, state, 0xFFFFFFFF);
 }
 
 /**
@@ -259,52 +337,48 @@ int rp_GPIOpGetState(uint32_t *state) {
  */
 
 int rp_DpinReset() {
-    iowrite32(0, &hk->ex_cd_p);
-    iowrite32(0, &hk->ex_cd_n);
-    iowrite32(0, &hk->ex_co_p);
-    iowrite32(0, &hk->ex_co_n);
-    iowrite32(0, &hk->led_control);
-    iowrite32(0, &hk->digital_loop);
+    ECHECK(cmn_SetValue(&hk->ex_cd_p, 0, EX_CD_P_MASK));
+    ECHECK(cmn_SetValue(&hk->ex_cd_n, 0, EX_CD_N_MASK));
+    ECHECK(cmn_SetValue(&hk->ex_co_p, 0, EX_CO_P_MASK));
+    ECHECK(cmn_SetValue(&hk->ex_co_n, 0, EX_CO_N_MASK));
+    ECHECK(cmn_SetValue(&hk->led_control, 0, LED_CONTROL_MASK));
+    ECHECK(cmn_SetValue(&hk->digital_loop, 0, DIGITAL_LOOP_MASK));
     return RP_OK;
 }
 
 int rp_DpinSetDirection(rp_dpin_t pin, rp_pinDirection_t direction) {
-    uint32_t tmp;
     if (pin < RP_DIO0_P) {
         // LEDS
         return RP_ELID;
     } else if (pin < RP_DIO0_N) {
         // DIO_P
         pin -= RP_DIO0_P;
-        tmp = ioread32(&hk->ex_cd_p);
-        iowrite32((tmp & ~(1 << pin)) | ((direction << pin) & (1 << pin)), &hk->ex_cd_p);
+        return cmn_SetShiftedValue(&hk->ex_cd_p, direction, 0x1, pin);
     } else {
         // DIO_N
         pin -= RP_DIO0_N;
-        tmp = ioread32(&hk->ex_cd_n);
-        iowrite32((tmp & ~(1 << pin)) | ((direction << pin) & (1 << pin)), &hk->ex_cd_n);
+        return cmn_SetShiftedValue(&hk->ex_cd_n, direction, 0x1, pin);
     }
-    return RP_OK;
 }
 
 int rp_DpinGetDirection(rp_dpin_t pin, rp_pinDirection_t* direction) {
+    uint32_t value = RP_OUT;
     if (pin < RP_DIO0_P) {
-        // LEDS
-        *direction = RP_OUT;
+        // LEDS, always outputs
     } else if (pin < RP_DIO0_N) {
         // DIO_P
         pin -= RP_DIO0_P;
-        *direction = (ioread32(&hk->ex_cd_p) >> pin) & 0x1;
+        ECHECK(cmn_GetShiftedValue(&hk->ex_cd_p, &value, 0x1, pin));
     } else {
         // DIO_N
         pin -= RP_DIO0_N;
-        *direction = (ioread32(&hk->ex_cd_n) >> pin) & 0x1;
+        ECHECK(cmn_GetShiftedValue(&hk->ex_cd_n, &value, 0x1, pin));
     }
+    *direction = value;
     return RP_OK;
 }
 
 int rp_DpinSetState(rp_dpin_t pin, rp_pinState_t state) {
-    uint32_t tmp;
     rp_pinDirection_t direction;
     rp_DpinGetDirection(pin, &direction);
     if (!direction) {
@@ -312,35 +386,33 @@ int rp_DpinSetState(rp_dpin_t pin, rp_pinState_t state) {
     }
     if (pin < RP_DIO0_P) {
         // LEDS
-        tmp = ioread32(&hk->led_control);
-        iowrite32((tmp & ~(1 << pin)) | ((state << pin) & (1 << pin)), &hk->led_control);
+        return cmn_SetShiftedValue(&hk->led_control, state, 0x1, pin);
     } else if (pin < RP_DIO0_N) {
         // DIO_P
         pin -= RP_DIO0_P;
-        tmp = ioread32(&hk->ex_co_p);
-        iowrite32((tmp & ~(1 << pin)) | ((state << pin) & (1 << pin)), &hk->ex_co_p);
+        return cmn_SetShiftedValue(&hk->ex_co_p, state, 0x1, pin);
     } else {
         // DIO_N
         pin -= RP_DIO0_N;
-        tmp = ioread32(&hk->ex_co_n);
-        iowrite32((tmp & ~(1 << pin)) | ((state << pin) & (1 << pin)), &hk->ex_co_n);
+        return cmn_SetShiftedValue(&hk->ex_co_n, state, 0x1, pin);
     }
-    return RP_OK;
 }
 
 int rp_DpinGetState(rp_dpin_t pin, rp_pinState_t* state) {
+    uint32_t value;
     if (pin < RP_DIO0_P) {
         // LEDS
-        *state = (ioread32(&hk->led_control) >> pin) & 0x1;
+        ECHECK(cmn_GetShiftedValue(&hk->led_control, &value, 0x1, pin));
     } else if (pin < RP_DIO0_N) {
         // DIO_P
         pin -= RP_DIO0_P;
-        *state = (ioread32(&hk->ex_ci_p) >> pin) & 0x1;
+        ECHECK(cmn_GetShiftedValue(&hk->ex_ci_p, &value, 0x1, pin));
     } else {
         // DIO_N
         pin -= RP_DIO0_N;
-        *state = (ioread32(&hk->ex_ci_n) >> pin) & 0x1;
+        ECHECK(cmn_GetShiftedValue(&hk->ex_ci_n, &value, 0x1, pin));
     }
+    *state = value;
     return RP_OK;
 }
 
@@ -350,8 +422,7 @@ int rp_DpinGetState(rp_dpin_t pin, rp_pinState_t* state) {
  */
 
 int rp_EnableDigitalLoop(bool enable) {
-    iowrite32((uint32_t) enable, &hk->digital_loop);
-    return RP_OK;
+    return cmn_SetValue(&hk->digital_loop, (uint32_t) enable, DIGITAL_LOOP_MASK);
 }
 
 
@@ -466,8 +537,7 @@ int rp_AOpinSetValueRaw(int unsigned pin, uint32_t value) {
     if (value > ANALOG_OUT_MAX_VAL_INTEGER) {
         return RP_EOOR;
     }
-    iowrite32((value & ANALOG_OUT_MASK) << ANALOG_OUT_BITS, &ams->dac[pin]);
-    return RP_OK;
+    return cmn_SetShiftedValue(&ams->dac[pin], value, ANALOG_OUT_MASK, ANALOG_OUT_BITS);
 }
 
 int rp_AOpinSetValue(int unsigned pin, float value) {
@@ -479,8 +549,7 @@ int rp_AOpinGetValueRaw(int unsigned pin, uint32_t* value) {
     if (pin >= 4) {
         return RP_EPN;
     }
-    *value = (ioread32(&ams->dac[pin]) >> ANALOG_OUT_BITS) & ANALOG_OUT_MASK;
-    return RP_OK;
+    return cmn_GetShiftedValue(&ams->dac[pin], value, ANALOG_OUT_MASK, ANALOG_OUT_BITS);
 }
 
 int rp_AOpinGetValue(int unsigned pin, float* value) {
@@ -508,7 +577,7 @@ int rp_AcqSetArmKeep(bool enable)
 
 int rp_AcqSetDecimation(rp_acq_decimation_t decimation)
 {
-    return acq_SetDecimation(decimation);
+    STATS_CALL(STAT_ACQ_SET_DECIMATION, acq_SetDecimation(decimation))
 }
 
 int rp_AcqGetDecimation(rp_acq_decimation_t* decimation)
@@ -548,7 +617,7 @@ int rp_AcqGetAveraging(bool *enabled)
 
 int rp_AcqSetTriggerSrc(rp_acq_trig_src_t source)
 {
-    return acq_SetTriggerSrc(source);
+    STATS_CALL(STAT_ACQ_SET_TRIGGER_SRC, acq_SetTriggerSrc(source))
 }
 
 int rp_AcqGetTriggerSrc(rp_acq_trig_src_t* source)
@@ -558,7 +627,12 @@ int rp_AcqGetTriggerSrc(rp_acq_trig_src_t* source)
 
 int rp_AcqGetTriggerState(rp_acq_trig_state_t* state)
 {
-    return acq_GetTriggerState(state);
+    STATS_CALL(STAT_ACQ_GET_TRIGGER_STATE, acq_GetTriggerState(state))
+}
+
+int rp_AcqWaitCaptureDone(uint32_t timeout_us)
+{
+    return acq_WaitCaptureDone(cmn_NowNs() + timeout_us * 1000ULL);
 }
 
 int rp_AcqSetTriggerDelay(int32_t decimated_data_num)
@@ -622,7 +696,7 @@ int rp_AcqSetTriggerHyst(float voltage)
 
 int rp_AcqGetWritePointer(uint32_t* pos)
 {
-    return acq_GetWritePointer(pos);
+    STATS_CALL(STAT_ACQ_GET_WRITE_POINTER, acq_GetWritePointer(pos))
 }
 
 int rp_AcqGetWritePointerAtTrig(uint32_t* pos)
@@ -632,16 +706,16 @@ int rp_AcqGetWritePointerAtTrig(uint32_t* pos)
 
 int rp_AcqStart()
 {
-    return acq_Start();
+    STATS_CALL(STAT_ACQ_START, acq_Start())
 }
 
 int rp_AcqStop()
 {
-    return acq_Stop();
+    STATS_CALL(STAT_ACQ_STOP, acq_Stop())
 }
 int rp_AcqReset()
 {
-    return acq_Reset();
+    STATS_CALL(STAT_ACQ_RESET, acq_Reset())
 }
 
 uint32_t rp_AcqGetNormalizedDataPos(uint32_t pos)
@@ -651,64 +725,220 @@ uint32_t rp_AcqGetNormalizedDataPos(uint32_t pos)
 
 int rp_AcqGetDataPosRaw(rp_channel_t channel, uint32_t start_pos, uint32_t end_pos, int16_t* buffer, uint32_t* buffer_size)
 {
-    return acq_GetDataPosRaw(channel, start_pos, end_pos, buffer, buffer_size);
+    STATS_CALL(STAT_ACQ_GET_DATA_POS_RAW, acq_GetDataPosRaw(channel, start_pos, end_pos, buffer, buffer_size))
 }
 
 int rp_AcqGetDataPosV(rp_channel_t channel, uint32_t start_pos, uint32_t end_pos, float* buffer, uint32_t* buffer_size)
 {
-    return acq_GetDataPosV(channel, start_pos, end_pos, buffer, buffer_size);
+    STATS_CALL(STAT_ACQ_GET_DATA_POS_V, acq_GetDataPosV(channel, start_pos, end_pos, buffer, buffer_size))
 }
 
 int rp_AcqGetDataRaw(rp_channel_t channel,  uint32_t pos, uint32_t* size, int16_t* buffer)
 {
-    return acq_GetDataRaw(channel, pos, size, buffer);
+    STATS_CALL(STAT_ACQ_GET_DATA_RAW, acq_GetDataRaw(channel, pos, size, buffer))
 }
 
 int rp_AcqGetDataRawV2(uint32_t pos, uint32_t* size, uint16_t* buffer, uint16_t* buffer2)
 {
-    return acq_GetDataRawV2(pos, size, buffer, buffer2);
+    STATS_CALL(STAT_ACQ_GET_DATA_RAW_V2, acq_GetDataRawV2(pos, size, buffer, buffer2))
 }
 
 int rp_AcqGetOldestDataRaw(rp_channel_t channel, uint32_t* size, int16_t* buffer)
 {
-    return acq_GetOldestDataRaw(channel, size, buffer);
+    STATS_CALL(STAT_ACQ_GET_OLDEST_DATA_RAW, acq_GetOldestDataRaw(channel, size, buffer))
 }
 
 int rp_AcqGetLatestDataRaw(rp_channel_t channel, uint32_t* size, int16_t* buffer)
 {
-    return acq_GetLatestDataRaw(channel, size, buffer);
+    STATS_CALL(STAT_ACQ_GET_LATEST_DATA_RAW, acq_GetLatestDataRaw(channel, size, buffer))
 }
 
 int rp_AcqGetDataV(rp_channel_t channel, uint32_t pos, uint32_t* size, float* buffer)
 {
-    return acq_GetDataV(channel, pos, size, buffer);
+    STATS_CALL(STAT_ACQ_GET_DATA_V, acq_GetDataV(channel, pos, size, buffer))
 }
 
 int rp_AcqGetDataV2(uint32_t pos, uint32_t* size, float* buffer1, float* buffer2)
 {
-    return acq_GetDataV2(pos, size, buffer1, buffer2);
+    STATS_CALL(STAT_ACQ_GET_DATA_V2, acq_GetDataV2(pos, size, buffer1, buffer2))
 }
 
 int rp_AcqGetOldestDataV(rp_channel_t channel, uint32_t* size, float* buffer)
 {
-    return acq_GetOldestDataV(channel, size, buffer);
+    STATS_CALL(STAT_ACQ_GET_OLDEST_DATA_V, acq_GetOldestDataV(channel, size, buffer))
 }
 
 int rp_AcqGetLatestDataV(rp_channel_t channel, uint32_t* size, float* buffer)
 {
-    return acq_GetLatestDataV(channel, size, buffer);
+    STATS_CALL(STAT_ACQ_GET_LATEST_DATA_V, acq_GetLatestDataV(channel, size, buffer))
 }
 
 int rp_AcqGetBufSize(uint32_t *size) {
     return acq_GetBufferSize(size);
 }
 
+int rp_AcqSineFit(const float* ch1, const float* ch2, uint32_t size, double sample_rate,
+                  double frequency, bool fit_frequency, rp_sine_fit_t* fit1, rp_sine_fit_t* fit2)
+{
+    return sinefit_Fit(ch1, ch2, size, sample_rate, frequency, fit_frequency, fit1, fit2);
+}
+
+int rp_AcqMaskSet(rp_channel_t channel, int32_t offset, const int16_t* min, const int16_t* max, uint32_t size)
+{
+    return mask_Set(channel, offset, min, max, size);
+}
+
+int rp_AcqMaskSetFromGolden(rp_channel_t channel, int32_t offset, const int16_t* golden, uint32_t size, uint16_t tolerance)
+{
+    return mask_SetFromGolden(channel, offset, golden, size, tolerance);
+}
+
+int rp_AcqMaskClear(rp_channel_t channel)
+{
+    return mask_Clear(channel);
+}
+
+int rp_AcqMaskTest(bool* pass)
+{
+    return mask_Test(pass);
+}
+
+int rp_AcqMaskStart(rp_acq_trig_src_t source, bool stop_on_fail)
+{
+    return mask_Start(source, stop_on_fail);
+}
+
+int rp_AcqMaskStop()
+{
+    return mask_Stop();
+}
+
+int rp_AcqMaskGetStats(rp_mask_stats_t* stats)
+{
+    return mask_GetStats(stats);
+}
+
+int rp_AcqMaskResetStats()
+{
+    return mask_ResetStats();
+}
+
+int rp_AcqMaskGetViolations(rp_channel_t channel, uint32_t* counts, uint32_t* size)
+{
+    return mask_GetViolations(channel, counts, size);
+}
+
+int rp_AcqMaskGetFailData(rp_channel_t channel, int16_t* buffer, uint32_t* size)
+{
+    return mask_GetFailData(channel, buffer, size);
+}
+
+int rp_AcqAutoScale(bool apply, rp_auto_scale_t* result)
+{
+    return autoscale_Run(apply, result);
+}
+
+int rp_AcqDecode(const rp_decode_cfg_t* cfg, uint32_t pos, uint32_t size,
+                 rp_decode_event_t* events, uint32_t* count, float* rate)
+{
+    return decode_Run(cfg, pos, size, events, count, rate);
+}
+
+int rp_ImpMeasure(const rp_imp_cfg_t* cfg, float frequency, double* z_re, double* z_im)
+{
+    return impedance_Measure(cfg, frequency, z_re, z_im);
+}
+
+int rp_ImpDerive(float frequency, double z_re, double z_im, rp_imp_result_t* result, uint32_t index)
+{
+    return impedance_Derive(frequency, z_re, z_im, result, index);
+}
+
+/**
+* Serial bus methods
+*/
+
+int rp_SpiSetDevice(const char* path)
+{
+    return spi_SetDevice(path);
+}
+
+int rp_SpiSetMode(rp_spi_mode_t mode)
+{
+    return spi_SetMode(mode);
+}
+
+int rp_SpiSetSpeed(uint32_t speed)
+{
+    return spi_SetSpeed(speed);
+}
+
+int rp_SpiSetWordLen(uint8_t bits)
+{
+    return spi_SetWordLen(bits);
+}
+
+int rp_SpiTransfer(rp_spi_xfer_t* xfers, int n)
+{
+    return spi_Transfer(xfers, n);
+}
+
+int rp_SpiRelease()
+{
+    return spi_Release();
+}
+
+int rp_I2cSetDevice(int bus, const char* path)
+{
+    return i2c_SetDevice(bus, path);
+}
+
+int rp_I2cTransfer(int bus, rp_i2c_msg_t* msgs, int n)
+{
+    return i2c_Transfer(bus, msgs, n);
+}
+
+int rp_I2cReadRegs(int bus, uint8_t addr, uint8_t reg, uint8_t* buf, uint16_t len)
+{
+    return i2c_ReadRegs(bus, addr, reg, buf, len);
+}
+
+int rp_I2cRelease()
+{
+    return i2c_Release();
+}
+
+int rp_UartOpen(const char* path, const rp_uart_cfg_t* cfg)
+{
+    return uart_Open(path, cfg);
+}
+
+int rp_UartClose()
+{
+    return uart_Close();
+}
+
+int rp_UartWrite(const uint8_t* data, uint32_t len)
+{
+    return uart_Write(data, len);
+}
+
+int rp_UartPeek(rp_uart_frame_t* frame, bool* ready)
+{
+    return uart_Peek(frame, ready);
+}
+
+int rp_UartConsume()
+{
+    return uart_Consume();
+}
+
 /**
 * Generate methods
 */
 
 int rp_GenReset() {
-    return gen_SetDefaultValues();
+    STATS_CALL(STAT_GEN_RESET, gen_SetDefaultValues())
 }
 
 int rp_GenOutDisable(rp_channel_t channel) {
@@ -724,7 +954,7 @@ int rp_GenOutIsEnabled(rp_channel_t channel, bool *value) {
 }
 
 int rp_GenAmp(rp_channel_t channel, float amplitude) {
-    return gen_setAmplitude(channel, amplitude);
+    STATS_CALL(STAT_GEN_AMP, gen_setAmplitude(channel, amplitude))
 }
 
 int rp_GenGetAmp(rp_channel_t channel, float *amplitude) {
@@ -732,7 +962,7 @@ int rp_GenGetAmp(rp_channel_t channel, float *amplitude) {
 }
 
 int rp_GenOffset(rp_channel_t channel, float offset) {
-    return gen_setOffset(channel, offset);
+    STATS_CALL(STAT_GEN_OFFSET, gen_setOffset(channel, offset))
 }
 
 int rp_GenGetOffset(rp_channel_t channel, float *offset) {
@@ -740,7 +970,7 @@ int rp_GenGetOffset(rp_channel_t channel, float *offset) {
 }
 
 int rp_GenFreq(rp_channel_t channel, float frequency) {
-    return gen_setFrequency(channel, frequency);
+    STATS_CALL(STAT_GEN_FREQ, gen_setFrequency(channel, frequency))
 }
 
 int rp_GenGetFreq(rp_channel_t channel, float *frequency) {
@@ -748,7 +978,7 @@ int rp_GenGetFreq(rp_channel_t channel, float *frequency) {
 }
 
 int rp_GenPhase(rp_channel_t channel, float phase) {
-    return gen_setPhase(channel, phase);
+    STATS_CALL(STAT_GEN_PHASE, gen_setPhase(channel, phase))
 }
 
 int rp_GenGetPhase(rp_channel_t channel, float *phase) {
@@ -756,7 +986,7 @@ int rp_GenGetPhase(rp_channel_t channel, float *phase) {
 }
 
 int rp_GenWaveform(rp_channel_t channel, rp_waveform_t type) {
-    return gen_setWaveform(channel, type);
+    STATS_CALL(STAT_GEN_WAVEFORM, gen_setWaveform(channel, type))
 }
 
 int rp_GenGetWaveform(rp_channel_t channel, rp_waveform_t *type) {
@@ -764,7 +994,7 @@ int rp_GenGetWaveform(rp_channel_t channel, rp_waveform_t *type) {
 }
 
 int rp_GenArbWaveform(rp_channel_t channel, float *waveform, uint32_t length) {
-    return gen_setArbWaveform(channel, waveform, length);
+    STATS_CALL(STAT_GEN_ARB_WAVEFORM, gen_setArbWaveform(channel, waveform, length))
 }
 
 int rp_GenGetArbWaveform(rp_channel_t channel, float *waveform, uint32_t *length) {
@@ -772,7 +1002,7 @@ int rp_GenGetArbWaveform(rp_channel_t channel, float *waveform, uint32_t *length
 }
 
 int rp_GenDutyCycle(rp_channel_t channel, float ratio) {
-    return gen_setDutyCycle(channel, ratio);
+    STATS_CALL(STAT_GEN_DUTY_CYCLE, gen_setDutyCycle(channel, ratio))
 }
 
 int rp_GenGetDutyCycle(rp_channel_t channel, float *ratio) {
@@ -820,7 +1050,7 @@ int rp_GenGetTriggerSource(rp_channel_t channel, rp_trig_src_t *src) {
 }
 
 int rp_GenTrigger(uint32_t channel) {
-    return gen_Trigger(channel);
+    STATS_CALL(STAT_GEN_TRIGGER, gen_Trigger(channel))
 }
 
 float rp_CmnCnvCntToV(uint32_t field_len, uint32_t cnts, float adc_max_v, uint32_t calibScale, int calib_dc_off, float user_dc_off)
@@ -0,0 +1,264 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library sine fit module implementation
+ *
+ * The signal is modelled as y[n] = a*cos(w*n) + b*sin(w*n) + c. The cos/sin
+ * reference is generated by rotating a phasor by exp(j*w) every sample and
+ * is resynchronised with cos()/sin() every SINEFIT_RESYNC samples, so only
+ * a handful of trigonometric calls are made per buffer. The Gram matrix of
+ * the 3-parameter fit only depends on w, so both channels share it and it
+ * is accumulated and factorised once. Residuals come from the normal
+ * equations (sum y^2 - x'A'y) and need no second pass over the data.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <math.h>
+
+#include "common.h"
+#include "sinefit.h"
+
+#define SINEFIT_RESYNC  256
+#define MAX_DIM         4
+#define MAX_RHS         2
+
+typedef struct {
+    double cos;
+    double sin;
+    double rot_cos;
+    double rot_sin;
+    double w;
+    uint32_t n;
+} phasor_t;
+
+/* Linear system of a fit, columns cos, sin, 1 and optionally d/dw */
+typedef struct {
+    double a[MAX_DIM][MAX_DIM];
+    double b[MAX_DIM][MAX_RHS];
+    double yy[MAX_RHS];
+} normal_eq_t;
+
+static void phasorInit(phasor_t *p, double w)
+{
+    p->w = w;
+    p->rot_cos = cos(w);
+    p->rot_sin = sin(w);
+    p->cos = 1.0;
+    p->sin = 0.0;
+    p->n = 0;
+}
+
+static inline void phasorNext(phasor_t *p)
+{
+    double c = p->cos * p->rot_cos - p->sin * p->rot_sin;
+    p->sin = p->sin * p->rot_cos + p->cos * p->rot_sin;
+    p->cos = c;
+    if ((++p->n % SINEFIT_RESYNC) == 0) {
+        p->cos = cos(p->w * p->n);
+        p->sin = sin(p->w * p->n);
+    }
+}
+
+/* Solves a x = b in place for nrhs right hand sides, b is overwritten with x */
+static int solve(double a[MAX_DIM][MAX_DIM], double b[MAX_DIM][MAX_RHS], int n, int nrhs)
+{
+    for (int j = 0; j < n; j++) {
+        int pivot = j;
+        for (int i = j + 1; i < n; i++) {
+            if (fabs(a[i][j]) > fabs(a[pivot][j])) {
+                pivot = i;
+            }
+        }
+        if (a[pivot][j] == 0.0) {
+            return RP_EOOR;
+        }
+        for (int k = 0; k < n; k++) {
+            double t = a[j][k]; a[j][k] = a[pivot][k]; a[pivot][k] = t;
+        }
+        for (int r = 0; r < nrhs; r++) {
+            double t = b[j][r]; b[j][r] = b[pivot][r]; b[pivot][r] = t;
+        }
+        for (int i = j + 1; i < n; i++) {
+            double f = a[i][j] / a[j][j];
+            for (int k = j; k < n; k++) {
+                a[i][k] -= f * a[j][k];
+            }
+            for (int r = 0; r < nrhs; r++) {
+                b[i][r] -= f * b[j][r];
+            }
+        }
+    }
+    for (int j = n - 1; j >= 0; j--) {
+        for (int r = 0; r < nrhs; r++) {
+            double s = b[j][r];
+            for (int k = j + 1; k < n; k++) {
+                s -= a[j][k] * b[k][r];
+            }
+            b[j][r] = s / a[j][j];
+        }
+    }
+    return RP_OK;
+}
+
+/* 3-parameter fit of up to MAX_RHS channels at w, sharing one Gram matrix */
+static int fit3(const float *y[], int chans, uint32_t size, double w, double x[][3], double yy[])
+{
+    normal_eq_t eq = { { { 0 } } };
+    double scc = 0, scs = 0, sss = 0, sc = 0, ss = 0;
+    phasor_t p;
+
+    phasorInit(&p, w);
+    for (uint32_t i = 0; i < size; i++) {
+        scc += p.cos * p.cos;
+        scs += p.cos * p.sin;
+        sss += p.sin * p.sin;
+        sc += p.cos;
+        ss += p.sin;
+        for (int ch = 0; ch < chans; ch++) {
+            double v = y[ch][i];
+            eq.b[0][ch] += v * p.cos;
+            eq.b[1][ch] += v * p.sin;
+            eq.b[2][ch] += v;
+            eq.yy[ch] += v * v;
+        }
+        phasorNext(&p);
+    }
+    eq.a[0][0] = scc;
+    eq.a[0][1] = eq.a[1][0] = scs;
+    eq.a[0][2] = eq.a[2][0] = sc;
+    eq.a[1][1] = sss;
+    eq.a[1][2] = eq.a[2][1] = ss;
+    eq.a[2][2] = size;
+
+    for (int ch = 0; ch < chans; ch++) {
+        // sum y^2 - x'A'y is the residual energy of the solution x
+        yy[ch] = eq.yy[ch];
+        for (int k = 0; k < 3; k++) {
+            x[ch][k] = eq.b[k][ch];
+        }
+    }
+    ECHECK(solve(eq.a, eq.b, 3, chans));
+    for (int ch = 0; ch < chans; ch++) {
+        for (int k = 0; k < 3; k++) {
+            yy[ch] -= x[ch][k] * eq.b[k][ch];
+            x[ch][k] = eq.b[k][ch];
+        }
+    }
+    return RP_OK;
+}
+
+/* One Gauss-Newton step of the 4-parameter fit, updates x and w */
+static int fit4Step(const float *y, uint32_t size, double *w, double x[3])
+{
+    normal_eq_t eq = { { { 0 } } };
+    double f[MAX_DIM];
+    phasor_t p;
+
+    phasorInit(&p, *w);
+    for (uint32_t i = 0; i < size; i++) {
+        f[0] = p.cos;
+        f[1] = p.sin;
+        f[2] = 1.0;
+        f[3] = i * (x[1] * p.cos - x[0] * p.sin);
+        for (int j = 0; j < MAX_DIM; j++) {
+            for (int k = j; k < MAX_DIM; k++) {
+                eq.a[j][k] += f[j] * f[k];
+            }
+            eq.b[j][0] += f[j] * y[i];
+        }
+        phasorNext(&p);
+    }
+    for (int j = 1; j < MAX_DIM; j++) {
+        for (int k = 0; k < j; k++) {
+            eq.a[j][k] = eq.a[k][j];
+        }
+    }
+    ECHECK(solve(eq.a, eq.b, MAX_DIM, 1));
+    for (int k = 0; k < 3; k++) {
+        x[k] = eq.b[k][0];
+    }
+    *w += eq.b[3][0];
+    return RP_OK;
+}
+
+static int fit4(const float *y, uint32_t size, double *w, double x[3], double *yy)
+{
+    const float *chans[] = { y };
+    double xs[1][3];
+
+    ECHECK(fit3(chans, 1, size, *w, xs, yy));
+    for (int k = 0; k < 3; k++) {
+        x[k] = xs[0][k];
+    }
+    for (int iter = 0; iter < SINEFIT_MAX_ITER; iter++) {
+        double w0 = *w;
+        ECHECK(fit4Step(y, size, w, x));
+        if (*w <= 0.0 || *w >= M_PI) {
+            return RP_EOOR;
+        }
+        if (fabs(*w - w0) < SINEFIT_FREQ_TOL * w0) {
+            break;
+        }
+    }
+    // Final 3-parameter fit, so that amplitude and residual belong to w
+    ECHECK(fit3(chans, 1, size, *w, xs, yy));
+    for (int k = 0; k < 3; k++) {
+        x[k] = xs[0][k];
+    }
+    return RP_OK;
+}
+
+static void fillResult(const double x[3], double yy, double w, uint32_t size, double sample_rate, rp_sine_fit_t *fit)
+{
+    fit->amplitude = sqrt(x[0] * x[0] + x[1] * x[1]);
+    fit->phase = atan2(-x[1], x[0]);
+    fit->offset = x[2];
+    fit->frequency = w * sample_rate / (2 * M_PI);
+    fit->residual_rms = sqrt(MAX(yy, 0.0) / size);
+    if (fit->residual_rms > 0) {
+        fit->sinad = 20 * log10(fit->amplitude / M_SQRT2 / fit->residual_rms);
+    } else {
+        fit->sinad = INFINITY;
+    }
+    fit->enob = (fit->sinad - 1.76) / 6.02;
+}
+
+int sinefit_Fit(const float *ch1, const float *ch2, uint32_t size, double sample_rate,
+                double frequency, bool fit_frequency, rp_sine_fit_t *fit1, rp_sine_fit_t *fit2)
+{
+    if (ch1 == NULL || fit1 == NULL || (ch2 != NULL && fit2 == NULL)) {
+        return RP_EOOR;
+    }
+    if (size < 4 || sample_rate <= 0 || frequency <= 0 || frequency >= sample_rate / 2) {
+        return RP_EOOR;
+    }
+
+    double w = 2 * M_PI * frequency / sample_rate;
+    const float *y[MAX_RHS] = { ch1, ch2 };
+    rp_sine_fit_t *fit[MAX_RHS] = { fit1, fit2 };
+    int chans = ch2 != NULL ? 2 : 1;
+    double x[MAX_RHS][3];
+    double yy[MAX_RHS];
+
+    if (!fit_frequency) {
+        ECHECK(fit3(y, chans, size, w, x, yy));
+        for (int ch = 0; ch < chans; ch++) {
+            fillResult(x[ch], yy[ch], w, size, sample_rate, fit[ch]);
+        }
+        return RP_OK;
+    }
+
+    for (int ch = 0; ch < chans; ch++) {
+        double wch = w;
+        ECHECK(fit4(y[ch], size, &wch, x[ch], &yy[ch]));
+        fillResult(x[ch], yy[ch], wch, size, sample_rate, fit[ch]);
+    }
+    return RP_OK;
+}
@@ -0,0 +1,35 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library sine fit module interface
+ *
+ * Least squares sine fits after IEEE Std 1057: the 3-parameter fit at a
+ * known frequency and the iterative 4-parameter fit which also estimates
+ * the frequency.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef __SINEFIT_H
+#define __SINEFIT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "redpitaya/rp.h"
+
+/* Number of 4-parameter iterations before giving up on convergence */
+#define SINEFIT_MAX_ITER    20
+/* Relative frequency change at which the 4-parameter fit has converged */
+#define SINEFIT_FREQ_TOL    1e-10
+
+int sinefit_Fit(const float *ch1, const float *ch2, uint32_t size, double sample_rate,
+                double frequency, bool fit_frequency, rp_sine_fit_t *fit1, rp_sine_fit_t *fit2);
+
+#endif /* __SINEFIT_H */
@@ -0,0 +1,156 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library SPI module implementation
+ *
+ * The segments of a transfer are handed to spidev in one SPI_IOC_MESSAGE
+ * ioctl, so the chip select is only released where a segment asks for it.
+ * The device stays open between transfers and the mode, speed and word
+ * length are only written to it when they change.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <linux/spi/spidev.h>
+
+#include "common.h"
+#include "spi.h"
+
+static char *spi_path = NULL;
+static int spi_fd = -1;
+
+static uint8_t spi_mode = RP_SPI_MODE_0;
+static uint32_t spi_speed = 1000000;
+static uint8_t spi_bits = 8;
+// Settings not yet written to the open device
+static bool spi_dirty = true;
+
+static int spiOpen()
+{
+    if (spi_fd >= 0) {
+        return RP_OK;
+    }
+    spi_fd = open(spi_path ? spi_path : SPI_DEVICE, O_RDWR);
+    if (spi_fd < 0) {
+        return RP_EFOB;
+    }
+    spi_dirty = true;
+    return RP_OK;
+}
+
+static int spiApply()
+{
+    if (!spi_dirty) {
+        return RP_OK;
+    }
+    if (ioctl(spi_fd, SPI_IOC_WR_MODE, &spi_mode) < 0
+        || ioctl(spi_fd, SPI_IOC_WR_BITS_PER_WORD, &spi_bits) < 0
+        || ioctl(spi_fd, SPI_IOC_WR_MAX_SPEED_HZ, &spi_speed) < 0) {
+        return RP_EABA;
+    }
+    spi_dirty = false;
+    return RP_OK;
+}
+
+/* The next transfer opens the new device */
+int spi_SetDevice(const char *path)
+{
+    char *copy = NULL;
+
+    if (path != NULL && (copy = strdup(path)) == NULL) {
+        return RP_EOOR;
+    }
+    ECHECK(spi_Release());
+    free(spi_path);
+    spi_path = copy;
+    return RP_OK;
+}
+
+int spi_SetMode(rp_spi_mode_t mode)
+{
+    if (mode < RP_SPI_MODE_0 || mode > RP_SPI_MODE_3) {
+        return RP_EOOR;
+    }
+    spi_dirty |= spi_mode != mode;
+    spi_mode = mode;
+    return RP_OK;
+}
+
+int spi_SetSpeed(uint32_t speed)
+{
+    if (speed == 0) {
+        return RP_EOOR;
+    }
+    spi_dirty |= spi_speed != speed;
+    spi_speed = speed;
+    return RP_OK;
+}
+
+int spi_SetWordLen(uint8_t bits)
+{
+    if (bits < 1 || bits > 32) {
+        return RP_EOOR;
+    }
+    spi_dirty |= spi_bits != bits;
+    spi_bits = bits;
+    return RP_OK;
+}
+
+int spi_Transfer(rp_spi_xfer_t *xfers, int n)
+{
+    struct spi_ioc_transfer msg[SPI_BATCH];
+    uint64_t bytes = 0;
+
+    if (n < 0 || (xfers == NULL && n > 0)) {
+        return RP_UIA;
+    }
+    if (n == 0) {
+        return RP_OK;
+    }
+    // Split messages would release the chip select between them
+    if (n > SPI_BATCH) {
+        return RP_EOOR;
+    }
+    for (int i = 0; i < n; i++) {
+        bytes += xfers[i].len;
+    }
+    if (bytes > SPI_BATCH_BYTES) {
+        return RP_EOOR;
+    }
+    ECHECK(spiOpen());
+    ECHECK(spiApply());
+
+    for (int i = 0; i < n; i++) {
+        memset(&msg[i], 0, sizeof(msg[i]));
+        msg[i].tx_buf = (uintptr_t)xfers[i].tx;
+        msg[i].rx_buf = (uintptr_t)xfers[i].rx;
+        msg[i].len = xfers[i].len;
+        msg[i].delay_usecs = xfers[i].delay_us;
+        msg[i].cs_change = xfers[i].cs_change;
+    }
+    if (ioctl(spi_fd, SPI_IOC_MESSAGE(n), msg) < 0) {
+        return RP_EFWB;
+    }
+    return RP_OK;
+}
+
+int spi_Release()
+{
+    if (spi_fd >= 0 && close(spi_fd) < 0) {
+        spi_fd = -1;
+        return RP_EFCB;
+    }
+    spi_fd = -1;
+    return RP_OK;
+}
@@ -0,0 +1,34 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library SPI module interface
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef __SPI_H
+#define __SPI_H
+
+#include <stdint.h>
+
+#include "redpitaya/rp.h"
+
+#define SPI_DEVICE          "/dev/spidev1.0"
+/* Most segments and bytes of a transfer, the spidev default buffer size */
+#define SPI_BATCH           128
+#define SPI_BATCH_BYTES     4096
+
+int spi_SetDevice(const char *path);
+int spi_SetMode(rp_spi_mode_t mode);
+int spi_SetSpeed(uint32_t speed);
+int spi_SetWordLen(uint8_t bits);
+int spi_Transfer(rp_spi_xfer_t *xfers, int n);
+int spi_Release();
+
+#endif //__SPI_H
@@ -0,0 +1,198 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library call statistics module implementation
+ *
+ * Every thread records into its own slot, so recording never contends on a
+ * lock or a shared cache line; slots are only summed up when statistics are
+ * read. Latencies go into log2 buckets split into four linear sub-buckets
+ * (HDR histogram style), which keeps the relative error below 25 %.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "common.h"
+#include "stats.h"
+
+#define SUB_BUCKET_BITS     2
+#define SUB_BUCKETS         (1 << SUB_BUCKET_BITS)
+
+#ifdef RP_STATS
+
+#define STATS_NAME(id, name) name,
+static const char *stats_names[] = {
+    STATS_LIST(STATS_NAME)
+};
+#undef STATS_NAME
+
+typedef struct {
+    uint64_t calls;
+    uint64_t total_ns;
+    uint64_t max_ns;
+    uint64_t mmio;
+    uint32_t buckets[RP_STATS_BUCKETS];
+} stats_entry_t;
+
+static stats_entry_t slots[STATS_THREADS][STAT_COUNT];
+static uint32_t slots_used = 0;
+static __thread stats_entry_t *thread_slot = NULL;
+
+static uint32_t bucketIndex(uint64_t ns)
+{
+    if (ns < SUB_BUCKETS) {
+        return ns;
+    }
+    uint32_t msb = 63 - __builtin_clzll(ns);
+    uint32_t index = (msb - SUB_BUCKET_BITS + 1) * SUB_BUCKETS
+                   + ((ns >> (msb - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1));
+    return MIN(index, RP_STATS_BUCKETS - 1);
+}
+
+uint64_t stats_Now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void stats_Record(stats_id_t id, uint64_t ns, uint64_t mmio)
+{
+    if (thread_slot == NULL) {
+        uint32_t slot = __atomic_fetch_add(&slots_used, 1, __ATOMIC_RELAXED);
+        thread_slot = slots[MIN(slot, STATS_THREADS - 1)];
+    }
+
+    // Relaxed atomics, the last slot may be shared by several threads
+    stats_entry_t *entry = &thread_slot[id];
+    __atomic_fetch_add(&entry->calls, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&entry->total_ns, ns, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&entry->mmio, mmio, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&entry->buckets[bucketIndex(ns)], 1, __ATOMIC_RELAXED);
+    if (ns > __atomic_load_n(&entry->max_ns, __ATOMIC_RELAXED)) {
+        __atomic_store_n(&entry->max_ns, ns, __ATOMIC_RELAXED);
+    }
+}
+
+static void aggregate(stats_id_t id, rp_stats_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    out->name = stats_names[id];
+
+    for (int slot = 0; slot < STATS_THREADS; slot++) {
+        stats_entry_t *entry = &slots[slot][id];
+        out->calls += __atomic_load_n(&entry->calls, __ATOMIC_RELAXED);
+        out->total_ns += __atomic_load_n(&entry->total_ns, __ATOMIC_RELAXED);
+        out->mmio += __atomic_load_n(&entry->mmio, __ATOMIC_RELAXED);
+        out->max_ns = MAX(out->max_ns, __atomic_load_n(&entry->max_ns, __ATOMIC_RELAXED));
+        for (int i = 0; i < RP_STATS_BUCKETS; i++) {
+            out->buckets[i] += __atomic_load_n(&entry->buckets[i], __ATOMIC_RELAXED);
+        }
+    }
+}
+
+/**
+ * Lower bound of the bucket holding the given fraction of calls.
+ */
+static uint64_t percentile(const rp_stats_t *stats, double fraction)
+{
+    uint64_t rank = (uint64_t)(stats->calls * fraction);
+    uint64_t seen = 0;
+
+    for (int i = 0; i < RP_STATS_BUCKETS; i++) {
+        seen += stats->buckets[i];
+        if (seen > rank) {
+            return stats_BucketNs(i);
+        }
+    }
+    return stats->max_ns;
+}
+
+int stats_Get(rp_stats_t *stats, uint32_t *count)
+{
+    if (stats == NULL || *count < STAT_COUNT) {
+        *count = STAT_COUNT;
+        return stats == NULL ? RP_OK : RP_BTS;
+    }
+
+    for (int id = 0; id < STAT_COUNT; id++) {
+        aggregate(id, &stats[id]);
+    }
+    *count = STAT_COUNT;
+    return RP_OK;
+}
+
+int stats_Reset()
+{
+    // Concurrent calls may survive the reset, counters are not a transaction
+    memset(slots, 0, sizeof(slots));
+    return RP_OK;
+}
+
+int stats_Json(char *buffer, size_t size)
+{
+    rp_stats_t stats;
+    size_t len = 0;
+    bool first = true;
+
+    len += snprintf(buffer, size, "{");
+    for (int id = 0; id < STAT_COUNT && len < size; id++) {
+        aggregate(id, &stats);
+        if (stats.calls == 0) {
+            continue;
+        }
+        len += snprintf(buffer + len, size - len,
+                        "%s\"%s\":{\"calls\":%llu,\"mean_ns\":%llu,\"p50_ns\":%llu,"
+                        "\"p90_ns\":%llu,\"p99_ns\":%llu,\"max_ns\":%llu,\"mmio\":%.1f}",
+                        first ? "" : ",", stats.name,
+                        (unsigned long long)stats.calls,
+                        (unsigned long long)(stats.total_ns / stats.calls),
+                        (unsigned long long)percentile(&stats, 0.5),
+                        (unsigned long long)percentile(&stats, 0.9),
+                        (unsigned long long)percentile(&stats, 0.99),
+                        (unsigned long long)stats.max_ns,
+                        (double)stats.mmio / stats.calls);
+        first = false;
+    }
+    if (len < size) {
+        len += snprintf(buffer + len, size - len, "}");
+    }
+    return len < size ? RP_OK : RP_BTS;
+}
+
+#else
+
+int stats_Get(rp_stats_t *stats, uint32_t *count)
+{
+    return RP_EUF;
+}
+
+int stats_Reset()
+{
+    return RP_EUF;
+}
+
+int stats_Json(char *buffer, size_t size)
+{
+    return RP_EUF;
+}
+
+#endif
+
+uint64_t stats_BucketNs(uint32_t index)
+{
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+    uint32_t msb = index / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+    return (uint64_t)(SUB_BUCKETS + index % SUB_BUCKETS) << (msb - SUB_BUCKET_BITS);
+}
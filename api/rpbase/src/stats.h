@@ -0,0 +1,98 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library call statistics module interface
+ *
+ * Call counters and latency histograms, compiled in only when the library
+ * is built with RP_STATS (make ENABLE_STATS=true). Without it the STATS_*
+ * macros expand to the plain call and nothing is recorded.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef __STATS_H
+#define __STATS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "redpitaya/rp.h"
+#include "common.h"
+
+/* Number of per thread slots, threads beyond that share the last one */
+#define STATS_THREADS   4
+
+/* Instrumented calls, in the order they are reported */
+#define STATS_LIST(X) \
+    X(STAT_INIT,                    "rp_Init") \
+    X(STAT_RESET,                   "rp_Reset") \
+    X(STAT_ACQ_START,               "rp_AcqStart") \
+    X(STAT_ACQ_STOP,                "rp_AcqStop") \
+    X(STAT_ACQ_RESET,               "rp_AcqReset") \
+    X(STAT_ACQ_SET_DECIMATION,      "rp_AcqSetDecimation") \
+    X(STAT_ACQ_SET_TRIGGER_SRC,     "rp_AcqSetTriggerSrc") \
+    X(STAT_ACQ_GET_TRIGGER_STATE,   "rp_AcqGetTriggerState") \
+    X(STAT_ACQ_GET_WRITE_POINTER,   "rp_AcqGetWritePointer") \
+    X(STAT_ACQ_GET_DATA_POS_RAW,    "rp_AcqGetDataPosRaw") \
+    X(STAT_ACQ_GET_DATA_POS_V,      "rp_AcqGetDataPosV") \
+    X(STAT_ACQ_GET_DATA_RAW,        "rp_AcqGetDataRaw") \
+    X(STAT_ACQ_GET_DATA_RAW_V2,     "rp_AcqGetDataRawV2") \
+    X(STAT_ACQ_GET_OLDEST_DATA_RAW, "rp_AcqGetOldestDataRaw") \
+    X(STAT_ACQ_GET_LATEST_DATA_RAW, "rp_AcqGetLatestDataRaw") \
+    X(STAT_ACQ_GET_DATA_V,          "rp_AcqGetDataV") \
+    X(STAT_ACQ_GET_DATA_V2,         "rp_AcqGetDataV2") \
+    X(STAT_ACQ_GET_OLDEST_DATA_V,   "rp_AcqGetOldestDataV") \
+    X(STAT_ACQ_GET_LATEST_DATA_V,   "rp_AcqGetLatestDataV") \
+    X(STAT_ACQ_TRIGGER_WAIT,        "trigger_wait") \
+    X(STAT_GEN_RESET,               "rp_GenReset") \
+    X(STAT_GEN_AMP,                 "rp_GenAmp") \
+    X(STAT_GEN_OFFSET,              "rp_GenOffset") \
+    X(STAT_GEN_FREQ,                "rp_GenFreq") \
+    X(STAT_GEN_PHASE,               "rp_GenPhase") \
+    X(STAT_GEN_WAVEFORM,            "rp_GenWaveform") \
+    X(STAT_GEN_ARB_WAVEFORM,        "rp_GenArbWaveform") \
+    X(STAT_GEN_DUTY_CYCLE,          "rp_GenDutyCycle") \
+    X(STAT_GEN_TRIGGER,             "rp_GenTrigger") \
+    X(STAT_GEN_SYNTHESIZE,          "synthesize_signal")
+
+#define STATS_ENUM(id, name) id,
+typedef enum {
+    STATS_LIST(STATS_ENUM)
+    STAT_COUNT
+} stats_id_t;
+#undef STATS_ENUM
+
+#ifdef RP_STATS
+
+uint64_t stats_Now();
+void stats_Record(stats_id_t id, uint64_t ns, uint64_t mmio);
+
+/* Times an int returning call, counts its register accesses and returns its result */
+#define STATS_CALL(id, call) { \
+        uint64_t stats_mmio = cmn_mmio; \
+        uint64_t stats_start = stats_Now(); \
+        int stats_retval = (call); \
+        stats_Record((id), stats_Now() - stats_start, cmn_mmio - stats_mmio); \
+        return stats_retval; \
+}
+
+#else
+
+#define STATS_CALL(id, call) { \
+        return (call); \
+}
+
+#endif
+
+int stats_Get(rp_stats_t *stats, uint32_t *count);
+int stats_Reset();
+int stats_Json(char *buffer, size_t size);
+uint64_t stats_BucketNs(uint32_t index);
+
+#endif /* __STATS_H */
@@ -0,0 +1,386 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library UART module implementation
+ *
+ * A reader thread waits in poll() for the port, splits what it reads into
+ * frames and appends each one, with the CLOCK_MONOTONIC time of the read
+ * that completed it, to a ring. The ring has one producer and one
+ * consumer, the positions are exchanged with acquire and release atomics
+ * and no lock is taken on either side.
+ *
+ * Each frame is a header and the data in one contiguous piece, so the
+ * consumer reads it in place. A frame that does not fit before the end of
+ * the ring is preceded by a wrap marker and starts at the beginning.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <errno.h>
+#include <time.h>
+#include <termios.h>
+#include <pthread.h>
+
+#include "common.h"
+#include "uart.h"
+
+#define WRAP_MARKER         0xFFFFFFFF
+#define ALIGN_UP(x)         (((x) + UART_ALIGN - 1) & ~(UART_ALIGN - 1))
+
+typedef struct {
+    uint32_t len;
+    uint16_t flags;
+    uint16_t reserved;
+    uint32_t dropped;
+    uint32_t reserved2;
+    uint64_t time_ns;
+} frame_hdr_t;
+
+/* Frame being assembled by the reader */
+typedef struct {
+    uint8_t *data;
+    uint32_t len;
+    uint16_t flags;
+    uint32_t expect;        // length from the prefix
+    uint32_t prefix;        // prefix bytes received
+} pending_t;
+
+static rp_uart_cfg_t config;
+static int uart_fd = -1;
+
+static uint8_t *ring = NULL;
+static uint32_t ring_size;
+// Free running byte counts, written by one side each
+static uint32_t head, tail;
+static uint32_t dropped = 0;
+static uint32_t peeked = 0;
+
+static pending_t pending;
+static pthread_t reader;
+static volatile bool running = false;
+static volatile int reader_error = RP_OK;
+
+static uint64_t nowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int baudConst(uint32_t baud, speed_t *speed)
+{
+    static const struct { uint32_t baud; speed_t speed; } rates[] = {
+        { 1200, B1200 }, { 2400, B2400 }, { 4800, B4800 }, { 9600, B9600 },
+        { 19200, B19200 }, { 38400, B38400 }, { 57600, B57600 },
+        { 115200, B115200 }, { 230400, B230400 }, { 460800, B460800 },
+        { 921600, B921600 }, { 1000000, B1000000 }, { 2000000, B2000000 },
+        { 3000000, B3000000 }, { 4000000, B4000000 }
+    };
+    for (int i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) {
+        if (rates[i].baud == baud) {
+            *speed = rates[i].speed;
+            return RP_OK;
+        }
+    }
+    return RP_EOOR;
+}
+
+static int setTermios(int fd, const rp_uart_cfg_t *cfg)
+{
+    static const tcflag_t sizes[] = { CS5, CS6, CS7, CS8 };
+    struct termios tio;
+    speed_t speed;
+
+    ECHECK(baudConst(cfg->baud, &speed));
+    if (tcgetattr(fd, &tio) < 0) {
+        return RP_EABA;
+    }
+    cfmakeraw(&tio);
+    cfsetspeed(&tio, speed);
+    tio.c_cflag &= ~(CSIZE | CSTOPB | PARENB | PARODD);
+    tio.c_cflag |= sizes[cfg->data_bits - 5] | CLOCAL | CREAD;
+    if (cfg->stop_bits == 2) {
+        tio.c_cflag |= CSTOPB;
+    }
+    if (cfg->parity != RP_DECODE_PARITY_NONE) {
+        tio.c_cflag |= PARENB;
+    }
+    if (cfg->parity == RP_DECODE_PARITY_ODD) {
+        tio.c_cflag |= PARODD;
+    }
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 0;
+    if (tcsetattr(fd, TCSANOW, &tio) < 0) {
+        return RP_EABA;
+    }
+    tcflush(fd, TCIOFLUSH);
+    return RP_OK;
+}
+
+/* Appends a frame, or counts it as dropped when the ring is full */
+static void push(const uint8_t *data, uint32_t len, uint16_t flags, uint64_t time_ns)
+{
+    uint32_t need = ALIGN_UP(sizeof(frame_hdr_t) + len);
+    uint32_t pos = head % ring_size;
+    uint32_t skip = pos + need > ring_size ? ring_size - pos : 0;
+    uint32_t used = head - __atomic_load_n(&tail, __ATOMIC_ACQUIRE);
+
+    if (used + skip + need > ring_size) {
+        dropped++;
+        return;
+    }
+    if (skip) {
+        ((frame_hdr_t *)(ring + pos))->len = WRAP_MARKER;
+        pos = 0;
+    }
+
+    frame_hdr_t *hdr = (frame_hdr_t *)(ring + pos);
+    hdr->len = len;
+    hdr->flags = flags;
+    hdr->dropped = dropped;
+    hdr->time_ns = time_ns;
+    memcpy(hdr + 1, data, len);
+    dropped = 0;
+    __atomic_store_n(&head, head + skip + need, __ATOMIC_RELEASE);
+}
+
+static void pushPending(uint64_t time_ns)
+{
+    push(pending.data, pending.len, pending.flags, time_ns);
+    pending.len = 0;
+    pending.flags = 0;
+    pending.expect = 0;
+    pending.prefix = 0;
+}
+
+/* Splits the received bytes into frames */
+static void feed(const uint8_t *data, uint32_t len, uint64_t time_ns)
+{
+    uint32_t prefix = config.framing == RP_UART_FRAME_LEN8 ? 1 : 2;
+
+    if (config.framing == RP_UART_FRAME_NONE) {
+        push(data, len, 0, time_ns);
+        return;
+    }
+
+    for (uint32_t i = 0; i < len; i++) {
+        uint8_t b = data[i];
+
+        if (config.framing == RP_UART_FRAME_DELIM) {
+            pending.data[pending.len++] = b;
+            if (b == config.delimiter) {
+                pushPending(time_ns);
+            } else if (pending.len == config.max_frame) {
+                pending.flags |= RP_UART_F_TRUNCATED;
+                pushPending(time_ns);
+            }
+            continue;
+        }
+
+        // Length prefix, most significant byte first
+        if (pending.prefix < prefix) {
+            pending.expect = (pending.expect << 8) | b;
+            if (++pending.prefix == prefix && pending.expect == 0) {
+                pushPending(time_ns);
+            }
+            continue;
+        }
+        if (pending.len < config.max_frame) {
+            pending.data[pending.len] = b;
+        } else {
+            pending.flags |= RP_UART_F_TRUNCATED;
+        }
+        if (++pending.len == pending.expect) {
+            pending.len = MIN(pending.len, config.max_frame);
+            pushPending(time_ns);
+        }
+    }
+}
+
+static void* readerThread(void *arg)
+{
+    uint8_t *chunk = malloc(config.max_frame);
+    struct pollfd pfd = { uart_fd, POLLIN, 0 };
+
+    if (chunk == NULL) {
+        reader_error = RP_EOOR;
+        return NULL;
+    }
+    while (running) {
+        int ret = poll(&pfd, 1, UART_POLL_MS);
+        if (ret < 0 && errno != EINTR) {
+            reader_error = RP_EFRB;
+            break;
+        }
+        if (ret <= 0) {
+            continue;
+        }
+        ssize_t n = read(uart_fd, chunk, config.max_frame);
+        if (n < 0 && (errno == EAGAIN || errno == EINTR)) {
+            continue;
+        }
+        if (n <= 0) {
+            // Closed by the other side
+            reader_error = RP_EFRB;
+            break;
+        }
+        feed(chunk, n, nowNs());
+    }
+    free(chunk);
+    return NULL;
+}
+
+int uart_Open(const char *path, const rp_uart_cfg_t *cfg)
+{
+    if (cfg == NULL) {
+        return RP_UIA;
+    }
+    if (uart_fd >= 0) {
+        return RP_EOOR;
+    }
+
+    config = *cfg;
+    config.data_bits = config.data_bits ? config.data_bits : 8;
+    config.stop_bits = config.stop_bits ? config.stop_bits : 1;
+    config.max_frame = config.max_frame ? config.max_frame : UART_MAX_FRAME;
+    // A power of two, so that the free running counts wrap with the ring
+    ring_size = UART_ALIGN;
+    while (ring_size < config.ring_size && ring_size < 0x40000000) {
+        ring_size <<= 1;
+    }
+    if (config.ring_size == 0) {
+        ring_size = UART_RING_SIZE;
+    }
+    if (config.data_bits < 5 || config.data_bits > 8 || config.stop_bits > 2
+        || config.framing > RP_UART_FRAME_LEN16
+        || ALIGN_UP(sizeof(frame_hdr_t) + config.max_frame) > ring_size / 2) {
+        return RP_EOOR;
+    }
+
+    uart_fd = open(path ? path : UART_DEVICE, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (uart_fd < 0) {
+        return RP_EFOB;
+    }
+    int ret = setTermios(uart_fd, &config);
+    if (ret == RP_OK) {
+        ring = malloc(ring_size);
+        pending.data = malloc(config.max_frame);
+        ret = ring && pending.data ? RP_OK : RP_EOOR;
+    }
+    if (ret == RP_OK) {
+        head = tail = dropped = peeked = 0;
+        pending.len = pending.flags = pending.expect = pending.prefix = 0;
+        reader_error = RP_OK;
+        running = true;
+        if (pthread_create(&reader, NULL, readerThread, NULL) != 0) {
+            running = false;
+            ret = RP_EOOR;
+        }
+    }
+    if (ret != RP_OK) {
+        close(uart_fd);
+        uart_fd = -1;
+        free(ring);
+        free(pending.data);
+        ring = pending.data = NULL;
+    }
+    return ret;
+}
+
+int uart_Close()
+{
+    if (uart_fd < 0) {
+        return RP_OK;
+    }
+    running = false;
+    pthread_join(reader, NULL);
+
+    int ret = close(uart_fd) < 0 ? RP_EFCB : RP_OK;
+    uart_fd = -1;
+    free(ring);
+    free(pending.data);
+    ring = pending.data = NULL;
+    return ret;
+}
+
+int uart_Write(const uint8_t *data, uint32_t len)
+{
+    struct pollfd pfd = { uart_fd, POLLOUT, 0 };
+
+    if (uart_fd < 0) {
+        return RP_EFOB;
+    }
+    if (data == NULL && len > 0) {
+        return RP_UIA;
+    }
+    while (len > 0) {
+        ssize_t n = write(uart_fd, data, len);
+        if (n < 0 && errno == EAGAIN) {
+            if (poll(&pfd, 1, -1) < 0 && errno != EINTR) {
+                return RP_EFWB;
+            }
+            continue;
+        }
+        if (n < 0 && errno != EINTR) {
+            return RP_EFWB;
+        }
+        if (n > 0) {
+            data += n;
+            len -= n;
+        }
+    }
+    return RP_OK;
+}
+
+/* The frame stays in the ring until uart_Consume() */
+int uart_Peek(rp_uart_frame_t *frame, bool *ready)
+{
+    if (frame == NULL || ready == NULL) {
+        return RP_UIA;
+    }
+    if (ring == NULL) {
+        return RP_EFOB;
+    }
+
+    *ready = false;
+    while (tail != __atomic_load_n(&head, __ATOMIC_ACQUIRE)) {
+        uint32_t pos = tail % ring_size;
+        const frame_hdr_t *hdr = (const frame_hdr_t *)(ring + pos);
+
+        if (hdr->len == WRAP_MARKER) {
+            __atomic_store_n(&tail, tail + ring_size - pos, __ATOMIC_RELEASE);
+            continue;
+        }
+        frame->data = (const uint8_t *)(hdr + 1);
+        frame->len = hdr->len;
+        frame->flags = hdr->flags;
+        frame->dropped = hdr->dropped;
+        frame->time_ns = hdr->time_ns;
+        peeked = ALIGN_UP(sizeof(frame_hdr_t) + hdr->len);
+        *ready = true;
+        return RP_OK;
+    }
+    // Everything received has been consumed, report why the reader stopped
+    return reader_error;
+}
+
+int uart_Consume()
+{
+    if (peeked == 0) {
+        return RP_EOOR;
+    }
+    __atomic_store_n(&tail, tail + peeked, __ATOMIC_RELEASE);
+    peeked = 0;
+    return RP_OK;
+}
@@ -0,0 +1,37 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library UART module interface
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef __UART_H
+#define __UART_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "redpitaya/rp.h"
+
+#define UART_DEVICE         "/dev/ttyPS1"
+#define UART_RING_SIZE      65536
+#define UART_MAX_FRAME      4096
+/* Longest time the reader waits before it checks whether to stop [ms] */
+#define UART_POLL_MS        100
+/* Frames start on this boundary, a frame header always fits before the end */
+#define UART_ALIGN          16
+
+int uart_Open(const char *path, const rp_uart_cfg_t *cfg);
+int uart_Close();
+int uart_Write(const uint8_t *data, uint32_t len);
+int uart_Peek(rp_uart_frame_t *frame, bool *ready);
+int uart_Consume();
+
+#endif //__UART_H
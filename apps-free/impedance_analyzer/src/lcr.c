@@ -0,0 +1,94 @@
+/** @file lcr.c
+ *
+ * @brief Red Pitaya impedance analyzer measurement.
+ *
+ * The impedance is measured in-process with the Red Pitaya API and the
+ * results are kept in memory, from where the worker plots them.
+ *
+ * @copyright Red Pitaya  http://www.redpitaya.com
+ */
+
+#include <stdio.h>
+
+#include "redpitaya/rp.h"
+
+#include "lcr.h"
+
+/* Generator output driving the device under test */
+#define LCR_GEN_CHANNEL RP_CH_1
+
+float lcr_data[LCR_QUANTITIES][LCR_MAX_STEPS];
+float lcr_freq[LCR_MAX_STEPS];
+
+/*----------------------------------------------------------------------------------*/
+int lcr_init(void)
+{
+    if(rp_Init() != RP_OK) {
+        fprintf(stderr, "Red Pitaya API init failed!\n");
+        return -1;
+    }
+    return 0;
+}
+
+
+/*----------------------------------------------------------------------------------*/
+int lcr_exit(void)
+{
+    rp_Release();
+    return 0;
+}
+
+
+/*----------------------------------------------------------------------------------*/
+int lcr_measure(int index, float frequency)
+{
+    rp_imp_cfg_t cfg;
+    rp_imp_result_t res;
+    double z_re, z_im;
+    int ret_val;
+
+    if(index < 0 || index >= LCR_MAX_STEPS)
+        return -1;
+
+    cfg.channel   = LCR_GEN_CHANNEL;
+    cfg.amplitude = rp_get_params_lcr(2);
+    cfg.averaging = rp_get_params_lcr(3);
+    cfg.dc_bias   = rp_get_params_lcr(4);
+    cfg.r_shunt   = rp_get_params_lcr(5);
+    cfg.periods   = 0;
+
+    ret_val = rp_ImpMeasure(&cfg, frequency, &z_re, &z_im);
+    if(ret_val != RP_OK) {
+        fprintf(stderr, "Impedance measurement at %.1f Hz failed: %s\n",
+                frequency, rp_GetError(ret_val));
+        return -1;
+    }
+
+    /* Rows in the order of the Y axis selection */
+    res.frequency = lcr_freq;
+    res.z_abs     = lcr_data[0];
+    res.z_phase   = lcr_data[1];
+    res.y_abs     = lcr_data[2];
+    res.y_phase   = lcr_data[3];
+    res.r_s       = lcr_data[4];
+    res.r_p       = lcr_data[5];
+    res.x_s       = lcr_data[6];
+    res.g_p       = lcr_data[7];
+    res.b_p       = lcr_data[8];
+    res.c_s       = lcr_data[9];
+    res.c_p       = lcr_data[10];
+    res.l_s       = lcr_data[11];
+    res.l_p       = lcr_data[12];
+    res.q         = lcr_data[13];
+    res.d         = lcr_data[14];
+
+    rp_ImpDerive(frequency, z_re, z_im, &res, index);
+    return 0;
+}
+
+
+/*----------------------------------------------------------------------------------*/
+int lcr_stop(void)
+{
+    return rp_GenOutDisable(LCR_GEN_CHANNEL) == RP_OK ? 0 : -1;
+}
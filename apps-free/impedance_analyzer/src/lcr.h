@@ -0,0 +1,32 @@
+/** @file lcr.h
+ *
+ * @brief Red Pitaya impedance analyzer measurement (C Header).
+ * @copyright Red Pitaya  http://www.redpitaya.com
+ */
+
+#ifndef __LCR_H
+#define __LCR_H
+
+#include "main.h"
+
+/* Number of Y axis quantities and longest sweep (lcr_steps maximum) */
+#define LCR_QUANTITIES 15
+#define LCR_MAX_STEPS  1000
+
+/* Results of the last sweep, one row per Y axis quantity in the order of
+ * the plot_y_scale_data selection, and the frequency of each point
+ */
+extern float lcr_data[LCR_QUANTITIES][LCR_MAX_STEPS];
+extern float lcr_freq[LCR_MAX_STEPS];
+
+int lcr_init(void);
+int lcr_exit(void);
+
+/* Measures the impedance at frequency with the current lcr parameters and
+ * stores all derived quantities at index of lcr_data and lcr_freq
+ */
+int lcr_measure(int index, float frequency);
+/* Turns off the generator after a sweep */
+int lcr_stop(void);
+
+#endif /* __LCR_H */
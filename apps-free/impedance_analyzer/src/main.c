@@ -22,6 +22,7 @@
 #include "fpga.h"
 #include "calib.h"
 #include "generate.h"
+#include "lcr.h"
 
 
 /* Describe app. parameters with some info/limitations */
@@ -302,6 +303,10 @@ int rp_app_init(void)
     fprintf(stderr, "Loading scope version %s-%s.\n", VERSION_STR, REVISION_STR);
 
 
+    if(lcr_init() < 0) {
+        return -1;
+    }
+
     rp_default_calib_params(&rp_main_calib_params);
     if(rp_read_calib_params(&rp_main_calib_params) < 0) {
         fprintf(stderr, "rp_read_calib_params() failed, using default"
@@ -345,6 +350,7 @@ int rp_app_exit(void)
 
     rp_osc_worker_exit();
     generate_exit();
+    lcr_exit();
 
     return 0;
 }
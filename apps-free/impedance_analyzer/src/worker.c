@@ -19,6 +19,7 @@
 
 #include "worker.h"
 #include "fpga.h"
+#include "lcr.h"
 
 pthread_t *rp_osc_thread_handler = NULL;
 void *rp_osc_worker_thread(void *args);
@@ -40,7 +41,6 @@ int                  *rp_fpga_cha_signal, *rp_fpga_chb_signal;
 
 /* Calibration parameters read from EEPROM */
 rp_calib_params_t *rp_calib_params = NULL;
-int counter = 0;
 int measure_counter = 0;
 int steps_counter = 0;
 int measure_method = 0;
@@ -283,17 +283,13 @@ void *rp_osc_worker_thread(void *args)
         /* Check if we want to save param data to a file */
         if(save_data == 1){
 
-            char f_command[100];
-
-            /* If the file doesn't exists yet */
-            if(fopen("/opt/redpitaya/www/apps/impedance_analyzer/lcr_param_data", "w") == NULL){
-                /* Create a normal file, as txt is a just an interpreter */
-                strcpy(f_command, "touch /opt/redpitaya/www/apps/impedance_analyzer/lcr_param_data");
-                system(f_command);
-            }
-
-            /* Open file for writing */
+            /* Open file for writing, it is created if it doesn't exist yet */
             FILE *data = fopen("/opt/redpitaya/www/apps/impedance_analyzer/lcr_param_data", "w");
+            if(data == NULL){
+                fprintf(stderr, "Saving parameters failed: %s\n", strerror(errno));
+                rp_set_params_lcr(2,0);
+                continue;
+            }
 
             /* Write parameter data */
             fprintf(data, "%.1f\n", rp_get_params_lcr(2));
@@ -321,159 +317,19 @@ void *rp_osc_worker_thread(void *args)
 
         /* Start lcr measurment */
         float measure_option = rp_get_params_lcr(0);
-        /* Set max command lenght */
-        char command[100];
         /* Frequency sweep */
         if(measure_option == 1){
-
-
-            float lcr_steps = rp_get_params_lcr(1);
-            float lcr_amp = rp_get_params_lcr(2);
-            float lcr_avg = rp_get_params_lcr(3);
-            float lcr_dc_bias = rp_get_params_lcr(4);
-            float lcr_r_shunt = rp_get_params_lcr(5);
-            float start_freq = rp_get_params_lcr(6);
-            float end_freq = rp_get_params_lcr(7);
-            float lcr_Scale = rp_get_params_lcr(8);
-            float lcr_load_re = rp_get_params_lcr(9);
-            float lcr_load_im = rp_get_params_lcr(10);
-            float lcr_calibration = rp_get_params_lcr(11);
-
-            char steps[10];
-            char sF[20];
-            char eF[20];
-            char amp[20];
-            char avg[20];
-            char dc_bias[20];
-            char r_shunt[20];
-            char scale[20];
-            char re[10];
-            char im[10];
-            char calib[1];
-
-            snprintf(steps, 10, "%f", lcr_steps);
-            printf("STEPS: %s\n", steps);
-            snprintf(sF, 20, "%f", start_freq);
-            snprintf(eF, 20, "%f", end_freq);
-            snprintf(amp, 20, "%f", lcr_amp);
-            snprintf(avg, 20, "%f", lcr_avg);
-            snprintf(dc_bias, 20, "%f", lcr_dc_bias);
-            snprintf(r_shunt, 20, "%f", lcr_r_shunt);
-            snprintf(scale, 20, "%f", lcr_Scale);
-            snprintf(re, 10, "%f", lcr_load_re);
-            snprintf(im, 10, "%f", lcr_load_im);
-            snprintf(calib, 1, "%f", lcr_calibration);
-            
-            strcpy(command, "/opt/redpitaya/www/apps/impedance_analyzer/lcr 1 ");
-            strcat(command, amp);
-            strcat(command, " ");
-
-            strcat(command, dc_bias);
-            strcat(command, " ");
-
-            strcat(command, r_shunt);
-            strcat(command, " ");
-
-            strcat(command, avg);
-
-            strcat(command, " 0 ");
-
-            strcat(command, re);
-            strcat(command, " ");
-            strcat(command, im);
-            strcat(command, " ");
-            strcat(command, steps);
-            strcat(command, " 1 ");
-
-            strcat(command, sF);
-            strcat(command, " ");
-            strcat(command, eF);
-            strcat(command, " ");
-            strcat(command, scale);
-            strcat(command, " 0");
-
-            system(command);
             measure_method = 2;
+            lcr_sweep(1);
             rp_set_params_lcr(0, 0);
 
-
         /* Measurment sweep */
         }else if(measure_option == 2){
-
-            float lcr_counts = rp_get_params_lcr(1);
-            float lcr_amp = rp_get_params_lcr(2);
-            float lcr_avg = rp_get_params_lcr(3);
-            float lcr_dc_bias = rp_get_params_lcr(4);
-            float lcr_r_shunt = rp_get_params_lcr(5);
-            float start_freq = rp_get_params_lcr(6);
-            float end_freq = rp_get_params_lcr(7);
-            float lcr_Scale = rp_get_params_lcr(8);
-            float lcr_load_re = rp_get_params_lcr(9);
-            float lcr_load_im = rp_get_params_lcr(10);
-            float lcr_calibration = rp_get_params_lcr(11);
-
-
-            char ms_counts[20];
-            char sF[20];
-            char eF[20];
-            char amp[20];
-            char avg[20];
-            char dc_bias[20];
-            char r_shunt[20];
-            char scale[20];
-            char re[10];
-            char im[10];
-            char calib[1];
-
-
-            snprintf(ms_counts, 20, "%f", lcr_counts);
-            snprintf(sF, 20, "%f", start_freq);
-            snprintf(eF, 20, "%f", end_freq);
-            snprintf(amp, 20, "%f", lcr_amp);
-            snprintf(avg, 20, "%f", lcr_avg);
-            snprintf(dc_bias, 20, "%f", lcr_dc_bias);
-            snprintf(r_shunt, 20, "%f", lcr_r_shunt);
-            snprintf(scale, 20, "%f", lcr_Scale);
-            snprintf(re, 10, "%f", lcr_load_re);
-            snprintf(im, 10, "%f", lcr_load_im);
-            snprintf(calib, 1, "%f", lcr_calibration);
-
-            char command[100];
-            
-            strcpy(command, "/opt/redpitaya/www/apps/impedance_analyzer/lcr 1 "); 
-            
-            strcat(command, amp);
-            strcat(command, " ");
-
-            strcat(command, dc_bias);
-            strcat(command, " ");
-
-            strcat(command, r_shunt);
-            strcat(command, " ");
-            
-            strcat(command, avg);
-            strcat(command, " 0 ");
-
-            strcat(command, re);
-            strcat(command, " ");
-            strcat(command, im);
-            strcat(command, " ");
-
-            strcat(command, ms_counts);
-            strcat(command, " 0 ");
-
-            strcat(command, sF);
-            strcat(command, " ");
-            strcat(command, " 1000 ");
-            strcat(command, scale);
-            strcat(command, " 0");
-            
-            system(command);
             measure_method = 1; // MS
+            lcr_sweep(0);
             rp_set_params_lcr(0, 0);
-            
         }
-        
+
         /* request to stop worker thread, we will shut down */
         if(state == rp_osc_quit_state) {
             rp_clean_params(curr_params);
@@ -781,6 +637,57 @@ int rp_osc_prepare_time_vector(float **out_signal, int dec_factor,
 }
 
 
+/*----------------------------------------------------------------------------------*/
+int lcr_sweep(int freq_sweep)
+{
+    rp_osc_worker_state_t state;
+    int steps = rp_get_params_lcr(1);
+    float start_freq = rp_get_params_lcr(6);
+    float end_freq = rp_get_params_lcr(7);
+    int log_scale = rp_get_params_lcr(8);
+    int i, ret_val = 0;
+
+    if(steps > LCR_MAX_STEPS)
+        steps = LCR_MAX_STEPS;
+    if(steps < 1)
+        steps = 1;
+
+    memset(lcr_data, 0, sizeof(lcr_data));
+    steps_counter = 0;
+    rp_set_params_lcr(1, 0);
+
+    for(i = 0; i < steps; i++) {
+        float f = start_freq;
+
+        if(freq_sweep && steps > 1) {
+            if(log_scale)
+                f = start_freq * pow(end_freq / start_freq, (float)i / (steps - 1));
+            else
+                f = start_freq + (end_freq - start_freq) * i / (steps - 1);
+        }
+
+        if((ret_val = lcr_measure(i, f)) < 0)
+            break;
+        steps_counter = i + 1;
+
+        /* Show every point as soon as it is measured */
+        lcr_start_Measure((float **)&rp_tmp_signals[1], &rp_fpga_cha_signal[0],
+                          (float **)&rp_tmp_signals[2], &rp_fpga_chb_signal[0],
+                          (float **)&rp_tmp_signals[0]);
+        rp_osc_set_signals(rp_tmp_signals, i);
+        rp_set_params_lcr(1, 100 * (i + 1) / steps);
+
+        rp_osc_worker_get_state(&state);
+        if(state == rp_osc_quit_state)
+            break;
+    }
+
+    lcr_stop();
+
+    return ret_val;
+}
+
+
 /*----------------------------------------------------------------------------------*/
 int lcr_start_Measure(float **cha_signal, int *in_cha_signal,
                     float **chb_signal, int *in_chb_signal,
@@ -789,222 +696,30 @@ int lcr_start_Measure(float **cha_signal, int *in_cha_signal,
     /* Output signal index */
     int out_idx;
 
-    /* Raw A and B channel signal */
     float *cha_s = *cha_signal;
     float *chb_s = *chb_signal;
 
     /* rp_tmp_signal[0] for X-coordinate set to frequency */
     float *t = *time_signal;
-    float *frequency = *time_signal;
 
-    /* If we are in first boot, start_measure will always be set to -1 
-     * rp_get_params_lcr(0):
-     * ret_val: -1 --> First boot 
-     *           0 --> No measurment
-     *           1 --> Frequency sweep
-     *           2 --> Measurment sweep  */
+    /* Selected quantity, see lcr_sweep() for the order */
+    int scale = rp_get_params_lcr(15);
+    if(scale < 0 || scale >= LCR_QUANTITIES)
+        scale = 0;
 
-    if(rp_get_params_lcr(0) == -1){
+    for(out_idx = 0; out_idx < steps_counter; out_idx++) {
+        cha_s[out_idx] = lcr_data[scale][out_idx];
+        chb_s[out_idx] = 0;
 
-
-        for(out_idx=0; out_idx < counter; out_idx++) {
-            cha_s[out_idx] = 0;
-            chb_s[out_idx] = 0;
+        /* Measurment sweep */
+        if(measure_method == 1){
             t[out_idx] = out_idx;
-        }
-    }else{
-
-
-        /* Opening files */
-        FILE *file_frequency = fopen("/tmp/lcr_data/data_frequency", "r");
-        FILE *file_phase = fopen("/tmp/lcr_data/data_phase", "r");
-        FILE *file_amplitude = fopen("/tmp/lcr_data/data_amplitude", "r");
-        FILE *file_Y_abs = fopen("/tmp/lcr_data/data_Y_abs", "r");
-        FILE *file_PhaseY = fopen("/tmp/lcr_data/data_phaseY", "r");
-        FILE *file_R_s = fopen("/tmp/lcr_data/data_R_s", "r");
-        FILE *file_X_s = fopen("/tmp/lcr_data/data_X_s", "r");
-        FILE *file_G_p = fopen("/tmp/lcr_data/data_G_p", "r");
-        FILE *file_B_p = fopen("/tmp/lcr_data/data_B_p", "r");
-        FILE *file_C_s = fopen("/tmp/lcr_data/data_C_s", "r");
-        FILE *file_C_p = fopen("/tmp/lcr_data/data_C_p", "r");
-        FILE *file_L_s = fopen("/tmp/lcr_data/data_L_s", "r");
-        FILE *file_L_p = fopen("/tmp/lcr_data/data_L_p", "r");
-        FILE *file_R_p = fopen("/tmp/lcr_data/data_R_p", "r");
-        FILE *file_Q = fopen("/tmp/lcr_data/data_Q", "r");
-        FILE *file_D = fopen("/tmp/lcr_data/data_D", "r");
-        
-
-        while(!feof(file_frequency)){
-            fscanf(file_frequency, "%f", &frequency[counter]);
-            counter++;
-        }
-
-        
-
-        /* Allocationg memory. TODO: Free up memory after use */
-        float *phase = malloc(counter * sizeof(float));
-        float *amplitude = malloc(counter * sizeof(float));
-        float *Y_abs = malloc(counter * sizeof(float));
-        float *R_s = malloc(counter * sizeof(float));
-        float *phaseY = malloc(counter * sizeof(float));
-        float *X_s = malloc(counter * sizeof(float));
-        float *G_p = malloc(counter * sizeof(float));
-        float *B_p = malloc(counter * sizeof(float));
-        float *C_s = malloc(counter * sizeof(float));
-        float *C_p = malloc(counter * sizeof(float));
-        float *L_s = malloc(counter * sizeof(float));
-        float *L_p = malloc(counter * sizeof(float));
-        float *R_p = malloc(counter * sizeof(float));
-        float *Q = malloc(counter * sizeof(float));
-        float *D = malloc(counter * sizeof(float));
-
-        /* Reading data from files into mem-allocated variables */
-        int B_p_counter = 0;
-        while(!feof(file_B_p)){
-            fscanf(file_B_p, "%f", &B_p[B_p_counter]);
-            B_p_counter++;
-        }
-
-        int C_s_counter = 0;
-        while(!feof(file_C_s)){
-            fscanf(file_C_s, "%f", &C_s[C_s_counter]);
-            C_s_counter++;
-        }
-
-        int C_p_counter = 0;
-        while(!feof(file_C_p)){
-            fscanf(file_C_p, "%f", &C_p[C_p_counter]);
-            C_p_counter++;
-        }
-
-        int L_s_counter = 0;
-        while(!feof(file_L_s)){
-            fscanf(file_L_s, "%f", &L_s[L_s_counter]);
-            L_s_counter++;
-        }
 
-        int L_p_counter = 0;
-        while(!feof(file_L_p)){
-            fscanf(file_L_p, "%f", &L_p[L_p_counter]);
-            L_p_counter++;
-        }
-
-        int R_p_counter = 0;
-        while(!feof(file_R_p)){
-            fscanf(file_R_p, "%f", &R_p[R_p_counter]);
-            R_p_counter++;
-        }
-
-        int q_counter = 0;
-        while(!feof(file_Q)){
-            fscanf(file_Q, "%f", &Q[q_counter]);
-            q_counter++;
-        }
-
-        int d_counter = 0;
-        while(!feof(file_D)){
-            fscanf(file_D, "%f", &D[d_counter]);
-            d_counter++;
-        }
-        
-        int p_counter = 0;
-        while(!feof(file_phase)){
-            fscanf(file_phase, "%f", &phase[p_counter]);
-            p_counter++;
-        }
-
-        int a_counter = 0;
-        while(!feof(file_amplitude)){
-            fscanf(file_amplitude, "%f", &amplitude[a_counter]);
-            a_counter++;
-        }
-        
-        int y_abs_counter = 0;
-        while(!feof(file_Y_abs)){
-            fscanf(file_Y_abs, "%f", &Y_abs[y_abs_counter]);
-            y_abs_counter++;
-        }
-
-        
-        int phaseY_counter = 0;
-        while(!feof(file_PhaseY)){
-            fscanf(file_PhaseY, "%f", &phaseY[phaseY_counter]);
-            phaseY_counter++;
-        }
-        
-        int R_s_counter = 0;
-        while(!feof(file_R_s)){
-            fscanf(file_R_s, "%f", &R_s[R_s_counter]);
-            R_s_counter++;
-        }
-        
-        int X_s_counter = 0;
-        while(!feof(file_X_s)){
-            fscanf(file_X_s, "%f", &X_s[X_s_counter]);
-            X_s_counter++;
-        }
-
-        int G_p_counter = 0;
-        while(!feof(file_G_p)){
-            fscanf(file_G_p, "%f", &G_p[G_p_counter]);
-            G_p_counter++;
+        /* Frequency sweep */
+        }else if(measure_method == 2){
+            t[out_idx] = lcr_freq[out_idx];
         }
-        
-        /* Closing all the files */
-        fclose(file_frequency);
-        fclose(file_amplitude);
-        fclose(file_phase);
-        fclose(file_Y_abs);
-        fclose(file_PhaseY);
-        fclose(file_R_s);
-        fclose(file_X_s);
-        fclose(file_G_p);
-        fclose(file_B_p);
-        fclose(file_C_s);
-        fclose(file_C_p);
-        fclose(file_L_s);
-        fclose(file_L_p);
-        fclose(file_R_p);
-        fclose(file_Q);
-        fclose(file_D);
-        
-        for(out_idx=0; out_idx < counter; out_idx++) {
-
-            /* Data check: TODO add switch statment for a niftier code */
-
-            float scale = rp_get_params_lcr(15);
-            if      (scale ==  0) cha_s[out_idx] = amplitude[out_idx];
-            else if (scale ==  1) cha_s[out_idx] = phase[out_idx]; 
-            else if (scale ==  2) cha_s[out_idx] = Y_abs[out_idx];
-            else if (scale ==  3) cha_s[out_idx] = phaseY[out_idx];
-            else if (scale ==  4) cha_s[out_idx] = R_s[out_idx];
-            else if (scale ==  5) cha_s[out_idx] = R_p[out_idx];
-            else if (scale ==  6) cha_s[out_idx] = X_s[out_idx];
-            else if (scale ==  7) cha_s[out_idx] = G_p[out_idx];
-            else if (scale ==  8) cha_s[out_idx] = B_p[out_idx];
-            else if (scale ==  9) cha_s[out_idx] = C_s[out_idx];
-            else if (scale == 10) cha_s[out_idx] = C_p[out_idx];
-            else if (scale == 11) cha_s[out_idx] = L_s[out_idx];
-            else if (scale == 12) cha_s[out_idx] = L_p[out_idx];
-            else if (scale == 13) cha_s[out_idx] = Q[out_idx];
-            else if (scale == 14) cha_s[out_idx] = D[out_idx];
-   
-            chb_s[out_idx] = 0;
-
-            /* Measurment sweep */
-            if(measure_method == 1){
-                t[out_idx] = out_idx;
-        
-            /* Frequency sweep */
-            }else if(measure_method == 2){
-                t[out_idx] = frequency[out_idx];
-            }
-        }     
-        
     }
-    
-    steps_counter = out_idx;
-    counter = 0;
 
     return 0;
 }
@@ -1440,14 +1155,13 @@ int rp_load_data(float save_data){
     if(save_data == 2){
         float val = 0;
         
-        if(fopen("/opt/redpitaya/www/apps/impedance_analyzer/lcr_param_data", "r") == NULL){
+        /* Read data */
+        FILE *data = fopen("/opt/redpitaya/www/apps/impedance_analyzer/lcr_param_data", "r");
+        if(data == NULL){
             printf("Parameter data failure!\n");
             return -1;
         }
 
-        /* Read data */
-        FILE *data = fopen("/opt/redpitaya/www/apps/impedance_analyzer/lcr_param_data", "r");
-
         int counter = 4;
         while(!feof(data)){
             val = 0;
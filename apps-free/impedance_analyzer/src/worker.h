@@ -47,14 +47,16 @@ int rp_osc_set_signals(float **source, int index);
 int rp_osc_prepare_time_vector(float **out_signal, int dec_factor,
                                float t_start, float t_stop, int time_unit);
 
-/* 16k -> 2k decimation
- * out_signal - needs to be already allocated, 2k float samples
- * in_signal  - 16k signal 
- * dec_factor - set in FPGA
- * t_start    - user set start time
- * t_stop     - user set stop time
- * TODO: Remove time vector generation from these functions, it should
- * be created at the beginning
+/* Measures the impedance at every point of a frequency sweep (freq_sweep = 1)
+ * or repeatedly at the start frequency (freq_sweep = 0), publishing the 
+ * signals and the progress after each point
+ */
+int lcr_sweep(int freq_sweep);
+
+/* Fills the signals from the last sweep results
+ * cha_signal  - quantity selected for the Y axis
+ * chb_signal  - zeroes
+ * time_signal - frequency or point index
  */
 int lcr_start_Measure(float **cha_signal, int *in_cha_signal,
                     float **chb_signal, int *in_chb_signal,
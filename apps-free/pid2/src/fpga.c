@@ -409,6 +409,20 @@ int osc_fpga_set_trigger_delay(uint32_t trig_delay)
 }
 
 
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief Setup the decimation factor
+ *
+ * @param[in]  dec_factor Decimation factor, one of 1, 8, 64, 1k, 8k or 65k
+ * @retval 0 Success, never fails
+ */
+int osc_fpga_set_decimation(int dec_factor)
+{
+    g_osc_fpga_reg_mem->data_dec = dec_factor;
+    return 0;
+}
+
+
 /*----------------------------------------------------------------------------*/
 /**
  * @brief Determine the "Trigger mode" the system is running in
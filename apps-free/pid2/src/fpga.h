@@ -216,6 +216,7 @@ int   osc_fpga_reset(void);
 int   osc_fpga_arm_trigger(void);
 int   osc_fpga_set_trigger(uint32_t trig_source);
 int   osc_fpga_set_trigger_delay(uint32_t trig_delay);
+int   osc_fpga_set_decimation(int dec_factor);
 int   osc_fpga_triggered(void);
 int   osc_fpga_get_sig_ptr(int **cha_signal, int **chb_signal); //, int **cho_signal); //--------------------- Fenske
 int   osc_fpga_get_wr_ptr(int *wr_ptr_curr, int *wr_ptr_trig);
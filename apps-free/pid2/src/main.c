@@ -402,6 +402,44 @@ static rp_app_params_t rp_main_params[PARAMS_NUM+1] = {
 	{ /* load_settings - Load PID settings. */
 		"load_settings",  0, 1, 0, 0, 3 },
 
+    /********************************/
+    /* PID identification parameters from here on */
+    /********************************/
+
+    { /* tune_run - Start an open-loop identification run:
+       *    0 - none
+       *    1 - step on the PID output offset
+       *    2 - PRBS on the PID output offset */
+        "tune_run", 0, 0, 0, 0, 2 },
+    { /* tune_pid - Identified loop: 0 - PID11, 1 - PID12, 2 - PID21, 3 - PID22 */
+        "tune_pid", 0, 0, 0, 0, 3 },
+    { /* tune_amp - Excitation amplitude, normalized to the output range */
+        "tune_amp", 0.1, 0, 0, -1, +1 },
+    { /* tune_time - Capture length [s] */
+        "tune_time", 0.01, 0, 0, 1e-4, 8 },
+    { /* tune_tc - SIMC closed-loop time constant, in multiples of dead time */
+        "tune_tc", 1, 0, 0, 0.1, 10 },
+    { /* tune_state - 0 - idle, 1 - running, 2 - done, 3 - failed */
+        "tune_state", 0, 0, 1, 0, 3 },
+    { /* tune_model - 0 - none, 1 - FOPDT, 2 - SOPDT */
+        "tune_model", 0, 0, 1, 0, 2 },
+    { /* tune_gain - Identified static gain */
+        "tune_gain", 0, 0, 1, -1e6, +1e6 },
+    { /* tune_tau1 - Identified dominant time constant [ms] */
+        "tune_tau1", 0, 0, 1, 0, +1e6 },
+    { /* tune_tau2 - Identified second time constant [ms] */
+        "tune_tau2", 0, 0, 1, 0, +1e6 },
+    { /* tune_dead - Identified dead time [ms] */
+        "tune_dead", 0, 0, 1, 0, +1e6 },
+    { /* tune_kp - Suggested proportional gain */
+        "tune_kp", 0, 0, 1, -1e6, +1e6 },
+    { /* tune_ki - Suggested integral gain [1/ms] */
+        "tune_ki", 0, 0, 1, -1e6, +1e6 },
+    { /* tune_kd - Suggested derivative gain [ns] */
+        "tune_kd", 0, 0, 1, -1e9, +1e9 },
+    { /* tune_pv - Process variable, streamed while identifying */
+        "tune_pv", 0, 0, 1, -1, +1 },
+
     { /* Must be last! */
         NULL, 0.0, -1, -1, 0.0, 0.0 }     
 };
@@ -724,6 +762,7 @@ int rp_set_params(rp_app_params_t *p, int len)
     int params_change = 0;
     int awg_params_change = 0;
     int pid_params_change = 0;
+    int tune_params_change = 0;
     
     TRACE("%s()\n", __FUNCTION__);
 
@@ -764,8 +803,10 @@ int rp_set_params(rp_app_params_t *p, int len)
                 params_change = 1;
             if ( (p_idx >= PARAMS_AWG_PARAMS) && (p_idx < PARAMS_PID_PARAMS) )
                 awg_params_change = 1;
-            if(p_idx >= PARAMS_PID_PARAMS)
+            if ( (p_idx >= PARAMS_PID_PARAMS) && (p_idx < PARAMS_TUNE_PARAMS) )
                 pid_params_change = 1;
+            if(p_idx >= PARAMS_TUNE_PARAMS)
+                tune_params_change = 1;
             if(rp_main_params[p_idx].fpga_update)
                 fpga_update = 1;
         }
@@ -986,6 +1027,14 @@ int rp_set_params(rp_app_params_t *p, int len)
         }
     }
 
+    /* Identification run - the worker picks up the settings and restores
+     * its previous state when done */
+    if(tune_params_change && (rp_main_params[TUNE_RUN].value != 0)) {
+        rp_osc_worker_update_params((rp_app_params_t *)&rp_main_params[0], 0);
+        rp_main_params[TUNE_RUN].value = 0;
+        rp_osc_worker_change_state(rp_osc_tune_state);
+    }
+
     return 0;
 }
 
@@ -1254,6 +1303,23 @@ int rp_update_meas_data(rp_osc_meas_res_t ch1_meas, rp_osc_meas_res_t ch2_meas)
     return 0;
 }
 
+int rp_update_tune_data(rp_pid_tune_res_t *res)
+{
+    pthread_mutex_lock(&rp_main_params_mutex);
+    rp_main_params[TUNE_STATE].value = res->state;
+    rp_main_params[TUNE_MODEL].value = res->model;
+    rp_main_params[TUNE_GAIN].value = res->gain;
+    rp_main_params[TUNE_TAU1].value = res->tau1;
+    rp_main_params[TUNE_TAU2].value = res->tau2;
+    rp_main_params[TUNE_DEAD].value = res->dead;
+    rp_main_params[TUNE_KP].value = res->kp;
+    rp_main_params[TUNE_KI].value = res->ki;
+    rp_main_params[TUNE_KD].value = res->kd;
+    rp_main_params[TUNE_PV].value = res->pv;
+    pthread_mutex_unlock(&rp_main_params_mutex);
+    return 0;
+}
+
 /*----------------------------------------------------------------------------*/
 /**
  * @brief Converts counts to float
@@ -48,9 +48,23 @@ typedef struct rp_osc_meas_res_s {
     float min_intensity; // min_intensity value from XADC -------- Fenske
 } rp_osc_meas_res_t;
 
+/* PID identification results - filled in by pid_tune_run() in the worker */
+typedef struct rp_pid_tune_res_s {
+    int   state;     /* 0 - idle, 1 - running, 2 - done, 3 - failed */
+    int   model;     /* 0 - none, 1 - first order, 2 - second order */
+    float gain;      /* static plant gain, input counts per output count */
+    float tau1;      /* dominant time constant [ms] */
+    float tau2;      /* second time constant [ms] */
+    float dead;      /* dead time [ms] */
+    float kp;        /* suggested gains in PID panel units */
+    float ki;
+    float kd;
+    float pv;        /* process variable, streamed while running */
+} rp_pid_tune_res_t;
+
 /* Parameters indexes - these defines should be in the same order as 
  * rp_app_params_t structure defined in main.c */
-#define PARAMS_NUM        122 // changed by Fenske-------------------------------------------------------------------
+#define PARAMS_NUM        137 // changed by Fenske-------------------------------------------------------------------
 #define MIN_GUI_PARAM     0
 #define MAX_GUI_PARAM     1
 #define TRIG_MODE_PARAM   2
@@ -186,6 +200,23 @@ typedef struct rp_osc_meas_res_s {
 #define SAVE_SETTINGS	  120
 #define LOAD_SETTINGS	  121
 
+/* PID identification parameters */
+#define TUNE_RUN          122
+#define TUNE_PID          123
+#define TUNE_AMP          124
+#define TUNE_TIME         125
+#define TUNE_TC           126
+#define TUNE_STATE        127
+#define TUNE_MODEL        128
+#define TUNE_GAIN         129
+#define TUNE_TAU1         130
+#define TUNE_TAU2         131
+#define TUNE_DEAD         132
+#define TUNE_KP           133
+#define TUNE_KI           134
+#define TUNE_KD           135
+#define TUNE_PV           136
+
 /* Defines from which parameters on are AWG parameters (used in set_param() to
  * trigger update only on needed part - either Oscilloscope, AWG or PID */
 #define PARAMS_AWG_PARAMS 42
@@ -195,6 +226,10 @@ typedef struct rp_osc_meas_res_s {
 #define PARAMS_PID_PARAMS 57
 #define PARAMS_PER_PID    12 // changed by Fenske --------------------------------------
 
+/* Defines from which parameters on are PID identification parameters (these
+ * start a run in the worker instead of updating the PID registers) */
+#define PARAMS_TUNE_PARAMS 122
+
 /* Output signals */
 #define SIGNAL_LENGTH (1024) /* Must be 2^n! */
 #define SIGNALS_NUM   3 // must be changed to 4 if output is added -------- Fenske
@@ -231,6 +266,8 @@ void transform_from_iface_units(rp_app_params_t *p);
  * in the application 
  */
 int rp_update_meas_data(rp_osc_meas_res_t ch1_meas, rp_osc_meas_res_t ch2_meas);
+/* sets the PID identification results (or progress) to output parameters */
+int rp_update_tune_data(rp_pid_tune_res_t *res);
 // converts counts to float
 float cnv_cnt_to_float(int cnts, float max_int);
 
@@ -16,6 +16,7 @@
 #include <string.h>
 #include <errno.h>
 #include <sys/mman.h> // for mmap
+#include <sys/mount.h>
 #include <fcntl.h> // for opening files
 
 #include "redpitaya/rp.h"
@@ -23,6 +24,10 @@
 #include "pid.h"
 #include "fpga_pid.h"
 
+/* Settings files live on the SD card, which is mounted read-only */
+#define PID_SETTINGS_DIR   "/opt/redpitaya/www/apps/pid2"
+#define PID_SETTINGS_MOUNT "/opt/redpitaya"
+
 // Variables
 void* map_ams = (void*)(-1);
 
@@ -72,6 +77,33 @@ int old_setpoint[] = {0, 0, 0, 0}; // saves the old_setpoint value
  */
 
 
+/*----------------------------------------------------------------------------------*/
+/** @brief Open one of the PID settings files
+ *
+ * The SD card is remounted writable only when a settings file is first
+ * written, instead of on every application start.
+ *
+ * @param[in] slot  Settings slot, 1 to 3
+ * @param[in] mode  fopen() mode
+ * @retval    NULL  failure, error message is reported on standard error
+ */
+static FILE *pid_settings_open(int slot, const char *mode)
+{
+    char path[64];
+    FILE *f;
+
+    snprintf(path, sizeof(path), PID_SETTINGS_DIR "/settings%d.txt", slot);
+    f = fopen(path, mode);
+    if((f == NULL) && (errno == EROFS)) {
+        if(mount(NULL, PID_SETTINGS_MOUNT, NULL, MS_REMOUNT, NULL) == 0)
+            f = fopen(path, mode);
+    }
+    if(f == NULL)
+        fprintf(stderr, "fopen(%s) failed: %s\n", path, strerror(errno));
+    return f;
+}
+
+
 /*----------------------------------------------------------------------------------*/
 /** @brief Initialize PID Controller module
  *
@@ -88,12 +120,6 @@ int pid_init(void)
     if(fpga_pid_init() < 0) {
         return -1;
     }
-    system("cd /opt/redpitaya/www/apps/pid2\n rw"); // should make the folder "pid2" writeable ------ Fenske CHANGE for pid2!!!
-    /* 	The C library function int system(const char *command) passes the command name
-    	or program name specified by command to the host environment to be executed
-    	by the command processor and returns after the command has been completed. */
-    //  (necessary for saving the settings in a .txt-file)
-
     if (rp_Init() != RP_OK) { // Init API functions!!!
          fprintf(stderr, "Red Pitaya API init failed!\n");
          return EXIT_FAILURE;
@@ -199,40 +225,28 @@ int pid_update(rp_app_params_t *params)
     min_intens_threshold[1] = params[MIN_I_THRESHOLD_2].value; // --------------- Fenske
 
     // Save settings ---------------------------------------------------------------------------- Fenske
-    // (for creating files it is necessary to mount the folder on the SD-card writable! see pid_init() )
+    // (the SD-card is remounted writable on demand, see pid_settings_open() )
     if (params[SAVE_SETTINGS].value != 0)
     {
-    	switch((int) params[SAVE_SETTINGS].value)
-    	{
-    		case 1: fd = fopen("/opt/redpitaya/www/apps/pid2/settings1.txt", "w"); break;
-    		case 2: fd = fopen("/opt/redpitaya/www/apps/pid2/settings2.txt", "w"); break;
-    		case 3: fd = fopen("/opt/redpitaya/www/apps/pid2/settings3.txt", "w"); break;
-    		default: break;
-    	}
+    	fd = pid_settings_open((int) params[SAVE_SETTINGS].value, "w");
     	if(fd != NULL) {
     		for(idx = 0; idx < no_settings; idx++){
     			fprintf(fd, "%f\n", params[PARAMS_PID_PARAMS+idx].value);
     		}
+    		fclose(fd);
     	}
-    	fclose(fd);
     	params[SAVE_SETTINGS].value = 0;
     }
     // Load settings ---------------------------------------------------------------------------- Fenske
     if (params[LOAD_SETTINGS].value != 0)
     {
-        switch((int) params[LOAD_SETTINGS].value)
-        {
-        	case 1: fd = fopen("/opt/redpitaya/www/apps/pid2/settings1.txt", "r"); break;
-        	case 2: fd = fopen("/opt/redpitaya/www/apps/pid2/settings2.txt", "r"); break;
-        	case 3: fd = fopen("/opt/redpitaya/www/apps/pid2/settings3.txt", "r"); break;
-        	default: break;
-        }
+        fd = pid_settings_open((int) params[LOAD_SETTINGS].value, "r");
         if(fd != NULL) {
         	for(idx = 0; idx < no_settings; idx++){
         		fscanf(fd, "%f\n", &params[PARAMS_PID_PARAMS+idx].value);
         	}
+        	fclose(fd);
         }
-        fclose(fd);
         params[LOAD_SETTINGS].value = 0;
         pid_update(&params[0]); // load saved and loaded params into fpga
     }
@@ -0,0 +1,429 @@
+/**
+ * @brief Red Pitaya PID Controller open-loop identification
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "pid_tune.h"
+#include "worker.h"
+#include "fpga.h"
+#include "fpga_pid.h"
+
+/**
+ * GENERAL DESCRIPTION:
+ *
+ * An identification run opens the selected loop by holding both PIDs that
+ * drive its output in reset, and excites the plant through the output offset
+ * register with either a step or a PRBS. Every write to the offset register
+ * is timestamped with the acquisition write pointer, so the excitation is
+ * known sample-exactly in the captured input buffer.
+ *
+ * The capture is averaged down to PID_TUNE_FIT_LEN samples and first and
+ * second order ARX models are fitted for every dead time. The best one is
+ * converted into a first or second order plus dead time model, from which
+ * SIMC PID gains are suggested:
+ *
+ *   Kc = tau1 / (K * (tc + theta)),  Ti = min(tau1, 4 * (tc + theta)),
+ *   Td = tau2
+ *
+ * The suggestion is given in the PID panel units (Ki in 1/ms, Kd in ns) for
+ * a master gain of 1. The loop registers are restored when the run ends.
+ */
+
+/* Capture decimations, shortest first */
+static const int c_tune_dec[] = { 1, 8, 64, 1024, 8*1024, 64*1024 };
+
+/* Excitation event, timestamped with the acquisition write pointer */
+typedef struct tune_event_s {
+    int ptr;
+    int level;
+} tune_event_t;
+
+static tune_event_t tune_events[PID_TUNE_PRBS_BITS];
+static float tune_u[PID_TUNE_FIT_LEN];
+static float tune_y[PID_TUNE_FIT_LEN];
+static float tune_x[PID_TUNE_FIT_LEN];
+
+
+/* Sign extends an ADC sample */
+static int tune_adc(int cnts)
+{
+    if(cnts & (1<<(c_osc_fpga_adc_bits-1)))
+        return -1 * ((cnts ^ ((1<<c_osc_fpga_adc_bits)-1)) + 1);
+    return cnts & ((1<<c_osc_fpga_adc_bits)-1);
+}
+
+static int tune_clip(int cnts)
+{
+    if(cnts > PID_TUNE_OUT_CNT)
+        return PID_TUNE_OUT_CNT;
+    if(cnts < -PID_TUNE_OUT_CNT)
+        return -PID_TUNE_OUT_CNT;
+    return cnts;
+}
+
+static void tune_add_ns(struct timespec *t, long ns)
+{
+    t->tv_nsec += ns;
+    while(t->tv_nsec >= 1000000000) {
+        t->tv_nsec -= 1000000000;
+        t->tv_sec++;
+    }
+}
+
+static int tune_before(const struct timespec *a, const struct timespec *b)
+{
+    return (a->tv_sec < b->tv_sec) ||
+        ((a->tv_sec == b->tv_sec) && (a->tv_nsec < b->tv_nsec));
+}
+
+static int tune_aborted(void)
+{
+    rp_osc_worker_state_t state;
+    rp_osc_worker_get_state(&state);
+    return state != rp_osc_tune_state;
+}
+
+/* Publishes the latest input sample as process variable */
+static void tune_stream(rp_pid_tune_res_t *res, int *sig)
+{
+    int wr_ptr;
+    osc_fpga_get_wr_ptr(&wr_ptr, NULL);
+    res->pv = tune_adc(sig[wr_ptr % OSC_FPGA_SIG_LEN]) /
+        (float)(1<<(c_osc_fpga_adc_bits-1));
+    rp_update_tune_data(res);
+}
+
+/* Waits for the given time, streaming the process variable at a steady rate */
+static int tune_wait(float t, rp_pid_tune_res_t *res, int *sig)
+{
+    struct timespec now, next, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    end = next = now;
+    tune_add_ns(&end, (long)(t * 1e9));
+    while(tune_before(&now, &end)) {
+        if(tune_aborted())
+            return -1;
+        if(!tune_before(&now, &next)) {
+            tune_stream(res, sig);
+            tune_add_ns(&next, PID_TUNE_STREAM_NS);
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
+                        tune_before(&next, &end) ? &next : &end, NULL);
+        clock_gettime(CLOCK_MONOTONIC, &now);
+    }
+    return 0;
+}
+
+/* Solves a n x n (n <= 3) linear system in place, returns -1 if singular */
+static int tune_solve(double a[3][3], double *b, int n)
+{
+    int i, j, k, p;
+    double t;
+
+    for(i = 0; i < n; i++) {
+        p = i;
+        for(j = i + 1; j < n; j++)
+            if(fabs(a[j][i]) > fabs(a[p][i]))
+                p = j;
+        if(fabs(a[p][i]) < 1e-12)
+            return -1;
+        for(k = 0; k < n; k++) {
+            t = a[i][k]; a[i][k] = a[p][k]; a[p][k] = t;
+        }
+        t = b[i]; b[i] = b[p]; b[p] = t;
+        for(j = i + 1; j < n; j++) {
+            t = a[j][i] / a[i][i];
+            for(k = i; k < n; k++)
+                a[j][k] -= t * a[i][k];
+            b[j] -= t * b[i];
+        }
+    }
+    for(i = n - 1; i >= 0; i--) {
+        for(k = i + 1; k < n; k++)
+            b[i] -= a[i][k] * b[k];
+        b[i] /= a[i][i];
+    }
+    return 0;
+}
+
+/* Simulates the ARX model noise-free, returns -1 if it is unstable */
+static int tune_sim(int order, const double *theta, int d, int n)
+{
+    int k;
+    double a1 = theta[0], a2 = (order == 2) ? theta[1] : 0;
+
+    if((fabs(a2) >= 1) || (fabs(a1) >= 1 - a2))
+        return -1;
+    tune_x[0] = tune_x[1] = 0;
+    for(k = 2; k < n; k++)
+        tune_x[k] = a1 * tune_x[k-1] + a2 * tune_x[k-2] +
+            theta[order] * ((k - 1 - d >= 0) ? tune_u[k-1-d] : 0);
+    return 0;
+}
+
+/* Solves the normal equations of y[k] = a1 y[k-1] (+ a2 y[k-2]) + b u[k-1-d],
+ * with the instruments taken from the simulated output when iv is set */
+static int tune_lsq(int order, int d, int n, int iv, double *theta)
+{
+    double a[3][3] = {{ 0 }}, phi[3], z[3];
+    int k, i, j, np = order + 1;
+
+    memset(theta, 0, 3 * sizeof(double));
+    for(k = d + 2; k < n; k++) {
+        phi[0] = tune_y[k-1];
+        phi[1] = tune_y[k-2];
+        phi[np-1] = tune_u[k-1-d];
+        z[0] = iv ? tune_x[k-1] : phi[0];
+        z[1] = iv ? tune_x[k-2] : phi[1];
+        z[np-1] = phi[np-1];
+        for(i = 0; i < np; i++) {
+            for(j = 0; j < np; j++)
+                a[i][j] += z[i] * phi[j];
+            theta[i] += z[i] * tune_y[k];
+        }
+    }
+    return tune_solve(a, theta, np);
+}
+
+/**
+ * Fits y[k] = a1 y[k-1] (+ a2 y[k-2]) + b u[k-1-d] for every dead time d.
+ * Plain least squares is biased by measurement noise, so its model only
+ * provides instruments for a second, instrumental variable estimate. The dead
+ * time with the smallest simulation error wins.
+ */
+static int tune_fit(int order, int n, double *theta, int *delay, double *mse)
+{
+    double t[3], e;
+    int d, k, found = 0;
+
+    for(d = 0; d < n / 2; d++) {
+        if((tune_lsq(order, d, n, 0, t) < 0) || (tune_sim(order, t, d, n) < 0))
+            continue;
+        if((tune_lsq(order, d, n, 1, t) < 0) || (tune_sim(order, t, d, n) < 0))
+            continue;
+        for(k = 0, e = 0; k < n; k++)
+            e += (tune_y[k] - tune_x[k]) * (tune_y[k] - tune_x[k]);
+        e /= n;
+        if(!found || (e < *mse)) {
+            memcpy(theta, t, sizeof(t));
+            *delay = d;
+            *mse = e;
+            found = 1;
+        }
+    }
+    return found ? 0 : -1;
+}
+
+/* Converts the fitted models into FOPDT/SOPDT parameters */
+static int tune_model(float ts, rp_pid_tune_res_t *res)
+{
+    double t1[3], t2[3], mse1, mse2;
+    int d1, d2;
+    int ok1 = (tune_fit(1, PID_TUNE_FIT_LEN, t1, &d1, &mse1) == 0) &&
+        (t1[0] > 0) && (t1[0] < 1) && (t1[1] != 0);
+    int ok2 = (tune_fit(2, PID_TUNE_FIT_LEN, t2, &d2, &mse2) == 0);
+
+    if(ok2) {
+        double disc = t2[0] * t2[0] + 4 * t2[1];
+        double p1, p2;
+        if(disc < 0) {
+            ok2 = 0;
+        } else {
+            p1 = (t2[0] + sqrt(disc)) / 2;
+            p2 = (t2[0] - sqrt(disc)) / 2;
+            ok2 = (p1 > 0) && (p1 < 1) && (p2 > 0) && (p2 < 1) &&
+                (t2[2] != 0) && (!ok1 || (mse2 < PID_TUNE_SOPDT_GAIN * mse1));
+            if(ok2) {
+                res->model = 2;
+                res->gain = t2[2] / (1 - t2[0] - t2[1]);
+                res->tau1 = -ts / log(p1);
+                res->tau2 = -ts / log(p2);
+                res->dead = d2 * ts;
+            }
+        }
+    }
+    if(!ok2) {
+        if(!ok1)
+            return -1;
+        res->model = 1;
+        res->gain = t1[1] / (1 - t1[0]);
+        res->tau1 = -ts / log(t1[0]);
+        res->tau2 = 0;
+        res->dead = d1 * ts;
+    }
+    return 0;
+}
+
+
+/*----------------------------------------------------------------------------------*/
+/**
+ * @brief Runs an open-loop identification of the selected PID loop.
+ *
+ * Called from the worker thread, which owns the acquisition during the run.
+ * Progress, the streamed process variable and the results are published with
+ * rp_update_tune_data().
+ *
+ * @param[in] params      Worker copy of the application parameters
+ * @param[in] cha_signal  Channel A acquisition buffer
+ * @param[in] chb_signal  Channel B acquisition buffer
+ * @retval -1 failure or aborted, tune_state is set to failed
+ * @retval  0 success
+ */
+int pid_tune_run(rp_app_params_t *params, int *cha_signal, int *chb_signal)
+{
+    rp_pid_tune_res_t res;
+    int pid  = (int)params[TUNE_PID].value;
+    int prbs = (params[TUNE_RUN].value == 2);
+    int out  = pid / 2;
+    int *sig = (pid % 2) ? chb_signal : cha_signal;
+    uint32_t *out_offset = out ? &g_pid_reg->out_2_offset :
+                                 &g_pid_reg->out_1_offset;
+    int amp = round(params[TUNE_AMP].value * PID_TUNE_OUT_CNT);
+    int u0  = tune_clip(round(params[OUT_1_OFFSET + out].value *
+                              PID_TUNE_OUT_CNT));
+    int pre = OSC_FPGA_SIG_LEN * PID_TUNE_PRE;
+    int blk = OSC_FPGA_SIG_LEN / PID_TUNE_FIT_LEN;
+    uint32_t saved_conf, saved_offset;
+    uint8_t lfsr = 0x7f;
+    int dec = 1, i, j, k, n_ev = 0, wr_ptr, start, ev0, level, ret = -1;
+    float t_win, ts, y0, tc, kc, ti;
+    long t_bit;
+    struct timespec now, next_stream, next_bit, end;
+
+    memset(&res, 0, sizeof(res));
+    res.state = 1;
+    rp_update_tune_data(&res);
+
+    /* Shortest decimation with the whole capture in the buffer */
+    for(i = 0; i < sizeof(c_tune_dec) / sizeof(c_tune_dec[0]); i++) {
+        dec = c_tune_dec[i];
+        if(OSC_FPGA_SIG_LEN * c_osc_fpga_smpl_period * dec >=
+           params[TUNE_TIME].value)
+            break;
+    }
+    t_win = OSC_FPGA_SIG_LEN * c_osc_fpga_smpl_period * dec;
+    ts = t_win / PID_TUNE_FIT_LEN;
+    t_bit = t_win * (1 - PID_TUNE_PRE) * 0.9 / PID_TUNE_PRBS_BITS * 1e9;
+    if(t_bit < PID_TUNE_PRBS_MIN)
+        t_bit = PID_TUNE_PRBS_MIN;
+
+    /* Open the loop and let the plant settle at the operating point */
+    saved_conf = g_pid_reg->configuration;
+    saved_offset = *out_offset;
+    g_pid_reg->configuration = saved_conf | (3 << (2 * out));
+    *out_offset = u0;
+    if(tune_wait(t_win, &res, sig) < 0)
+        goto restore;
+
+    /* Capture pre-excitation history, then trigger immediately */
+    osc_fpga_reset();
+    osc_fpga_set_decimation(dec);
+    osc_fpga_set_trigger_delay(OSC_FPGA_SIG_LEN - 7 - pre);
+    osc_fpga_arm_trigger();
+    if(tune_wait(pre * c_osc_fpga_smpl_period * dec * 1.2, &res, sig) < 0)
+        goto restore;
+    osc_fpga_set_trigger(1);
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    next_stream = next_bit = end = now;
+    tune_add_ns(&end, (long)(2 * t_win * 1e9) + 1000000000);
+    while(!osc_fpga_triggered()) {
+        if(tune_aborted() || !tune_before(&now, &end))
+            goto restore;
+
+        if((n_ev < (prbs ? PID_TUNE_PRBS_BITS : 1)) &&
+           !tune_before(&now, &next_bit)) {
+            level = amp;
+            if(prbs) {
+                level = (lfsr & 1) ? amp : -amp;
+                lfsr = ((lfsr << 1) | (((lfsr >> 6) ^ (lfsr >> 5)) & 1)) & 0x7f;
+            }
+            *out_offset = tune_clip(u0 + level);
+            osc_fpga_get_wr_ptr(&tune_events[n_ev].ptr, NULL);
+            tune_events[n_ev++].level = tune_clip(u0 + level) - u0;
+            tune_add_ns(&next_bit, t_bit);
+        }
+        if(!tune_before(&now, &next_stream)) {
+            tune_stream(&res, sig);
+            tune_add_ns(&next_stream, PID_TUNE_STREAM_NS);
+        }
+
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
+                        (prbs && (n_ev < PID_TUNE_PRBS_BITS) &&
+                         tune_before(&next_bit, &next_stream)) ?
+                        &next_bit : &next_stream, NULL);
+        clock_gettime(CLOCK_MONOTONIC, &now);
+    }
+    tune_stream(&res, sig);
+
+    /* Oldest sample follows the last written one; event timestamps are
+     * converted to the same linear index */
+    osc_fpga_get_wr_ptr(&wr_ptr, NULL);
+    start = (wr_ptr + 1) % OSC_FPGA_SIG_LEN;
+    for(i = 0; i < n_ev; i++)
+        tune_events[i].ptr = (tune_events[i].ptr - start + OSC_FPGA_SIG_LEN) %
+            OSC_FPGA_SIG_LEN;
+    ev0 = n_ev ? tune_events[0].ptr : 0;
+    if(ev0 < blk)
+        goto restore;
+
+    y0 = 0;
+    for(j = 0; j < ev0; j++)
+        y0 += tune_adc(sig[(start + j) % OSC_FPGA_SIG_LEN]);
+    y0 /= ev0;
+
+    /* Average down to the fit length, reconstructing the excitation */
+    level = 0;
+    for(i = 0, j = 0, k = 0; i < PID_TUNE_FIT_LEN; i++) {
+        float u = 0, y = 0;
+        for(; j < (i + 1) * blk; j++) {
+            while((k < n_ev) && (tune_events[k].ptr <= j))
+                level = tune_events[k++].level;
+            u += level;
+            y += tune_adc(sig[(start + j) % OSC_FPGA_SIG_LEN]);
+        }
+        tune_u[i] = u / blk;
+        tune_y[i] = y / blk - y0;
+    }
+
+    if(tune_model(ts, &res) < 0)
+        goto restore;
+
+    /* SIMC, tc is set relative to the dead time (at least one sample) */
+    tc = params[TUNE_TC].value * ((res.dead > ts) ? res.dead : ts);
+    kc = res.tau1 / (res.gain * (tc + res.dead));
+    ti = res.tau1 < 4 * (tc + res.dead) ? res.tau1 : 4 * (tc + res.dead);
+    res.kp = kc * (1 + res.tau2 / ti);
+    res.ki = kc / ti * 1e-3;
+    res.kd = kc * res.tau2 * 1e9;
+    res.tau1 *= 1e3;
+    res.tau2 *= 1e3;
+    res.dead *= 1e3;
+    ret = 0;
+
+restore:
+    *out_offset = saved_offset;
+    g_pid_reg->configuration = saved_conf;
+
+    if(ret < 0) {
+        memset(&res, 0, sizeof(res));
+        fprintf(stderr, "PID identification failed\n");
+    }
+    res.state = (ret < 0) ? 3 : 2;
+    rp_update_tune_data(&res);
+    return ret;
+}
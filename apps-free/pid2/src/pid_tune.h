@@ -0,0 +1,34 @@
+/**
+ * @brief Red Pitaya PID Controller open-loop identification
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef __PID_TUNE_H
+#define __PID_TUNE_H
+
+#include "main.h"
+
+/* Full scale of the PID output offset register [counts] */
+#define PID_TUNE_OUT_CNT    8191
+/* Part of the capture recorded before the excitation starts */
+#define PID_TUNE_PRE        0.1
+/* Number of samples the capture is averaged down to for the model fit */
+#define PID_TUNE_FIT_LEN    1024
+/* PRBS length (7 bit LFSR) and shortest bit period software can keep [ns] */
+#define PID_TUNE_PRBS_BITS  127
+#define PID_TUNE_PRBS_MIN   100000
+/* Process variable streaming period [ns] */
+#define PID_TUNE_STREAM_NS  20000000
+/* Relative fit improvement needed to prefer the second order model */
+#define PID_TUNE_SOPDT_GAIN 0.9
+
+int pid_tune_run(rp_app_params_t *params, int *cha_signal, int *chb_signal);
+
+#endif // __PID_TUNE_H
@@ -28,6 +28,7 @@
 #include "worker.h"
 #include "fpga.h"
 #include "pid.h"  // bar graph ---------------- Fenske
+#include "pid_tune.h"
 
 
 
@@ -346,6 +347,22 @@ void *rp_osc_worker_thread(void *args)
             fpga_update = 0;
         }
 
+        if(state == rp_osc_tune_state) {
+            /* PID identification takes over the acquisition, afterwards
+             * FPGA settings are restored and the previous state resumed */
+            pid_tune_run(curr_params, &rp_fpga_cha_signal[0],
+                         &rp_fpga_chb_signal[0]);
+
+            pthread_mutex_lock(&rp_osc_ctrl_mutex);
+            if(rp_osc_ctrl == rp_osc_tune_state)
+                rp_osc_ctrl = (old_state == rp_osc_tune_state) ?
+                    rp_osc_idle_state : old_state;
+            pthread_mutex_unlock(&rp_osc_ctrl_mutex);
+            fpga_update = 1;
+            time_vect_update = 1;
+            continue;
+        }
+
         if(state == rp_osc_idle_state) {
             usleep(10000);
             continue;
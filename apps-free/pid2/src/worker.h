@@ -26,6 +26,7 @@ typedef enum rp_osc_worker_state_e {
     rp_osc_normal_state, /* normal mode */
     rp_osc_single_state, /* single acq., automatically goes to idle */
     rp_osc_auto_set_state, /* runs auto-set algorithm */
+    rp_osc_tune_state, /* PID identification run, returns to previous state */
     rp_osc_nonexisting_state /* must be last */
 } rp_osc_worker_state_t;
 
@@ -15,10 +15,16 @@
  * for more details on the language used herein.
  */
  
+#include <time.h>
+
 #include "ISTctrl.h"
+#include "ISTlog.h"
 
-void* map_base_ = (void*)(-1);
-const uint32_t c_addrAms = 0x40400000;
+static void* map_base_ = (void*)(-1);
+static const uint32_t c_addrAms = 0x40400000;
+// AMS registers, mapped by ISTctrl_Init()
+static int ams_fd = -1;
+static amsReg_t* ams = NULL;
 
 float AmsConversion(ams_t a_ch, unsigned int a_raw)
 {
@@ -84,7 +90,7 @@ void DacWrite(amsReg_t * a_amsReg, double * a_val, ssize_t a_cnt)
 	}
 }
 
-void ISTctrl_Init(void)
+int ISTctrl_Init(void)
 {
 	fileopen = 0;
 	HeatStp = 1;
@@ -98,7 +104,46 @@ void ISTctrl_Init(void)
 	ISTlm35 = 0;
 	ISTfreq = 0;
 	ISTper = 0;
+	memset(&ISTjitter, 0, sizeof(ISTjitter));
+
+	// Map the AMS page once, the control loop only accesses the registers
+	ams_fd = open("/dev/mem", O_RDWR | O_SYNC);
+	if(ams_fd < 0) {
+		fprintf(stderr, "open(/dev/mem) failed: %s\n", strerror(errno));
+		return -1;
+	}
+	map_base_ = mmap(0, MAP_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, ams_fd, c_addrAms & ~MAP_MASK);
+	if(map_base_ == (void *) -1) {
+		fprintf(stderr, "mmap() failed: %s\n", strerror(errno));
+		close(ams_fd);
+		ams_fd = -1;
+		return -1;
+	}
+	ams = map_base_ + (c_addrAms & MAP_MASK);
+
 	IST_tempCalib();
+	return 0;
+}
+
+void ISTctrl_Exit(void)
+{
+	if(ISTjitter.cycles > 0)
+	{
+		double mean = ISTjitter.sum_ns / ISTjitter.cycles;
+		fprintf(stderr, "IST control loop: %llu cycles, lateness mean %.1f us, rms %.1f us, max %.1f us, %llu overruns\n",
+			(unsigned long long)ISTjitter.cycles, mean / 1000,
+			sqrt(ISTjitter.sum2_ns / ISTjitter.cycles) / 1000, ISTjitter.max_ns / 1000,
+			(unsigned long long)ISTjitter.overruns);
+	}
+	if(map_base_ != (void *) -1) {
+		munmap(map_base_, MAP_SIZE);
+		map_base_ = (void *) -1;
+		ams = NULL;
+	}
+	if(ams_fd >= 0) {
+		close(ams_fd);
+		ams_fd = -1;
+	}
 }
 
 
@@ -106,16 +151,9 @@ void IST_tempCalib(void)
 {
 	//read ADC 0 ans 1 to make differential mesure
 	int i;
-	double val[2];
+	double val[2] = { 0, 0 };
 	unsigned int raw;
-			
-	uint32_t addr = c_addrAms;
-	amsReg_t* ams=NULL;
-	// Map one page
-	map_base_ = mmap(0, MAP_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, addr & ~MAP_MASK);	    
-	if(map_base_ == (void *) -1) FATAL;	
-	
-	ams = map_base_ + (addr & MAP_MASK);
+
 	for(i=0;i<2000;i++)
 	{
 		raw = ams->aif[0];
@@ -130,103 +168,80 @@ void IST_tempCalib(void)
 	{
 		ISTsnsAdj = 0;
 	}
-	munmap(0, MAP_SIZE);
 }
 
-void swap(double* a, double* b)
+/* Adds a sample, returns 1 and the median of the last 3 once it has them */
+int ISTmedian(ist_median_t *f, double x, double *out)
 {
-	double tmp = *a;
-	*b = *a;
-	*a = tmp;
-}
+	double a, b, c;
 
-double getMin(double a, double b, double c)
-{	
-	if(a>b)
-	{
-		swap(&a,&b);
-	}
-	if(b>c)
+	f->v[f->pos] = x;
+	f->pos = (f->pos + 1) % 3;
+	if(f->n < 3)
 	{
-		swap(&b,&c);
-	}
-	if(a>b)
-	{
-		swap(&a,&b);
+		f->n++;
+		if(f->n < 3)
+		{
+			return 0;
+		}
 	}
-	return a;
+	a = f->v[0];
+	b = f->v[1];
+	c = f->v[2];
+	*out = fmax(fmin(a, b), fmin(fmax(a, b), c));
+	return 1;
 }
 
 float ISTctrl()
 {
 	//read ADC 0 ans 1 to make differential mesure
-	static int filecnt = 0, mv = 0;
+	static int filecnt = 0;
+	static ist_median_t ist_filt, lm35_filt;
 	double val[4];
-	static double bufVal_0[3],bufVal_1[3];
 	unsigned int raw;
-	float CtrlMaxTemp = DeltaTemp,toDAC;
-			
-	uint32_t addr = c_addrAms;
-	amsReg_t* ams=NULL;
-	// Map one page
-	map_base_ = mmap(0, MAP_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, addr & ~MAP_MASK);	    
-	if(map_base_ == (void *) -1) FATAL;	
-	ams = map_base_ + (addr & MAP_MASK);
+	float CtrlMaxTemp = DeltaTemp,toDAC = 0;
+	int ready;
+
 	raw = ams->aif[0];
 	val[0]=AmsConversion(1, raw)*1000*ISTsnsAdj; //0.01749 is the conv. value from Volt to °C for the PT1000
 	raw = ams->aif[1];
 	val[1]=AmsConversion(2, raw)*100;
 	
 	//median filter
-	bufVal_0[mv] = val[0];
-	bufVal_1[mv] = val[1];	
-	if(mv<2) 
-	{ 
-		mv++; 
+	ready = ISTmedian(&ist_filt, val[0], &val[0]);
+	ready &= ISTmedian(&lm35_filt, val[1], &val[1]);
+	if(!ready)
+	{
+		return toDAC;
 	}
-	else 
-	{ 		
-		val[0] = getMin(bufVal_0[0],bufVal_0[1],bufVal_0[2]);
-		val[1] = getMin(bufVal_1[0],bufVal_1[1],bufVal_1[2]);
-		bufVal_0[0] = bufVal_0[1];
-		bufVal_0[1] = bufVal_0[2];
-		bufVal_1[0] = bufVal_1[1];
-		bufVal_1[1] = bufVal_1[2]; 
+
+	float RS_LM35_diff = (val[1]-val[0])+ DeltaTemp; //diff measure between LM35 and IST sens		
+	float PIDout = pid_update(RS_LM35_diff);
 	
-		float RS_LM35_diff = (val[1]-val[0])+ DeltaTemp; //diff measure between LM35 and IST sens		
-		float PIDout = pid_update(RS_LM35_diff);
-		
-		toDAC = (PIDout*1.8/CtrlMaxTemp); //PID control
-		if(toDAC>1.8) toDAC = 1.8;
-		if(toDAC<0) toDAC = 0;
-				
-		if(filecnt < 10)	//save at abt 1K Hz, 2ms of period
-		{	
-			filecnt++;
-		}
-		else
+	toDAC = (PIDout*1.8/CtrlMaxTemp); //PID control
+	if(toDAC>1.8) toDAC = 1.8;
+	if(toDAC<0) toDAC = 0;
+			
+	if(filecnt < 10)	//save at abt 1K Hz, 2ms of period
+	{	
+		filecnt++;
+	}
+	else
+	{
+		filecnt=0;
+		ISTlm35 = (float)(val[1]);
+		if(IST2file==1 && fileopen==1)// log to the file 
 		{
-			filecnt=0;
-			ISTlm35 = (float)(val[1]);
-			if(IST2file==1 && fileopen==1)// write to the file 
-			{
-				fprintf(file_ptr, "%f,%f,%f\n", val[0],val[1],toDAC); //IST temp, LM35 temp, Out ctrl
-			}
+			ISTlog_Append(val[0], val[1], toDAC); //IST temp, LM35 temp, Out ctrl
 		}
-		
-		val[0] = toDAC;
-		val[1] = 0;//AmsConversion(eAmsAO0+1, ams->dac[1]);
-		val[2] = 0;//AmsConversion(eAmsAO0+2, ams->dac[2]);
-		val[3] = 0;//AmsConversion(eAmsAO0+3, ams->dac[3]);
+	}
+	
+	val[0] = toDAC;
+	val[1] = 0;//AmsConversion(eAmsAO0+1, ams->dac[1]);
+	val[2] = 0;//AmsConversion(eAmsAO0+2, ams->dac[2]);
+	val[3] = 0;//AmsConversion(eAmsAO0+3, ams->dac[3]);
 
-		DacWrite(ams, &val[0], 4);
-		
-		if (map_base_ != (void*)(-1)) {
-			if(munmap(map_base_, MAP_SIZE) == -1) FATAL;
-			map_base_ = (void*)(-1);
-		}
-		munmap(0, MAP_SIZE);
-	}	
+	DacWrite(ams, &val[0], 4);
 	return (float)toDAC;
 }
 
@@ -241,24 +256,49 @@ void StopHeat()
 {
 	if(IST_EN==0 && HeatStp==0) 
 	{ 
+		double val[4] = { 0, 0, 0, 0 };
+
 		ISTcnt = 0;
 		HeatStp = 1;
-		double* val;
-		amsReg_t* ams=NULL;
-		val = calloc(4*1024, sizeof(double));
-					
-		map_base_ = mmap(0, MAP_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, c_addrAms & ~MAP_MASK);
-		
-		ams = map_base_ + (c_addrAms & MAP_MASK);
-		val[0] = 0;
-		val[1] = 0;
-		val[2] = 0;
-		val[3] = 0;
-
 		DacWrite(ams, val, 4);
 	}
 }
 
+static void addNs(struct timespec *t, long ns)
+{
+	t->tv_nsec += ns;
+	while(t->tv_nsec >= 1000000000L)
+	{
+		t->tv_nsec -= 1000000000L;
+		t->tv_sec++;
+	}
+}
+
+/* Waits for the next period from an absolute deadline, so that the time the
+ * controller takes does not add to it. A late wake up is recorded, a cycle
+ * that missed its deadline by a whole period starts the schedule again. */
+static void ISTwait(struct timespec *next, long period_ns)
+{
+	struct timespec now;
+	double late;
+
+	addNs(next, period_ns);
+	while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, next, NULL) == EINTR)
+		;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	late = (now.tv_sec - next->tv_sec) * 1e9 + (now.tv_nsec - next->tv_nsec);
+
+	ISTjitter.cycles++;
+	ISTjitter.sum_ns += late;
+	ISTjitter.sum2_ns += late * late;
+	if(late > ISTjitter.max_ns) { ISTjitter.max_ns = late; }
+	if(late >= period_ns)
+	{
+		ISTjitter.overruns++;
+		*next = now;
+	}
+}
+
 void ISTctrl_time(int delay)
 {
 	if(IST_EN==1) 
@@ -268,11 +308,14 @@ void ISTctrl_time(int delay)
 		float dataTemp;
 		HeatStp = 0;
 		float ISTctrl_delay = Dt*1000000;	//us
+		long period_ns = Dt*1e9;
 		int iterations = (int)(delay/ISTctrl_delay);
 		int dupSample =(int)((TimeWin/ISTctrl_delay)/1024);
 		int i;
 		static int j = 0;
-				
+		struct timespec next;
+
+		clock_gettime(CLOCK_MONOTONIC, &next);
 		for(i=0;i<iterations;i++)
 		{		
 				dataTemp = ISTctrl();
@@ -298,13 +341,13 @@ void ISTctrl_time(int delay)
 						ISTminTmp = ISTmaxTmp;
 						ISTmax = ISTmaxTmp;
 						ISTadj = ISTsnsAdj;
-						ISTfreq = 10000;
-						ISTper = 0.0001;
+						ISTfreq = 1 / Dt;
+						ISTper = Dt;
 												
 						ISTcnt = 0; 					
 					}
 				}
-				usleep(10);
+				ISTwait(&next, period_ns);
 				
 		}	
 	}	//enable IST realprobe Controller abt 190uS
@@ -323,24 +366,18 @@ void IST_Initfile(void)
 		char filename[64];		
 		
 		sprintf (filename, "/tmp/ISTctrl_%d.dat", nameCnt);
-		while(fopen(filename, "r"))
+		while(access(filename, F_OK) == 0)
 		{
 			nameCnt++;		
 			sprintf (filename, "/tmp/ISTctrl_%d.dat", nameCnt);
 		}
 		
-		/* open the file */
-		file_ptr = fopen(filename, "w");
-		if (file_ptr == NULL) 
+		/* binary log, istlog2csv converts it */
+		if(ISTlog_Open(filename, ISTsnsAdj, Dt) < 0)
 		{
-			printf("I couldn't open file for writing.\n");
 			fileErr = 1;
-			exit(0);
+			return;
 		}
-		fprintf(file_ptr, "RedPitaya Oscilloscope + IST Realprobe Flow Controller\n");
-		fprintf(file_ptr, "The PID controller freq. is 10KHz and the data saving freq. is 1KHz.\n");
-		fprintf(file_ptr, "The IST PT100 V/°C conversion value is %f. The following data are:",ISTsnsAdj);
-		fprintf(file_ptr, "\nIST realprobe temp (°C), LM35 temp (°C), IST power control (Volt)\n\n");
 		fileopen = 1;			
 	}
 }
@@ -350,7 +387,6 @@ void IST_Closefile(void)
 	if(fileopen==1)
 	{
 		fileopen = 0;
-		/* close the file */
-		fclose(file_ptr); 
+		ISTlog_Close();
 	}	
 }
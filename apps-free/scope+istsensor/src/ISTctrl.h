@@ -50,7 +50,6 @@ int parse_from_argv(int a_argc, char **a_argv, unsigned long* a_addr, int* a_typ
 int parse_from_stdin(unsigned long* a_addr, int* a_type, unsigned long** a_values, ssize_t* a_len);
 uint32_t read_value(uint32_t a_addr);
 void write_values(unsigned long a_addr, int a_type, unsigned long* a_values, ssize_t a_len);
-int fd;
 
 typedef struct {
 	uint32_t aif[5];
@@ -85,13 +84,29 @@ typedef enum {
 	eSendNum
 } ams_t;
 
+/* 3-tap median filter of one input */
+typedef struct {
+	double v[3];
+	int pos;
+	int n;
+} ist_median_t;
+
+/* Lateness of the control cycles against their fixed period */
+typedef struct {
+	uint64_t cycles;
+	uint64_t overruns;	// cycles late by a whole period
+	double sum_ns;
+	double sum2_ns;
+	double max_ns;
+} ist_jitter_t;
+
 float IST_PWR_out[SIGNAL_LENGTH];
 int HeatStp,ISTcnt;
 float TimeWin;	//in us
-FILE *file_ptr;
 int fileopen,fileErr;
 float ISTsnsAdj;	//about 0.00234;
 float ISTmin,ISTmax,ISTadj,ISTfreq,ISTper,ISTlm35;
+ist_jitter_t ISTjitter;
 	
 float AmsConversion(ams_t , unsigned int );
 void DacWrite(amsReg_t * , double * , ssize_t );
@@ -100,12 +115,12 @@ void ISTctrl_time(int);
 double PID(double delta);
 void StopHeat();
 void Stop_ISTctrl(rp_app_params_t *);
-void ISTctrl_Init(void);
+int ISTctrl_Init(void);
+void ISTctrl_Exit(void);
 void IST_Initfile(void);
 void IST_Closefile(void);
 void IST_tempCalib(void);
-double getMin(double, double, double);
-void swap(double *, double *);
+int ISTmedian(ist_median_t *, double, double *);
 
 #endif // __ISTctrl
 
@@ -0,0 +1,148 @@
+/**
+ * @brief Red Pitaya IST sensor binary trace log.
+ *
+ * The ring has one producer, the control loop, and one consumer, the
+ * writer thread. Each side only writes its own position and reads the
+ * other one with acquire and release atomics, so appending is a copy and
+ * a store, without a lock, a system call or formatting. A record that
+ * finds the ring full is counted and the count is stored with the next
+ * one.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "ISTlog.h"
+
+static ist_log_rec_t ring[IST_LOG_RING];
+// Free running record counts
+static uint32_t head, tail;
+static uint32_t dropped;
+
+static int log_fd = -1;
+static volatile int logging = 0;
+static pthread_t writer;
+
+/* Writes the records from tail up to head, in at most two pieces */
+static int drain(void)
+{
+	uint32_t end = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+
+	while(tail != end)
+	{
+		uint32_t pos = tail % IST_LOG_RING;
+		uint32_t cnt = end - tail;
+		if(pos + cnt > IST_LOG_RING) { cnt = IST_LOG_RING - pos; }
+
+		ssize_t n = write(log_fd, &ring[pos], cnt * sizeof(ist_log_rec_t));
+		if(n < 0 && errno == EINTR) { continue; }
+		// Short only when the disk is full
+		if(n != cnt * sizeof(ist_log_rec_t)) { return -1; }
+		__atomic_store_n(&tail, tail + cnt, __ATOMIC_RELEASE);
+	}
+	return 0;
+}
+
+static void* writerThread(void *arg)
+{
+	struct timespec t = { 0, IST_LOG_FLUSH_MS * 1000000L };
+
+	while(logging)
+	{
+		if(drain() < 0)
+		{
+			fprintf(stderr, "IST log write failed: %s\n", strerror(errno));
+			logging = 0;
+			break;
+		}
+		nanosleep(&t, NULL);
+	}
+	return NULL;
+}
+
+int ISTlog_Open(const char *filename, float sns_adj, float period)
+{
+	ist_log_hdr_t hdr;
+
+	if(log_fd >= 0) { return 0; }
+
+	log_fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if(log_fd < 0)
+	{
+		fprintf(stderr, "open(%s) failed: %s\n", filename, strerror(errno));
+		return -1;
+	}
+
+	memset(&hdr, 0, sizeof(hdr));
+	strncpy(hdr.magic, IST_LOG_MAGIC, sizeof(hdr.magic));
+	hdr.version = IST_LOG_VERSION;
+	hdr.rec_size = sizeof(ist_log_rec_t);
+	hdr.sns_adj = sns_adj;
+	hdr.period = period;
+	if(write(log_fd, &hdr, sizeof(hdr)) != sizeof(hdr))
+	{
+		close(log_fd);
+		log_fd = -1;
+		return -1;
+	}
+
+	head = tail = dropped = 0;
+	logging = 1;
+	if(pthread_create(&writer, NULL, writerThread, NULL) != 0)
+	{
+		logging = 0;
+		close(log_fd);
+		log_fd = -1;
+		return -1;
+	}
+	return 0;
+}
+
+/* Called from the control loop, never blocks */
+void ISTlog_Append(float ist, float lm35, float dac)
+{
+	struct timespec ts;
+	ist_log_rec_t *rec;
+
+	if(!logging) { return; }
+	if(head - __atomic_load_n(&tail, __ATOMIC_ACQUIRE) >= IST_LOG_RING)
+	{
+		dropped++;
+		return;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	rec = &ring[head % IST_LOG_RING];
+	rec->time_ns = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+	rec->ist = ist;
+	rec->lm35 = lm35;
+	rec->dac = dac;
+	rec->dropped = dropped;
+	dropped = 0;
+	__atomic_store_n(&head, head + 1, __ATOMIC_RELEASE);
+}
+
+/* Stops the writer and writes what is left */
+void ISTlog_Close(void)
+{
+	if(log_fd < 0) { return; }
+
+	logging = 0;
+	pthread_join(writer, NULL);
+	drain();
+	close(log_fd);
+	log_fd = -1;
+}
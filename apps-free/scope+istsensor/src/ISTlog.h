@@ -0,0 +1,49 @@
+/**
+ * @brief Red Pitaya IST sensor binary trace log.
+ *
+ * The control loop appends records to a preallocated ring, a writer thread
+ * drains it to the file. istlog2csv converts a file to CSV.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef __ISTLOG_H
+#define __ISTLOG_H
+
+#include <stdint.h>
+
+#define IST_LOG_MAGIC       "ISTLOG1"
+#define IST_LOG_VERSION     1
+/* Records in the ring, a power of two, about 9 s of the 1 kHz trace */
+#define IST_LOG_RING        8192
+/* Writer thread wake up period [ms] */
+#define IST_LOG_FLUSH_MS    50
+
+/* File header, followed by the records */
+typedef struct {
+	char magic[8];
+	uint32_t version;
+	uint32_t rec_size;	// sizeof(ist_log_rec_t)
+	float sns_adj;		// IST PT100 V/°C conversion value
+	float period;		// control loop period [s]
+} ist_log_hdr_t;
+
+typedef struct {
+	uint64_t time_ns;	// CLOCK_MONOTONIC
+	float ist;		// IST realprobe temperature [°C]
+	float lm35;		// LM35 temperature [°C]
+	float dac;		// IST power control [V]
+	uint32_t dropped;	// records lost to a full ring before this one
+} ist_log_rec_t;
+
+int ISTlog_Open(const char *filename, float sns_adj, float period);
+void ISTlog_Append(float ist, float lm35, float dac);
+void ISTlog_Close(void);
+
+#endif // __ISTLOG_H
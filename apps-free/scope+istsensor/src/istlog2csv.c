@@ -0,0 +1,67 @@
+/**
+ * @brief Converts an IST sensor binary trace log to CSV.
+ *
+ * Usage: istlog2csv <log file> [<csv file>]
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "ISTlog.h"
+
+int main(int argc, char **argv)
+{
+	ist_log_hdr_t hdr;
+	ist_log_rec_t rec;
+	FILE *in, *out = stdout;
+	uint64_t t0 = 0, n = 0;
+
+	if(argc < 2 || argc > 3)
+	{
+		fprintf(stderr, "Usage: %s <log file> [<csv file>]\n", argv[0]);
+		return 1;
+	}
+	in = fopen(argv[1], "rb");
+	if(in == NULL)
+	{
+		perror(argv[1]);
+		return 1;
+	}
+	if(fread(&hdr, sizeof(hdr), 1, in) != 1
+	   || strncmp(hdr.magic, IST_LOG_MAGIC, sizeof(hdr.magic)) != 0
+	   || hdr.version != IST_LOG_VERSION || hdr.rec_size != sizeof(rec))
+	{
+		fprintf(stderr, "%s: not an IST log of version %d\n", argv[1], IST_LOG_VERSION);
+		fclose(in);
+		return 1;
+	}
+	if(argc == 3 && (out = fopen(argv[2], "w")) == NULL)
+	{
+		perror(argv[2]);
+		fclose(in);
+		return 1;
+	}
+
+	fprintf(out, "# RedPitaya Oscilloscope + IST Realprobe Flow Controller\n");
+	fprintf(out, "# The PID controller period is %g s.\n", hdr.period);
+	fprintf(out, "# The IST PT100 V/°C conversion value is %f.\n", hdr.sns_adj);
+	fprintf(out, "time (s),IST realprobe temp (°C),LM35 temp (°C),IST power control (Volt)\n");
+	while(fread(&rec, sizeof(rec), 1, in) == 1)
+	{
+		if(n++ == 0) { t0 = rec.time_ns; }
+		if(rec.dropped) { fprintf(out, "# %u records dropped\n", rec.dropped); }
+		fprintf(out, "%.6f,%f,%f,%f\n", (rec.time_ns - t0) * 1e-9, rec.ist, rec.lm35, rec.dac);
+	}
+
+	fclose(in);
+	if(out != stdout) { fclose(out); }
+	return 0;
+}
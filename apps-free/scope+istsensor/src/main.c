@@ -287,7 +287,9 @@ int rp_app_init(void)
 
 
     pid_init();
-    ISTctrl_Init();
+    if(ISTctrl_Init() < 0) {
+        return -1;
+    }
     pid_constUpdate(&rp_main_params[0]);	//update PID parameters
 
     return 0;
@@ -298,6 +300,7 @@ int rp_app_exit(void)
     fprintf(stderr, "Unloading 1Ch scope + IST sensor Control version %s-%s.\n", VERSION_STR, REVISION_STR);
 
     Stop_ISTctrl(&rp_main_params[0]);
+    ISTctrl_Exit();
     rp_osc_worker_exit();
     generate_exit();
 
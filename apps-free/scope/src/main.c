@@ -160,6 +160,47 @@ static rp_app_params_t rp_main_params[PARAMS_NUM+1] = {
     { /* scale_ch2 - Jumper & probe attenuation dependent Y scaling factor for Channel 2 */
         "scale_ch2", 0, 0, 1, -1000, 1000 },
 
+    /***************************************/
+    /* Persistence parameters from here on */
+    /***************************************/
+
+    { /* persist_mode - Accumulates all frames into hit-count images:
+       *    0 - off, latest frame only
+       *    1 - on  */
+        "persist_mode", 0, 0, 0, 0, 1 },
+    { /* persist_decay - Decay of the images, counts are reduced by
+       * 1/2^persist_decay every image period:
+       *    0    - infinite persistence
+       *    1..8 - decay, 1 fastest */
+        "persist_decay", 0, 0, 0, 0, 8 },
+    { /* persist_clear - Clears the accumulated images:
+       *    0 - ignore
+       *    1 - clear */
+        "persist_clear", 0, 0, 0, 0, 1 },
+    { /* persist_idx - Index of the last written image file pair
+       * (/tmp/ram/persN_idx.bmp), -1 before the first one */
+        "persist_idx", -1, 0, 1, -1, 1000 },
+    { /* persist_fs_ch1, persist_fs_ch2 - Voltage of the top image row, the
+       * bottom row is its negative value (full ADC range) */
+        "persist_fs_ch1", 0, 0, 1, -1000, 1000 },
+    {
+        "persist_fs_ch2", 0, 0, 1, -1000, 1000 },
+    { /* math_en - Enables the math channel (signal 4), math_func(math_src):
+       *    0 - off
+       *    1 - on */
+        "math_en", 0, 0, 0, 0, 1 },
+    { /* math_src - Source of the math channel:
+       *    0 - A, 1 - B, 2 - A+B, 3 - A-B, 4 - A*B */
+        "math_src", 3, 0, 0, 0, 4 },
+    { /* math_func - Function applied to the source:
+       *    0 - none
+       *    1 - integrate [unit*s]
+       *    2 - differentiate [unit/s]
+       *    3 - FFT magnitude [dBV], math_fft_df spaced bins from 0 Hz on */
+        "math_func", 0, 0, 0, 0, 3 },
+    { /* math_fft_df - FFT bin width [Hz] of the last math frame */
+        "math_fft_df", 0, 0, 1, 0, 1e9 },
+
     /********************************************************/
     /* Arbitrary Waveform Generator parameters from here on */
     /********************************************************/
@@ -850,6 +891,9 @@ int rp_set_params(rp_app_params_t *p, int len)
             return -1;
         }
 
+        /* Worker has cleared the images with the new parameters */
+        rp_main_params[PERSIST_CLEAR].value = 0;
+
         if(rp_main_params[SINGLE_BUT_PARAM].value == 1) {
             rp_main_params[SINGLE_BUT_PARAM].value = 0;
             rp_osc_clean_signals();
@@ -1130,6 +1174,24 @@ int rp_update_meas_data(rp_osc_meas_res_t ch1_meas, rp_osc_meas_res_t ch2_meas)
     return 0;
 }
 
+int rp_update_persist_data(int img_idx, float ch1_fs, float ch2_fs)
+{
+    pthread_mutex_lock(&rp_main_params_mutex);
+    rp_main_params[PERSIST_IDX].value = img_idx;
+    rp_main_params[PERSIST_FS_CH1].value = ch1_fs;
+    rp_main_params[PERSIST_FS_CH2].value = ch2_fs;
+    pthread_mutex_unlock(&rp_main_params_mutex);
+    return 0;
+}
+
+int rp_update_math_data(float fft_df)
+{
+    pthread_mutex_lock(&rp_main_params_mutex);
+    rp_main_params[MATH_FFT_DF].value = fft_df;
+    pthread_mutex_unlock(&rp_main_params_mutex);
+    return 0;
+}
+
 float rp_gen_limit_freq(float freq, float gen_type)
 {
     int type = (int)gen_type;
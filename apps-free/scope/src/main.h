@@ -45,7 +45,7 @@ typedef struct rp_osc_meas_res_s {
 
 /* Parameters indexes - these defines should be in the same order as 
  * rp_app_params_t structure defined in main.c */
-#define PARAMS_NUM        81
+#define PARAMS_NUM        91
 #define MIN_GUI_PARAM     0
 #define MAX_GUI_PARAM     1
 #define TRIG_MODE_PARAM   2
@@ -88,60 +88,72 @@ typedef struct rp_osc_meas_res_s {
 #define GEN_DC_NORM_2     39
 #define SCALE_CH1         40
 #define SCALE_CH2         41
+/* Persistence parameters */
+#define PERSIST_MODE      42
+#define PERSIST_DECAY     43
+#define PERSIST_CLEAR     44
+#define PERSIST_IDX       45
+#define PERSIST_FS_CH1    46
+#define PERSIST_FS_CH2    47
+/* Math channel parameters */
+#define MATH_EN           48
+#define MATH_SRC          49
+#define MATH_FUNC         50
+#define MATH_FFT_DF       51
 /* AWG parameters */
-#define GEN_TRIG_MODE_CH1 42
-#define GEN_SIG_TYPE_CH1  43
-#define GEN_ENABLE_CH1    44
-#define GEN_SINGLE_CH1    45
-#define GEN_SIG_AMP_CH1   46
-#define GEN_SIG_FREQ_CH1  47
-#define GEN_SIG_DCOFF_CH1 48
-#define GEN_TRIG_MODE_CH2 49
-#define GEN_SIG_TYPE_CH2  50
-#define GEN_ENABLE_CH2    51
-#define GEN_SINGLE_CH2    52
-#define GEN_SIG_AMP_CH2   53
-#define GEN_SIG_FREQ_CH2  54
-#define GEN_SIG_DCOFF_CH2 55
-#define GEN_AWG_REFRESH   56
+#define GEN_TRIG_MODE_CH1 52
+#define GEN_SIG_TYPE_CH1  53
+#define GEN_ENABLE_CH1    54
+#define GEN_SINGLE_CH1    55
+#define GEN_SIG_AMP_CH1   56
+#define GEN_SIG_FREQ_CH1  57
+#define GEN_SIG_DCOFF_CH1 58
+#define GEN_TRIG_MODE_CH2 59
+#define GEN_SIG_TYPE_CH2  60
+#define GEN_ENABLE_CH2    61
+#define GEN_SINGLE_CH2    62
+#define GEN_SIG_AMP_CH2   63
+#define GEN_SIG_FREQ_CH2  64
+#define GEN_SIG_DCOFF_CH2 65
+#define GEN_AWG_REFRESH   66
 /* PID parameters */
-#define PID_11_ENABLE     57
-#define PID_11_RESET      58
-#define PID_11_SP         59
-#define PID_11_KP         60
-#define PID_11_KI         61
-#define PID_11_KD         62
-#define PID_12_ENABLE     63
-#define PID_12_RESET      64
-#define PID_12_SP         65
-#define PID_12_KP         66
-#define PID_12_KI         67
-#define PID_12_KD         68
-#define PID_21_ENABLE     69
-#define PID_21_RESET      70
-#define PID_21_SP         71
-#define PID_21_KP         72
-#define PID_21_KI         73
-#define PID_21_KD         74
-#define PID_22_ENABLE     75
-#define PID_22_RESET      76
-#define PID_22_SP         77
-#define PID_22_KP         78
-#define PID_22_KI         79
-#define PID_22_KD         80
+#define PID_11_ENABLE     67
+#define PID_11_RESET      68
+#define PID_11_SP         69
+#define PID_11_KP         70
+#define PID_11_KI         71
+#define PID_11_KD         72
+#define PID_12_ENABLE     73
+#define PID_12_RESET      74
+#define PID_12_SP         75
+#define PID_12_KP         76
+#define PID_12_KI         77
+#define PID_12_KD         78
+#define PID_21_ENABLE     79
+#define PID_21_RESET      80
+#define PID_21_SP         81
+#define PID_21_KP         82
+#define PID_21_KI         83
+#define PID_21_KD         84
+#define PID_22_ENABLE     85
+#define PID_22_RESET      86
+#define PID_22_SP         87
+#define PID_22_KP         88
+#define PID_22_KI         89
+#define PID_22_KD         90
 
 /* Defines from which parameters on are AWG parameters (used in set_param() to
  * trigger update only on needed part - either Oscilloscope, AWG or PID */
-#define PARAMS_AWG_PARAMS 42
+#define PARAMS_AWG_PARAMS 52
 
 /* Defines from which parameters on are PID parameters (used in set_param() to
  * trigger update only on needed part - either Oscilloscope, AWG or PID */
-#define PARAMS_PID_PARAMS 57
+#define PARAMS_PID_PARAMS 67
 #define PARAMS_PER_PID     6
 
 /* Output signals */
 #define SIGNAL_LENGTH (1024) /* Must be 2^n! */
-#define SIGNALS_NUM   3
+#define SIGNALS_NUM   4
 
 
 /* module entry points */
@@ -176,6 +188,14 @@ void transform_from_iface_units(rp_app_params_t *p);
  */
 int rp_update_meas_data(rp_osc_meas_res_t ch1_meas, rp_osc_meas_res_t ch2_meas);
 
+/* sets the index of the last persistence images and their full scale
+ * voltages, read-only for the client as the measurement data
+ */
+int rp_update_persist_data(int img_idx, float ch1_fs, float ch2_fs);
+
+/* sets the FFT bin width of the math channel, read-only for the client */
+int rp_update_math_data(float fft_df);
+
 /* Waveform generator frequency limiter. */
 float rp_gen_limit_freq(float freq, float gen_type);
 
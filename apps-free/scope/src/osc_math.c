@@ -0,0 +1,393 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya Oscilloscope math channel module.
+ *
+ * The math channel is a two node expression func(src), evaluated once per
+ * triggered frame straight from the raw FPGA buffers. Every source is
+ * affine in the clamped ADC counts a, b and their product:
+ *
+ *    src = c0 + ca * a + cb * b + cab * a * b
+ *
+ * so the source node is reduced to four coefficients and no per channel
+ * volt buffers are needed. The functions only need sums of a, b and a * b
+ * over consecutive sample segments, which are accumulated in integers by
+ * two branch-free loops (with and without the product term) that the
+ * compiler vectorizes. Integration and differentiation use all samples of
+ * the window, not only the displayed ones.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "osc_math.h"
+#include "fpga.h"
+
+#define MATH_ADC_MASK       ((1 << 14) - 1)
+#define MATH_ADC_SIGN       (1 << 13)
+#define MATH_ADC_FS         (1 << 13)
+#define MATH_FFT_MIN_DBV    (-200.0)
+
+/* Source coefficients, see the module description */
+typedef struct math_coeff_s {
+    double c0, ca, cb, cab;
+    int    a_off, b_off;    /* calibration offsets in counts */
+} math_coeff_t;
+
+/* Sums over a segment of clamped counts */
+typedef struct math_sums_s {
+    int64_t a, b, ab;
+    int     n;
+} math_sums_t;
+
+
+/*----------------------------------------------------------------------------------*/
+int rp_osc_math_init(rp_osc_math_t *m)
+{
+    int bits = 0, i, k;
+
+    memset(m, 0, sizeof(*m));
+    m->fft_re  = (float *)malloc(MATH_FFT_LEN * sizeof(float));
+    m->fft_im  = (float *)malloc(MATH_FFT_LEN * sizeof(float));
+    m->fft_win = (float *)malloc(MATH_FFT_LEN * sizeof(float));
+    m->fft_cos = (float *)malloc(MATH_FFT_LEN / 2 * sizeof(float));
+    m->fft_sin = (float *)malloc(MATH_FFT_LEN / 2 * sizeof(float));
+    m->fft_rev = (int *)malloc(MATH_FFT_LEN * sizeof(int));
+    if(!m->fft_re || !m->fft_im || !m->fft_win || !m->fft_cos ||
+       !m->fft_sin || !m->fft_rev) {
+        fprintf(stderr, "rp_osc_math_init(): malloc() failed\n");
+        rp_osc_math_exit(m);
+        return -1;
+    }
+
+    while((1 << bits) < MATH_FFT_LEN)
+        bits++;
+    for(i = 0; i < MATH_FFT_LEN; i++) {
+        int r = 0;
+        for(k = 0; k < bits; k++)
+            r |= ((i >> k) & 1) << (bits - 1 - k);
+        m->fft_rev[i] = r;
+        m->fft_win[i] = 0.5 * (1 - cos(2 * M_PI * i / MATH_FFT_LEN));
+    }
+    for(i = 0; i < MATH_FFT_LEN / 2; i++) {
+        m->fft_cos[i] = cos(2 * M_PI * i / MATH_FFT_LEN);
+        m->fft_sin[i] = -sin(2 * M_PI * i / MATH_FFT_LEN);
+    }
+    return 0;
+}
+
+
+/*----------------------------------------------------------------------------------*/
+void rp_osc_math_exit(rp_osc_math_t *m)
+{
+    free(m->fft_re);
+    free(m->fft_im);
+    free(m->fft_win);
+    free(m->fft_cos);
+    free(m->fft_sin);
+    free(m->fft_rev);
+    memset(m, 0, sizeof(*m));
+}
+
+
+/*----------------------------------------------------------------------------------*/
+static void math_coeffs(math_coeff_t *c, int src,
+                        const rp_osc_math_chan_t *cha, const rp_osc_math_chan_t *chb)
+{
+    double ga = cha->max_adc_v / MATH_ADC_FS, ua = cha->user_dc_off;
+    double gb = chb->max_adc_v / MATH_ADC_FS, ub = chb->user_dc_off;
+
+    memset(c, 0, sizeof(*c));
+    c->a_off = cha->calib_dc_off;
+    c->b_off = chb->calib_dc_off;
+
+    switch(src) {
+    case MATH_SRC_B:
+        c->c0 = ub;
+        c->cb = gb;
+        break;
+    case MATH_SRC_A_ADD_B:
+        c->c0 = ua + ub;
+        c->ca = ga;
+        c->cb = gb;
+        break;
+    case MATH_SRC_A_SUB_B:
+        c->c0 = ua - ub;
+        c->ca = ga;
+        c->cb = -gb;
+        break;
+    case MATH_SRC_A_MUL_B:
+        /* (ga * a + ua) * (gb * b + ub) */
+        c->c0 = ua * ub;
+        c->ca = ga * ub;
+        c->cb = gb * ua;
+        c->cab = ga * gb;
+        break;
+    case MATH_SRC_A:
+    default:
+        c->c0 = ua;
+        c->ca = ga;
+        break;
+    }
+}
+
+
+/*----------------------------------------------------------------------------------*/
+/* Clamped count with the calibrated offset, as in osc_fpga_cnv_cnt_to_v() */
+static inline int math_cnt(int raw, int off)
+{
+    int m = (((raw & MATH_ADC_MASK) ^ MATH_ADC_SIGN) - MATH_ADC_SIGN) + off;
+    m = (m < -MATH_ADC_FS) ? -MATH_ADC_FS : m;
+    return (m > MATH_ADC_FS) ? MATH_ADC_FS : m;
+}
+
+/* Sums of len samples from idx on (circular) - the buffer is split in
+ * contiguous parts, so that the loops have no wrap-around check */
+static void math_sums(math_sums_t *s, const math_coeff_t *c,
+                      const int *a, const int *b, int idx, int len)
+{
+    int k;
+
+    s->a = s->b = s->ab = 0;
+    s->n = len;
+    idx %= OSC_FPGA_SIG_LEN;
+    if(idx < 0)
+        idx += OSC_FPGA_SIG_LEN;
+
+    while(len > 0) {
+        int part = OSC_FPGA_SIG_LEN - idx;
+        const int *pa = &a[idx], *pb = &b[idx];
+        int32_t sa = 0, sb = 0;
+        if(part > len)
+            part = len;
+
+        /* Part is at most 16k samples of 14 bits - 32 bit sums suffice */
+        if(c->cab == 0) {
+            for(k = 0; k < part; k++) {
+                sa += math_cnt(pa[k], c->a_off);
+                sb += math_cnt(pb[k], c->b_off);
+            }
+        } else {
+            int64_t sab = 0;
+            for(k = 0; k < part; k++) {
+                int ma = math_cnt(pa[k], c->a_off);
+                int mb = math_cnt(pb[k], c->b_off);
+                sa += ma;
+                sb += mb;
+                sab += (int64_t)(ma * mb);
+            }
+            s->ab += sab;
+        }
+        s->a += sa;
+        s->b += sb;
+        len -= part;
+        idx = 0;
+    }
+}
+
+static inline double math_sum_val(const math_sums_t *s, const math_coeff_t *c)
+{
+    return c->c0 * s->n + c->ca * s->a + c->cb * s->b + c->cab * s->ab;
+}
+
+
+/*----------------------------------------------------------------------------------*/
+static void math_fft(rp_osc_math_t *m)
+{
+    float *re = m->fft_re, *im = m->fft_im;
+    int len, i, k;
+
+    for(i = 0; i < MATH_FFT_LEN; i++) {
+        int j = m->fft_rev[i];
+        if(j > i) {
+            float t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+
+    for(len = 2; len <= MATH_FFT_LEN; len <<= 1) {
+        int half = len / 2;
+        int tw_step = MATH_FFT_LEN / len;
+        for(i = 0; i < MATH_FFT_LEN; i += len) {
+            for(k = 0; k < half; k++) {
+                float wr = m->fft_cos[k * tw_step];
+                float wi = m->fft_sin[k * tw_step];
+                int p = i + k, q = p + half;
+                float tr = re[q] * wr - im[q] * wi;
+                float ti = re[q] * wi + im[q] * wr;
+                re[q] = re[p] - tr;
+                im[q] = im[p] - ti;
+                re[p] += tr;
+                im[p] += ti;
+            }
+        }
+    }
+}
+
+/* Hann windowed spectrum of segment means, RMS magnitude in [dBV] */
+static void math_spectrum(rp_osc_math_t *m, float *out, const math_coeff_t *c,
+                          const int *a, const int *b, int in_idx, int step,
+                          float smpl_period)
+{
+    math_sums_t s;
+    double win_sum = 0;
+    int k;
+
+    for(k = 0; k < MATH_FFT_LEN; k++) {
+        math_sums(&s, c, a, b, in_idx + k * step, step);
+        m->fft_re[k] = m->fft_win[k] * math_sum_val(&s, c) / step;
+        m->fft_im[k] = 0;
+        win_sum += m->fft_win[k];
+    }
+    math_fft(m);
+
+    for(k = 0; k < SIGNAL_LENGTH; k++) {
+        double mag = sqrt(m->fft_re[k] * m->fft_re[k] + m->fft_im[k] * m->fft_im[k]);
+        /* Single sided, RMS of a sine - DC bin is not doubled */
+        mag = (k == 0) ? mag / win_sum : mag * M_SQRT2 / win_sum;
+        out[k] = (mag > 0) ? 20 * log10(mag) : MATH_FFT_MIN_DBV;
+        if(out[k] < MATH_FFT_MIN_DBV)
+            out[k] = MATH_FFT_MIN_DBV;
+    }
+    m->fft_df = 1.0 / (MATH_FFT_LEN * step * smpl_period);
+}
+
+
+/*----------------------------------------------------------------------------------*/
+float rp_osc_math_period(rp_osc_math_t *m, const int *in_signal, int in_idx, int step)
+{
+    float *re = m->fft_re, *im = m->fft_im;
+    double mean = 0, total = 0, peak_power = 0;
+    double a, b, c, den, delta;
+    int peak = 1;
+    int i, k;
+
+    /* Segment means - a boxcar filter against aliasing for step > 1 */
+    for(k = 0; k < MATH_FFT_LEN; k++) {
+        int sum = 0;
+        for(i = 0; i < step; i++)
+            sum += math_cnt(in_signal[(in_idx + k * step + i) % OSC_FPGA_SIG_LEN], 0);
+        re[k] = (float)sum / step;
+        mean += re[k];
+    }
+    mean /= MATH_FFT_LEN;
+    for(k = 0; k < MATH_FFT_LEN; k++) {
+        re[k] = m->fft_win[k] * (re[k] - mean);
+        im[k] = 0;
+    }
+    math_fft(m);
+
+    /* Power spectrum in place of the real part */
+    for(k = 1; k < SIGNAL_LENGTH; k++) {
+        re[k] = re[k] * re[k] + im[k] * im[k];
+        total += re[k];
+        if(re[k] > re[peak])
+            peak = k;
+    }
+    if((peak < MATH_PERIOD_MIN) || (peak >= SIGNAL_LENGTH - 1) || (total <= 0))
+        return 0;
+
+    /* Main lobe of the Hann window is +-2 bins */
+    for(k = peak - 2; k <= peak + 2; k++)
+        if((k > 0) && (k < SIGNAL_LENGTH))
+            peak_power += re[k];
+    if(peak_power < MATH_PERIOD_POWER * total)
+        return 0;
+
+    /* Parabolic interpolation of the log power */
+    a = log(re[peak - 1] + 1e-30);
+    b = log(re[peak]);
+    c = log(re[peak + 1] + 1e-30);
+    den = a - 2 * b + c;
+    delta = (den < 0) ? 0.5 * (a - c) / den : 0;
+    return (float)MATH_FFT_LEN * step / (peak + delta);
+}
+
+
+/*----------------------------------------------------------------------------------*/
+int rp_osc_math_calc(rp_osc_math_t *m, float *out_signal,
+                     int *cha_signal, int *chb_signal,
+                     const rp_osc_math_chan_t *cha, const rp_osc_math_chan_t *chb,
+                     int src, int func,
+                     float t_start, float t_stop, int dec_factor)
+{
+    float smpl_period = c_osc_fpga_smpl_period * dec_factor;
+    int t_start_idx, t_stop_idx, t_step;
+    int wr_ptr_curr, wr_ptr_trig;
+    int in_idx, out_idx;
+    math_coeff_t c;
+    math_sums_t s;
+    double acc, prev;
+
+    math_coeffs(&c, src, cha, chb);
+
+    /* Same window and step as rp_osc_decimate() */
+    if(t_stop <= t_start) {
+        t_start = 0;
+        t_stop = (OSC_FPGA_SIG_LEN-1) * smpl_period;
+    }
+    t_start_idx = round(t_start / smpl_period);
+    t_stop_idx  = round(t_stop / smpl_period);
+    if(((t_stop_idx-t_start_idx)/(float)(SIGNAL_LENGTH-1)) < 1)
+        t_step = 1;
+    else
+        t_step = round((t_stop_idx-t_start_idx)/(float)(SIGNAL_LENGTH-1));
+
+    osc_fpga_get_wr_ptr(&wr_ptr_curr, &wr_ptr_trig);
+    in_idx = wr_ptr_trig + t_start_idx - 3;
+
+    switch(func) {
+    case MATH_FUNC_INTEGRATE:
+        /* Integral from the window start, every sample contributes */
+        acc = 0;
+        for(out_idx = 0; out_idx < SIGNAL_LENGTH; out_idx++) {
+            out_signal[out_idx] = acc * smpl_period;
+            math_sums(&s, &c, cha_signal, chb_signal,
+                      in_idx + out_idx * t_step, t_step);
+            acc += math_sum_val(&s, &c);
+        }
+        break;
+
+    case MATH_FUNC_DIFF:
+        /* Difference of the segment means before and after each point, at
+         * full resolution this is the plain sample difference */
+        math_sums(&s, &c, cha_signal, chb_signal, in_idx - t_step, t_step);
+        prev = math_sum_val(&s, &c) / t_step;
+        for(out_idx = 0; out_idx < SIGNAL_LENGTH; out_idx++) {
+            math_sums(&s, &c, cha_signal, chb_signal,
+                      in_idx + out_idx * t_step, t_step);
+            acc = math_sum_val(&s, &c) / t_step;
+            out_signal[out_idx] = (acc - prev) / (t_step * smpl_period);
+            prev = acc;
+        }
+        break;
+
+    case MATH_FUNC_FFT:
+        /* Twice the displayed points over the same window */
+        math_spectrum(m, out_signal, &c, cha_signal, chb_signal, in_idx,
+                      (t_step > 1) ? t_step / 2 : 1, smpl_period);
+        break;
+
+    case MATH_FUNC_NONE:
+    default:
+        for(out_idx = 0; out_idx < SIGNAL_LENGTH; out_idx++) {
+            math_sums(&s, &c, cha_signal, chb_signal,
+                      in_idx + out_idx * t_step, 1);
+            out_signal[out_idx] = math_sum_val(&s, &c);
+        }
+        break;
+    }
+
+    return 0;
+}
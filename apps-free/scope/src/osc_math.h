@@ -0,0 +1,78 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya Oscilloscope math channel module.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef __OSC_MATH_H
+#define __OSC_MATH_H
+
+#include "main.h"
+
+/* Math source (first node of the expression) - math_src parameter */
+#define MATH_SRC_A          0
+#define MATH_SRC_B          1
+#define MATH_SRC_A_ADD_B    2
+#define MATH_SRC_A_SUB_B    3
+#define MATH_SRC_A_MUL_B    4
+
+/* Function applied to the source (second node) - math_func parameter */
+#define MATH_FUNC_NONE      0
+#define MATH_FUNC_INTEGRATE 1
+#define MATH_FUNC_DIFF      2
+#define MATH_FUNC_FFT       3
+
+/* FFT length, the output holds the lower half of the bins */
+#define MATH_FFT_LEN        (2 * SIGNAL_LENGTH)
+
+/* Period estimation - fewest periods in the analysed samples and the share
+ * of the AC power that makes the spectral peak dominant */
+#define MATH_PERIOD_MIN     3
+#define MATH_PERIOD_POWER   0.05
+
+/* Conversion of one channel from ADC counts, see osc_fpga_cnv_cnt_to_v() */
+typedef struct rp_osc_math_chan_s {
+    float max_adc_v;
+    int   calib_dc_off;
+    float user_dc_off;
+} rp_osc_math_chan_t;
+
+typedef struct rp_osc_math_s {
+    float *fft_re;      /* FFT buffers, scratch */
+    float *fft_im;
+    float *fft_win;     /* Hann window */
+    float *fft_cos;     /* twiddle factors */
+    float *fft_sin;
+    int   *fft_rev;     /* bit reversed indices */
+    float  fft_df;      /* bin width of the last FFT [Hz] */
+} rp_osc_math_t;
+
+int  rp_osc_math_init(rp_osc_math_t *m);
+void rp_osc_math_exit(rp_osc_math_t *m);
+
+/* Evaluates func(src) over the triggered frame in the time window
+ * [t_start, t_stop] (in [s] relative to the trigger) and writes
+ * SIGNAL_LENGTH points to out_signal. Time domain results share the time
+ * vector of the channels, the FFT result is in [dBV] with m->fft_df spacing.
+ */
+int  rp_osc_math_calc(rp_osc_math_t *m, float *out_signal,
+                      int *cha_signal, int *chb_signal,
+                      const rp_osc_math_chan_t *cha, const rp_osc_math_chan_t *chb,
+                      int src, int func,
+                      float t_start, float t_stop, int dec_factor);
+
+/* Dominant period of a raw channel in FPGA samples, from the spectrum of
+ * MATH_FFT_LEN means of step samples from in_idx on (circular). Returns 0
+ * without a dominant spectral peak or with less than MATH_PERIOD_MIN periods.
+ */
+float rp_osc_math_period(rp_osc_math_t *m, const int *in_signal, int in_idx, int step);
+
+#endif /* __OSC_MATH_H */
@@ -0,0 +1,302 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya Oscilloscope persistence (hit-count histogram) module.
+ *
+ * Every triggered frame is accumulated into a 2-D histogram per channel
+ * (time bins x voltage bins) of saturating 16 bit counters. The voltage bin
+ * is taken straight from the raw 14 bit ADC count, so accumulation needs no
+ * conversion to volts: flipping the sign bit turns two's complement into
+ * offset binary and the top bits are the bin. Bin indices of a frame are
+ * computed in a branch-free loop over contiguous buffer parts, which the
+ * compiler vectorizes, and then scatter-added in a separate loop.
+ *
+ * The histograms are only turned into images (8 bit BMP, logarithmic hit
+ * count scale) every PERSIST_IMG_PERIOD, independently of the trigger rate.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+
+#include "persist.h"
+#include "fpga.h"
+
+#define PERSIST_ADC_MASK    ((1 << 14) - 1)
+#define PERSIST_ADC_SIGN    (1 << 13)
+#define PERSIST_MAX_HITS    0xffff
+
+#define BMP_HEADER_SIZE     (14 + 40 + 256 * 4)
+
+/*----------------------------------------------------------------------------------*/
+int rp_osc_persist_init(rp_osc_persist_t *p)
+{
+    const int hist_size = PERSIST_TIME_BINS * PERSIST_VOLT_BINS;
+
+    memset(p, 0, sizeof(*p));
+    p->hist[0] = (uint16_t *)malloc(hist_size * sizeof(uint16_t));
+    p->hist[1] = (uint16_t *)malloc(hist_size * sizeof(uint16_t));
+    p->col = (int *)malloc(OSC_FPGA_SIG_LEN * sizeof(int));
+    p->idx = (int *)malloc(OSC_FPGA_SIG_LEN * sizeof(int));
+    /* rows are padded to 4 bytes */
+    p->img = (uint8_t *)malloc(BMP_HEADER_SIZE + (PERSIST_TIME_BINS + 3) * PERSIST_VOLT_BINS);
+    p->lut = (uint8_t *)malloc(PERSIST_MAX_HITS + 1);
+    if(!p->hist[0] || !p->hist[1] || !p->col || !p->idx || !p->img || !p->lut) {
+        fprintf(stderr, "rp_osc_persist_init(): malloc() failed\n");
+        rp_osc_persist_exit(p);
+        return -1;
+    }
+    p->img_idx = -1;
+    return rp_osc_persist_setup(p, 0, (OSC_FPGA_SIG_LEN-1) * c_osc_fpga_smpl_period, 1);
+}
+
+
+/*----------------------------------------------------------------------------------*/
+void rp_osc_persist_exit(rp_osc_persist_t *p)
+{
+    free(p->hist[0]);
+    free(p->hist[1]);
+    free(p->col);
+    free(p->idx);
+    free(p->img);
+    free(p->lut);
+    memset(p, 0, sizeof(*p));
+}
+
+
+/*----------------------------------------------------------------------------------*/
+int rp_osc_persist_setup(rp_osc_persist_t *p, float t_start, float t_stop,
+                         int dec_factor)
+{
+    float smpl_period = c_osc_fpga_smpl_period * dec_factor;
+    int k;
+
+    /* If illegal take whole frame, as rp_osc_decimate() */
+    if(t_stop <= t_start) {
+        t_start = 0;
+        t_stop = (OSC_FPGA_SIG_LEN-1) * smpl_period;
+    }
+    p->t_start_idx = round(t_start / smpl_period);
+    p->len = round(t_stop / smpl_period) - p->t_start_idx;
+    if(p->len < 1)
+        p->len = 1;
+    else if(p->len > OSC_FPGA_SIG_LEN)
+        p->len = OSC_FPGA_SIG_LEN;
+
+    /* Short windows get one column per sample */
+    p->width = (p->len < PERSIST_TIME_BINS) ? p->len : PERSIST_TIME_BINS;
+    for(k = 0; k < p->len; k++)
+        p->col[k] = (k * p->width) / p->len;
+
+    rp_osc_persist_clear(p);
+    return 0;
+}
+
+
+/*----------------------------------------------------------------------------------*/
+void rp_osc_persist_clear(rp_osc_persist_t *p)
+{
+    const int hist_size = PERSIST_TIME_BINS * PERSIST_VOLT_BINS;
+
+    memset(p->hist[0], 0, hist_size * sizeof(uint16_t));
+    memset(p->hist[1], 0, hist_size * sizeof(uint16_t));
+    p->frames = 0;
+    clock_gettime(CLOCK_MONOTONIC, &p->img_time);
+}
+
+
+/*----------------------------------------------------------------------------------*/
+static void persist_add_channel(rp_osc_persist_t *p, uint16_t *hist,
+                                const int *in_signal, int in_idx)
+{
+    const int *col = p->col;
+    int *idx = p->idx;
+    int width = p->width;
+    int n = 0;
+    int k;
+
+    /* Histogram indices - the circular buffer is split in contiguous parts
+     * so that the loop has no wrap-around check and vectorizes */
+    while(n < p->len) {
+        int part = OSC_FPGA_SIG_LEN - in_idx;
+        const int *s = &in_signal[in_idx];
+        if(part > p->len - n)
+            part = p->len - n;
+
+        for(k = 0; k < part; k++) {
+            int v_bin = ((s[k] & PERSIST_ADC_MASK) ^ PERSIST_ADC_SIGN) >> PERSIST_VOLT_SHIFT;
+            idx[n + k] = v_bin * width + col[n + k];
+        }
+        n += part;
+        in_idx = 0;
+    }
+
+    /* Saturating scatter-add */
+    for(k = 0; k < p->len; k++) {
+        uint16_t *h = &hist[idx[k]];
+        *h += (*h != PERSIST_MAX_HITS);
+    }
+}
+
+
+/*----------------------------------------------------------------------------------*/
+void rp_osc_persist_add(rp_osc_persist_t *p, int *cha_signal, int *chb_signal)
+{
+    int wr_ptr_curr, wr_ptr_trig;
+    int in_idx;
+
+    /* Same window start as rp_osc_decimate() */
+    osc_fpga_get_wr_ptr(&wr_ptr_curr, &wr_ptr_trig);
+    in_idx = (wr_ptr_trig + p->t_start_idx - 3) % OSC_FPGA_SIG_LEN;
+    if(in_idx < 0)
+        in_idx += OSC_FPGA_SIG_LEN;
+
+    persist_add_channel(p, p->hist[0], cha_signal, in_idx);
+    persist_add_channel(p, p->hist[1], chb_signal, in_idx);
+    p->frames++;
+}
+
+
+/*----------------------------------------------------------------------------------*/
+int rp_osc_persist_due(rp_osc_persist_t *p)
+{
+    struct timespec now;
+    long long elapsed_us;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    elapsed_us = (now.tv_sec - p->img_time.tv_sec) * 1000000LL +
+        (now.tv_nsec - p->img_time.tv_nsec) / 1000;
+    return (elapsed_us >= PERSIST_IMG_PERIOD);
+}
+
+
+/*----------------------------------------------------------------------------------*/
+static void persist_put_u16(uint8_t *b, uint16_t v)
+{
+    b[0] = v & 0xff;
+    b[1] = v >> 8;
+}
+
+static void persist_put_u32(uint8_t *b, uint32_t v)
+{
+    persist_put_u16(b, v & 0xffff);
+    persist_put_u16(b + 2, v >> 16);
+}
+
+/* Writes 8 bit BMP header with a black-red-yellow-white palette */
+static int persist_bmp_header(uint8_t *b, int width, int height)
+{
+    int stride = (width + 3) & ~3;
+    int i;
+
+    memset(b, 0, BMP_HEADER_SIZE);
+    b[0] = 'B';
+    b[1] = 'M';
+    persist_put_u32(&b[2], BMP_HEADER_SIZE + stride * height);
+    persist_put_u32(&b[10], BMP_HEADER_SIZE);
+    persist_put_u32(&b[14], 40);
+    persist_put_u32(&b[18], width);
+    persist_put_u32(&b[22], height); /* positive - bottom row first */
+    persist_put_u16(&b[26], 1);
+    persist_put_u16(&b[28], 8);
+    persist_put_u32(&b[34], stride * height);
+    persist_put_u32(&b[46], 256);
+
+    for(i = 0; i < 256; i++) {
+        uint8_t *c = &b[54 + 4 * i];
+        int r = 3 * i, g = 3 * i - 255, bl = 3 * i - 510;
+        c[0] = (bl < 0) ? 0 : bl;
+        c[1] = (g < 0) ? 0 : ((g > 255) ? 255 : g);
+        c[2] = (r > 255) ? 255 : r;
+    }
+    return stride;
+}
+
+static int persist_write_image(rp_osc_persist_t *p, uint16_t *hist, int ch, int img_idx)
+{
+    char fname[64], tmp_fname[64];
+    int stride = persist_bmp_header(p->img, p->width, PERSIST_VOLT_BINS);
+    uint8_t *rows = p->img + BMP_HEADER_SIZE;
+    int size = BMP_HEADER_SIZE + stride * PERSIST_VOLT_BINS;
+    int max = 0;
+    int x, y;
+    FILE *fp;
+
+    for(y = 0; y < PERSIST_VOLT_BINS; y++)
+        for(x = 0; x < p->width; x++)
+            if(hist[y * p->width + x] > max)
+                max = hist[y * p->width + x];
+
+    /* Logarithmic scale, any hit is visible */
+    p->lut[0] = 0;
+    for(x = 1; x <= max; x++)
+        p->lut[x] = (max == 1) ? 255 : 1 + round(254 * log(x) / log(max));
+
+    for(y = 0; y < PERSIST_VOLT_BINS; y++) {
+        uint8_t *row = &rows[y * stride];
+        for(x = 0; x < p->width; x++)
+            row[x] = p->lut[hist[y * p->width + x]];
+        for(; x < stride; x++)
+            row[x] = 0;
+    }
+
+    /* Rename, so that the client never reads a partial file */
+    sprintf(fname, "%s%01d_%03d.bmp", PERSIST_IMG_PATH, ch, img_idx);
+    sprintf(tmp_fname, "%s%01d.tmp", PERSIST_IMG_PATH, ch);
+    fp = fopen(tmp_fname, "wb");
+    if(fp == NULL) {
+        fprintf(stderr, "persist_write_image() can not open file (%s): %s\n",
+                tmp_fname, strerror(errno));
+        return -1;
+    }
+    if(fwrite(p->img, 1, size, fp) != size) {
+        fprintf(stderr, "persist_write_image() write failed (%s): %s\n",
+                tmp_fname, strerror(errno));
+        fclose(fp);
+        return -1;
+    }
+    fclose(fp);
+    if(rename(tmp_fname, fname) < 0) {
+        fprintf(stderr, "persist_write_image() rename failed (%s): %s\n",
+                fname, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+
+/*----------------------------------------------------------------------------------*/
+int rp_osc_persist_save(rp_osc_persist_t *p, int decay_shift)
+{
+    int img_idx = (p->img_idx + 1) % (PERSIST_IMG_MAX + 1);
+    int ch, k;
+
+    clock_gettime(CLOCK_MONOTONIC, &p->img_time);
+
+    if((persist_write_image(p, p->hist[0], 1, img_idx) < 0) ||
+       (persist_write_image(p, p->hist[1], 2, img_idx) < 0))
+        return -1;
+    p->img_idx = img_idx;
+
+    /* Decay after the image - at least by one, so that rare hits fade out too */
+    if(decay_shift > 0) {
+        for(ch = 0; ch < 2; ch++) {
+            uint16_t *h = p->hist[ch];
+            for(k = 0; k < PERSIST_VOLT_BINS * p->width; k++) {
+                int d = h[k] >> decay_shift;
+                h[k] -= d ? d : (h[k] != 0);
+            }
+        }
+    }
+    return img_idx;
+}
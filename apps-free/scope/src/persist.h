@@ -0,0 +1,69 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya Oscilloscope persistence (hit-count histogram) module.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef __PERSIST_H
+#define __PERSIST_H
+
+#include <stdint.h>
+#include <time.h>
+
+/* Histogram geometry - time bins across the displayed window, voltage bins
+ * across the full ADC range (14 bit counts >> PERSIST_VOLT_SHIFT)
+ */
+#define PERSIST_TIME_BINS   512
+#define PERSIST_VOLT_SHIFT  6
+#define PERSIST_VOLT_BINS   (1 << (14 - PERSIST_VOLT_SHIFT))
+
+/* Images are written (and decayed) every PERSIST_IMG_PERIOD [us] */
+#define PERSIST_IMG_PERIOD  200000
+/* Image files: PERSIST_IMG_PATH + [1|2] + _ + index (3 digits) + .bmp */
+#define PERSIST_IMG_PATH    "/tmp/ram/pers"
+#define PERSIST_IMG_MAX     63
+
+typedef struct rp_osc_persist_s {
+    uint16_t *hist[2];  /* hit counts [volt bin][time bin], row 0 most negative */
+    int      *col;      /* time bin of every sample in the window */
+    int      *idx;      /* histogram index of every sample, scratch */
+    uint8_t  *img;      /* image rows, scratch */
+    uint8_t  *lut;      /* hit count to pixel map, scratch */
+    int       width;    /* time bins in use, at most PERSIST_TIME_BINS */
+    int       len;      /* window length in FPGA samples */
+    int       t_start_idx;
+    uint32_t  frames;   /* frames accumulated since the last clear */
+    int       img_idx;  /* index of the last written image pair, -1 none */
+    struct timespec img_time;
+} rp_osc_persist_t;
+
+int  rp_osc_persist_init(rp_osc_persist_t *p);
+void rp_osc_persist_exit(rp_osc_persist_t *p);
+
+/* Sets up the time window [t_start, t_stop] (in [s] relative to the trigger)
+ * and clears the histograms
+ */
+int  rp_osc_persist_setup(rp_osc_persist_t *p, float t_start, float t_stop,
+                          int dec_factor);
+void rp_osc_persist_clear(rp_osc_persist_t *p);
+
+/* Accumulates the triggered frame from the FPGA buffers */
+void rp_osc_persist_add(rp_osc_persist_t *p, int *cha_signal, int *chb_signal);
+
+/* Returns 1 when the next image is due */
+int  rp_osc_persist_due(rp_osc_persist_t *p);
+
+/* Decays the histograms by 1/2^decay_shift (0 - no decay) and writes them
+ * as images, returns the index of the written image pair or -1
+ */
+int  rp_osc_persist_save(rp_osc_persist_t *p, int decay_shift);
+
+#endif /* __PERSIST_H */
@@ -23,9 +23,12 @@
 
 #include "worker.h"
 #include "fpga.h"
+#include "persist.h"
+#include "osc_math.h"
 
 pthread_t *rp_osc_thread_handler = NULL;
 void *rp_osc_worker_thread(void *args);
+int rp_osc_adc_sign(int in_data);
 
 pthread_mutex_t       rp_osc_ctrl_mutex = PTHREAD_MUTEX_INITIALIZER;
 rp_osc_worker_state_t rp_osc_ctrl;
@@ -45,6 +48,12 @@ int                  *rp_fpga_cha_signal, *rp_fpga_chb_signal;
 /* Calibration parameters read from EEPROM */
 rp_calib_params_t *rp_calib_params = NULL;
 
+/* Persistence histograms, used only from worker */
+rp_osc_persist_t    rp_osc_persist;
+
+/* Math channel buffers, used only from worker */
+rp_osc_math_t       rp_osc_math;
+
 
 /*----------------------------------------------------------------------------------*/
 int rp_osc_worker_init(rp_app_params_t *params, int params_len,
@@ -78,6 +87,21 @@ int rp_osc_worker_init(rp_app_params_t *params, int params_len,
 
     osc_fpga_get_sig_ptr(&rp_fpga_cha_signal, &rp_fpga_chb_signal);
 
+    if(rp_osc_persist_init(&rp_osc_persist) < 0) {
+        osc_fpga_exit();
+        rp_cleanup_signals(&rp_osc_signals);
+        rp_cleanup_signals(&rp_tmp_signals);
+        return -1;
+    }
+
+    if(rp_osc_math_init(&rp_osc_math) < 0) {
+        rp_osc_persist_exit(&rp_osc_persist);
+        osc_fpga_exit();
+        rp_cleanup_signals(&rp_osc_signals);
+        rp_cleanup_signals(&rp_tmp_signals);
+        return -1;
+    }
+
     rp_osc_thread_handler = (pthread_t *)malloc(sizeof(pthread_t));
     if(rp_osc_thread_handler == NULL) {
         rp_cleanup_signals(&rp_osc_signals);
@@ -119,6 +143,8 @@ int rp_osc_worker_exit(void)
 
     rp_cleanup_signals(&rp_osc_signals);
     rp_cleanup_signals(&rp_tmp_signals);
+    rp_osc_persist_exit(&rp_osc_persist);
+    rp_osc_math_exit(&rp_osc_math);
 
     rp_clean_params(rp_osc_params);
 
@@ -187,6 +213,7 @@ int rp_osc_get_signals(float ***signals, int *sig_idx)
     memcpy(&s[0][0], &rp_osc_signals[0][0], sizeof(float)*SIGNAL_LENGTH);
     memcpy(&s[1][0], &rp_osc_signals[1][0], sizeof(float)*SIGNAL_LENGTH);
     memcpy(&s[2][0], &rp_osc_signals[2][0], sizeof(float)*SIGNAL_LENGTH);
+    memcpy(&s[3][0], &rp_osc_signals[3][0], sizeof(float)*SIGNAL_LENGTH);
 
     *sig_idx = rp_osc_sig_last_idx;
 
@@ -204,6 +231,7 @@ int rp_osc_set_signals(float **source, int index)
     memcpy(&rp_osc_signals[0][0], &source[0][0], sizeof(float)*SIGNAL_LENGTH);
     memcpy(&rp_osc_signals[1][0], &source[1][0], sizeof(float)*SIGNAL_LENGTH);
     memcpy(&rp_osc_signals[2][0], &source[2][0], sizeof(float)*SIGNAL_LENGTH);
+    memcpy(&rp_osc_signals[3][0], &source[3][0], sizeof(float)*SIGNAL_LENGTH);
     rp_osc_sig_last_idx = index;
 
     rp_osc_signals_dirty = 1;
@@ -240,6 +268,15 @@ void *rp_osc_worker_thread(void *args)
     int long_acq_step = 0;
     int long_acq_init_trig_ptr;
 
+    /* Roll mode - long acquisition in auto mode, no trigger and no gaps */
+    rp_osc_roll_t roll;
+    int roll_active = 0;
+
+    /* Persistence - every frame is accumulated, signals and images are
+     * only published every PERSIST_IMG_PERIOD */
+    int persist_on = 0;
+    int math_on = 0;
+
     rp_osc_meas_res_t ch1_meas, ch2_meas;
     float ch1_max_adc_v = 1, ch2_max_adc_v = 1;
     float max_adc_norm = osc_fpga_calc_adc_max_v(rp_calib_params->fe_ch1_fs_g_hi, 0);
@@ -337,6 +374,7 @@ void *rp_osc_worker_thread(void *args)
         }
 
         if(state == rp_osc_idle_state) {
+            roll_active = 0;
             usleep(10000);
             continue;
         }
@@ -355,6 +393,19 @@ void *rp_osc_worker_thread(void *args)
 
             time_vect_update = 0;
 
+            /* New window or scale - start accumulating from scratch */
+            persist_on = (curr_params[PERSIST_MODE].value == 1);
+            if(persist_on) {
+                rp_osc_persist_setup(&rp_osc_persist,
+                                     curr_params[MIN_GUI_PARAM].value,
+                                     curr_params[MAX_GUI_PARAM].value,
+                                     dec_factor);
+            }
+
+            /* Math channel stays zero when off and in long acquisitions */
+            math_on = (curr_params[MATH_EN].value == 1);
+            memset(rp_tmp_signals[3], 0, SIGNAL_LENGTH * sizeof(float));
+
             /* check if we have long acquisition - if yes the algorithm 
              * (wait for pre-defined time and return partial signal) */
             /* TODO: Make it programmable */
@@ -373,7 +424,50 @@ void *rp_osc_worker_thread(void *args)
                 long_acq = 0;
             }
             long_acq_idx = 0;
+            roll_active = 0;
+        }
+
+        if(long_acq && (state == rp_osc_auto_state)) {
+            /* Roll mode - the FPGA keeps writing (armed, but never triggered)
+             * and only samples written since the last pass are processed */
+            if(!roll_active) {
+                osc_fpga_arm_trigger();
+                rp_osc_roll_init(&roll, (float **)&rp_tmp_signals[1],
+                                 (float **)&rp_tmp_signals[2],
+                                 (float **)&rp_tmp_signals[0], dec_factor,
+                                 curr_params[MIN_GUI_PARAM].value,
+                                 curr_params[MAX_GUI_PARAM].value,
+                                 curr_params[TIME_UNIT_PARAM].value);
+                rp_osc_meas_clear(&ch1_meas);
+                rp_osc_meas_clear(&ch2_meas);
+                roll_active = 1;
+            }
+
+            if(rp_osc_roll_update(&roll, (float **)&rp_tmp_signals[1],
+                                  &rp_fpga_cha_signal[0],
+                                  (float **)&rp_tmp_signals[2],
+                                  &rp_fpga_chb_signal[0],
+                                  &ch1_meas, &ch2_meas,
+                                  ch1_max_adc_v, ch2_max_adc_v,
+                                  curr_params[GEN_DC_OFFS_1].value,
+                                  curr_params[GEN_DC_OFFS_2].value) > 0) {
+                /* Measurements cover the samples since the last update */
+                rp_osc_meas_avg_amp(&ch1_meas, roll.meas_len);
+                rp_osc_meas_avg_amp(&ch2_meas, roll.meas_len);
+                rp_osc_meas_convert(&ch1_meas, ch1_max_adc_v, rp_calib_params->fe_ch1_dc_offs);
+                rp_osc_meas_convert(&ch2_meas, ch2_max_adc_v, rp_calib_params->fe_ch2_dc_offs);
+                rp_osc_set_meas_data(ch1_meas, ch2_meas);
+                rp_osc_meas_clear(&ch1_meas);
+                rp_osc_meas_clear(&ch2_meas);
+                roll.meas_len = 0;
+
+                /* Signals are marked dirty only when columns were added */
+                rp_osc_set_signals(rp_tmp_signals, SIGNAL_LENGTH-1);
+            }
+            usleep(10000);
+            continue;
         }
+        roll_active = 0;
 
         /* Start new acquisition only if it is the index 0 (new acquisition) */
         if(long_acq_idx == 0) {
@@ -495,6 +589,19 @@ void *rp_osc_worker_thread(void *args)
         if((state != old_state) || params_dirty)
             continue;
 
+        if(!long_acq && persist_on) {
+            rp_osc_persist_add(&rp_osc_persist, &rp_fpga_cha_signal[0],
+                               &rp_fpga_chb_signal[0]);
+            /* Re-arm right away, the client does not see every frame */
+            if(!rp_osc_persist_due(&rp_osc_persist) &&
+               (state != rp_osc_single_state))
+                continue;
+            rp_osc_persist_save(&rp_osc_persist,
+                                curr_params[PERSIST_DECAY].value);
+            rp_update_persist_data(rp_osc_persist.img_idx,
+                                   ch1_max_adc_v, ch2_max_adc_v);
+        }
+
         if(!long_acq) {
             /* Triggered, decimate & convert the values */
             rp_osc_meas_clear(&ch1_meas);
@@ -508,6 +615,24 @@ void *rp_osc_worker_thread(void *args)
                             &ch1_meas, &ch2_meas, ch1_max_adc_v, ch2_max_adc_v,
                             curr_params[GEN_DC_OFFS_1].value,
                             curr_params[GEN_DC_OFFS_2].value);
+
+            if(math_on) {
+                rp_osc_math_chan_t cha = { ch1_max_adc_v,
+                                           rp_calib_params->fe_ch1_dc_offs,
+                                           curr_params[GEN_DC_OFFS_1].value };
+                rp_osc_math_chan_t chb = { ch2_max_adc_v,
+                                           rp_calib_params->fe_ch2_dc_offs,
+                                           curr_params[GEN_DC_OFFS_2].value };
+                rp_osc_math_calc(&rp_osc_math, rp_tmp_signals[3],
+                                 &rp_fpga_cha_signal[0], &rp_fpga_chb_signal[0],
+                                 &cha, &chb, curr_params[MATH_SRC].value,
+                                 curr_params[MATH_FUNC].value,
+                                 curr_params[MIN_GUI_PARAM].value,
+                                 curr_params[MAX_GUI_PARAM].value,
+                                 dec_factor);
+                if(curr_params[MATH_FUNC].value == MATH_FUNC_FFT)
+                    rp_update_math_data(rp_osc_math.fft_df);
+            }
         } else {
             long_acq_idx = rp_osc_decimate_partial((float **)&rp_tmp_signals[1], 
                                              &rp_fpga_cha_signal[0], 
@@ -770,6 +895,120 @@ int rp_osc_decimate_partial(float **cha_out_signal, int *cha_in_signal,
 }
 
 
+/*----------------------------------------------------------------------------------*/
+int rp_osc_roll_init(rp_osc_roll_t *roll,
+                     float **cha_signal, float **chb_signal,
+                     float **time_signal, int dec_factor,
+                     float t_start, float t_stop, int time_unit)
+{
+    float smpl_period = c_osc_fpga_smpl_period * dec_factor;
+    int   t_unit_factor = rp_osc_get_time_unit_factor(time_unit);
+    float *t = *time_signal;
+    int   col;
+
+    roll->col_len = ceil((t_stop - t_start) / smpl_period / ROLL_COLUMNS);
+    if(roll->col_len < 1)
+        roll->col_len = 1;
+    roll->col_fill = 0;
+    roll->meas_len = 0;
+    osc_fpga_get_wr_ptr(&roll->rd_ptr, NULL);
+
+    /* Both points of a column share its time, the newest column is last */
+    for(col = 0; col < ROLL_COLUMNS; col++) {
+        float t_col = t_stop - (ROLL_COLUMNS-1-col) * roll->col_len * smpl_period;
+        t[2*col] = t[2*col+1] = t_col * t_unit_factor;
+    }
+
+    memset(*cha_signal, 0, SIGNAL_LENGTH * sizeof(float));
+    memset(*chb_signal, 0, SIGNAL_LENGTH * sizeof(float));
+
+    return 0;
+}
+
+
+/*----------------------------------------------------------------------------------*/
+int rp_osc_roll_update(rp_osc_roll_t *roll,
+                       float **cha_signal, int *cha_in_signal,
+                       float **chb_signal, int *chb_in_signal,
+                       rp_osc_meas_res_t *ch1_meas,
+                       rp_osc_meas_res_t *ch2_meas,
+                       float ch1_max_adc_v, float ch2_max_adc_v,
+                       float ch1_user_dc_off, float ch2_user_dc_off)
+{
+    float *cha_s = *cha_signal;
+    float *chb_s = *chb_signal;
+    float  cha_new[SIGNAL_LENGTH], chb_new[SIGNAL_LENGTH];
+    int    new_cols = 0;
+    int    wr_ptr, avail, max_avail;
+
+    osc_fpga_get_wr_ptr(&wr_ptr, NULL);
+    avail = (wr_ptr - roll->rd_ptr + OSC_FPGA_SIG_LEN) % OSC_FPGA_SIG_LEN;
+
+    /* Samples which would scroll out of the display anyway are skipped */
+    max_avail = ROLL_COLUMNS * roll->col_len;
+    if(avail > max_avail) {
+        roll->rd_ptr = (roll->rd_ptr + avail - max_avail) % OSC_FPGA_SIG_LEN;
+        roll->col_fill = 0;
+        avail = max_avail;
+    }
+
+    for(; avail > 0; avail--) {
+        int cha = rp_osc_adc_sign(cha_in_signal[roll->rd_ptr]);
+        int chb = rp_osc_adc_sign(chb_in_signal[roll->rd_ptr]);
+
+        rp_osc_meas_min_max(ch1_meas, cha_in_signal[roll->rd_ptr]);
+        rp_osc_meas_min_max(ch2_meas, chb_in_signal[roll->rd_ptr]);
+        roll->meas_len++;
+
+        if(roll->col_fill == 0) {
+            roll->cha_min = roll->cha_max = cha;
+            roll->chb_min = roll->chb_max = chb;
+        } else {
+            roll->cha_min = (cha < roll->cha_min) ? cha : roll->cha_min;
+            roll->cha_max = (cha > roll->cha_max) ? cha : roll->cha_max;
+            roll->chb_min = (chb < roll->chb_min) ? chb : roll->chb_min;
+            roll->chb_max = (chb > roll->chb_max) ? chb : roll->chb_max;
+        }
+
+        if(++roll->rd_ptr >= OSC_FPGA_SIG_LEN)
+            roll->rd_ptr = 0;
+        if(++roll->col_fill < roll->col_len)
+            continue;
+
+        /* Column complete - back to ADC counts for the conversion */
+        roll->col_fill = 0;
+        cha_new[2*new_cols] =
+            osc_fpga_cnv_cnt_to_v(roll->cha_min & ((1<<c_osc_fpga_adc_bits)-1),
+                                  ch1_max_adc_v, rp_calib_params->fe_ch1_dc_offs,
+                                  ch1_user_dc_off);
+        cha_new[2*new_cols+1] =
+            osc_fpga_cnv_cnt_to_v(roll->cha_max & ((1<<c_osc_fpga_adc_bits)-1),
+                                  ch1_max_adc_v, rp_calib_params->fe_ch1_dc_offs,
+                                  ch1_user_dc_off);
+        chb_new[2*new_cols] =
+            osc_fpga_cnv_cnt_to_v(roll->chb_min & ((1<<c_osc_fpga_adc_bits)-1),
+                                  ch2_max_adc_v, rp_calib_params->fe_ch2_dc_offs,
+                                  ch2_user_dc_off);
+        chb_new[2*new_cols+1] =
+            osc_fpga_cnv_cnt_to_v(roll->chb_max & ((1<<c_osc_fpga_adc_bits)-1),
+                                  ch2_max_adc_v, rp_calib_params->fe_ch2_dc_offs,
+                                  ch2_user_dc_off);
+        new_cols++;
+    }
+
+    if(new_cols == 0)
+        return 0;
+
+    /* Scroll once by all new columns and append them on the right */
+    memmove(&cha_s[0], &cha_s[2*new_cols], (SIGNAL_LENGTH - 2*new_cols) * sizeof(float));
+    memmove(&chb_s[0], &chb_s[2*new_cols], (SIGNAL_LENGTH - 2*new_cols) * sizeof(float));
+    memcpy(&cha_s[SIGNAL_LENGTH - 2*new_cols], cha_new, 2*new_cols * sizeof(float));
+    memcpy(&chb_s[SIGNAL_LENGTH - 2*new_cols], chb_new, 2*new_cols * sizeof(float));
+
+    return new_cols;
+}
+
+
 /*----------------------------------------------------------------------------------*/
 int rp_osc_get_time_unit_factor(int time_unit)
 {
@@ -795,6 +1034,83 @@ int rp_osc_get_time_unit_factor(int time_unit)
 }
 
 
+/*----------------------------------------------------------------------------------*/
+/* Acquisition with immediate trigger for the auto-set, returns -1 when aborted
+ * by a change of state or parameters */
+static int rp_osc_auto_capture(int time_range, int en_avg_at_dec,
+                               float ch1_max_adc_v, float ch2_max_adc_v,
+                               int ch1_probe_att, int ch2_probe_att,
+                               int ch1_gain, int ch2_gain)
+{
+    rp_osc_worker_state_t old_state, state;
+    int params_dirty;
+
+    pthread_mutex_lock(&rp_osc_ctrl_mutex);
+    old_state = rp_osc_ctrl;
+    pthread_mutex_unlock(&rp_osc_ctrl_mutex);
+
+    osc_fpga_reset();
+    osc_fpga_update_params(1, 0, 0, 0, 0, time_range, ch1_max_adc_v, ch2_max_adc_v,
+                           rp_calib_params->fe_ch1_dc_offs,
+                           0,
+                           rp_calib_params->fe_ch2_dc_offs,
+                           0,
+                           ch1_probe_att, ch2_probe_att, ch1_gain, ch2_gain, en_avg_at_dec);
+
+    /* ARM & Trigger */
+    osc_fpga_arm_trigger();
+    osc_fpga_set_trigger(1);
+
+    /* Wait for trigger to finish */
+    while(1) {
+        pthread_mutex_lock(&rp_osc_ctrl_mutex);
+        state = rp_osc_ctrl;
+        params_dirty = rp_osc_params_dirty;
+        pthread_mutex_unlock(&rp_osc_ctrl_mutex);
+        /* change in state, abort polling */
+        if((state != old_state) || params_dirty) {
+            return -1;
+        }
+        if(osc_fpga_triggered()) {
+            break;
+        }
+        usleep(500);
+    }
+    return 0;
+}
+
+/* Min/max over the whole buffer, in counts with the calibrated offset */
+static void rp_osc_auto_min_max(const int *in_signal, int calib_dc_off,
+                                int *min, int *max)
+{
+    int smpl_cnt;
+
+    for(smpl_cnt = 0; smpl_cnt < OSC_FPGA_SIG_LEN; smpl_cnt++) {
+        int smpl = rp_osc_adc_sign(in_signal[smpl_cnt]) + calib_dc_off;
+        *max = (*max < smpl) ? smpl : *max;
+        *min = (*min > smpl) ? smpl : *min;
+    }
+}
+
+/* Dominant period [s] of the last acquisition, 0 if not found. The first
+ * MATH_FFT_LEN samples are analysed at the full rate, which covers the fast
+ * signals without aliasing; only if that fails the whole buffer is analysed
+ * as means of 8 samples, for the signals too slow for the short window. */
+static float rp_osc_auto_period(const int *in_signal, int time_range)
+{
+    const int c_step = OSC_FPGA_SIG_LEN / MATH_FFT_LEN;
+    int wr_ptr_curr, wr_ptr_trig;
+    float period;
+
+    osc_fpga_get_wr_ptr(&wr_ptr_curr, &wr_ptr_trig);
+    period = rp_osc_math_period(&rp_osc_math, in_signal, wr_ptr_trig, 1);
+    if(period == 0)
+        period = rp_osc_math_period(&rp_osc_math, in_signal, wr_ptr_trig, c_step);
+
+    return period * c_osc_fpga_smpl_period * osc_fpga_cnv_time_range_to_dec(time_range);
+}
+
+
 /*----------------------------------------------------------------------------------*/
 int rp_osc_auto_set(rp_app_params_t *orig_params, 
                     float ch1_max_adc_v, float ch2_max_adc_v,
@@ -802,121 +1118,53 @@ int rp_osc_auto_set(rp_app_params_t *orig_params,
                     int ch1_probe_att, int ch2_probe_att, int ch1_gain, int ch2_gain, int en_avg_at_dec)
 {
     const int c_noise_thr = 500; /* noise threshold */
-    rp_osc_worker_state_t old_state, state;
-    int params_dirty;
+    /* Acquisitions: full rate first, 130 ms (D = 1024) with averaging only
+     * if the signal is too slow for it */
+    const int c_time_range[2] = { 0, 3 };
+    const int c_avg[2]        = { 0, 1 };
+    const int calib_dc_off[2] = { rp_calib_params->fe_ch1_dc_offs,
+                                  rp_calib_params->fe_ch2_dc_offs };
+    int *sig_data[2] = { rp_fpga_cha_signal, rp_fpga_chb_signal };
     /* Min/maxes from both channel */
-    int max_cha = INT_MIN;
-    int max_chb = INT_MIN;
-    int min_cha = INT_MAX;
-    int min_chb = INT_MAX;
+    int max_ch[2] = { INT_MIN, INT_MIN };
+    int min_ch[2] = { INT_MAX, INT_MAX };
     /* Y axis deltas, 0 - ChA, 1 - Chb */
-    int dy[2]     = { 0, 0 };
-    int old_dy[2] = { 0, 0 };
+    int dy[2] = { 0, 0 };
+    int min_y, max_y, ave_y;
+    float period = 0;
 
     /* Channel to be used for auto-algorithm:
      * 0 - Channel A 
      * 1 - Channel B 
      */
-    int channel; 
-    int smpl_cnt;
-    int iter;
-    int time_range = 0;
-
-    for (iter=0; iter < 10; iter++) {
-        /* 10 auto-trigger acquisitions */
-        pthread_mutex_lock(&rp_osc_ctrl_mutex);
-        old_state = state = rp_osc_ctrl;
-        pthread_mutex_unlock(&rp_osc_ctrl_mutex);
-
-        osc_fpga_reset();
-        osc_fpga_update_params(1, 0, 0, 0, 0, time_range, ch1_max_adc_v, ch2_max_adc_v,
-                   rp_calib_params->fe_ch1_dc_offs,
-                   0,
-                   rp_calib_params->fe_ch2_dc_offs,
-                   0,
-                   ch1_probe_att, ch2_probe_att, ch1_gain, ch2_gain, 0);
-
-        /* ARM & Trigger */
-        osc_fpga_arm_trigger();
-        osc_fpga_set_trigger(1);
-
-        /* Wait for trigger to finish */
-        while(1) {
-            pthread_mutex_lock(&rp_osc_ctrl_mutex);
-            state = rp_osc_ctrl;
-            params_dirty = rp_osc_params_dirty;
-            pthread_mutex_unlock(&rp_osc_ctrl_mutex);
-            /* change in state, abort polling */
-            if((state != old_state) || params_dirty) {
-                return -1;
-            }
-            if(osc_fpga_triggered()) {
-                break;
-            }
-            usleep(500);
-        }
+    int channel = 0;
+    int acq, i;
 
-        /* Get the signals - available at rp_fpga_chX_signal vectors */
-        for(smpl_cnt = 0; smpl_cnt < OSC_FPGA_SIG_LEN; smpl_cnt++) {
-            int cha_smpl = rp_fpga_cha_signal[smpl_cnt];
-            int chb_smpl = rp_fpga_chb_signal[smpl_cnt];
-
-            // TWO'S COMPLEMENT
-            if(cha_smpl & (1<<(c_osc_fpga_adc_bits-1)))
-                cha_smpl = -1 * ((cha_smpl ^ ((1<<c_osc_fpga_adc_bits)-1))+1);
-            if(chb_smpl & (1<<(c_osc_fpga_adc_bits-1)))
-                chb_smpl = -1 * ((chb_smpl ^ ((1<<c_osc_fpga_adc_bits)-1))+1);
-
-            cha_smpl = cha_smpl + rp_calib_params->fe_ch1_dc_offs;
-            chb_smpl = chb_smpl + rp_calib_params->fe_ch2_dc_offs;
-
-            /* Get min/maxes */
-            max_cha = (max_cha < cha_smpl) ? cha_smpl : max_cha;
-            min_cha = (min_cha > cha_smpl) ? cha_smpl : min_cha;
-            max_chb = (max_chb < chb_smpl) ? chb_smpl : max_chb;
-            min_chb = (min_chb > chb_smpl) ? chb_smpl : min_chb;
-        }
+    for(acq = 0; acq < 2; acq++) {
+        if(rp_osc_auto_capture(c_time_range[acq], c_avg[acq],
+                               ch1_max_adc_v, ch2_max_adc_v,
+                               ch1_probe_att, ch2_probe_att, ch1_gain, ch2_gain) < 0)
+            return -1;
 
-        dy[0] = max_cha - min_cha;
-        dy[1] = max_chb - min_chb;
-
-        /* Calculate ratios of last amplitude increase for both channels */
-        const float c_inc_thr = 1.1;
-        float ratio[2] = { 1e6, 1e6 };
-        int i;
         for(i = 0; i < 2; i++) {
-            if (old_dy[i] != 0) {
-                ratio[i] = (float)dy[i] / (float)old_dy[i];
-            }
-        }
-        old_dy[0] = dy[0];
-        old_dy[1] = dy[1];
-
-        /* Signal amplitude found & stable? */
-        if ( ((ratio[0] < c_inc_thr) && (dy[0] > c_noise_thr)) ||
-             ((ratio[1] < c_inc_thr) && (dy[1] > c_noise_thr)) ) {
-            /* This is meant for optimizing the time it takes for AUTO to complete,
-             * and is a compromise between the speed and robustness of the AUTO
-             * algorithm.
-             * Since it is fast enough, it is safer to search for amplitude through
-             * all the iterations instead of bailing out sooner.
-             */
-            //break;
+            rp_osc_auto_min_max(sig_data[i], calib_dc_off[i], &min_ch[i], &max_ch[i]);
+            dy[i] = max_ch[i] - min_ch[i];
         }
 
-        /* Still searching? - Increase time range up to 130 ms (D = 1024). */
-        if ((iter % 3) == 2) {
-            time_range++;
-            if (time_range > 3) {
-                time_range = 3;
-            }
+        /* Check the Y axis amplitude on both channels and select the
+         * channel with the larger one */
+        channel = (dy[0] > dy[1]) ? 0 : 1;
+        if(dy[channel] >= c_noise_thr) {
+            period = rp_osc_auto_period(sig_data[channel], c_time_range[acq]);
+            TRACE("AUTO: acquisition %d, period = %.6f\n", acq, period);
+            if(period > 0)
+                break;
         }
     }
 
-    /* Check the Y axis amplitude on both channels and select the channel with 
-     * the larger one.
-     */
-    channel = (dy[0] > dy[1]) ? 0 : 1;
+    min_y = (min_ch[0] < min_ch[1]) ? min_ch[0] : min_ch[1];
+    max_y = (max_ch[0] > max_ch[1]) ? max_ch[0] : max_ch[1];
+    ave_y = (min_y + max_y) >> 1;
 
     if(dy[channel] < c_noise_thr) {
         /* No signal detected, set the parameters to:
@@ -926,7 +1174,6 @@ int rp_osc_auto_set(rp_app_params_t *orig_params,
          * - Y axis - Min/Max + adding extra 200% to average
          */
         TRACE("AUTO: No signal detected.\n");
-        int min_y, max_y, ave_y;
 
         orig_params[TRIG_MODE_PARAM].value  = 0;
         orig_params[MIN_GUI_PARAM].value    = 0;      
@@ -938,176 +1185,74 @@ int rp_osc_auto_set(rp_app_params_t *orig_params,
         orig_params[TIME_UNIT_PARAM].value  = 0;
         orig_params[TRIG_DLY_PARAM].value   = 0;
 
-        min_y = (min_cha < min_chb) ? min_cha : min_chb;
-        max_y = (max_cha > max_chb) ? max_cha : max_chb;
-
-        ave_y = (min_y + max_y) >> 1;
         min_y = (min_y - ave_y) * 2 + ave_y;
         max_y = (max_y - ave_y) * 2 + ave_y;
 
-        orig_params[MIN_Y_NORM].value = min_y / (float)(1 << (c_osc_fpga_adc_bits - 1));
-        orig_params[MAX_Y_NORM].value = max_y / (float)(1 << (c_osc_fpga_adc_bits - 1));
-
-        // For POST response ...
-        transform_to_iface_units(orig_params);
-        return 0;
-
     } else {
-
-        /* Signal above threshold - loop from lower to higher decimation */
-        int min_y, max_y;
-        int trig_src_ch;               /* Trigger level in samples, smpls_2 introduced for histeresis */
-        int trig_level;
-        float trig_level_v;            /* Trigger level in [V] */
-        int time_range;                /* decimation from 0 to 5 */
-        float max_adc_v;
-        int calib_dc_off;
-
-       int wr_ptr_curr, wr_ptr_trig;
-
-        if(channel == 0) {
-            min_y = min_cha;
-            max_y = max_cha;
-            trig_src_ch = 0;
-            max_adc_v = ch1_max_adc_v;
-            calib_dc_off = rp_calib_params->fe_ch1_dc_offs;
+        /* Signal above threshold - lowest time range that holds 3 periods,
+         * as required by meas_period() (Last range removed: too slow) */
+        int time_range = 0;
+        int time_unit = 2;
+        float t_unit_factor = 1; /* to convert to seconds */
+        int amp_y;
+
+        if(period > 0) {
+            while((time_range < 4) &&
+                  (period * 3 >= OSC_FPGA_SIG_LEN * c_osc_fpga_smpl_period *
+                   osc_fpga_cnv_time_range_to_dec(time_range)))
+                time_range++;
         } else {
-            min_y = min_chb;
-            max_y = max_chb;
-            trig_src_ch = 1;
-            max_adc_v = ch2_max_adc_v;
-            calib_dc_off = rp_calib_params->fe_ch2_dc_offs;            
+            /* Period not detected, which means it is longer than ~45 ms */
+            TRACE("AUTO: Signal period cannot be determined.\n");
+            time_range = 5;
         }
-        trig_level = (max_y + min_y) >> 1;
-        TRACE("AUTO: trig level: %d\n", trig_level);
-        TRACE("AUTO: min,max: %d  %d\n", min_y, max_y);
-
-        trig_level_v = (((trig_level + calib_dc_off) * max_adc_v)/
-                        (float)(1<<(c_osc_fpga_adc_bits-1))) ;
-
-        int loc_max = INT_MIN;
-        int loc_min = INT_MAX;
 
-        /* Loop over time ranges and search for the best suiting one (Last range removed: too slow) */
-        for(time_range = 0; time_range < 5; time_range++) {
-            float period = 0;
-            int trig_source = osc_fpga_cnv_trig_source(0, trig_src_ch, 0);
-            int *sig_data;
+        /* pick correct which time unit is selected */
+        if((time_range == 0) || (time_range == 1)) {
+            time_unit     = 0;
+            t_unit_factor = 1e6;
+        } else if((time_range == 2) || (time_range == 3)) {
+            time_unit     = 1;
+            t_unit_factor = 1e3;
+        }
 
-            osc_fpga_reset();
-            osc_fpga_update_params(0, trig_src_ch, 0, 0, trig_level_v, time_range,
-                                   ch1_max_adc_v, ch2_max_adc_v,
-                                   rp_calib_params->fe_ch1_dc_offs,
-                                   0,
-                                   rp_calib_params->fe_ch2_dc_offs,
-                                   0, 
-                                   ch1_probe_att, ch2_probe_att, ch1_gain, ch2_gain, en_avg_at_dec);
-
-            /* ARM & Trigger */
-            osc_fpga_arm_trigger();
-            osc_fpga_set_trigger(trig_source);
+        orig_params[TRIG_MODE_PARAM].value  = 1; /* 'normal' */
+        orig_params[TIME_RANGE_PARAM].value = time_range;
+        orig_params[TRIG_SRC_PARAM].value   = channel;
+        /* Midpoint of the raw counts */
+        orig_params[TRIG_LEVEL_PARAM].value =
+            ((float)(max_ch[channel] + min_ch[channel]) / 2 - calib_dc_off[channel]) /
+            (float)(1<<(c_osc_fpga_adc_bits-1));
 
-            /* Wait for trigger */
-            /* Wait for trigger to finish */
-            while(1) {
-                pthread_mutex_lock(&rp_osc_ctrl_mutex);
-                state = rp_osc_ctrl;
-                params_dirty = rp_osc_params_dirty;
-                pthread_mutex_unlock(&rp_osc_ctrl_mutex);
+        orig_params[MIN_GUI_PARAM].value    = 0;
+        orig_params[TRIG_DLY_PARAM].value   = 0;
 
-                /* change in state, abort polling */
-                if((state != old_state) || params_dirty) {
-                    return -1;
-                }
-                if(osc_fpga_triggered()) {
-                    break;
-                }    
-                usleep(500);
+        if (period > 0) {
+            /* Period detected */
+            const float c_min_t_span = 1e-7;
+            if (period < c_min_t_span / 1.5) {
+                period = c_min_t_span / 1.5;
             }
+            orig_params[MAX_GUI_PARAM].value =  period * 1.5 * t_unit_factor;
+        } else {
+            /* Stretch to max 1/4 range. All slow signals should be still visible there */
+            orig_params[MAX_GUI_PARAM].value = 2.0;
+        }
 
-            // Checking where acquisition starts
-            osc_fpga_get_wr_ptr(&wr_ptr_curr, &wr_ptr_trig);
-
-            /* We have a signal in rp_fpga_chX_signal */
-            sig_data = (channel == 0) ? rp_fpga_cha_signal : rp_fpga_chb_signal;
-            int dec_factor = osc_fpga_cnv_time_range_to_dec(time_range);
-
-            rp_osc_meas_res_t meas;
-            rp_osc_meas_clear(&meas);
-            meas.min = min_y;
-            meas.max = max_y;
-
-            meas_period(&meas, sig_data, wr_ptr_trig, dec_factor, &loc_min, &loc_max);
-            period = meas.period;
-            TRACE("AUTO: period = %.6f\n", period);
-
-            /* We have a winner - calculate the new parameters */
-            if ((period > 0) || (time_range >= 4))
-            {
-                int ave_y, amp_y;
-                int time_unit = 2;
-                float t_unit_factor = 1; /* to convert to seconds */
-
-                /* pick correct which time unit is selected */
-                if((time_range == 0) || (time_range == 1)) {
-                    time_unit     = 0;
-                    t_unit_factor = 1e6;
-                } else if((time_range == 2) || (time_range == 3)) {
-                    time_unit     = 1;
-                    t_unit_factor = 1e3;
-                }
-                
-                orig_params[TRIG_MODE_PARAM].value  = 1; /* 'normal' */
-                orig_params[TIME_RANGE_PARAM].value = time_range;
-                orig_params[TRIG_SRC_PARAM].value   = trig_src_ch;
-                orig_params[TRIG_LEVEL_PARAM].value = ((float)(loc_max + loc_min))/2 /
-                                        (float)(1<<(c_osc_fpga_adc_bits-1));
-
-                orig_params[MIN_GUI_PARAM].value    = 0;
-                orig_params[TRIG_DLY_PARAM].value   = 0;
-
-                if (period > 0) {
-                    /* Period detected */
-                    const float c_min_t_span = 1e-7;
-                    if (period < c_min_t_span / 1.5) {
-                        period = c_min_t_span / 1.5;
-                    }
-                    orig_params[MAX_GUI_PARAM].value =  period * 1.5 * t_unit_factor;
-                } else {
-                    /* Period not detected, which means it is longer than ~300 ms */
-                    TRACE("AUTO: Signal period cannot be determined.\n");
-                    /* Stretch to max 1/4 range. All slow signals should be still visible there */
-                    orig_params[MAX_GUI_PARAM].value = 2.0;
-                    orig_params[TIME_RANGE_PARAM].value = 5;
-                }
-
-                orig_params[TIME_UNIT_PARAM].value  = time_unit;
-                orig_params[AUTO_FLAG_PARAM].value  = 0;
-
-                min_y = (min_cha < min_chb) ? min_cha : min_chb;
-                max_y = (max_cha > max_chb) ? max_cha : max_chb;
-
-                if (loc_max > max_y)
-                    max_y = loc_max;
-
-                if (loc_min <  min_y)
-                    min_y = loc_min;
+        orig_params[TIME_UNIT_PARAM].value  = time_unit;
+        orig_params[AUTO_FLAG_PARAM].value  = 0;
 
-                ave_y = (min_y + max_y) >> 1;
-                amp_y = ((max_y - min_y) >> 1) * 1.2;
-                min_y = ave_y - amp_y;
-                max_y = ave_y + amp_y;
+        amp_y = ((max_y - min_y) >> 1) * 1.2;
+        min_y = ave_y - amp_y;
+        max_y = ave_y + amp_y;
+    }
 
-                orig_params[MIN_Y_NORM].value = min_y / (float)(1 << (c_osc_fpga_adc_bits - 1));
-                orig_params[MAX_Y_NORM].value = max_y / (float)(1 << (c_osc_fpga_adc_bits - 1));
+    orig_params[MIN_Y_NORM].value = min_y / (float)(1 << (c_osc_fpga_adc_bits - 1));
+    orig_params[MAX_Y_NORM].value = max_y / (float)(1 << (c_osc_fpga_adc_bits - 1));
 
-                // For POST response ...
-                transform_to_iface_units(orig_params);
-                return 0;
-            }
-        }
-    }
-    return -1;
+    // For POST response ...
+    transform_to_iface_units(orig_params);
+    return 0;
 }
 
 
@@ -29,6 +29,20 @@ typedef enum rp_osc_worker_state_e {
     rp_osc_nonexisting_state /* must be last */
 } rp_osc_worker_state_t;
 
+/* Roll mode strip chart - every display column holds the minimum and the
+ * maximum of its samples as two consecutive points
+ */
+#define ROLL_COLUMNS (SIGNAL_LENGTH/2)
+
+typedef struct rp_osc_roll_s {
+    int rd_ptr;   /* next FPGA buffer sample to consume */
+    int col_len;  /* FPGA samples per display column */
+    int col_fill; /* samples collected in the current column */
+    int cha_min, cha_max;
+    int chb_min, chb_max;
+    int meas_len; /* samples accumulated in the measurements */
+} rp_osc_roll_t;
+
 int rp_osc_worker_init(rp_app_params_t *params, int params_len,
                        rp_calib_params_t *calib_params);
 int rp_osc_worker_exit(void);
@@ -82,6 +96,25 @@ int rp_osc_decimate_partial(float **cha_out_signal, int *cha_in_signal,
                             float ch1_max_adc_v, float ch2_max_adc_v,
                             float ch1_user_dc_off, float ch2_user_dc_off);
 
+/* Roll mode - starts an empty strip chart at the current write pointer and
+ * prepares its time vector (newest column at t_stop)
+ */
+int rp_osc_roll_init(rp_osc_roll_t *roll,
+                     float **cha_signal, float **chb_signal,
+                     float **time_signal, int dec_factor,
+                     float t_start, float t_stop, int time_unit);
+
+/* Roll mode - consumes the samples written since the last call, scrolls the
+ * strip chart by the completed columns and returns their number
+ */
+int rp_osc_roll_update(rp_osc_roll_t *roll,
+                       float **cha_signal, int *cha_in_signal,
+                       float **chb_signal, int *chb_in_signal,
+                       rp_osc_meas_res_t *ch1_meas,
+                       rp_osc_meas_res_t *ch2_meas,
+                       float ch1_max_adc_v, float ch2_max_adc_v,
+                       float ch1_user_dc_off, float ch2_user_dc_off);
+
 /* Auto-set algorithm */
 int rp_osc_auto_set(rp_app_params_t *orig_params, 
                     float ch1_max_adc_v, float ch2_max_adc_v,
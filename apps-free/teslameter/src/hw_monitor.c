@@ -0,0 +1,76 @@
+/**
+ * @brief Red Pitaya Teslameter LED field indicator.
+ *
+ * The LEDs are driven through librp, which maps the housekeeping
+ * registers once, and also provides them on its simulated backend
+ * (RP_SIMULATE=1), where rp_LEDGetState() reads back the indicator. This
+ * file only includes the library header, its calibration types clash
+ * with the ones of calib.h.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+
+#include "redpitaya/rp.h"
+#include "hw_monitor.h"
+
+/* Channel 2 amplitude above which each level starts [V] */
+static const float level_threshold[HW_MONITOR_LEDS - 1] = {
+    0.1, 0.3, 0.5, 0.7, 0.8, 0.9, 1.0
+};
+
+static int hw_monitor_ready = 0;
+static int led_level = -1;
+
+/* The application owns the FPGA settings, librp must not reset them */
+int hw_monitor_init(void)
+{
+    int ret = rp_InitReset(false);
+    if(ret != RP_OK) {
+        fprintf(stderr, "rp_InitReset() failed: %s\n", rp_GetError(ret));
+        return -1;
+    }
+    led_level = -1;
+    hw_monitor_ready = 1;
+    return 0;
+}
+
+void hw_monitor_exit(void)
+{
+    if(!hw_monitor_ready) {
+        return;
+    }
+    rp_LEDSetState(0);
+    rp_Release();
+    hw_monitor_ready = 0;
+}
+
+/* Number of thresholds the amplitude is above */
+int hw_monitor_level(float amplitude)
+{
+    int l = 0;
+    while(l < HW_MONITOR_LEDS - 1 && amplitude > level_threshold[l]) {
+        l++;
+    }
+    return l;
+}
+
+/* The register is only written when the level changes */
+void hw_monitor_update(float amplitude)
+{
+    int l = hw_monitor_level(amplitude);
+
+    if(!hw_monitor_ready || l == led_level) {
+        return;
+    }
+    if(rp_LEDSetState(1 << l) == RP_OK) {
+        led_level = l;
+    }
+}
@@ -1,11 +1,24 @@
-/*
- * led.h
+/**
+ * @brief Red Pitaya Teslameter LED field indicator.
  *
- *  Created on: Nov 27, 2014
- *      Author: infused
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
  */
 
+#ifndef __HW_MONITOR_H
+#define __HW_MONITOR_H
 
+/* LEDs of the indicator, LED n is lit for level n */
+#define HW_MONITOR_LEDS     8
 
+int hw_monitor_init(void);
+void hw_monitor_exit(void);
+int hw_monitor_level(float amplitude);
+void hw_monitor_update(float amplitude);
 
-
+#endif // __HW_MONITOR_H
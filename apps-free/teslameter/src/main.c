@@ -28,6 +28,7 @@
 #include "calib.h"
 #include "generate.h"
 #include "pid.h"
+#include "hw_monitor.h"
 
 
 #include <sys/mman.h>
@@ -1129,7 +1130,7 @@ int rp_update_main_params(rp_app_params_t *params)
     return 0;
 }
 
-int rp_update_meas_data(rp_osc_meas_res_t ch1_meas, rp_osc_meas_res_t ch2_meas, int tesla_fd)
+int rp_update_meas_data(rp_osc_meas_res_t ch1_meas, rp_osc_meas_res_t ch2_meas)
 {
 
 
@@ -1154,42 +1155,7 @@ int rp_update_meas_data(rp_osc_meas_res_t ch1_meas, rp_osc_meas_res_t ch2_meas,
 
     float amplitude = ch2_meas.amp;
 
-
-        power_led(1, tesla_fd); // tur on leds
-
-        if ( amplitude > 0.1){
-          power_led(1, tesla_fd); // tur on leds
-
-        }
-        else if ( amplitude > 0.3){
-
-          power_led(2, tesla_fd); // tur on leds
-        }
-        else if ( amplitude > 0.5){
-
-          power_led(3, tesla_fd); // tur on leds
-        }
-        else if ( amplitude > 0.7){
-
-          power_led(4, tesla_fd); // tur on leds
-        }
-        else if ( amplitude > 0.8){
-
-          power_led(5, tesla_fd); // tur on leds
-        }
-        else if ( amplitude > 0.9){
-
-          power_led(6, tesla_fd); // tur on leds
-        }
-        else if ( amplitude > 1){
-
-          power_led(7, tesla_fd); // tur on leds
-        }
-        else{
-           power_led(7, tesla_fd); // tur on leds
-      }
-
-
+    hw_monitor_update(amplitude);
 
     pthread_mutex_unlock(&rp_main_params_mutex);
     return 0;
@@ -178,7 +178,7 @@ void transform_from_iface_units(rp_app_params_t *p);
  * are read-only for the client and there is no need to update them internally
  * in the application 
  */
-int rp_update_meas_data(rp_osc_meas_res_t ch1_meas, rp_osc_meas_res_t ch2_meas, int tesla_fd);
+int rp_update_meas_data(rp_osc_meas_res_t ch1_meas, rp_osc_meas_res_t ch2_meas);
 
 /* Waveform generator frequency limiter. */
 float rp_gen_limit_freq(float freq, float gen_type);
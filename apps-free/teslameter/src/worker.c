@@ -24,95 +24,7 @@
  #include <math.h>
 #include "worker.h"
 #include "fpga.h"
-#include <sys/mman.h>
-
-
- /** Base Housekeeping address */
-const int LED_BASE_ADDR = 0x40000000;
-const int LED_BASE_SIZE = 0x30;
-
-/* Base AMS address */
-const int TEMP_BASE_ADDR = 0x40400000;
-const int TEMP_BASE_SIZE = 0x30;
-
-const int ADC_FULL_RANGE_CNT =  0xfff;
-
-
-
- /* Led structure declaration */
-typedef struct led_control_s{
-    unsigned long int id;
-    unsigned long int dna_part1;
-    unsigned long int dna_part2;
-    unsigned long int reserved_1;
-    unsigned long int ex_cd_p;
-    unsigned long int ex_cd_n;
-    unsigned long int ex_co_p;
-    unsigned long int ex_co;
-    unsigned long int ex_ci_p;
-    unsigned long int ex_ci_n;
-    unsigned long int reserved_2;
-    unsigned long int reserved_3;
-    unsigned long int led_control;
-} led_control_t;
-
-
-led_control_t *led_struct;
-
-
-
-void power_led(int l, int fd){
-    led_struct->led_control = pow(2, l);
-}
-
-
-int hw_monitor(){
-
-    int fd_control = -1;
-    /* Page variables used to calculate correct mapping addresses for temperature control */
-    char *page_ptr_led, *page_ptr_temp;
-    long page_addr_led, page_addr_temp, page_off_led, page_off_temp, page_size = sysconf(_SC_PAGESIZE);
-
-    /* Open file descriptor */
-    fd_control = open("/dev/mem", O_RDWR | O_SYNC);
-
-    /* Error check */
-    if(fd_control < 0) {
-       // cout << " Error opening (/dev/mem)";
-    }
-
-    /* Led mmap */
-    page_addr_led = LED_BASE_ADDR & (~(page_size-1));
-    page_off_led  = LED_BASE_ADDR - page_addr_led;
-
-    page_ptr_led = (char*)mmap(NULL, LED_BASE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd_control, page_addr_led);
-    page_ptr_led = page_ptr_led + page_off_led;
-
-    char *c_led = (char *)&led_struct;
-    c_led = page_ptr_led;
-
-    led_struct = (led_control_t*)c_led;
-
-    /* Temp mmap */
-    page_addr_temp = TEMP_BASE_ADDR & (~(page_size-1));
-    page_off_temp = TEMP_BASE_ADDR - page_addr_temp;
-
-    page_ptr_temp = (char*)mmap(NULL, TEMP_BASE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd_control, page_addr_temp);
-    page_ptr_temp = page_ptr_temp + page_off_temp;
-
-    return fd_control;
-}
-
-void destruct_hw_monitor(int tesla_fd){
-    if(led_struct){
-        if(munmap(led_struct, LED_BASE_SIZE) < 0){
-            // cout << "munmap failed." << endl;
-         }
-         led_struct = NULL;
-     }
-}
-
-
+#include "hw_monitor.h"
 
 
 pthread_t *rp_osc_thread_handler = NULL;
@@ -305,9 +217,9 @@ int rp_osc_set_signals(float **source, int index)
 
 
 /*----------------------------------------------------------------------------------*/
-int rp_osc_set_meas_data(rp_osc_meas_res_t ch1_meas, rp_osc_meas_res_t ch2_meas, int tesla_fd)
+int rp_osc_set_meas_data(rp_osc_meas_res_t ch1_meas, rp_osc_meas_res_t ch2_meas)
 {
-    rp_update_meas_data(ch1_meas, ch2_meas, tesla_fd);
+    rp_update_meas_data(ch1_meas, ch2_meas);
     return 0;
 }
 
@@ -347,7 +259,11 @@ void *rp_osc_worker_thread(void *args)
 
 
 
-    int tesla_fd = hw_monitor();
+    /* The measurement runs without the indicator, hw_monitor_update()
+     * does nothing then */
+    if(hw_monitor_init() < 0) {
+        fprintf(stderr, "LED field indicator disabled\n");
+    }
           
        
 
@@ -387,6 +303,7 @@ void *rp_osc_worker_thread(void *args)
         /* request to stop worker thread, we will shut down */
         if(state == rp_osc_quit_state) {
             rp_clean_params(curr_params);
+            hw_monitor_exit();
             return 0;
         }
 
@@ -618,8 +535,7 @@ void *rp_osc_worker_thread(void *args)
                             curr_params[GAIN_CH1].value,
                             curr_params[GAIN_CH2].value,
                              curr_params[SCALE_DECADE_TESLA_CH1].value,
-                             curr_params[SCALE_DECADE_TESLA_CH2].value, 
-                             tesla_fd);
+                             curr_params[SCALE_DECADE_TESLA_CH2].value);
         } else {
             long_acq_idx = rp_osc_decimate_partial((float **)&rp_tmp_signals[1], 
                                              &rp_fpga_cha_signal[0], 
@@ -641,8 +557,7 @@ void *rp_osc_worker_thread(void *args)
                                              curr_params[GAIN_CH1].value,
                                              curr_params[GAIN_CH2].value,
                                              curr_params[SCALE_DECADE_TESLA_CH1].value,
-                                             curr_params[SCALE_DECADE_TESLA_CH2].value,
-                                             tesla_fd);
+                                             curr_params[SCALE_DECADE_TESLA_CH2].value);
 
             /* Acquisition over, start one more! */
             if(long_acq_idx >= SIGNAL_LENGTH-1) {
@@ -686,7 +601,7 @@ void *rp_osc_worker_thread(void *args)
             rp_osc_meas_convert(&ch1_meas, ch1_max_adc_v, rp_calib_params->fe_ch1_dc_offs);
             rp_osc_meas_convert(&ch2_meas, ch2_max_adc_v, rp_calib_params->fe_ch2_dc_offs);
             
-            rp_osc_set_meas_data(ch1_meas, ch2_meas, tesla_fd);
+            rp_osc_set_meas_data(ch1_meas, ch2_meas);
             rp_osc_set_signals(rp_tmp_signals, SIGNAL_LENGTH-1);
         } else {
             rp_osc_set_signals(rp_tmp_signals, long_acq_idx);
@@ -696,6 +611,7 @@ void *rp_osc_worker_thread(void *args)
     }
 
     rp_clean_params(curr_params);
+    hw_monitor_exit();
     return 0;
 }
 
@@ -744,8 +660,7 @@ int rp_osc_decimate(float **cha_signal, int *in_cha_signal,
                     int gain_ch1, 
                     int gain_ch2,
                     int tesla_scale_decade_ch1, 
-                    int tesla_scale_decade_ch2,
-                    int tesla_fd)
+                    int tesla_scale_decade_ch2)
 {
     int t_start_idx, t_stop_idx;
     float smpl_period = c_osc_fpga_smpl_period * dec_factor;
@@ -905,8 +820,7 @@ int rp_osc_decimate_partial(float **cha_out_signal, int *cha_in_signal,
                             int gain_ch1, 
                             int gain_ch2, 
                             int tesla_scale_decade_ch1, 
-                            int tesla_scale_decade_ch2,
-                            int tesla_fd)
+                            int tesla_scale_decade_ch2)
 {
     float *cha_out = *cha_out_signal;
     float *chb_out = *chb_out_signal;
@@ -49,7 +49,7 @@ int rp_osc_get_signals(float ***signals, int *sig_idx);
 int rp_osc_set_signals(float **source, int index);
 /* Fills the output measuremenet data with last measurements
  */
-int rp_osc_set_meas_data(rp_osc_meas_res_t ch1_meas, rp_osc_meas_res_t ch2_meas, int tesla_fd);
+int rp_osc_set_meas_data(rp_osc_meas_res_t ch1_meas, rp_osc_meas_res_t ch2_meas);
 
 /* Prepares time vector (only where there is a need for it) */
 int rp_osc_prepare_time_vector(float **out_signal, int dec_factor,
@@ -74,8 +74,7 @@ int rp_osc_decimate(float **cha_signal, int *in_cha_signal,
                     float ch1_scale_tesla,
                     float ch2_scale_tesla,
                     int gain_ch1, int gain_ch2,
-                    int tesla_scale_decade_ch1, int tesla_scale_decade_ch2,
-                    int tesla_fd);
+                    int tesla_scale_decade_ch1, int tesla_scale_decade_ch2);
 
 int rp_osc_decimate_partial(float **cha_out_signal, int *cha_in_signal, 
                             float **chb_out_signal, int *chb_in_signal,
@@ -89,8 +88,7 @@ int rp_osc_decimate_partial(float **cha_out_signal, int *cha_in_signal,
                             float ch1_scale_tesla,
                             float ch2_scale_tesla,
                             int gain_ch1, int gain_ch2,
-                            int tesla_scale_decade_ch1, int tesla_scale_decade_ch2,
-                            int tesla_fd);
+                            int tesla_scale_decade_ch1, int tesla_scale_decade_ch2);
 
 /* Auto-set algorithm */
 int rp_osc_auto_set(rp_app_params_t *orig_params, 
@@ -115,9 +113,5 @@ int meas_period(rp_osc_meas_res_t *meas, int *in_signal, int wr_ptr_trig, int de
 /* helper function - convert CNT to V for meas. data (min, max, amp, avg) */
 int rp_osc_meas_convert(rp_osc_meas_res_t *ch_meas, float adc_max_v, int32_t cal_dc_offs);
 
-//leds teslameter
-void power_led(int l, int fd);
-int hw_monitor();
-void destruct_hw_monitor(int tesla_fd);
 
 #endif /* __WORKER_H*/
@@ -0,0 +1,206 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya benchmark harness implementation.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+
+#include "bench.h"
+
+typedef struct {
+    char name[BENCH_NAME_SIZE];
+    size_t bytes;
+    double ns_per_op;
+    unsigned long iterations;
+} bench_result_t;
+
+static const char *out_path = NULL;
+static const char *baseline_path = NULL;
+static double threshold = 10.0;     // %
+static double min_ms = 50.0;        // per repeat
+
+static bench_result_t *results = NULL;
+static int results_count = 0;
+
+static double nowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int cmpDouble(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+int bench_Option(int opt, const char *arg)
+{
+    switch (opt) {
+    case 'o': out_path = arg; return 1;
+    case 'B': baseline_path = arg; return 1;
+    case 't': threshold = atof(arg); return 1;
+    case 'm': min_ms = atof(arg); return 1;
+    case 'c': {
+        // Pinning keeps the scheduler from moving the benchmark mid run
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(atoi(arg), &set);
+        if (sched_setaffinity(0, sizeof(set), &set) < 0) {
+            perror("sched_setaffinity");
+            return -1;
+        }
+        return 1;
+    }
+    default:
+        return 0;
+    }
+}
+
+void bench_Report(const char *name, size_t bytes, double ns_per_op, unsigned long iterations)
+{
+    bench_result_t *grown = realloc(results, (results_count + 1) * sizeof(*results));
+    if (grown == NULL) {
+        fprintf(stderr, "Out of memory, %s not recorded\n", name);
+        return;
+    }
+    results = grown;
+
+    bench_result_t *result = &results[results_count++];
+    snprintf(result->name, sizeof(result->name), "%s", name);
+    result->bytes = bytes;
+    result->ns_per_op = ns_per_op;
+    result->iterations = iterations;
+
+    fprintf(stderr, "%-44s %14.1f ns/op", name, ns_per_op);
+    if (bytes) {
+        fprintf(stderr, " %10.2f MB/s", bytes / ns_per_op * 1e3);
+    }
+    fprintf(stderr, "\n");
+}
+
+void bench_Run(const char *name, size_t bytes, bench_fn_t fn, void *arg)
+{
+    unsigned long iterations = 1;
+    double elapsed;
+
+    // Calibration doubles as warm up of caches and lazily initialised state
+    for (;;) {
+        double start = nowNs();
+        for (unsigned long i = 0; i < iterations; i++) {
+            fn(arg);
+        }
+        elapsed = nowNs() - start;
+        if (elapsed >= min_ms * 1e6) {
+            break;
+        }
+        iterations *= 2;
+    }
+
+    double samples[BENCH_REPEATS];
+    for (int r = 0; r < BENCH_REPEATS; r++) {
+        double start = nowNs();
+        for (unsigned long i = 0; i < iterations; i++) {
+            fn(arg);
+        }
+        samples[r] = (nowNs() - start) / iterations;
+    }
+    qsort(samples, BENCH_REPEATS, sizeof(double), cmpDouble);
+
+    bench_Report(name, bytes, samples[BENCH_REPEATS / 2], iterations);
+}
+
+static int writeResults()
+{
+    FILE *fp = out_path ? fopen(out_path, "w") : stdout;
+    if (fp == NULL) {
+        perror(out_path);
+        return 1;
+    }
+
+    // One result per line, bench_Finish reads baselines back line by line
+    fprintf(fp, "{\n");
+    for (int i = 0; i < results_count; i++) {
+        bench_result_t *result = &results[i];
+        fprintf(fp, "\"%s\": {\"ns_per_op\": %.1f, \"mb_per_s\": %.3f, \"bytes\": %zu, \"iterations\": %lu}%s\n",
+                result->name, result->ns_per_op,
+                result->bytes ? result->bytes / result->ns_per_op * 1e3 : 0.0,
+                result->bytes, result->iterations,
+                i + 1 < results_count ? "," : "");
+    }
+    fprintf(fp, "}\n");
+
+    if (fp != stdout && fclose(fp) != 0) {
+        perror(out_path);
+        return 1;
+    }
+    return 0;
+}
+
+static int compareBaseline()
+{
+    FILE *fp = fopen(baseline_path, "r");
+    if (fp == NULL) {
+        perror(baseline_path);
+        return 1;
+    }
+
+    char line[512];
+    char name[BENCH_NAME_SIZE];
+    double base_ns;
+    int regressions = 0;
+
+    fprintf(stderr, "\n%-44s %14s %14s %8s\n", "benchmark", "baseline ns", "current ns", "change");
+    while (fgets(line, sizeof(line), fp)) {
+        if (sscanf(line, " \"%127[^\"]\": {\"ns_per_op\": %lf", name, &base_ns) != 2) {
+            continue;
+        }
+        for (int i = 0; i < results_count; i++) {
+            if (strcmp(results[i].name, name) != 0) {
+                continue;
+            }
+            double change = (results[i].ns_per_op - base_ns) / base_ns * 100.0;
+            bool regressed = change > threshold;
+            fprintf(stderr, "%-44s %14.1f %14.1f %+7.1f%%%s\n", name, base_ns,
+                    results[i].ns_per_op, change, regressed ? "  REGRESSION" : "");
+            regressions += regressed;
+            break;
+        }
+    }
+    fclose(fp);
+
+    if (regressions) {
+        fprintf(stderr, "%d benchmark(s) more than %.0f%% slower than the baseline\n", regressions, threshold);
+        return 2;
+    }
+    return 0;
+}
+
+int bench_Finish()
+{
+    int result = writeResults();
+    if (result == 0 && baseline_path) {
+        result = compareBaseline();
+    }
+
+    free(results);
+    results = NULL;
+    results_count = 0;
+    return result;
+}
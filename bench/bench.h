@@ -0,0 +1,68 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya benchmark harness interface.
+ *
+ * Every benchmark is calibrated to run for at least the minimal time,
+ * repeated BENCH_REPEATS times and reported by its median. Results are
+ * written as JSON, one benchmark per line, and optionally compared against
+ * a baseline file written by an earlier run.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef __BENCH_H
+#define __BENCH_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BENCH_REPEATS       5
+#define BENCH_NAME_SIZE     128
+
+/* Options handled by bench_Option, to be added to the getopt string */
+#define BENCH_OPTIONS       "o:B:t:m:c:"
+#define BENCH_USAGE         "[-o results.json] [-B baseline.json] [-t threshold percent] [-m min ms] [-c cpu]"
+
+/* Benchmarked operation, called once per iteration */
+typedef void (*bench_fn_t)(void *arg);
+
+/**
+ * Handles a common command line option.
+ * @return 1 if the option was handled, 0 if it is not a common one, -1 on error.
+ */
+int bench_Option(int opt, const char *arg);
+
+/**
+ * Times fn and records the median time per call.
+ * @param bytes Bytes processed per call, 0 if throughput is meaningless.
+ */
+void bench_Run(const char *name, size_t bytes, bench_fn_t fn, void *arg);
+
+/**
+ * Records a result measured by the caller, for operations that can not be
+ * repeated in a loop (network round trips).
+ */
+void bench_Report(const char *name, size_t bytes, double ns_per_op, unsigned long iterations);
+
+/**
+ * Writes the results and compares them against the baseline.
+ * @return 0 on success, 1 if writing failed, 2 if a result regressed by more
+ * than the threshold.
+ */
+int bench_Finish();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BENCH_H */
@@ -0,0 +1,209 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library (librp) micro benchmarks.
+ *
+ * Measures buffer readout in raw counts and volts at several sizes, both
+ * from the buffer start and wrapping around its end, calibration count to
+ * voltage conversion, generator waveform synthesis and the spectrum
+ * analyzer window + FFT. Runs against the simulated register backend
+ * (RP_SIMULATE) unless -H is given, so results do not depend on a board.
+ *
+ * Usage: rp-bench [-H] [-o results.json] [-B baseline.json] [-t %] [-m ms] [-c cpu]
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <math.h>
+
+#include "redpitaya/rp.h"
+#include "spec_fpga.h"
+#include "spec_dsp.h"
+#include "bench.h"
+
+static const uint32_t sizes[] = { 1024, 4096, ADC_BUFFER_SIZE };
+
+typedef struct {
+    uint32_t pos;
+    uint32_t size;
+    int16_t raw[ADC_BUFFER_SIZE];
+    float volts[ADC_BUFFER_SIZE];
+    float volts2[ADC_BUFFER_SIZE];
+} acq_arg_t;
+
+static void acqRaw(void *arg)
+{
+    acq_arg_t *a = arg;
+    uint32_t size = a->size;
+    rp_AcqGetDataRaw(RP_CH_1, a->pos, &size, a->raw);
+}
+
+static void acqVolts(void *arg)
+{
+    acq_arg_t *a = arg;
+    uint32_t size = a->size;
+    rp_AcqGetDataV(RP_CH_1, a->pos, &size, a->volts);
+}
+
+static void acqVolts2(void *arg)
+{
+    acq_arg_t *a = arg;
+    uint32_t size = a->size;
+    rp_AcqGetDataV2(a->pos, &size, a->volts, a->volts2);
+}
+
+static void calibConvert(void *arg)
+{
+    acq_arg_t *a = arg;
+    for (uint32_t i = 0; i < a->size; i++) {
+        a->volts[i] = rp_CmnCnvCntToV(14, a->raw[i] & 0x3fff, 1.0, 0x10000000, 0, 0.0);
+    }
+}
+
+typedef struct {
+    rp_waveform_t waveform;
+    int toggle;
+} gen_arg_t;
+
+static void genSynthesize(void *arg)
+{
+    // Alternating frequencies, every call has to synthesize the buffer again
+    gen_arg_t *a = arg;
+    a->toggle = !a->toggle;
+    rp_GenFreq(RP_CH_1, a->toggle ? 1000.0 : 2000.0);
+}
+
+typedef struct {
+    double cha[SPECTR_FPGA_SIG_LEN], chb[SPECTR_FPGA_SIG_LEN];
+    double cha_w[SPECTR_FPGA_SIG_LEN], chb_w[SPECTR_FPGA_SIG_LEN];
+    double cha_f[SPECTR_FPGA_SIG_LEN], chb_f[SPECTR_FPGA_SIG_LEN];
+} fft_arg_t;
+
+static void spectrumFft(void *arg)
+{
+    fft_arg_t *a = arg;
+    double *cha_w = a->cha_w, *chb_w = a->chb_w;
+    double *cha_f = a->cha_f, *chb_f = a->chb_f;
+    rp_spectr_hann_filter(a->cha, a->chb, &cha_w, &chb_w);
+    rp_spectr_fft(cha_w, chb_w, &cha_f, &chb_f);
+}
+
+static void benchAcquire(acq_arg_t *a)
+{
+    char name[BENCH_NAME_SIZE];
+
+    for (int s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        for (int wrap = 0; wrap < 2; wrap++) {
+            a->size = sizes[s];
+            a->pos = wrap ? ADC_BUFFER_SIZE - sizes[s] / 2 : 0;
+            const char *where = wrap ? "wrap" : "start";
+
+            snprintf(name, sizeof(name), "acq/raw/%u/%s", a->size, where);
+            bench_Run(name, a->size * sizeof(int16_t), acqRaw, a);
+            snprintf(name, sizeof(name), "acq/volts/%u/%s", a->size, where);
+            bench_Run(name, a->size * sizeof(int16_t), acqVolts, a);
+        }
+    }
+
+    a->size = ADC_BUFFER_SIZE;
+    a->pos = 0;
+    bench_Run("acq/volts2/16384", 2 * a->size * sizeof(int16_t), acqVolts2, a);
+}
+
+static void benchCalib(acq_arg_t *a)
+{
+    for (uint32_t i = 0; i < ADC_BUFFER_SIZE; i++) {
+        a->raw[i] = (int16_t)(8191 * sin(i * 2 * M_PI / 1000));
+    }
+    a->size = ADC_BUFFER_SIZE;
+    bench_Run("calib/cnt_to_v/16384", a->size * sizeof(int16_t), calibConvert, a);
+}
+
+static void benchGenerate()
+{
+    static const struct {
+        rp_waveform_t waveform;
+        const char *name;
+    } waveforms[] = {
+        { RP_WAVEFORM_SINE,     "gen/synthesize/sine" },
+        { RP_WAVEFORM_SQUARE,   "gen/synthesize/square" },
+        { RP_WAVEFORM_TRIANGLE, "gen/synthesize/triangle" },
+        { RP_WAVEFORM_RAMP_UP,  "gen/synthesize/ramp_up" },
+        { RP_WAVEFORM_PWM,      "gen/synthesize/pwm" },
+    };
+
+    for (int i = 0; i < sizeof(waveforms) / sizeof(waveforms[0]); i++) {
+        gen_arg_t a = { .waveform = waveforms[i].waveform };
+        rp_GenWaveform(RP_CH_1, a.waveform);
+        bench_Run(waveforms[i].name, 0, genSynthesize, &a);
+    }
+}
+
+static void benchSpectrum()
+{
+    fft_arg_t *a = malloc(sizeof(fft_arg_t));
+    if (a == NULL || rp_spectr_hann_init() < 0 || rp_spectr_fft_init() < 0) {
+        fprintf(stderr, "Spectrum benchmark initialization failed\n");
+        free(a);
+        return;
+    }
+
+    for (int i = 0; i < SPECTR_FPGA_SIG_LEN; i++) {
+        a->cha[i] = sin(i * 2 * M_PI / 100);
+        a->chb[i] = cos(i * 2 * M_PI / 333);
+    }
+    bench_Run("spectrum/hann_fft/16384", 2 * SPECTR_FPGA_SIG_LEN * sizeof(double), spectrumFft, a);
+
+    rp_spectr_fft_clean();
+    rp_spectr_hann_clean();
+    free(a);
+}
+
+int main(int argc, char *argv[])
+{
+    int hardware = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "H" BENCH_OPTIONS)) != -1) {
+        if (opt == 'H') {
+            hardware = 1;
+        } else if (bench_Option(opt, optarg) != 1) {
+            fprintf(stderr, "Usage: %s [-H] " BENCH_USAGE "\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (!hardware) {
+        setenv("RP_SIMULATE", "1", 1);
+    }
+
+    int result = rp_Init();
+    if (result != RP_OK) {
+        fprintf(stderr, "rp_Init failed: %s\n", rp_GetError(result));
+        return 1;
+    }
+
+    acq_arg_t *a = calloc(1, sizeof(acq_arg_t));
+    if (a == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    benchAcquire(a);
+    benchCalib(a);
+    benchGenerate();
+    benchSpectrum();
+
+    free(a);
+    rp_Release();
+    return bench_Finish();
+}
@@ -0,0 +1,154 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya SCPI server macro benchmarks.
+ *
+ * Measures commands per second of short queries, sent one at a time and
+ * pipelined, and the transfer rate of full buffer readouts in BIN and ASCII
+ * format. The server can run on a board or on the host against the simulated
+ * register backend (RP_SIMULATE=1 scpi-server).
+ *
+ * Usage: scpi-bench [-p port] [-o results.json] [-B baseline.json] [-t %] [-m ms] [-c cpu] [host]
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "redpitaya_scpi.h"
+#include "bench.h"
+
+#define TIMEOUT_MS      5000
+#define PIPELINE_DEPTH  64
+#define BUFFER_SAMPLES  (16 * 1024)
+
+/* "-1.234567" per sample plus separator, generous for ASCII volts */
+#define ASCII_SIZE      (BUFFER_SAMPLES * 16)
+
+typedef struct {
+    rp_scpi_t *scpi;
+    const char *query;
+    rp_scpi_block_t block;
+    rp_scpi_reply_t reply;
+    char *buffer;
+    size_t size;
+    size_t len;
+    int failed;
+} scpi_arg_t;
+
+static void querySync(void *arg)
+{
+    scpi_arg_t *a = arg;
+    rp_scpi_ReplyInit(&a->reply, a->buffer, a->size);
+    a->reply.block = a->block;
+    if (rp_scpi_QuerySync(a->scpi, a->query, &a->reply, TIMEOUT_MS) < 0 || a->reply.truncated) {
+        a->failed = 1;
+    }
+    a->len = a->reply.len;
+}
+
+static void queryPipelined(void *arg)
+{
+    scpi_arg_t *a = arg;
+    rp_scpi_reply_t replies[PIPELINE_DEPTH];
+
+    for (int i = 0; i < PIPELINE_DEPTH; i++) {
+        rp_scpi_ReplyInit(&replies[i], NULL, 0);
+        if (rp_scpi_Query(a->scpi, a->query, &replies[i]) < 0) {
+            a->failed = 1;
+        }
+    }
+    if (rp_scpi_WaitAll(a->scpi, TIMEOUT_MS) < 0) {
+        a->failed = 1;
+    }
+}
+
+static int run(const char *name, scpi_arg_t *a, int bytes)
+{
+    // One untimed query tells the reply length used for MB/s
+    querySync(a);
+    if (!a->failed) {
+        bench_Run(name, bytes ? a->len : 0, querySync, a);
+    }
+    if (a->failed) {
+        fprintf(stderr, "%s: query %s failed\n", name, a->query);
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    uint16_t port = RP_SCPI_PORT;
+    const char *host = "localhost";
+    int opt;
+
+    while ((opt = getopt(argc, argv, "p:" BENCH_OPTIONS)) != -1) {
+        if (opt == 'p') {
+            port = atoi(optarg);
+        } else if (bench_Option(opt, optarg) != 1) {
+            fprintf(stderr, "Usage: %s [-p port] " BENCH_USAGE " [host]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (optind < argc) {
+        host = argv[optind];
+    }
+
+    rp_scpi_t scpi;
+    if (rp_scpi_Connect(&scpi, host, port) < 0) {
+        perror(host);
+        return 1;
+    }
+
+    scpi_arg_t a = { .scpi = &scpi, .query = "ACQ:DEC?" };
+    if (run("scpi/cmd/sequential", &a, 0) < 0) {
+        return 1;
+    }
+
+    // Timed per batch of PIPELINE_DEPTH queries
+    bench_Run("scpi/cmd/pipelined/64", 0, queryPipelined, &a);
+    if (a.failed) {
+        fprintf(stderr, "Pipelined query failed\n");
+        return 1;
+    }
+
+    a.size = ASCII_SIZE;
+    a.buffer = malloc(a.size);
+    if (a.buffer == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    a.query = "ACQ:SOUR1:DATA?";
+
+    rp_scpi_Send(&scpi, "ACQ:DATA:FORMAT BIN");
+    rp_scpi_Send(&scpi, "ACQ:DATA:UNITS RAW");
+    a.block = RP_SCPI_BLOCK_INT16;
+    if (run("scpi/data/bin/raw/16384", &a, 1) < 0) {
+        return 1;
+    }
+
+    rp_scpi_Send(&scpi, "ACQ:DATA:UNITS VOLTS");
+    a.block = RP_SCPI_BLOCK_FLOAT32;
+    if (run("scpi/data/bin/volts/16384", &a, 1) < 0) {
+        return 1;
+    }
+
+    rp_scpi_Send(&scpi, "ACQ:DATA:FORMAT ASCII");
+    a.block = RP_SCPI_BLOCK_RAW;
+    if (run("scpi/data/ascii/volts/16384", &a, 1) < 0) {
+        return 1;
+    }
+
+    rp_scpi_Close(&scpi);
+    free(a.buffer);
+    return bench_Finish();
+}
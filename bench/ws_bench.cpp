@@ -0,0 +1,109 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya websocket frame benchmarks.
+ *
+ * Measures what the websocket server does for every signal frame of an
+ * application: serializing the registered signals to JSON (ws_get_signals)
+ * and compressing them (ws_gzip), for two channels of various lengths.
+ *
+ * Usage: ws-bench [-o results.json] [-B baseline.json] [-t %] [-m ms] [-c cpu]
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C++ programming language.
+ * Please visit http://en.wikipedia.org/wiki/C%2B%2B
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <string>
+#include <vector>
+
+#include "DataManager.h"
+#include "CustomParameters.h"
+#include "bench.h"
+
+static const int sizes[] = { 1024, 2048, 16384 };
+
+CFloatSignal ch1("ch1", sizes[0], 0.0f);
+CFloatSignal ch2("ch2", sizes[0], 0.0f);
+
+// rp_sdk application callbacks, nothing to update in the benchmark
+void UpdateParams(void) {}
+void UpdateSignals(void) {}
+void OnNewParams(void) {}
+void OnNewSignals(void) {}
+
+struct frame_arg_t {
+	std::string json;
+	std::vector<char> out;
+	size_t out_size;
+};
+
+static void serialize(void *arg)
+{
+	frame_arg_t *a = (frame_arg_t *)arg;
+	a->json = ws_get_signals();
+}
+
+static void compress(void *arg)
+{
+	frame_arg_t *a = (frame_arg_t *)arg;
+	ws_gzip(a->json.c_str(), &a->out[0], &a->out_size);
+}
+
+static void frame(void *arg)
+{
+	serialize(arg);
+	compress(arg);
+}
+
+static void fill(int size)
+{
+	std::vector<float> v1(size), v2(size);
+	for (int i = 0; i < size; i++) {
+		v1[i] = sin(i * 2 * M_PI / 500);
+		v2[i] = 0.5 * cos(i * 2 * M_PI / 137);
+	}
+	ch1.Set(v1);
+	ch2.Set(v2);
+}
+
+int main(int argc, char *argv[])
+{
+	int opt;
+
+	while ((opt = getopt(argc, argv, BENCH_OPTIONS)) != -1) {
+		if (bench_Option(opt, optarg) != 1) {
+			fprintf(stderr, "Usage: %s " BENCH_USAGE "\n", argv[0]);
+			return 1;
+		}
+	}
+
+	frame_arg_t a;
+	char name[BENCH_NAME_SIZE];
+
+	for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+		fill(sizes[s]);
+		serialize(&a);
+		// Compressed data never outgrows its input by more than the gzip framing
+		a.out.resize(a.json.size() + 1024);
+
+		snprintf(name, sizeof(name), "ws/serialize/2x%d", sizes[s]);
+		bench_Run(name, a.json.size(), serialize, &a);
+		snprintf(name, sizeof(name), "ws/gzip/2x%d", sizes[s]);
+		bench_Run(name, a.json.size(), compress, &a);
+		snprintf(name, sizeof(name), "ws/frame/2x%d", sizes[s]);
+		bench_Run(name, a.json.size(), frame, &a);
+
+		fprintf(stderr, "%-44s %14zu bytes json, %zu bytes compressed\n", "", a.json.size(), a.out_size);
+	}
+
+	return bench_Finish();
+}
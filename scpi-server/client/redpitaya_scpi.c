@@ -0,0 +1,534 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya SCPI client library implementation
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <netdb.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include "redpitaya_scpi.h"
+
+/* Parser states of the reply at the head of the queue */
+enum {
+    PARSE_START,
+    PARSE_TEXT,
+    PARSE_BLOCK_HEADER,
+    PARSE_BLOCK_DATA
+};
+
+static rp_scpi_reply_t *head(rp_scpi_t *scpi)
+{
+    return scpi->count > 0 ? scpi->pending[scpi->head] : NULL;
+}
+
+static char *destination(rp_scpi_reply_t *reply)
+{
+    return reply->buffer != NULL ? reply->buffer : reply->value;
+}
+
+static size_t destinationSize(rp_scpi_reply_t *reply)
+{
+    return reply->buffer != NULL ? reply->size : sizeof(reply->value);
+}
+
+static void convertBlock(rp_scpi_reply_t *reply)
+{
+    char *data = destination(reply);
+
+    if (reply->block == RP_SCPI_BLOCK_INT16) {
+        for (size_t i = 0; i + sizeof(uint16_t) <= reply->len; i += sizeof(uint16_t)) {
+            uint16_t v;
+            memcpy(&v, data + i, sizeof(v));
+            v = ntohs(v);
+            memcpy(data + i, &v, sizeof(v));
+        }
+    }
+    else if (reply->block == RP_SCPI_BLOCK_FLOAT32) {
+        for (size_t i = 0; i + sizeof(uint32_t) <= reply->len; i += sizeof(uint32_t)) {
+            uint32_t v;
+            memcpy(&v, data + i, sizeof(v));
+            v = ntohl(v);
+            memcpy(data + i, &v, sizeof(v));
+        }
+    }
+}
+
+/**
+ * Completes the reply at the head of the queue.
+ */
+static void complete(rp_scpi_t *scpi, rp_scpi_state_t state)
+{
+    rp_scpi_reply_t *reply = head(scpi);
+
+    scpi->head = (scpi->head + 1) % RP_SCPI_MAX_PENDING;
+    scpi->count--;
+    scpi->parse = PARSE_START;
+
+    if (state == RP_SCPI_DONE && reply->binary) {
+        convertBlock(reply);
+    }
+    reply->state = state;
+    if (reply->callback) {
+        reply->callback(reply, reply->user);
+    }
+}
+
+static void failAll(rp_scpi_t *scpi)
+{
+    while (scpi->count > 0) {
+        complete(scpi, RP_SCPI_ERROR);
+    }
+}
+
+/**
+ * Appends received bytes to the reply at the head, dropping what does not fit.
+ */
+static void store(rp_scpi_reply_t *reply, const char *data, size_t len, size_t reserve)
+{
+    size_t size = destinationSize(reply);
+    size_t room = size > reply->len + reserve ? size - reply->len - reserve : 0;
+    size_t n = len < room ? len : room;
+
+    memcpy(destination(reply) + reply->len, data, n);
+    reply->len += n;
+    if (n < len) {
+        reply->truncated = 1;
+    }
+}
+
+/**
+ * Parses received bytes and completes replies.
+ */
+static void parse(rp_scpi_t *scpi)
+{
+    while (scpi->rx_pos < scpi->rx_len && scpi->count > 0) {
+        rp_scpi_reply_t *reply = head(scpi);
+        char *p = scpi->rx + scpi->rx_pos;
+        size_t avail = scpi->rx_len - scpi->rx_pos;
+
+        switch (scpi->parse) {
+        case PARSE_START:
+            // Skip the terminator left behind by a binary block
+            if (*p == '\r' || *p == '\n') {
+                scpi->rx_pos++;
+            } else if (*p == '#') {
+                reply->binary = 1;
+                scpi->header_len = 0;
+                scpi->parse = PARSE_BLOCK_HEADER;
+            } else {
+                scpi->parse = PARSE_TEXT;
+            }
+            break;
+
+        case PARSE_TEXT: {
+            char *eol = memchr(p, '\n', avail);
+            size_t n = eol ? (size_t)(eol - p) : avail;
+
+            store(reply, p, n, 1);
+            scpi->rx_pos += eol ? n + 1 : n;
+            if (eol) {
+                char *text = destination(reply);
+                if (reply->len > 0 && text[reply->len - 1] == '\r') {
+                    reply->len--;
+                }
+                text[reply->len] = '\0';
+                complete(scpi, reply->truncated ? RP_SCPI_ERROR : RP_SCPI_DONE);
+            }
+            break;
+        }
+
+        case PARSE_BLOCK_HEADER:
+            scpi->header[scpi->header_len++] = *p;
+            scpi->rx_pos++;
+
+            // "#<n><n digits of length>"
+            if (scpi->header_len >= 2) {
+                int digits = scpi->header[1] - '0';
+                if (digits == 0) {
+                    // Indefinite length block, terminated by the newline
+                    scpi->parse = PARSE_TEXT;
+                } else if (digits < 0 || digits > 9) {
+                    complete(scpi, RP_SCPI_ERROR);
+                } else if (scpi->header_len == (size_t)digits + 2) {
+                    scpi->header[scpi->header_len] = '\0';
+                    scpi->block_left = strtoul(scpi->header + 2, NULL, 10);
+                    scpi->parse = PARSE_BLOCK_DATA;
+                    if (scpi->block_left == 0) {
+                        complete(scpi, RP_SCPI_DONE);
+                    }
+                }
+            }
+            break;
+
+        case PARSE_BLOCK_DATA: {
+            size_t n = avail < scpi->block_left ? avail : scpi->block_left;
+
+            store(reply, p, n, 0);
+            scpi->rx_pos += n;
+            scpi->block_left -= n;
+            if (scpi->block_left == 0) {
+                complete(scpi, reply->truncated ? RP_SCPI_ERROR : RP_SCPI_DONE);
+            }
+            break;
+        }
+        }
+    }
+
+    // Bytes nobody asked for
+    if (scpi->count == 0) {
+        scpi->rx_pos = scpi->rx_len;
+    }
+}
+
+/**
+ * Waits up to timeout_ms for data and receives it. Block payload is received
+ * straight into the destination when nothing else is buffered.
+ * @return 1 when data was received, 0 on timeout, -1 on error.
+ */
+static int receive(rp_scpi_t *scpi, int timeout_ms)
+{
+    struct pollfd pfd = { .fd = scpi->fd, .events = POLLIN };
+    ssize_t n;
+
+    int ready = poll(&pfd, 1, timeout_ms);
+    if (ready < 0) {
+        return errno == EINTR ? 0 : -1;
+    }
+    if (ready == 0) {
+        return 0;
+    }
+
+    if (scpi->rx_pos == scpi->rx_len) {
+        scpi->rx_pos = scpi->rx_len = 0;
+    }
+
+    rp_scpi_reply_t *reply = head(scpi);
+    if (reply != NULL && scpi->parse == PARSE_BLOCK_DATA && scpi->rx_pos == scpi->rx_len
+            && !reply->truncated && reply->len + scpi->block_left <= destinationSize(reply)) {
+        n = recv(scpi->fd, destination(reply) + reply->len, scpi->block_left, MSG_DONTWAIT);
+        if (n > 0) {
+            reply->len += n;
+            scpi->block_left -= n;
+            if (scpi->block_left == 0) {
+                complete(scpi, RP_SCPI_DONE);
+            }
+            return 1;
+        }
+    } else {
+        if (scpi->rx_pos > 0) {
+            memmove(scpi->rx, scpi->rx + scpi->rx_pos, scpi->rx_len - scpi->rx_pos);
+            scpi->rx_len -= scpi->rx_pos;
+            scpi->rx_pos = 0;
+        }
+        n = recv(scpi->fd, scpi->rx + scpi->rx_len, sizeof(scpi->rx) - scpi->rx_len, MSG_DONTWAIT);
+        if (n > 0) {
+            scpi->rx_len += n;
+            parse(scpi);
+            return 1;
+        }
+    }
+
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+        return 0;
+    }
+    if (n == 0) {
+        errno = ECONNRESET;
+    }
+    failAll(scpi);
+    return -1;
+}
+
+/**
+ * Sends a buffer, receiving answers meanwhile so that the server never
+ * blocks on a full socket while we block on ours.
+ */
+static int sendAll(rp_scpi_t *scpi, const char *data, size_t len)
+{
+    while (len > 0) {
+        struct pollfd pfd = { .fd = scpi->fd, .events = POLLOUT | (scpi->count ? POLLIN : 0) };
+
+        if (poll(&pfd, 1, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        if ((pfd.revents & POLLIN) && receive(scpi, 0) < 0) {
+            return -1;
+        }
+        if (pfd.revents & (POLLOUT | POLLERR | POLLHUP)) {
+            ssize_t n = send(scpi->fd, data, len, MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+                    continue;
+                }
+                failAll(scpi);
+                return -1;
+            }
+            data += n;
+            len -= n;
+        }
+    }
+    return 0;
+}
+
+static int append(rp_scpi_t *scpi, const char *command)
+{
+    size_t len = strlen(command);
+
+    if (scpi->tx_len + len + 2 > sizeof(scpi->tx) && rp_scpi_Flush(scpi) < 0) {
+        return -1;
+    }
+    if (len + 2 > sizeof(scpi->tx)) {
+        return sendAll(scpi, command, len) < 0 || sendAll(scpi, "\r\n", 2) < 0 ? -1 : 0;
+    }
+
+    memcpy(scpi->tx + scpi->tx_len, command, len);
+    memcpy(scpi->tx + scpi->tx_len + len, "\r\n", 2);
+    scpi->tx_len += len + 2;
+    return 0;
+}
+
+void rp_scpi_ReplyInit(rp_scpi_reply_t *reply, void *buffer, size_t size)
+{
+    memset(reply, 0, sizeof(*reply));
+    reply->buffer = buffer;
+    reply->size = size;
+}
+
+int rp_scpi_Connect(rp_scpi_t *scpi, const char *host, uint16_t port)
+{
+    struct addrinfo hints, *res, *ai;
+    char service[8];
+    int one = 1;
+
+    memset(scpi, 0, sizeof(*scpi));
+    scpi->fd = -1;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    snprintf(service, sizeof(service), "%u", port);
+
+    if (getaddrinfo(host, service, &hints, &res) != 0) {
+        errno = EHOSTUNREACH;
+        return -1;
+    }
+
+    for (ai = res; ai != NULL; ai = ai->ai_next) {
+        scpi->fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (scpi->fd < 0) {
+            continue;
+        }
+        if (connect(scpi->fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+            break;
+        }
+        close(scpi->fd);
+        scpi->fd = -1;
+    }
+    freeaddrinfo(res);
+
+    if (scpi->fd < 0) {
+        return -1;
+    }
+    setsockopt(scpi->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return 0;
+}
+
+void rp_scpi_Close(rp_scpi_t *scpi)
+{
+    failAll(scpi);
+    if (scpi->fd >= 0) {
+        close(scpi->fd);
+        scpi->fd = -1;
+    }
+}
+
+int rp_scpi_Send(rp_scpi_t *scpi, const char *command)
+{
+    return append(scpi, command);
+}
+
+int rp_scpi_Query(rp_scpi_t *scpi, const char *command, rp_scpi_reply_t *reply)
+{
+    // Queue full, make room by completing the oldest query
+    if (scpi->count == RP_SCPI_MAX_PENDING && rp_scpi_Wait(scpi, head(scpi), -1) < 0) {
+        return -1;
+    }
+
+    reply->state = RP_SCPI_PENDING;
+    reply->binary = 0;
+    reply->truncated = 0;
+    reply->len = 0;
+
+    scpi->pending[(scpi->head + scpi->count) % RP_SCPI_MAX_PENDING] = reply;
+    scpi->count++;
+
+    return append(scpi, command);
+}
+
+int rp_scpi_Flush(rp_scpi_t *scpi)
+{
+    size_t len = scpi->tx_len;
+
+    scpi->tx_len = 0;
+    return len > 0 ? sendAll(scpi, scpi->tx, len) : 0;
+}
+
+int rp_scpi_Wait(rp_scpi_t *scpi, rp_scpi_reply_t *reply, int timeout_ms)
+{
+    if (rp_scpi_Flush(scpi) < 0) {
+        return -1;
+    }
+
+    while (reply->state == RP_SCPI_PENDING) {
+        int result = receive(scpi, timeout_ms);
+        if (result < 0) {
+            return -1;
+        }
+        if (result == 0 && timeout_ms >= 0) {
+            errno = ETIMEDOUT;
+            return -1;
+        }
+    }
+
+    if (reply->state != RP_SCPI_DONE) {
+        errno = ENOBUFS;
+        return -1;
+    }
+    return 0;
+}
+
+int rp_scpi_WaitAll(rp_scpi_t *scpi, int timeout_ms)
+{
+    if (rp_scpi_Flush(scpi) < 0) {
+        return -1;
+    }
+
+    while (scpi->count > 0) {
+        int result = receive(scpi, timeout_ms);
+        if (result < 0) {
+            return -1;
+        }
+        if (result == 0 && timeout_ms >= 0) {
+            errno = ETIMEDOUT;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int rp_scpi_Process(rp_scpi_t *scpi)
+{
+    int result;
+
+    while ((result = receive(scpi, 0)) > 0) {
+    }
+    return result;
+}
+
+int rp_scpi_QuerySync(rp_scpi_t *scpi, const char *command, rp_scpi_reply_t *reply, int timeout_ms)
+{
+    if (rp_scpi_Query(scpi, command, reply) < 0) {
+        return -1;
+    }
+    return rp_scpi_Wait(scpi, reply, timeout_ms);
+}
+
+void rp_scpi_PoolInit(rp_scpi_pool_t *pool)
+{
+    memset(pool, 0, sizeof(*pool));
+}
+
+int rp_scpi_PoolAdd(rp_scpi_pool_t *pool, const char *host, uint16_t port)
+{
+    if (pool->count == RP_SCPI_POOL_MAX) {
+        errno = ENOSPC;
+        return -1;
+    }
+
+    rp_scpi_t *scpi = malloc(sizeof(rp_scpi_t));
+    if (scpi == NULL) {
+        return -1;
+    }
+    if (rp_scpi_Connect(scpi, host, port) < 0) {
+        free(scpi);
+        return -1;
+    }
+
+    pool->conn[pool->count] = scpi;
+    return pool->count++;
+}
+
+rp_scpi_t *rp_scpi_PoolGet(rp_scpi_pool_t *pool, int index)
+{
+    return index >= 0 && index < pool->count ? pool->conn[index] : NULL;
+}
+
+int rp_scpi_PoolWaitAll(rp_scpi_pool_t *pool, int timeout_ms)
+{
+    struct pollfd pfd[RP_SCPI_POOL_MAX];
+    rp_scpi_t *conn[RP_SCPI_POOL_MAX];
+
+    for (int i = 0; i < pool->count; i++) {
+        if (rp_scpi_Flush(pool->conn[i]) < 0) {
+            return -1;
+        }
+    }
+
+    for (;;) {
+        int n = 0;
+        for (int i = 0; i < pool->count; i++) {
+            if (pool->conn[i]->count > 0) {
+                conn[n] = pool->conn[i];
+                pfd[n] = (struct pollfd){ .fd = conn[n]->fd, .events = POLLIN };
+                n++;
+            }
+        }
+        if (n == 0) {
+            return 0;
+        }
+
+        int ready = poll(pfd, n, timeout_ms);
+        if (ready < 0 && errno != EINTR) {
+            return -1;
+        }
+        if (ready == 0) {
+            errno = ETIMEDOUT;
+            return -1;
+        }
+
+        for (int i = 0; i < n; i++) {
+            if (pfd[i].revents && rp_scpi_Process(conn[i]) < 0) {
+                return -1;
+            }
+        }
+    }
+}
+
+void rp_scpi_PoolClose(rp_scpi_pool_t *pool)
+{
+    for (int i = 0; i < pool->count; i++) {
+        rp_scpi_Close(pool->conn[i]);
+        free(pool->conn[i]);
+    }
+    pool->count = 0;
+}
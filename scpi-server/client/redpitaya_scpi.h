@@ -0,0 +1,180 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya SCPI client library interface
+ *
+ * Commands and queries are queued into a transmit buffer and sent without
+ * waiting for the previous answer (pipelining). Every query is tied to a
+ * caller owned rp_scpi_reply_t, which acts as a future: it is completed in
+ * order as answers arrive, optionally invoking a callback, and can be waited
+ * for individually. IEEE-488.2 definite length blocks (#<n><len><data>, as
+ * sent with ACQ:DATA:FORMAT BIN) are received directly into the caller buffer.
+ *
+ * The library is single threaded; all progress is made inside rp_scpi_Wait*,
+ * rp_scpi_Process and the rp_scpi_Pool* functions.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef REDPITAYA_SCPI_H_
+#define REDPITAYA_SCPI_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define RP_SCPI_PORT            5000
+
+/* @brief Maximal number of queries waiting for an answer on one connection. */
+#define RP_SCPI_MAX_PENDING     256
+
+#define RP_SCPI_TX_BUFF_SIZE    4096
+#define RP_SCPI_RX_BUFF_SIZE    4096
+
+/* @brief Size of the reply inline buffer, used when no buffer is given. */
+#define RP_SCPI_VALUE_SIZE      128
+
+/* @brief Maximal number of connections in a pool. */
+#define RP_SCPI_POOL_MAX        16
+
+typedef enum {
+    RP_SCPI_PENDING,    //!< Queued, answer not received yet
+    RP_SCPI_DONE,       //!< Answer received
+    RP_SCPI_ERROR       //!< Connection failed, answer did not fit or was discarded
+} rp_scpi_state_t;
+
+/**
+ * Byte order conversion applied to binary blocks once received.
+ * The server sends binary data in network (big endian) order.
+ */
+typedef enum {
+    RP_SCPI_BLOCK_RAW,      //!< Leave data as received
+    RP_SCPI_BLOCK_INT16,    //!< Convert to host order 16 bit words
+    RP_SCPI_BLOCK_FLOAT32   //!< Convert to host order 32 bit floats
+} rp_scpi_block_t;
+
+struct rp_scpi_reply;
+
+typedef void (*rp_scpi_callback_t)(struct rp_scpi_reply *reply, void *user);
+
+typedef struct rp_scpi_reply {
+    rp_scpi_state_t state;
+    int binary;                 //!< Non zero when the answer was a binary block
+    int truncated;              //!< Non zero when the answer did not fit into the destination
+    char *buffer;               //!< Destination, value is used when NULL
+    size_t size;                //!< Destination size
+    size_t len;                 //!< Received length (text is also NUL terminated)
+    rp_scpi_block_t block;      //!< Conversion of binary answers
+    rp_scpi_callback_t callback;
+    void *user;
+    char value[RP_SCPI_VALUE_SIZE];
+} rp_scpi_reply_t;
+
+typedef struct {
+    int fd;
+
+    char tx[RP_SCPI_TX_BUFF_SIZE];
+    size_t tx_len;
+
+    char rx[RP_SCPI_RX_BUFF_SIZE];
+    size_t rx_pos;
+    size_t rx_len;
+
+    /* Pending replies, in order of the queries */
+    rp_scpi_reply_t *pending[RP_SCPI_MAX_PENDING];
+    unsigned head;
+    unsigned count;
+
+    /* Parser state of the reply at the head */
+    int parse;
+    size_t block_left;
+    char header[12];
+    size_t header_len;
+} rp_scpi_t;
+
+typedef struct {
+    rp_scpi_t *conn[RP_SCPI_POOL_MAX];
+    int count;
+} rp_scpi_pool_t;
+
+/**
+ * Initializes a reply. When buffer is NULL the answer is stored into the
+ * reply's inline value buffer.
+ */
+void rp_scpi_ReplyInit(rp_scpi_reply_t *reply, void *buffer, size_t size);
+
+/**
+ * Connects to a SCPI server.
+ * @return 0 on success, -1 on failure (errno is set).
+ */
+int rp_scpi_Connect(rp_scpi_t *scpi, const char *host, uint16_t port);
+
+/**
+ * Fails all pending replies and closes the connection.
+ */
+void rp_scpi_Close(rp_scpi_t *scpi);
+
+/**
+ * Queues a command without an answer.
+ */
+int rp_scpi_Send(rp_scpi_t *scpi, const char *command);
+
+/**
+ * Queues a query. The reply must stay valid until it is completed.
+ * A query the server does not answer (e.g. a SCPI error) stalls all later
+ * replies; such failures show up as timeouts in rp_scpi_Wait.
+ */
+int rp_scpi_Query(rp_scpi_t *scpi, const char *command, rp_scpi_reply_t *reply);
+
+/**
+ * Sends everything queued so far.
+ */
+int rp_scpi_Flush(rp_scpi_t *scpi);
+
+/**
+ * Flushes and receives answers until the given reply is complete.
+ * @param timeout_ms Time without progress after which waiting fails, -1 waits forever.
+ * @return 0 when the reply is done, -1 on error or timeout.
+ */
+int rp_scpi_Wait(rp_scpi_t *scpi, rp_scpi_reply_t *reply, int timeout_ms);
+
+/**
+ * Flushes and receives answers until no query is pending.
+ */
+int rp_scpi_WaitAll(rp_scpi_t *scpi, int timeout_ms);
+
+/**
+ * Receives and completes replies from data that is available on the socket,
+ * without blocking. Used with external poll loops.
+ */
+int rp_scpi_Process(rp_scpi_t *scpi);
+
+/**
+ * Sends a query and waits for its answer, the non pipelined way.
+ */
+int rp_scpi_QuerySync(rp_scpi_t *scpi, const char *command, rp_scpi_reply_t *reply, int timeout_ms);
+
+void rp_scpi_PoolInit(rp_scpi_pool_t *pool);
+
+/**
+ * Connects to another board and adds the connection to the pool.
+ * @return Index of the connection in the pool, -1 on failure.
+ */
+int rp_scpi_PoolAdd(rp_scpi_pool_t *pool, const char *host, uint16_t port);
+
+rp_scpi_t *rp_scpi_PoolGet(rp_scpi_pool_t *pool, int index);
+
+/**
+ * Flushes all connections and serves them together until no query is
+ * pending on any of them.
+ */
+int rp_scpi_PoolWaitAll(rp_scpi_pool_t *pool, int timeout_ms);
+
+void rp_scpi_PoolClose(rp_scpi_pool_t *pool);
+
+#endif /* REDPITAYA_SCPI_H_ */
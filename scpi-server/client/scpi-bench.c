@@ -0,0 +1,138 @@
+/**
+ * $Id: $
+ *
+ * @brief SCPI client benchmark, sequential versus pipelined queries.
+ *
+ * Runs the same query sequence once the classic way (send, wait for the
+ * answer, send the next one) and once pipelined, against one or more boards.
+ * With -b the buffer query ACQ:SOUR1:DATA? is used in binary format instead
+ * of the short ACQ:DEC? query.
+ *
+ * Usage: scpi-bench [-n queries] [-b] [-p port] host [host ...]
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "redpitaya_scpi.h"
+
+#define TIMEOUT_MS      5000
+#define BUFFER_SAMPLES  (16 * 1024)
+
+static double monotonicS()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void report(const char *name, int queries, size_t bytes, double elapsed)
+{
+    printf("%-10s %6d queries in %8.3f s: %9.1f queries/s, %8.3f MB/s\n",
+           name, queries, elapsed, queries / elapsed, bytes / elapsed / 1e6);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *query = "ACQ:DEC?";
+    int queries = 1000;
+    int binary = 0;
+    uint16_t port = RP_SCPI_PORT;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:bp:")) != -1) {
+        switch (opt) {
+        case 'n': queries = atoi(optarg); break;
+        case 'b': binary = 1; break;
+        case 'p': port = atoi(optarg); break;
+        default:
+            optind = argc;
+            break;
+        }
+    }
+    if (optind >= argc || queries <= 0) {
+        fprintf(stderr, "Usage: %s [-n queries] [-b] [-p port] host [host ...]\n", argv[0]);
+        return 1;
+    }
+
+    rp_scpi_pool_t pool;
+    rp_scpi_PoolInit(&pool);
+    for (int i = optind; i < argc; i++) {
+        if (rp_scpi_PoolAdd(&pool, argv[i], port) < 0) {
+            fprintf(stderr, "Failed to connect to %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    size_t size = binary ? BUFFER_SAMPLES * sizeof(int16_t) : RP_SCPI_VALUE_SIZE;
+    rp_scpi_reply_t *replies = calloc(queries, sizeof(rp_scpi_reply_t));
+    char *buffers = binary ? malloc((size_t)queries * size) : NULL;
+    if (replies == NULL || (binary && buffers == NULL)) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    for (int i = 0; i < queries; i++) {
+        rp_scpi_ReplyInit(&replies[i], binary ? buffers + i * size : NULL, size);
+        replies[i].block = RP_SCPI_BLOCK_INT16;
+    }
+
+    if (binary) {
+        query = "ACQ:SOUR1:DATA?";
+        for (int i = 0; i < pool.count; i++) {
+            rp_scpi_Send(rp_scpi_PoolGet(&pool, i), "ACQ:DATA:FORMAT BIN");
+            rp_scpi_Send(rp_scpi_PoolGet(&pool, i), "ACQ:DATA:UNITS RAW");
+            rp_scpi_Flush(rp_scpi_PoolGet(&pool, i));
+        }
+    }
+
+    // Sequential, one query in flight at a time
+    size_t bytes = 0;
+    double start = monotonicS();
+    for (int i = 0; i < queries; i++) {
+        if (rp_scpi_QuerySync(rp_scpi_PoolGet(&pool, i % pool.count), query, &replies[i], TIMEOUT_MS) < 0) {
+            perror("Sequential query failed");
+            return 1;
+        }
+        bytes += replies[i].len;
+    }
+    report("sequential", queries, bytes, monotonicS() - start);
+
+    // Pipelined, all queries queued before waiting, spread over the pool
+    bytes = 0;
+    start = monotonicS();
+    for (int i = 0; i < queries; i++) {
+        if (rp_scpi_Query(rp_scpi_PoolGet(&pool, i % pool.count), query, &replies[i]) < 0) {
+            perror("Pipelined query failed");
+            return 1;
+        }
+    }
+    if (rp_scpi_PoolWaitAll(&pool, TIMEOUT_MS) < 0) {
+        perror("Pipelined query failed");
+        return 1;
+    }
+    for (int i = 0; i < queries; i++) {
+        if (replies[i].state != RP_SCPI_DONE) {
+            fprintf(stderr, "Query %d failed\n", i);
+            return 1;
+        }
+        bytes += replies[i].len;
+    }
+    report("pipelined", queries, bytes, monotonicS() - start);
+
+    rp_scpi_PoolClose(&pool);
+    free(buffers);
+    free(replies);
+    return 0;
+}
@@ -26,6 +26,16 @@
 
 rp_scpi_acq_unit_t unit     = RP_SCPI_VOLTS;        // default value
 
+/* Decoder settings, ACQ:DECO:* - thresholds for 1 V logic on the LV range */
+static rp_decode_cfg_t decode_cfg = {
+    .protocol = RP_DECODE_UART,
+    .channel = RP_CH_1,
+    .level = { 0.5, 0.5 },
+    .hyst = { 0.1, 0.1 },
+};
+static float decode_rate = 0;
+static rp_decode_event_t decode_events[ADC_BUFFER_SIZE];
+
 /* These structures are a direct API mirror 
 and should not be altered! */
 const scpi_choice_def_t scpi_RpUnits[] = {
@@ -64,6 +74,20 @@ const scpi_choice_def_t scpi_RpTrigSrc[] = {
     SCPI_CHOICE_LIST_END
 };
 
+const scpi_choice_def_t scpi_RpDecodeProt[] = {
+    {"UART", 0},
+    {"I2C",  1},
+    {"SPI",  2},
+    SCPI_CHOICE_LIST_END
+};
+
+const scpi_choice_def_t scpi_RpDecodeParity[] = {
+    {"NONE", 0},
+    {"EVEN", 1},
+    {"ODD",  2},
+    SCPI_CHOICE_LIST_END
+};
+
 const scpi_choice_def_t scpi_RpTrigStat[] = {
     {"TD",   0},
     {"WAIT", 1},
@@ -850,3 +874,442 @@ scpi_result_t RP_AcqBufferSizeQ(scpi_t *context) {
     RP_LOG(LOG_INFO, "*ACQ:BUF:SIZE?? Successfully returned buffer size.\n");
     return SCPI_RES_OK;
 }
+
+scpi_result_t RP_AcqMaskData(scpi_t *context) {
+
+    rp_channel_t channel;
+    int32_t offset;
+    float min_buf[ADC_BUFFER_SIZE], max_buf[ADC_BUFFER_SIZE];
+    int16_t min[ADC_BUFFER_SIZE], max[ADC_BUFFER_SIZE];
+    uint32_t min_size, max_size;
+
+    if (RP_ParseChArgv(context, &channel) != RP_OK){
+        return SCPI_RES_ERR;
+    }
+
+    if(!SCPI_ParamInt32(context, &offset, true)){
+        RP_LOG(LOG_ERR, "*ACQ:SOUR<n>:MASK:DATA is missing OFFSET parameter.\n");
+        return SCPI_RES_ERR;
+    }
+
+    if(!SCPI_ParamBufferFloat(context, min_buf, &min_size, true) ||
+       !SCPI_ParamBufferFloat(context, max_buf, &max_size, true)){
+        RP_LOG(LOG_ERR, "*ACQ:SOUR<n>:MASK:DATA is missing MIN or MAX parameter.\n");
+        return SCPI_RES_ERR;
+    }
+
+    if(min_size != max_size){
+        RP_LOG(LOG_ERR, "*ACQ:SOUR<n>:MASK:DATA MIN and MAX differ in size.\n");
+        return SCPI_RES_ERR;
+    }
+
+    for(uint32_t i = 0; i < min_size; i++){
+        min[i] = min_buf[i];
+        max[i] = max_buf[i];
+    }
+
+    int result = rp_AcqMaskSet(channel, offset, min, max, min_size);
+    if(result != RP_OK){
+        RP_LOG(LOG_ERR, "*ACQ:SOUR<n>:MASK:DATA Failed to set mask: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    RP_LOG(LOG_INFO, "*ACQ:SOUR<n>:MASK:DATA Successfully set mask.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqMaskGolden(scpi_t *context) {
+
+    rp_channel_t channel;
+    int32_t offset;
+    uint32_t size, tolerance, trig_pos;
+    int16_t golden[ADC_BUFFER_SIZE];
+
+    if (RP_ParseChArgv(context, &channel) != RP_OK){
+        return SCPI_RES_ERR;
+    }
+
+    if(!SCPI_ParamInt32(context, &offset, true) ||
+       !SCPI_ParamUInt32(context, &size, true) ||
+       !SCPI_ParamUInt32(context, &tolerance, true)){
+        RP_LOG(LOG_ERR, "*ACQ:SOUR<n>:MASK:GOLD is missing OFFSET, SIZE or TOLERANCE parameter.\n");
+        return SCPI_RES_ERR;
+    }
+
+    if(size > ADC_BUFFER_SIZE || tolerance > UINT16_MAX){
+        RP_LOG(LOG_ERR, "*ACQ:SOUR<n>:MASK:GOLD SIZE or TOLERANCE out of range.\n");
+        return SCPI_RES_ERR;
+    }
+
+    /* The golden waveform is the current capture */
+    int result = rp_AcqGetWritePointerAtTrig(&trig_pos);
+    if(result == RP_OK){
+        result = rp_AcqGetDataRaw(channel, (trig_pos + ADC_BUFFER_SIZE + offset) % ADC_BUFFER_SIZE,
+                                  &size, golden);
+    }
+    if(result == RP_OK){
+        result = rp_AcqMaskSetFromGolden(channel, offset, golden, size, tolerance);
+    }
+    if(result != RP_OK){
+        RP_LOG(LOG_ERR, "*ACQ:SOUR<n>:MASK:GOLD Failed to set mask: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    RP_LOG(LOG_INFO, "*ACQ:SOUR<n>:MASK:GOLD Successfully set mask.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqMaskClear(scpi_t *context) {
+
+    rp_channel_t channel;
+
+    if (RP_ParseChArgv(context, &channel) != RP_OK){
+        return SCPI_RES_ERR;
+    }
+
+    int result = rp_AcqMaskClear(channel);
+    if(result != RP_OK){
+        RP_LOG(LOG_ERR, "*ACQ:SOUR<n>:MASK:CLR Failed to clear mask: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    RP_LOG(LOG_INFO, "*ACQ:SOUR<n>:MASK:CLR Successfully cleared mask.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqMaskViolationsQ(scpi_t *context) {
+
+    rp_channel_t channel;
+    uint32_t counts[ADC_BUFFER_SIZE];
+    uint32_t size = ADC_BUFFER_SIZE;
+
+    if (RP_ParseChArgv(context, &channel) != RP_OK){
+        return SCPI_RES_ERR;
+    }
+
+    int result = rp_AcqMaskGetViolations(channel, counts, &size);
+    if(result != RP_OK){
+        RP_LOG(LOG_ERR, "*ACQ:SOUR<n>:MASK:VIOL? Failed to get violations: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    for(uint32_t i = 0; i < size; i++){
+        SCPI_ResultUInt32Base(context, counts[i], 10);
+    }
+
+    RP_LOG(LOG_INFO, "*ACQ:SOUR<n>:MASK:VIOL? Successfully returned violations.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqMaskFailDataQ(scpi_t *context) {
+
+    rp_channel_t channel;
+    int16_t buffer[ADC_BUFFER_SIZE];
+    uint32_t size = ADC_BUFFER_SIZE;
+
+    if (RP_ParseChArgv(context, &channel) != RP_OK){
+        return SCPI_RES_ERR;
+    }
+
+    int result = rp_AcqMaskGetFailData(channel, buffer, &size);
+    if(result != RP_OK){
+        RP_LOG(LOG_ERR, "*ACQ:SOUR<n>:MASK:FAIL? Failed to get failed capture: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    SCPI_ResultBufferInt16(context, buffer, size);
+
+    RP_LOG(LOG_INFO, "*ACQ:SOUR<n>:MASK:FAIL? Successfully returned failed capture.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqMaskTestQ(scpi_t *context) {
+
+    bool pass;
+
+    int result = rp_AcqMaskTest(&pass);
+    if(result != RP_OK){
+        RP_LOG(LOG_ERR, "*ACQ:MASK:TEST? Failed to test capture: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    SCPI_ResultMnemonic(context, pass ? "PASS" : "FAIL");
+
+    RP_LOG(LOG_INFO, "*ACQ:MASK:TEST? Successfully tested capture.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqMaskStart(scpi_t *context) {
+
+    int32_t trig_src;
+    scpi_bool_t stop_on_fail;
+
+    if (!SCPI_ParamChoice(context, scpi_RpTrigSrc, &trig_src, true)) {
+        RP_LOG(LOG_ERR, "*ACQ:MASK:START is missing first parameter.\n");
+        return SCPI_RES_ERR;
+    }
+
+    // read second parameter STOP ON FAIL (OFF,ON)
+    if (!SCPI_ParamBool(context, &stop_on_fail, false)) {
+        stop_on_fail = false;
+    }
+
+    int result = rp_AcqMaskStart(trig_src, stop_on_fail);
+    if(result != RP_OK){
+        RP_LOG(LOG_ERR, "*ACQ:MASK:START Failed to start mask test: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    RP_LOG(LOG_INFO, "*ACQ:MASK:START Successfully started mask test.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqMaskStop(scpi_t *context) {
+
+    int result = rp_AcqMaskStop();
+    if(result != RP_OK){
+        RP_LOG(LOG_ERR, "*ACQ:MASK:STOP Failed to stop mask test: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    RP_LOG(LOG_INFO, "*ACQ:MASK:STOP Successfully stopped mask test.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqMaskStatsQ(scpi_t *context) {
+
+    rp_mask_stats_t stats;
+    char text[200];
+
+    int result = rp_AcqMaskGetStats(&stats);
+    if(result != RP_OK){
+        RP_LOG(LOG_ERR, "*ACQ:MASK:STAT? Failed to get statistics: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    /* tested,passed,failed,violations,channel,first,last,running - channel
+     * and positions of the last failure, the channel counts from 1 */
+    snprintf(text, sizeof(text), "%llu,%llu,%llu,%llu,%d,%d,%d,%d",
+             (unsigned long long)stats.tested, (unsigned long long)stats.passed,
+             (unsigned long long)stats.failed, (unsigned long long)stats.violations,
+             stats.fail_channel + 1, stats.fail_first, stats.fail_last, stats.running);
+    SCPI_ResultMnemonic(context, text);
+
+    RP_LOG(LOG_INFO, "*ACQ:MASK:STAT? Successfully returned statistics.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqMaskStatsReset(scpi_t *context) {
+
+    int result = rp_AcqMaskResetStats();
+    if(result != RP_OK){
+        RP_LOG(LOG_ERR, "*ACQ:MASK:STAT:RES Failed to reset statistics: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    RP_LOG(LOG_INFO, "*ACQ:MASK:STAT:RES Successfully reset statistics.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqAutoScaleQ(scpi_t *context) {
+
+    rp_auto_scale_t scale;
+    const char *trig_name;
+    char text[100];
+
+    int result = rp_AcqAutoScale(true, &scale);
+    if(result != RP_OK){
+        RP_LOG(LOG_ERR, "*ACQ:AUTO? Failed to autoscale: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    if(!SCPI_ChoiceToName(scpi_RpTrigSrc, scale.trigger_source, &trig_name)){
+        RP_LOG(LOG_ERR, "*ACQ:AUTO? Failed to parse trigger source.\n");
+        return SCPI_RES_ERR;
+    }
+
+    /* trigger source,level,period - the decimation and level are applied,
+     * the source is left to ACQ:TRIG */
+    snprintf(text, sizeof(text), "%s,%g,%g", trig_name, scale.trigger_level, scale.period);
+    SCPI_ResultMnemonic(context, text);
+
+    RP_LOG(LOG_INFO, "*ACQ:AUTO? Successfully autoscaled.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqDecodeProtocol(scpi_t *context) {
+
+    int32_t protocol;
+
+    if (!SCPI_ParamChoice(context, scpi_RpDecodeProt, &protocol, true)) {
+        RP_LOG(LOG_ERR, "*ACQ:DECO:PROT is missing first parameter.\n");
+        return SCPI_RES_ERR;
+    }
+    decode_cfg.protocol = protocol;
+
+    RP_LOG(LOG_INFO, "*ACQ:DECO:PROT Successfully set decoder protocol.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqDecodeProtocolQ(scpi_t *context) {
+
+    const char *name;
+
+    if(!SCPI_ChoiceToName(scpi_RpDecodeProt, decode_cfg.protocol, &name)){
+        RP_LOG(LOG_ERR, "*ACQ:DECO:PROT? Failed to parse decoder protocol.\n");
+        return SCPI_RES_ERR;
+    }
+    SCPI_ResultMnemonic(context, name);
+
+    RP_LOG(LOG_INFO, "*ACQ:DECO:PROT? Successfully returned decoder protocol.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqDecodeSource(scpi_t *context) {
+
+    uint32_t source;
+
+    if (!SCPI_ParamUInt32(context, &source, true) || source < 1 || source > 2) {
+        RP_LOG(LOG_ERR, "*ACQ:DECO:SOUR is missing first parameter or it is not 1 or 2.\n");
+        return SCPI_RES_ERR;
+    }
+    decode_cfg.channel = source - 1;
+
+    RP_LOG(LOG_INFO, "*ACQ:DECO:SOUR Successfully set decoder data source.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqDecodeLevel(scpi_t *context) {
+
+    rp_channel_t channel;
+    float level, hyst;
+
+    if (RP_ParseChArgv(context, &channel) != RP_OK){
+        return SCPI_RES_ERR;
+    }
+
+    if (!SCPI_ParamFloat(context, &level, true)) {
+        RP_LOG(LOG_ERR, "*ACQ:SOUR<n>:DECO:LEV is missing first parameter.\n");
+        return SCPI_RES_ERR;
+    }
+
+    // read second parameter HYSTERESIS (optional)
+    if (!SCPI_ParamFloat(context, &hyst, false)) {
+        hyst = decode_cfg.hyst[channel];
+    }
+    decode_cfg.level[channel] = level;
+    decode_cfg.hyst[channel] = hyst;
+
+    RP_LOG(LOG_INFO, "*ACQ:SOUR<n>:DECO:LEV Successfully set decoder threshold.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqDecodeUart(scpi_t *context) {
+
+    uint32_t baud, bits;
+    int32_t parity;
+    scpi_bool_t invert;
+
+    // read first parameter BAUD RATE, 0 for auto
+    if (!SCPI_ParamUInt32(context, &baud, true)) {
+        RP_LOG(LOG_ERR, "*ACQ:DECO:UART is missing first parameter.\n");
+        return SCPI_RES_ERR;
+    }
+    // read optional parameters DATA BITS, PARITY (NONE,EVEN,ODD), INVERT (OFF,ON)
+    if (!SCPI_ParamUInt32(context, &bits, false)) {
+        bits = 8;
+    }
+    if (!SCPI_ParamChoice(context, scpi_RpDecodeParity, &parity, false)) {
+        parity = RP_DECODE_PARITY_NONE;
+    }
+    if (!SCPI_ParamBool(context, &invert, false)) {
+        invert = false;
+    }
+    if (bits < 5 || bits > 9) {
+        RP_LOG(LOG_ERR, "*ACQ:DECO:UART Data bits out of range.\n");
+        return SCPI_RES_ERR;
+    }
+
+    decode_cfg.baud = baud;
+    decode_cfg.data_bits = bits;
+    decode_cfg.parity = parity;
+    decode_cfg.invert = invert;
+
+    RP_LOG(LOG_INFO, "*ACQ:DECO:UART Successfully set UART decoder.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqDecodeSpi(scpi_t *context) {
+
+    uint32_t mode, bits;
+    scpi_bool_t lsb_first;
+
+    if (!SCPI_ParamUInt32(context, &mode, true)) {
+        RP_LOG(LOG_ERR, "*ACQ:DECO:SPI is missing first parameter.\n");
+        return SCPI_RES_ERR;
+    }
+    // read optional parameters WORD BITS, LSB FIRST (OFF,ON)
+    if (!SCPI_ParamUInt32(context, &bits, false)) {
+        bits = 8;
+    }
+    if (!SCPI_ParamBool(context, &lsb_first, false)) {
+        lsb_first = false;
+    }
+    if (mode > 3 || bits < 1 || bits > 16) {
+        RP_LOG(LOG_ERR, "*ACQ:DECO:SPI Mode or word bits out of range.\n");
+        return SCPI_RES_ERR;
+    }
+
+    decode_cfg.spi_mode = mode;
+    decode_cfg.data_bits = bits;
+    decode_cfg.lsb_first = lsb_first;
+
+    RP_LOG(LOG_INFO, "*ACQ:DECO:SPI Successfully set SPI decoder.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqDecodeDataQ(scpi_t *context) {
+
+    uint32_t pos, size = ADC_BUFFER_SIZE;
+    uint32_t count = ADC_BUFFER_SIZE;
+
+    // optional START POSITION and SIZE, the whole buffer from the oldest sample by default
+    if (SCPI_ParamUInt32(context, &pos, false)) {
+        if (!SCPI_ParamUInt32(context, &size, true)) {
+            RP_LOG(LOG_ERR, "*ACQ:DECO:DATA? is missing second parameter.\n");
+            return SCPI_RES_ERR;
+        }
+    }
+    else {
+        int result = rp_AcqGetWritePointer(&pos);
+        if(result != RP_OK){
+            RP_LOG(LOG_ERR, "*ACQ:DECO:DATA? Failed to get write pointer: %s\n", rp_GetError(result));
+            return SCPI_RES_ERR;
+        }
+        pos = (pos + 1) % ADC_BUFFER_SIZE;
+    }
+
+    int result = rp_AcqDecode(&decode_cfg, pos, size, decode_events, &count, &decode_rate);
+    if(result != RP_OK){
+        RP_LOG(LOG_ERR, "*ACQ:DECO:DATA? Failed to decode: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    /* time,data,flags for every event, time in samples from pos */
+    for(uint32_t i = 0; i < count; i++){
+        SCPI_ResultUInt32Base(context, decode_events[i].time, 10);
+        SCPI_ResultUInt32Base(context, decode_events[i].data, 10);
+        SCPI_ResultUInt32Base(context, decode_events[i].flags, 10);
+    }
+
+    RP_LOG(LOG_INFO, "*ACQ:DECO:DATA? Successfully returned decoded events.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqDecodeRateQ(scpi_t *context) {
+
+    SCPI_ResultFloat(context, decode_rate);
+
+    RP_LOG(LOG_INFO, "*ACQ:DECO:RATE? Successfully returned decoded rate.\n");
+    return SCPI_RES_OK;
+}
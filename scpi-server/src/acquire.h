@@ -57,6 +57,25 @@ scpi_result_t RP_AcqDataOldestAllQ(scpi_t * context);
 scpi_result_t RP_AcqOldestDataQ(scpi_t *context);
 scpi_result_t RP_AcqLatestDataQ(scpi_t *context);
 scpi_result_t RP_AcqBufferSizeQ(scpi_t * context);
+scpi_result_t RP_AcqMaskData(scpi_t * context);
+scpi_result_t RP_AcqMaskGolden(scpi_t * context);
+scpi_result_t RP_AcqMaskClear(scpi_t * context);
+scpi_result_t RP_AcqMaskViolationsQ(scpi_t * context);
+scpi_result_t RP_AcqMaskFailDataQ(scpi_t * context);
+scpi_result_t RP_AcqMaskTestQ(scpi_t * context);
+scpi_result_t RP_AcqMaskStart(scpi_t * context);
+scpi_result_t RP_AcqMaskStop(scpi_t * context);
+scpi_result_t RP_AcqMaskStatsQ(scpi_t * context);
+scpi_result_t RP_AcqMaskStatsReset(scpi_t * context);
+scpi_result_t RP_AcqAutoScaleQ(scpi_t * context);
+scpi_result_t RP_AcqDecodeProtocol(scpi_t * context);
+scpi_result_t RP_AcqDecodeProtocolQ(scpi_t * context);
+scpi_result_t RP_AcqDecodeSource(scpi_t * context);
+scpi_result_t RP_AcqDecodeLevel(scpi_t * context);
+scpi_result_t RP_AcqDecodeUart(scpi_t * context);
+scpi_result_t RP_AcqDecodeSpi(scpi_t * context);
+scpi_result_t RP_AcqDecodeDataQ(scpi_t * context);
+scpi_result_t RP_AcqDecodeRateQ(scpi_t * context);
 
 scpi_result_t RP_AcqGetLatestData(rp_channel_t channel, scpi_t * context);
 
@@ -146,3 +146,34 @@ scpi_result_t RP_EnableDigLoop(scpi_t *context){
 
     return SCPI_RES_OK;
 }
+
+scpi_result_t RP_SystemStatsQ(scpi_t *context){
+
+    static char stats[8192];
+    int result = rp_StatsJson(stats, sizeof(stats));
+
+    if(result != RP_OK){
+        RP_LOG(LOG_ERR, "*SYST:STAT? Failed to get library "
+            "statistics: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    SCPI_ResultMnemonic(context, stats);
+
+    RP_LOG(LOG_INFO, "*SYST:STAT? Successfully returned library statistics.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_SystemStatsReset(scpi_t *context){
+
+    int result = rp_StatsReset();
+
+    if(result != RP_OK){
+        RP_LOG(LOG_ERR, "*SYST:STAT:RES Failed to reset library "
+            "statistics: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    RP_LOG(LOG_INFO, "*SYST:STAT:RES Successfully reset library statistics.\n");
+    return SCPI_RES_OK;
+}
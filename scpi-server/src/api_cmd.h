@@ -22,5 +22,7 @@ scpi_result_t RP_ResetAll(scpi_t *context);
 scpi_result_t RP_ReleaseAll(scpi_t *context);
 scpi_result_t RP_FpgaBitStream(scpi_t *context);
 scpi_result_t RP_EnableDigLoop(scpi_t *context);
+scpi_result_t RP_SystemStatsQ(scpi_t *context);
+scpi_result_t RP_SystemStatsReset(scpi_t *context);
 
 #endif /* API_CMD_H_ */
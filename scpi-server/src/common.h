@@ -15,10 +15,9 @@
 #ifndef COMMON_H_
 #define COMMON_H_
 
-#include <syslog.h>
-
 #include "scpi/parser.h"
 #include "redpitaya/rp.h"
+#include "redpitaya/log.h"
 
 #define SET_OK(cont) \
     	SCPI_ResultString(cont, "OK"); \
@@ -28,12 +27,9 @@
 
 #define SCPI_CMD_NUM 	1
 
-#ifdef SCPI_DEBUG
+/* Asynchronous, filtered at LOG_NOTICE unless SCPI_DEBUG or RP_LOG_LEVEL is set */
 #define RP_LOG(...) \
-syslog(__VA_ARGS__);
-#else
-#define RP_LOG(...)
-#endif
+rp_log(__VA_ARGS__)
 
 int RP_ParseChArgv(scpi_t *context, rp_channel_t *channel);
 
@@ -145,6 +145,8 @@ static const scpi_command_t scpi_commands[] = {
     {.pattern = "RP:RELease", .callback                 = RP_ReleaseAll,},
     {.pattern = "RP:FPGABITREAM", .callback             = RP_FpgaBitStream,},
     {.pattern = "RP:DIg[:loop]", .callback              = RP_EnableDigLoop,},
+    {.pattern = "SYSTem:STATistics?", .callback         = RP_SystemStatsQ,},
+    {.pattern = "SYSTem:STATistics:RESet", .callback    = RP_SystemStatsReset,},
 
     {.pattern = "DIG:RST", .callback                    = RP_DigitalPinReset,},
     {.pattern = "DIG:PIN", .callback                    = RP_DigitalPinState,},
@@ -188,6 +190,25 @@ static const scpi_command_t scpi_commands[] = {
     {.pattern = "ACQ:SOUR#:DATA?", .callback            = RP_AcqDataOldestAllQ,},
     {.pattern = "ACQ:SOUR#:DATA:LAT:N?", .callback      = RP_AcqLatestDataQ,},
     {.pattern = "ACQ:BUF:SIZE?", .callback              = RP_AcqBufferSizeQ,},
+    {.pattern = "ACQ:SOUR#:MASK:DATA", .callback        = RP_AcqMaskData,},
+    {.pattern = "ACQ:SOUR#:MASK:GOLD", .callback        = RP_AcqMaskGolden,},
+    {.pattern = "ACQ:SOUR#:MASK:CLR", .callback         = RP_AcqMaskClear,},
+    {.pattern = "ACQ:SOUR#:MASK:VIOL?", .callback       = RP_AcqMaskViolationsQ,},
+    {.pattern = "ACQ:SOUR#:MASK:FAIL?", .callback       = RP_AcqMaskFailDataQ,},
+    {.pattern = "ACQ:MASK:TEST?", .callback             = RP_AcqMaskTestQ,},
+    {.pattern = "ACQ:MASK:START", .callback             = RP_AcqMaskStart,},
+    {.pattern = "ACQ:MASK:STOP", .callback              = RP_AcqMaskStop,},
+    {.pattern = "ACQ:MASK:STAT?", .callback             = RP_AcqMaskStatsQ,},
+    {.pattern = "ACQ:MASK:STAT:RES", .callback          = RP_AcqMaskStatsReset,},
+    {.pattern = "ACQ:AUTO?", .callback                  = RP_AcqAutoScaleQ,},
+    {.pattern = "ACQ:DECO:PROT", .callback              = RP_AcqDecodeProtocol,},
+    {.pattern = "ACQ:DECO:PROT?", .callback             = RP_AcqDecodeProtocolQ,},
+    {.pattern = "ACQ:DECO:SOUR", .callback              = RP_AcqDecodeSource,},
+    {.pattern = "ACQ:SOUR#:DECO:LEV", .callback         = RP_AcqDecodeLevel,},
+    {.pattern = "ACQ:DECO:UART", .callback              = RP_AcqDecodeUart,},
+    {.pattern = "ACQ:DECO:SPI", .callback               = RP_AcqDecodeSpi,},
+    {.pattern = "ACQ:DECO:DATA?", .callback             = RP_AcqDecodeDataQ,},
+    {.pattern = "ACQ:DECO:RATE?", .callback             = RP_AcqDecodeRateQ,},
 
     /* Generate */
     {.pattern = "GEN:RST", .callback                    = RP_GenReset,},
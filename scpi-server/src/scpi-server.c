@@ -204,6 +204,9 @@ int main(int argc, char *argv[])
     // Open logging into "/var/log/messages" or /var/log/syslog" or other configured...
     setlogmask (LOG_UPTO (LOG_INFO));
     openlog ("scpi-server", LOG_CONS | LOG_PID | LOG_NDELAY, LOG_LOCAL1);
+#ifdef SCPI_DEBUG
+    rp_LogSetLevel(LOG_DEBUG);
+#endif
 
     RP_LOG (LOG_NOTICE, "scpi-server started");
 
@@ -291,6 +294,10 @@ int main(int argc, char *argv[])
             // this is the child process
             close(listenfd); // child doesn't need the listener
 
+            // The register shadow is the parent's, from rp_Init(), other
+            // connections and applications may have changed the FPGA since
+            rp_SyncFromHardware();
+
             scpi_context.user_context = &connfd;
 
             result = handleConnection(connfd);
@@ -320,6 +327,7 @@ int main(int argc, char *argv[])
 
     RP_LOG(LOG_INFO, "scpi-server stopped.");
 
+    rp_LogClose();
     closelog ();
 
     return (EXIT_SUCCESS);
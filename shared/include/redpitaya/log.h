@@ -0,0 +1,104 @@
+/**
+ * $Id$
+ *
+ * @brief Red Pitaya asynchronous logging library.
+ *
+ * Messages are formatted by the calling thread into its own lock-free ring
+ * buffer and written to syslog or a log file by a background flusher thread,
+ * so logging never blocks on I/O. Messages below the compile time level
+ * (RP_LOG_COMPILE_LEVEL) are removed by the compiler, messages below the
+ * runtime level are rejected before their arguments are formatted. Every
+ * call site is rate limited to RP_LOG_RATE_BURST messages per second.
+ *
+ * Levels are the syslog levels (LOG_ERR, LOG_INFO, ...). The initial runtime
+ * level can be set with the RP_LOG_LEVEL environment variable.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef REDPITAYA_LOG_H
+#define REDPITAYA_LOG_H
+
+#include <stdarg.h>
+#include <syslog.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Messages above this level are not compiled in */
+#ifndef RP_LOG_COMPILE_LEVEL
+#define RP_LOG_COMPILE_LEVEL    LOG_DEBUG
+#endif
+
+#define RP_LOG_DEFAULT_LEVEL    LOG_NOTICE
+
+/* Maximal message length, longer messages are truncated */
+#define RP_LOG_MSG_SIZE         200
+
+/* Number of messages buffered per thread */
+#define RP_LOG_RING_SIZE        256
+
+/* Messages per call site and second before further ones are suppressed */
+#define RP_LOG_RATE_BURST       20
+
+/* Sink 0 is syslog, further sinks are files opened with rp_LogOpen */
+#define RP_LOG_SYSLOG           0
+#define RP_LOG_MAX_SINKS        4
+
+/* Rate limiting state of one call site */
+typedef struct {
+    long window;
+    unsigned count;
+    unsigned suppressed;
+} rp_log_site_t;
+
+extern volatile int rp_log_level;
+
+#define rp_log_to(sink, level, ...) \
+    do { \
+        if ((level) <= RP_LOG_COMPILE_LEVEL && (level) <= rp_log_level) { \
+            static rp_log_site_t rp_log_site_; \
+            rp_LogWrite(&rp_log_site_, (sink), (level), __VA_ARGS__); \
+        } \
+    } while (0)
+
+#define rp_log(level, ...)  rp_log_to(RP_LOG_SYSLOG, level, __VA_ARGS__)
+
+/**
+ * Opens a log file sink.
+ * @param flags Additional open() flags, O_APPEND or O_TRUNC.
+ * @return Sink number for rp_log_to, -1 on failure.
+ */
+int rp_LogOpen(const char *path, int flags);
+
+/**
+ * Writes out all buffered messages, stops the flusher thread and closes the
+ * file sinks.
+ */
+void rp_LogClose(void);
+
+void rp_LogSetLevel(int level);
+int rp_LogGetLevel(void);
+
+/**
+ * Number of messages dropped because a thread's ring buffer was full.
+ */
+unsigned long rp_LogDropped(void);
+
+/* Use the rp_log macros instead, they do the level filtering */
+void rp_LogWrite(rp_log_site_t *site, int sink, int level, const char *format, ...)
+        __attribute__((format(printf, 4, 5)));
+void rp_LogWriteV(rp_log_site_t *site, int sink, int level, const char *format, va_list args);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* REDPITAYA_LOG_H */
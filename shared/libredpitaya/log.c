@@ -0,0 +1,422 @@
+/**
+ * $Id$
+ *
+ * @brief Red Pitaya asynchronous logging library.
+ *
+ * Every logging thread owns a single producer, single consumer ring of
+ * records. The producer only advances the ring head and the flusher only the
+ * tail, so no locks are taken on the logging path. Rings are kept in a
+ * lock-free list and reused after their thread exits.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <errno.h>
+
+#include "redpitaya/log.h"
+
+/* Flusher period [us], the flusher is woken earlier when a ring fills up */
+#define FLUSH_PERIOD_US     20000
+
+#define FILE_BUFF_SIZE      8192
+
+typedef struct {
+    struct timespec ts;
+    unsigned char level;
+    unsigned char sink;
+    unsigned short len;
+    char text[RP_LOG_MSG_SIZE];
+} log_record_t;
+
+typedef struct log_ring_s {
+    struct log_ring_s *next;
+    unsigned head;          //!< Written by the owning thread only
+    unsigned tail;          //!< Written by the flusher only
+    int owned;              //!< Cleared when the owning thread exits
+    log_record_t rec[RP_LOG_RING_SIZE];
+} log_ring_t;
+
+typedef struct {
+    int fd;
+    size_t len;
+    char buff[FILE_BUFF_SIZE];
+} log_sink_t;
+
+volatile int rp_log_level = RP_LOG_DEFAULT_LEVEL;
+
+static log_ring_t *rings = NULL;
+static __thread log_ring_t *thread_ring = NULL;
+static unsigned long dropped = 0;
+
+static log_sink_t sinks[RP_LOG_MAX_SINKS];
+
+static pthread_once_t init_once = PTHREAD_ONCE_INIT;
+static pthread_key_t ring_key;
+static pthread_mutex_t drain_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t sink_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_t flusher;
+static sem_t flusher_wake;
+static int flusher_state = 0;   // 0 stopped, 1 starting or running
+static volatile int flusher_exit = 0;
+
+static const char *level_names[] = {
+    "EMERG", "ALERT", "CRIT", "ERR", "WARNING", "NOTICE", "INFO", "DEBUG"
+};
+
+/*----------------------------------------------------------------------------*/
+
+static void releaseRing(void *ring)
+{
+    __atomic_store_n(&((log_ring_t *)ring)->owned, 0, __ATOMIC_RELEASE);
+}
+
+/**
+ * Reuses the ring of an exited thread or allocates and registers a new one.
+ */
+static log_ring_t *acquireRing()
+{
+    log_ring_t *ring;
+
+    for (ring = __atomic_load_n(&rings, __ATOMIC_ACQUIRE); ring != NULL; ring = ring->next) {
+        int free_ring = 0;
+        if (__atomic_compare_exchange_n(&ring->owned, &free_ring, 1, false,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            break;
+        }
+    }
+
+    if (ring == NULL) {
+        ring = calloc(1, sizeof(log_ring_t));
+        if (ring == NULL) {
+            return NULL;
+        }
+        ring->owned = 1;
+        ring->next = __atomic_load_n(&rings, __ATOMIC_RELAXED);
+        while (!__atomic_compare_exchange_n(&rings, &ring->next, ring, true,
+                                            __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+        }
+    }
+
+    pthread_setspecific(ring_key, ring);
+    return ring;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static void flushSink(log_sink_t *sink)
+{
+    size_t pos = 0;
+    while (pos < sink->len) {
+        ssize_t n = write(sink->fd, sink->buff + pos, sink->len - pos);
+        if (n <= 0) {
+            break;
+        }
+        pos += n;
+    }
+    sink->len = 0;
+}
+
+static void output(log_record_t *rec)
+{
+    if (rec->sink == RP_LOG_SYSLOG) {
+        syslog(rec->level, "%.*s", rec->len, rec->text);
+        return;
+    }
+
+    log_sink_t *sink = &sinks[rec->sink];
+    if (sink->fd < 0) {
+        return;
+    }
+    if (sink->len + RP_LOG_MSG_SIZE + 64 > FILE_BUFF_SIZE) {
+        flushSink(sink);
+    }
+
+    struct tm tm;
+    localtime_r(&rec->ts.tv_sec, &tm);
+    sink->len += strftime(sink->buff + sink->len, 32, "%Y-%m-%d %H:%M:%S", &tm);
+    sink->len += sprintf(sink->buff + sink->len, ".%03ld %s %.*s\n",
+                         rec->ts.tv_nsec / 1000000, level_names[rec->level & 7],
+                         rec->len, rec->text);
+}
+
+/**
+ * Writes out everything buffered in all rings.
+ */
+static void drain()
+{
+    pthread_mutex_lock(&drain_mutex);
+    pthread_mutex_lock(&sink_mutex);
+
+    for (log_ring_t *ring = __atomic_load_n(&rings, __ATOMIC_ACQUIRE); ring != NULL; ring = ring->next) {
+        unsigned head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        unsigned tail = ring->tail;
+
+        while (tail != head) {
+            output(&ring->rec[tail % RP_LOG_RING_SIZE]);
+            tail++;
+        }
+        __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+    }
+
+    for (int i = 1; i < RP_LOG_MAX_SINKS; i++) {
+        if (sinks[i].fd >= 0 && sinks[i].len > 0) {
+            flushSink(&sinks[i]);
+        }
+    }
+
+    pthread_mutex_unlock(&sink_mutex);
+    pthread_mutex_unlock(&drain_mutex);
+}
+
+static void *flusherThread(void *arg)
+{
+    while (!flusher_exit) {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_nsec += FLUSH_PERIOD_US * 1000;
+        if (ts.tv_nsec >= 1000000000) {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000;
+        }
+        while (sem_timedwait(&flusher_wake, &ts) < 0 && errno == EINTR) {
+        }
+        drain();
+    }
+    drain();
+    return NULL;
+}
+
+static void startFlusher()
+{
+    int stopped = 0;
+    if (!__atomic_compare_exchange_n(&flusher_state, &stopped, 1, false,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+        return;
+    }
+    flusher_exit = 0;
+    sem_init(&flusher_wake, 0, 0);
+    if (pthread_create(&flusher, NULL, flusherThread, NULL) != 0) {
+        __atomic_store_n(&flusher_state, 0, __ATOMIC_RELEASE);
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+static void prepareFork()
+{
+    pthread_mutex_lock(&drain_mutex);
+}
+
+static void parentFork()
+{
+    pthread_mutex_unlock(&drain_mutex);
+}
+
+/**
+ * Threads do not survive fork(). Records buffered so far are written by the
+ * parent, so the child forgets them and starts its own flusher on demand.
+ */
+static void childFork()
+{
+    for (log_ring_t *ring = rings; ring != NULL; ring = ring->next) {
+        ring->tail = ring->head;
+        if (ring != thread_ring) {
+            ring->owned = 0;
+        }
+    }
+    flusher_state = 0;
+    pthread_mutex_unlock(&drain_mutex);
+}
+
+static void init()
+{
+    const char *env = getenv("RP_LOG_LEVEL");
+    if (env != NULL) {
+        rp_LogSetLevel(atoi(env));
+    }
+
+    for (int i = 0; i < RP_LOG_MAX_SINKS; i++) {
+        sinks[i].fd = -1;
+    }
+
+    pthread_key_create(&ring_key, releaseRing);
+    pthread_atfork(prepareFork, parentFork, childFork);
+}
+
+/**
+ * @return false when the call site exceeded its rate, otherwise true and the
+ *         number of messages suppressed since the last accepted one.
+ */
+static bool rateAllowed(rp_log_site_t *site, unsigned *suppressed)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+
+    *suppressed = 0;
+    if (__atomic_load_n(&site->window, __ATOMIC_RELAXED) != ts.tv_sec) {
+        __atomic_store_n(&site->window, ts.tv_sec, __ATOMIC_RELAXED);
+        __atomic_store_n(&site->count, 0, __ATOMIC_RELAXED);
+        *suppressed = __atomic_exchange_n(&site->suppressed, 0, __ATOMIC_RELAXED);
+    }
+
+    if (__atomic_fetch_add(&site->count, 1, __ATOMIC_RELAXED) >= RP_LOG_RATE_BURST) {
+        __atomic_fetch_add(&site->suppressed, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+
+/**
+ * Writes out what is left at exit, or when the library is part of an
+ * application module that is being unloaded.
+ */
+static void __attribute__((destructor)) fini()
+{
+    if (rings != NULL) {
+        rp_LogClose();
+        pthread_key_delete(ring_key);
+    }
+}
+
+int rp_LogOpen(const char *path, int flags)
+{
+    pthread_once(&init_once, init);
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_CLOEXEC | flags, 0644);
+    if (fd < 0) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&sink_mutex);
+    for (int i = 1; i < RP_LOG_MAX_SINKS; i++) {
+        if (sinks[i].fd < 0) {
+            sinks[i].fd = fd;
+            sinks[i].len = 0;
+            pthread_mutex_unlock(&sink_mutex);
+            return i;
+        }
+    }
+    pthread_mutex_unlock(&sink_mutex);
+
+    close(fd);
+    return -1;
+}
+
+void rp_LogClose()
+{
+    pthread_once(&init_once, init);
+
+    if (__atomic_load_n(&flusher_state, __ATOMIC_ACQUIRE)) {
+        flusher_exit = 1;
+        sem_post(&flusher_wake);
+        pthread_join(flusher, NULL);
+        __atomic_store_n(&flusher_state, 0, __ATOMIC_RELEASE);
+    }
+    drain();
+
+    pthread_mutex_lock(&sink_mutex);
+    for (int i = 1; i < RP_LOG_MAX_SINKS; i++) {
+        if (sinks[i].fd >= 0) {
+            close(sinks[i].fd);
+            sinks[i].fd = -1;
+        }
+    }
+    pthread_mutex_unlock(&sink_mutex);
+}
+
+void rp_LogSetLevel(int level)
+{
+    rp_log_level = level < LOG_EMERG ? LOG_EMERG : level > LOG_DEBUG ? LOG_DEBUG : level;
+}
+
+int rp_LogGetLevel()
+{
+    return rp_log_level;
+}
+
+unsigned long rp_LogDropped()
+{
+    return __atomic_load_n(&dropped, __ATOMIC_RELAXED);
+}
+
+void rp_LogWriteV(rp_log_site_t *site, int sink, int level, const char *format, va_list args)
+{
+    unsigned suppressed = 0;
+
+    if (site != NULL && !rateAllowed(site, &suppressed)) {
+        return;
+    }
+
+    pthread_once(&init_once, init);
+    if (!__atomic_load_n(&flusher_state, __ATOMIC_ACQUIRE)) {
+        startFlusher();
+    }
+
+    log_ring_t *ring = thread_ring;
+    if (ring == NULL) {
+        ring = thread_ring = acquireRing();
+        if (ring == NULL) {
+            vsyslog(level, format, args);
+            return;
+        }
+    }
+
+    unsigned head = ring->head;
+    unsigned used = head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    if (used >= RP_LOG_RING_SIZE) {
+        __atomic_fetch_add(&dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    // Do not wait for the flusher period when a burst fills the ring
+    if (used == RP_LOG_RING_SIZE / 2) {
+        sem_post(&flusher_wake);
+    }
+
+    log_record_t *rec = &ring->rec[head % RP_LOG_RING_SIZE];
+    int len = 0;
+
+    clock_gettime(CLOCK_REALTIME, &rec->ts);
+    rec->level = level;
+    rec->sink = sink >= 0 && sink < RP_LOG_MAX_SINKS ? sink : RP_LOG_SYSLOG;
+
+    if (site != NULL && suppressed > 0) {
+        len = snprintf(rec->text, sizeof(rec->text), "(%u messages suppressed) ", suppressed);
+    }
+    len += vsnprintf(rec->text + len, sizeof(rec->text) - len, format, args);
+    if (len >= (int)sizeof(rec->text)) {
+        len = sizeof(rec->text) - 1;
+    }
+    // Messages are written line by line, drop the trailing newline
+    while (len > 0 && rec->text[len - 1] == '\n') {
+        len--;
+    }
+    rec->len = len;
+
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+void rp_LogWrite(rp_log_site_t *site, int sink, int level, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    rp_LogWriteV(site, sink, level, format, args);
+    va_end(args);
+}
@@ -0,0 +1,208 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya streaming client library implementation
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include "rp_stream_client.h"
+
+static int connectTcp(const char *host, uint16_t port)
+{
+    struct addrinfo hints, *res, *ai;
+    char service[8];
+    int fd = -1;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    snprintf(service, sizeof(service), "%u", port);
+
+    if (getaddrinfo(host, service, &hints, &res) != 0) {
+        errno = EHOSTUNREACH;
+        return -1;
+    }
+
+    for (ai = res; ai != NULL; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+            break;
+        }
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(res);
+
+    if (fd >= 0) {
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    return fd;
+}
+
+static int readFull(int fd, void *buffer, size_t len)
+{
+    char *p = buffer;
+    while (len > 0) {
+        ssize_t n = recv(fd, p, len, 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return -1;
+        }
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
+
+static void countLost(rp_stream_client_t *client, uint32_t sequence)
+{
+    // The first block sets the reference, subscribers may join mid-stream
+    if (client->blocks++ > 0 && sequence != client->next_seq) {
+        client->lost += (uint32_t)(sequence - client->next_seq);
+    }
+    client->next_seq = sequence + 1;
+}
+
+int rp_stream_Connect(rp_stream_client_t *client, const char *host)
+{
+    memset(client, 0, sizeof(*client));
+    client->data_fd = -1;
+    client->ctrl_fd = connectTcp(host, RP_STREAM_CTRL_PORT);
+    return client->ctrl_fd < 0 ? -1 : 0;
+}
+
+int rp_stream_SubscribeTcp(rp_stream_client_t *client, const char *host)
+{
+    client->udp = 0;
+    client->data_fd = connectTcp(host, RP_STREAM_DATA_PORT);
+    return client->data_fd < 0 ? -1 : 0;
+}
+
+int rp_stream_SubscribeUdp(rp_stream_client_t *client, const char *local_host, uint16_t port)
+{
+    struct sockaddr_in addr;
+    char command[128];
+    int rcvbuf = 4 * 1024 * 1024;
+
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+
+    client->udp = 1;
+    client->data_fd = fd;
+
+    snprintf(command, sizeof(command), "UDP %s %u", local_host, port);
+    return rp_stream_Command(client, command, NULL, 0);
+}
+
+int rp_stream_Command(rp_stream_client_t *client, const char *command, char *reply, size_t reply_len)
+{
+    char line[256];
+    size_t len = 0;
+
+    struct iovec iov[2] = {
+        { .iov_base = (void *)command, .iov_len = strlen(command) },
+        { .iov_base = "\r\n",          .iov_len = 2 },
+    };
+    if (writev(client->ctrl_fd, iov, 2) < 0) {
+        return -1;
+    }
+
+    // Answers are a single short line; read byte by byte up to the newline
+    while (len < sizeof(line) - 1) {
+        if (recv(client->ctrl_fd, &line[len], 1, 0) != 1) {
+            return -1;
+        }
+        if (line[len] == '\n') {
+            break;
+        }
+        len++;
+    }
+    if (len > 0 && line[len - 1] == '\r') {
+        len--;
+    }
+    line[len] = '\0';
+
+    if (reply != NULL && reply_len > 0) {
+        snprintf(reply, reply_len, "%s", line);
+    }
+    return strncmp(line, "ERR", 3) == 0 ? -1 : 0;
+}
+
+int rp_stream_Receive(rp_stream_client_t *client, rp_stream_header_t *header, void *buffer, size_t buffer_len)
+{
+    if (client->udp) {
+        struct iovec iov[2] = {
+            { .iov_base = header, .iov_len = sizeof(*header) },
+            { .iov_base = buffer, .iov_len = buffer_len },
+        };
+        struct msghdr msg = { .msg_iov = iov, .msg_iovlen = 2 };
+
+        ssize_t n = recvmsg(client->data_fd, &msg, 0);
+        if (n < (ssize_t)sizeof(*header) || header->magic != RP_STREAM_MAGIC
+                || n != (ssize_t)(sizeof(*header) + header->payload_len)) {
+            return -1;
+        }
+        countLost(client, header->sequence);
+        return header->payload_len;
+    }
+
+    if (readFull(client->data_fd, header, sizeof(*header)) < 0 || header->magic != RP_STREAM_MAGIC) {
+        return -1;
+    }
+    if (header->payload_len > buffer_len) {
+        errno = ENOBUFS;
+        return -1;
+    }
+    if (readFull(client->data_fd, buffer, header->payload_len) < 0) {
+        return -1;
+    }
+    countLost(client, header->sequence);
+    return header->payload_len;
+}
+
+void rp_stream_Close(rp_stream_client_t *client)
+{
+    if (client->data_fd >= 0) {
+        close(client->data_fd);
+        client->data_fd = -1;
+    }
+    if (client->ctrl_fd >= 0) {
+        close(client->ctrl_fd);
+        client->ctrl_fd = -1;
+    }
+}
@@ -0,0 +1,63 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya streaming client library interface
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef RP_STREAM_CLIENT_H_
+#define RP_STREAM_CLIENT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rp_stream.h"
+
+typedef struct {
+    int ctrl_fd;        //!< Control connection
+    int data_fd;        //!< TCP subscription or bound UDP socket
+    int udp;            //!< Non zero when data_fd is a UDP socket
+    uint32_t next_seq;  //!< Expected sequence number
+    uint64_t blocks;    //!< Blocks received so far
+    uint64_t lost;      //!< Blocks missing from the sequence so far
+} rp_stream_client_t;
+
+/**
+ * Connects the control socket to the streaming server.
+ * @return 0 on success, -1 on failure (errno is set).
+ */
+int rp_stream_Connect(rp_stream_client_t *client, const char *host);
+
+/**
+ * Subscribes to the TCP data port.
+ */
+int rp_stream_SubscribeTcp(rp_stream_client_t *client, const char *host);
+
+/**
+ * Binds a local UDP port and asks the server to send datagrams to it.
+ * local_host is the address the server should send to.
+ */
+int rp_stream_SubscribeUdp(rp_stream_client_t *client, const char *local_host, uint16_t port);
+
+/**
+ * Sends one control command and waits for its one line answer.
+ * @return 0 when the server answered anything but "ERR ...", -1 otherwise.
+ */
+int rp_stream_Command(rp_stream_client_t *client, const char *command, char *reply, size_t reply_len);
+
+/**
+ * Receives one block. The payload is written directly into buffer.
+ * @return Payload size in bytes, -1 on error or when buffer is too small.
+ */
+int rp_stream_Receive(rp_stream_client_t *client, rp_stream_header_t *header, void *buffer, size_t buffer_len);
+
+void rp_stream_Close(rp_stream_client_t *client);
+
+#endif /* RP_STREAM_CLIENT_H_ */
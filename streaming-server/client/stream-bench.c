@@ -0,0 +1,156 @@
+/**
+ * $Id: $
+ *
+ * @brief Streaming server throughput/latency benchmark.
+ *
+ * Configures the streaming server, receives blocks for a given time and
+ * reports throughput, block rate, lost blocks and latency. Latency is the
+ * difference between the receive time and the block timestamp, both taken
+ * from CLOCK_MONOTONIC, so it is only meaningful when the benchmark runs on
+ * the board itself (loopback, 127.0.0.1).
+ *
+ * Usage: stream-bench [-u udp_port] [-t seconds] [-b block] [-d decimation]
+ *                     [-c channels] [-f INT16|FLOAT32] [host]
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "rp_stream_client.h"
+
+static uint64_t monotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int command(rp_stream_client_t *client, const char *name, const char *value)
+{
+    char cmd[128], reply[128];
+    if (value) {
+        snprintf(cmd, sizeof(cmd), "%s %s", name, value);
+    } else {
+        snprintf(cmd, sizeof(cmd), "%s", name);
+    }
+    if (rp_stream_Command(client, cmd, reply, sizeof(reply)) != 0) {
+        fprintf(stderr, "%s: %s\n", cmd, reply);
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *host = "127.0.0.1";
+    const char *block = "4096";
+    const char *decimation = "64";
+    const char *channels = "3";
+    const char *format = "INT16";
+    int udp_port = 0;
+    double seconds = 5;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "u:t:b:d:c:f:")) != -1) {
+        switch (opt) {
+        case 'u': udp_port = atoi(optarg); break;
+        case 't': seconds = atof(optarg); break;
+        case 'b': block = optarg; break;
+        case 'd': decimation = optarg; break;
+        case 'c': channels = optarg; break;
+        case 'f': format = optarg; break;
+        default:
+            fprintf(stderr, "Usage: %s [-u udp_port] [-t seconds] [-b block] [-d decimation] "
+                            "[-c channels] [-f INT16|FLOAT32] [host]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (optind < argc) {
+        host = argv[optind];
+    }
+
+    rp_stream_client_t client;
+    if (rp_stream_Connect(&client, host) != 0) {
+        perror("Failed to connect to streaming server");
+        return 1;
+    }
+
+    if (command(&client, "STOP", NULL) != 0
+            || command(&client, "UDP", "OFF") != 0
+            || command(&client, "MODE", "CONTINUOUS") != 0
+            || command(&client, "BLOCK", block) != 0
+            || command(&client, "DECIMATION", decimation) != 0
+            || command(&client, "CHANNELS", channels) != 0
+            || command(&client, "FORMAT", format) != 0) {
+        return 1;
+    }
+
+    int result = udp_port
+            ? rp_stream_SubscribeUdp(&client, "127.0.0.1", udp_port)
+            : rp_stream_SubscribeTcp(&client, host);
+    if (result != 0) {
+        perror("Failed to subscribe");
+        return 1;
+    }
+
+    if (command(&client, "START", NULL) != 0) {
+        return 1;
+    }
+
+    size_t buffer_len = 2 * RP_STREAM_MAX_SAMPLES * sizeof(float);
+    void *buffer = malloc(buffer_len);
+    rp_stream_header_t header;
+
+    uint64_t bytes = 0, blocks = 0, overruns = 0;
+    uint64_t lat_sum = 0, lat_min = UINT64_MAX, lat_max = 0;
+    uint64_t start = monotonicNs();
+    uint64_t end = start + (uint64_t)(seconds * 1e9);
+    uint64_t now = start;
+
+    while (now < end) {
+        int len = rp_stream_Receive(&client, &header, buffer, buffer_len);
+        now = monotonicNs();
+        if (len < 0) {
+            perror("Receive failed");
+            break;
+        }
+
+        uint64_t latency = now - header.timestamp_ns;
+        lat_sum += latency;
+        lat_min = latency < lat_min ? latency : lat_min;
+        lat_max = latency > lat_max ? latency : lat_max;
+
+        bytes += sizeof(header) + len;
+        blocks++;
+        if (header.flags & RP_STREAM_FLAG_OVERRUN) {
+            overruns++;
+        }
+    }
+
+    command(&client, "STOP", NULL);
+
+    double elapsed = (now - start) / 1e9;
+    printf("blocks:     %llu (%.1f blocks/s)\n", (unsigned long long)blocks, blocks / elapsed);
+    printf("throughput: %.3f MB/s\n", bytes / elapsed / 1e6);
+    printf("lost:       %llu blocks, %llu overruns\n",
+           (unsigned long long)client.lost, (unsigned long long)overruns);
+    if (blocks > 0) {
+        printf("latency:    min %.1f us, avg %.1f us, max %.1f us\n",
+               lat_min / 1e3, lat_sum / 1e3 / blocks, lat_max / 1e3);
+    }
+
+    free(buffer);
+    rp_stream_Close(&client);
+    return 0;
+}
@@ -0,0 +1,80 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya streaming server wire protocol
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef RP_STREAM_H_
+#define RP_STREAM_H_
+
+#include <stdint.h>
+
+/** TCP port of the text control socket */
+#define RP_STREAM_CTRL_PORT     5001
+/** TCP port subscribers connect to (UDP data is sent to a client chosen port) */
+#define RP_STREAM_DATA_PORT     5002
+
+/** "RPSD" */
+#define RP_STREAM_MAGIC         0x44535052
+#define RP_STREAM_VERSION       1
+
+/** Largest block (samples per channel), half of the ADC ring buffer */
+#define RP_STREAM_MAX_SAMPLES       (8*1024)
+
+/** Largest UDP payload we produce; larger blocks are clamped in UDP mode */
+#define RP_STREAM_UDP_MAX_PAYLOAD   60000
+
+/** Channel mask bits */
+#define RP_STREAM_CH1           0x01
+#define RP_STREAM_CH2           0x02
+
+/** Header flags */
+#define RP_STREAM_FLAG_TRIGGERED    0x0001  //!< Block starts at a trigger event
+#define RP_STREAM_FLAG_OVERRUN      0x0002  //!< Samples were lost before this block
+
+typedef enum {
+    RP_STREAM_FMT_INT16   = 0,  //!< Calibrated ADC counts
+    RP_STREAM_FMT_FLOAT32 = 1,  //!< Volts
+} rp_stream_format_t;
+
+/**
+ * Block header, sent in front of every data block.
+ *
+ * All fields are little endian (native on both the board and x86 hosts).
+ * The payload follows the header and is channel planar: all samples of the
+ * lowest enabled channel first, then the next one.
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t magic;         //!< RP_STREAM_MAGIC
+    uint16_t version;       //!< RP_STREAM_VERSION
+    uint16_t header_len;    //!< sizeof(rp_stream_header_t), lets old clients skip new fields
+    uint32_t sequence;      //!< Block counter, gaps mean lost UDP datagrams
+    uint8_t  channel_mask;  //!< RP_STREAM_CH1 | RP_STREAM_CH2
+    uint8_t  format;        //!< rp_stream_format_t
+    uint16_t flags;         //!< RP_STREAM_FLAG_*
+    uint32_t decimation;    //!< Decimation factor the block was acquired with
+    uint32_t samples;       //!< Samples per channel
+    uint32_t payload_len;   //!< Payload size in bytes
+    uint32_t reserved;
+    uint64_t timestamp_ns;  //!< CLOCK_MONOTONIC of the first sample (trigger for triggered blocks)
+} rp_stream_header_t;
+
+static inline int rp_stream_SampleSize(uint8_t format)
+{
+    return format == RP_STREAM_FMT_FLOAT32 ? sizeof(float) : sizeof(int16_t);
+}
+
+static inline int rp_stream_ChannelCount(uint8_t mask)
+{
+    return ((mask & RP_STREAM_CH1) ? 1 : 0) + ((mask & RP_STREAM_CH2) ? 1 : 0);
+}
+
+#endif /* RP_STREAM_H_ */
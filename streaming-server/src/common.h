@@ -0,0 +1,36 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya streaming server utils
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef COMMON_H_
+#define COMMON_H_
+
+#include "redpitaya/rp.h"
+#include "redpitaya/log.h"
+
+#define MIN(X, Y) (((X) < (Y)) ? (X) : (Y))
+#define MAX(X, Y) (((X) > (Y)) ? (X) : (Y))
+
+/* Asynchronous, filtered at LOG_NOTICE unless STREAM_DEBUG or RP_LOG_LEVEL is set */
+#define RP_LOG(...) \
+rp_log(__VA_ARGS__)
+
+#define ECHECK(x) { \
+        int retval = (x); \
+        if (retval != RP_OK) { \
+            RP_LOG(LOG_ERR, "%s returned \"%s\"", #x, rp_GetError(retval)); \
+            return retval; \
+        } \
+}
+
+#endif /* COMMON_H_ */
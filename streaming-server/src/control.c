@@ -0,0 +1,251 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya streaming server control commands implementation
+ *
+ * Control socket commands (one per line, case insensitive):
+ *
+ *   CHANNELS <1|2|3>               channel mask, 3 = both
+ *   DECIMATION <1|8|64|1024|8192|65536>
+ *   BLOCK <samples>                samples per channel and block
+ *   FORMAT <INT16|FLOAT32>
+ *   MODE <CONTINUOUS|TRIGGERED>
+ *   TRIGGER <CH1_PE|CH1_NE|CH2_PE|CH2_NE|EXT_PE|EXT_NE>
+ *   LEVEL <volts>                  trigger level
+ *   PRETRIGGER <samples>
+ *   UDP <host> <port> | UDP OFF    datagram target in addition to TCP subscribers
+ *   START | STOP
+ *   STATUS?
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+
+#include "common.h"
+#include "stream.h"
+#include "sink.h"
+#include "control.h"
+
+static stream_config_t config;
+
+typedef struct {
+    const char *name;
+    int value;
+} choice_t;
+
+static const choice_t decimations[] = {
+    {"1", RP_DEC_1}, {"8", RP_DEC_8}, {"64", RP_DEC_64}, {"1024", RP_DEC_1024},
+    {"8192", RP_DEC_8192}, {"65536", RP_DEC_65536}, {NULL, 0}
+};
+
+static const choice_t formats[] = {
+    {"INT16", RP_STREAM_FMT_INT16}, {"FLOAT32", RP_STREAM_FMT_FLOAT32}, {NULL, 0}
+};
+
+static const choice_t modes[] = {
+    {"CONTINUOUS", STREAM_MODE_CONTINUOUS}, {"TRIGGERED", STREAM_MODE_TRIGGERED}, {NULL, 0}
+};
+
+/* Same mnemonics as the SCPI ACQ:TRIG command */
+static const choice_t triggers[] = {
+    {"CH1_PE", RP_TRIG_SRC_CHA_PE}, {"CH1_NE", RP_TRIG_SRC_CHA_NE},
+    {"CH2_PE", RP_TRIG_SRC_CHB_PE}, {"CH2_NE", RP_TRIG_SRC_CHB_NE},
+    {"EXT_PE", RP_TRIG_SRC_EXT_PE}, {"EXT_NE", RP_TRIG_SRC_EXT_NE}, {NULL, 0}
+};
+
+static bool parseChoice(const choice_t *choices, const char *arg, int *value)
+{
+    if (arg == NULL) {
+        return false;
+    }
+    for (; choices->name != NULL; choices++) {
+        if (strcasecmp(choices->name, arg) == 0) {
+            *value = choices->value;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool parseFloat(const char *arg, float *value)
+{
+    char *end;
+    if (arg == NULL) {
+        return false;
+    }
+    float v = strtof(arg, &end);
+    if (end == arg || *end != '\0' || !isfinite(v)) {
+        return false;
+    }
+    *value = v;
+    return true;
+}
+
+static bool parseUInt(const char *arg, uint32_t *value)
+{
+    char *end;
+    if (arg == NULL) {
+        return false;
+    }
+    unsigned long v = strtoul(arg, &end, 0);
+    if (*end != '\0') {
+        return false;
+    }
+    *value = v;
+    return true;
+}
+
+/**
+ * Largest block that still fits into one datagram for the current format
+ * and channel mask.
+ */
+static uint32_t maxUdpBlock()
+{
+    return RP_STREAM_UDP_MAX_PAYLOAD
+            / (rp_stream_SampleSize(config.format) * rp_stream_ChannelCount(config.channel_mask));
+}
+
+static const char *startStreaming()
+{
+    if (stream_IsRunning()) {
+        return "already running";
+    }
+
+    stream_config_t cfg = config;
+    if (sink_IsUdp()) {
+        cfg.block_size = MIN(cfg.block_size, maxUdpBlock());
+    }
+
+    int result = stream_Start(&cfg, sink_Publish, NULL);
+    if (result != RP_OK) {
+        return rp_GetError(result);
+    }
+    return NULL;
+}
+
+void control_Init()
+{
+    stream_SetDefaultConfig(&config);
+}
+
+void control_Execute(char *line, char *reply, size_t reply_len)
+{
+    char *save;
+    char *cmd = strtok_r(line, " \t", &save);
+    char *arg = strtok_r(NULL, " \t", &save);
+    const char *error = NULL;
+    int choice;
+    uint32_t value;
+
+    if (cmd == NULL) {
+        snprintf(reply, reply_len, "ERR empty command");
+        return;
+    }
+
+    if (strcasecmp(cmd, "STATUS?") == 0) {
+        stream_stats_t stats;
+        stream_GetStats(&stats);
+        snprintf(reply, reply_len,
+                 "RUNNING=%d BLOCKS=%llu BYTES=%llu OVERRUNS=%llu SUBSCRIBERS=%d UDP=%d",
+                 stream_IsRunning(), (unsigned long long)stats.blocks,
+                 (unsigned long long)stats.bytes, (unsigned long long)stats.overruns,
+                 sink_SubscriberCount(), sink_IsUdp());
+        return;
+    }
+
+    if (strcasecmp(cmd, "START") == 0) {
+        error = startStreaming();
+    }
+    else if (strcasecmp(cmd, "STOP") == 0) {
+        stream_Stop();
+    }
+    else if (stream_IsRunning()) {
+        // Configuration is latched at START
+        error = "stop streaming first";
+    }
+    else if (strcasecmp(cmd, "CHANNELS") == 0) {
+        if (parseUInt(arg, &value) && value >= 1 && value <= 3) {
+            config.channel_mask = value;
+        } else {
+            error = "invalid channel mask";
+        }
+    }
+    else if (strcasecmp(cmd, "DECIMATION") == 0) {
+        if (parseChoice(decimations, arg, &choice)) {
+            config.decimation = choice;
+        } else {
+            error = "invalid decimation";
+        }
+    }
+    else if (strcasecmp(cmd, "BLOCK") == 0) {
+        if (parseUInt(arg, &value) && value > 0 && value <= RP_STREAM_MAX_SAMPLES) {
+            config.block_size = value;
+        } else {
+            error = "invalid block size";
+        }
+    }
+    else if (strcasecmp(cmd, "FORMAT") == 0) {
+        if (parseChoice(formats, arg, &choice)) {
+            config.format = choice;
+        } else {
+            error = "invalid format";
+        }
+    }
+    else if (strcasecmp(cmd, "MODE") == 0) {
+        if (parseChoice(modes, arg, &choice)) {
+            config.mode = choice;
+        } else {
+            error = "invalid mode";
+        }
+    }
+    else if (strcasecmp(cmd, "TRIGGER") == 0) {
+        if (parseChoice(triggers, arg, &choice)) {
+            config.trig_src = choice;
+        } else {
+            error = "invalid trigger source";
+        }
+    }
+    else if (strcasecmp(cmd, "LEVEL") == 0) {
+        if (!parseFloat(arg, &config.trig_level)) {
+            error = "invalid level";
+        }
+    }
+    else if (strcasecmp(cmd, "PRETRIGGER") == 0) {
+        if (parseUInt(arg, &value)) {
+            config.pre_trigger = value;
+        } else {
+            error = "invalid pre-trigger";
+        }
+    }
+    else if (strcasecmp(cmd, "UDP") == 0) {
+        char *port = strtok_r(NULL, " \t", &save);
+        if (arg != NULL && strcasecmp(arg, "OFF") == 0) {
+            sink_ClearUdpTarget();
+        } else if (arg == NULL || !parseUInt(port, &value) || value == 0 || value > 0xffff) {
+            error = "usage: UDP <host> <port> | UDP OFF";
+        } else if (sink_SetUdpTarget(arg, value) != 0) {
+            error = "cannot resolve host";
+        }
+    }
+    else {
+        error = "unknown command";
+    }
+
+    if (error) {
+        RP_LOG(LOG_ERR, "Control command %s failed: %s", cmd, error);
+        snprintf(reply, reply_len, "ERR %s", error);
+    } else {
+        snprintf(reply, reply_len, "OK");
+    }
+}
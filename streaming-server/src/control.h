@@ -0,0 +1,28 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya streaming server control commands interface
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef CONTROL_H_
+#define CONTROL_H_
+
+#include <stddef.h>
+
+void control_Init();
+
+/**
+ * Executes one control line (without the line delimiter) and writes a
+ * one line answer, "OK", "ERR <reason>" or the query result, into reply.
+ */
+void control_Execute(char *line, char *reply, size_t reply_len);
+
+#endif /* CONTROL_H_ */
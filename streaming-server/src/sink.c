@@ -0,0 +1,191 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya streaming server subscriber module implementation
+ *
+ * Blocks are pushed to every connected TCP subscriber and, when configured,
+ * to one UDP target. Header and payload go out in one sendmsg() call so the
+ * payload is never copied in user space. Sends never block the acquisition:
+ * a subscriber whose socket buffer cannot take a whole block has fallen
+ * behind and is dropped.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include "common.h"
+#include "sink.h"
+
+static pthread_mutex_t sink_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static int subscribers[SINK_MAX_SUBSCRIBERS];
+static int subscriber_count = 0;
+
+static int udp_fd = -1;
+static struct sockaddr_storage udp_addr;
+static socklen_t udp_addr_len = 0;
+
+static int sendBlock(int fd, const rp_stream_header_t *header, const void *payload,
+                     const struct sockaddr *addr, socklen_t addr_len)
+{
+    struct iovec iov[2] = {
+        { .iov_base = (void *)header,  .iov_len = sizeof(rp_stream_header_t) },
+        { .iov_base = (void *)payload, .iov_len = header->payload_len },
+    };
+    struct msghdr msg = {
+        .msg_name = (void *)addr,
+        .msg_namelen = addr_len,
+        .msg_iov = iov,
+        .msg_iovlen = 2,
+    };
+
+    size_t left = iov[0].iov_len + iov[1].iov_len;
+    while (left > 0) {
+        ssize_t sent = sendmsg(fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        left -= sent;
+
+        // Partial TCP write; advance the iovec past what was sent
+        while (sent > 0 && msg.msg_iovlen > 0) {
+            if ((size_t)sent >= msg.msg_iov->iov_len) {
+                sent -= msg.msg_iov->iov_len;
+                msg.msg_iov++;
+                msg.msg_iovlen--;
+            } else {
+                msg.msg_iov->iov_base = (char *)msg.msg_iov->iov_base + sent;
+                msg.msg_iov->iov_len -= sent;
+                sent = 0;
+            }
+        }
+    }
+    return 0;
+}
+
+int sink_AddSubscriber(int fd)
+{
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    pthread_mutex_lock(&sink_mutex);
+    if (subscriber_count == SINK_MAX_SUBSCRIBERS) {
+        pthread_mutex_unlock(&sink_mutex);
+        return -1;
+    }
+    subscribers[subscriber_count++] = fd;
+    pthread_mutex_unlock(&sink_mutex);
+    return 0;
+}
+
+int sink_SubscriberCount()
+{
+    pthread_mutex_lock(&sink_mutex);
+    int count = subscriber_count;
+    pthread_mutex_unlock(&sink_mutex);
+    return count;
+}
+
+void sink_CloseAll()
+{
+    pthread_mutex_lock(&sink_mutex);
+    for (int i = 0; i < subscriber_count; i++) {
+        close(subscribers[i]);
+    }
+    subscriber_count = 0;
+    pthread_mutex_unlock(&sink_mutex);
+    sink_ClearUdpTarget();
+}
+
+int sink_SetUdpTarget(const char *host, uint16_t port)
+{
+    struct addrinfo hints, *res;
+    char service[8];
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    snprintf(service, sizeof(service), "%u", port);
+
+    if (getaddrinfo(host, service, &hints, &res) != 0) {
+        return -1;
+    }
+
+    int fd = socket(res->ai_family, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        freeaddrinfo(res);
+        return -1;
+    }
+
+    pthread_mutex_lock(&sink_mutex);
+    if (udp_fd >= 0) {
+        close(udp_fd);
+    }
+    udp_fd = fd;
+    memcpy(&udp_addr, res->ai_addr, res->ai_addrlen);
+    udp_addr_len = res->ai_addrlen;
+    pthread_mutex_unlock(&sink_mutex);
+
+    freeaddrinfo(res);
+    return 0;
+}
+
+void sink_ClearUdpTarget()
+{
+    pthread_mutex_lock(&sink_mutex);
+    if (udp_fd >= 0) {
+        close(udp_fd);
+    }
+    udp_fd = -1;
+    pthread_mutex_unlock(&sink_mutex);
+}
+
+bool sink_IsUdp()
+{
+    pthread_mutex_lock(&sink_mutex);
+    bool udp = udp_fd >= 0;
+    pthread_mutex_unlock(&sink_mutex);
+    return udp;
+}
+
+void sink_Publish(const rp_stream_header_t *header, const void *payload, void *user)
+{
+    pthread_mutex_lock(&sink_mutex);
+
+    if (udp_fd >= 0) {
+        // Datagrams may be lost, clients detect it from the sequence number
+        sendBlock(udp_fd, header, payload, (struct sockaddr *)&udp_addr, udp_addr_len);
+    }
+
+    for (int i = 0; i < subscriber_count; ) {
+        if (sendBlock(subscribers[i], header, payload, NULL, 0) < 0) {
+            RP_LOG(LOG_INFO, "Dropping subscriber (%s)",
+                   errno == EAGAIN || errno == EWOULDBLOCK ? "fell behind" : strerror(errno));
+            close(subscribers[i]);
+            subscribers[i] = subscribers[--subscriber_count];
+            continue;
+        }
+        i++;
+    }
+
+    pthread_mutex_unlock(&sink_mutex);
+}
@@ -0,0 +1,35 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya streaming server subscriber module interface
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef SINK_H_
+#define SINK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "rp_stream.h"
+
+#define SINK_MAX_SUBSCRIBERS    8
+
+int sink_AddSubscriber(int fd);
+int sink_SubscriberCount();
+void sink_CloseAll();
+
+int sink_SetUdpTarget(const char *host, uint16_t port);
+void sink_ClearUdpTarget();
+bool sink_IsUdp();
+
+void sink_Publish(const rp_stream_header_t *header, const void *payload, void *user);
+
+#endif /* SINK_H_ */
@@ -0,0 +1,306 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya streaming server acquisition module implementation
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "common.h"
+#include "stream.h"
+
+/* @brief Sampling period (non-decimated) - 8 [ns]. */
+#define ADC_SAMPLE_PERIOD_NS    8
+
+/* @brief Shortest sleep between write pointer polls [us]. */
+#define MIN_POLL_US             50
+
+/* @brief Longest wait for a capture between checks for a stop [us]. */
+#define CAPTURE_WAIT_US         10000
+
+static pthread_t stream_thread;
+static bool stream_joinable = false;
+static volatile bool stream_running = false;
+static volatile bool stream_exit = false;
+
+static stream_config_t cfg;
+static stream_sink_t cfg_sink;
+static void *cfg_user;
+
+static pthread_mutex_t stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+static stream_stats_t stats;
+
+/* Payload buffer, large enough for two float channels of a full ADC buffer */
+static uint8_t payload[2 * ADC_BUFFER_SIZE * sizeof(float)];
+
+static uint64_t monotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * Sleeps for roughly the time the FPGA needs to write the given number of samples.
+ */
+static void waitSamples(uint32_t samples, uint32_t decimation)
+{
+    uint64_t us = (uint64_t)samples * decimation * ADC_SAMPLE_PERIOD_NS / 1000;
+    usleep(MAX(us, MIN_POLL_US));
+}
+
+static uint32_t bufferDistance(uint32_t from, uint32_t to)
+{
+    return (to + ADC_BUFFER_SIZE - from) % ADC_BUFFER_SIZE;
+}
+
+/**
+ * Copies one block starting at buffer position pos for every enabled channel
+ * into the payload buffer.
+ * @return Payload size in bytes, negative on error.
+ */
+static int readBlock(uint32_t pos, uint32_t samples)
+{
+    uint8_t *dst = payload;
+    size_t chunk = (size_t)samples * rp_stream_SampleSize(cfg.format);
+
+    for (rp_channel_t ch = RP_CH_1; ch <= RP_CH_2; ch++) {
+        if (!(cfg.channel_mask & (1 << ch))) {
+            continue;
+        }
+
+        uint32_t size = samples;
+        int result = cfg.format == RP_STREAM_FMT_FLOAT32
+                ? rp_AcqGetDataV(ch, pos, &size, (float *)dst)
+                : rp_AcqGetDataRaw(ch, pos, &size, (int16_t *)dst);
+
+        if (result != RP_OK) {
+            RP_LOG(LOG_ERR, "Failed to read channel %d: %s", ch + 1, rp_GetError(result));
+            return -1;
+        }
+        dst += chunk;
+    }
+    return dst - payload;
+}
+
+static void publishBlock(rp_stream_header_t *header, uint32_t pos, uint32_t samples)
+{
+    int len = readBlock(pos, samples);
+    if (len < 0) {
+        return;
+    }
+
+    header->samples = samples;
+    header->payload_len = len;
+    cfg_sink(header, payload, cfg_user);
+    header->sequence++;
+
+    pthread_mutex_lock(&stats_mutex);
+    stats.blocks++;
+    stats.bytes += sizeof(rp_stream_header_t) + len;
+    if (header->flags & RP_STREAM_FLAG_OVERRUN) {
+        stats.overruns++;
+    }
+    pthread_mutex_unlock(&stats_mutex);
+}
+
+/**
+ * Continuous mode: the ADC keeps writing (arm keep) and we follow the write
+ * pointer, cutting the ring buffer into consecutive blocks.
+ */
+static int runContinuous(rp_stream_header_t *header, uint32_t decimation)
+{
+    uint32_t block = cfg.block_size;
+    uint32_t rd, wr;
+
+    ECHECK(rp_AcqSetArmKeep(true));
+    ECHECK(rp_AcqStart());
+    ECHECK(rp_AcqSetTriggerSrc(RP_TRIG_SRC_NOW));
+    ECHECK(rp_AcqGetWritePointer(&rd));
+
+    while (!stream_exit) {
+        ECHECK(rp_AcqGetWritePointer(&wr));
+        uint32_t available = bufferDistance(rd, wr);
+
+        if (available < block) {
+            waitSamples(block - available, decimation);
+            continue;
+        }
+
+        header->flags = 0;
+        if (available > ADC_BUFFER_SIZE - block) {
+            // Writer is about to lap us; skip ahead to the freshest full block
+            header->flags |= RP_STREAM_FLAG_OVERRUN;
+            rd = (wr + ADC_BUFFER_SIZE - block) % ADC_BUFFER_SIZE;
+            available = block;
+        }
+
+        // Time of the first sample, derived from the poll time and the backlog
+        header->timestamp_ns = monotonicNs() - (uint64_t)available * decimation * ADC_SAMPLE_PERIOD_NS;
+
+        publishBlock(header, rd, block);
+        rd = (rd + block) % ADC_BUFFER_SIZE;
+    }
+    return RP_OK;
+}
+
+/**
+ * Triggered mode: one block per trigger, with pre_trigger samples in front of
+ * the trigger position.
+ */
+static int runTriggered(rp_stream_header_t *header, uint32_t decimation)
+{
+    uint32_t pre = MIN(cfg.pre_trigger, cfg.block_size);
+    uint32_t post = cfg.block_size - pre;
+    uint32_t trig_pos;
+    int ret;
+
+    ECHECK(rp_AcqSetArmKeep(false));
+    ECHECK(rp_AcqSetTriggerLevel(cfg.trig_level));
+    ECHECK(rp_AcqSetTriggerDelay((int32_t)post - ADC_BUFFER_SIZE / 2));
+
+    while (!stream_exit) {
+        ECHECK(rp_AcqStart());
+
+        // Fill the pre-trigger part before arming the trigger
+        waitSamples(pre, decimation);
+        ECHECK(rp_AcqSetTriggerSrc(cfg.trig_src));
+
+        // The trigger may take any time
+        do {
+            ret = rp_AcqWaitCaptureDone(CAPTURE_WAIT_US);
+        } while (ret == RP_ETMO && !stream_exit);
+
+        if (stream_exit) {
+            break;
+        }
+        ECHECK(ret);
+
+        uint64_t trig_ns = monotonicNs() - (uint64_t)post * decimation * ADC_SAMPLE_PERIOD_NS;
+        ECHECK(rp_AcqGetWritePointerAtTrig(&trig_pos));
+
+        header->flags = RP_STREAM_FLAG_TRIGGERED;
+        header->timestamp_ns = trig_ns - (uint64_t)pre * decimation * ADC_SAMPLE_PERIOD_NS;
+        publishBlock(header, (trig_pos + ADC_BUFFER_SIZE - pre) % ADC_BUFFER_SIZE, cfg.block_size);
+    }
+    return RP_OK;
+}
+
+static void *streamThread(void *arg)
+{
+    uint32_t decimation;
+    rp_stream_header_t header;
+
+    memset(&header, 0, sizeof(header));
+    header.magic = RP_STREAM_MAGIC;
+    header.version = RP_STREAM_VERSION;
+    header.header_len = sizeof(rp_stream_header_t);
+    header.channel_mask = cfg.channel_mask;
+    header.format = cfg.format;
+
+    if (rp_AcqReset() != RP_OK
+            || rp_AcqSetDecimation(cfg.decimation) != RP_OK
+            || rp_AcqGetDecimationFactor(&decimation) != RP_OK) {
+        RP_LOG(LOG_ERR, "Failed to configure acquisition.");
+        stream_running = false;
+        return NULL;
+    }
+    header.decimation = decimation;
+
+    int result = cfg.mode == STREAM_MODE_CONTINUOUS
+            ? runContinuous(&header, decimation)
+            : runTriggered(&header, decimation);
+
+    // Also after an error, so that the acquisition is not left running
+    rp_AcqSetArmKeep(false);
+    int stop = rp_AcqStop();
+    result = result != RP_OK ? result : stop;
+
+    if (result != RP_OK) {
+        RP_LOG(LOG_ERR, "Streaming stopped: %s", rp_GetError(result));
+    }
+
+    stream_running = false;
+    return NULL;
+}
+
+void stream_SetDefaultConfig(stream_config_t *config)
+{
+    config->channel_mask = RP_STREAM_CH1 | RP_STREAM_CH2;
+    config->format = RP_STREAM_FMT_INT16;
+    config->mode = STREAM_MODE_CONTINUOUS;
+    config->decimation = RP_DEC_1024;
+    config->block_size = 4096;
+    config->trig_src = RP_TRIG_SRC_CHA_PE;
+    config->trig_level = 0.0;
+    config->pre_trigger = 0;
+}
+
+int stream_Start(const stream_config_t *config, stream_sink_t sink, void *user)
+{
+    if (stream_running) {
+        return RP_EIPV;
+    }
+    if (config->block_size == 0 || config->block_size > RP_STREAM_MAX_SAMPLES) {
+        return RP_EOOR;
+    }
+    if (!(config->channel_mask & (RP_STREAM_CH1 | RP_STREAM_CH2))) {
+        return RP_EOOR;
+    }
+
+    cfg = *config;
+    cfg_sink = sink;
+    cfg_user = user;
+
+    pthread_mutex_lock(&stats_mutex);
+    memset(&stats, 0, sizeof(stats));
+    pthread_mutex_unlock(&stats_mutex);
+
+    if (stream_joinable) {
+        pthread_join(stream_thread, NULL);
+        stream_joinable = false;
+    }
+
+    stream_exit = false;
+    stream_running = true;
+    if (pthread_create(&stream_thread, NULL, streamThread, NULL) != 0) {
+        stream_running = false;
+        return RP_EUF;
+    }
+    stream_joinable = true;
+    return RP_OK;
+}
+
+int stream_Stop()
+{
+    stream_exit = true;
+    if (stream_joinable) {
+        pthread_join(stream_thread, NULL);
+        stream_joinable = false;
+    }
+    return RP_OK;
+}
+
+bool stream_IsRunning()
+{
+    return stream_running;
+}
+
+void stream_GetStats(stream_stats_t *out)
+{
+    pthread_mutex_lock(&stats_mutex);
+    *out = stats;
+    pthread_mutex_unlock(&stats_mutex);
+}
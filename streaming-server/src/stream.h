@@ -0,0 +1,58 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya streaming server acquisition module interface
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef STREAM_H_
+#define STREAM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "redpitaya/rp.h"
+#include "rp_stream.h"
+
+typedef enum {
+    STREAM_MODE_CONTINUOUS,    //!< Gap-free blocks fed from the write pointer
+    STREAM_MODE_TRIGGERED,     //!< One block per trigger event
+} stream_mode_t;
+
+typedef struct {
+    uint8_t channel_mask;
+    rp_stream_format_t format;
+    stream_mode_t mode;
+    rp_acq_decimation_t decimation;
+    uint32_t block_size;        //!< Samples per channel and block
+    rp_acq_trig_src_t trig_src; //!< Triggered mode only
+    float trig_level;           //!< Triggered mode only [V]
+    uint32_t pre_trigger;       //!< Samples before the trigger in a triggered block
+} stream_config_t;
+
+typedef struct {
+    uint64_t blocks;
+    uint64_t bytes;
+    uint64_t overruns;
+} stream_stats_t;
+
+/**
+ * Block consumer. Called from the acquisition thread for every block,
+ * header and payload are only valid during the call.
+ */
+typedef void (*stream_sink_t)(const rp_stream_header_t *header, const void *payload, void *user);
+
+void stream_SetDefaultConfig(stream_config_t *config);
+int stream_Start(const stream_config_t *config, stream_sink_t sink, void *user);
+int stream_Stop();
+bool stream_IsRunning();
+void stream_GetStats(stream_stats_t *stats);
+
+#endif /* STREAM_H_ */
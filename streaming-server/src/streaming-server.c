@@ -0,0 +1,259 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya streaming server implementation
+ *
+ * Unlike the SCPI server, which answers one text request at a time, this
+ * daemon pushes binary acquisition blocks (see rp_stream.h) to every
+ * subscriber connected to the data port, or to a UDP target, as soon as
+ * they are available. Streaming is configured and started through a small
+ * line based control socket.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <poll.h>
+#include <syslog.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#include "common.h"
+#include "stream.h"
+#include "sink.h"
+#include "control.h"
+
+#define LISTEN_BACKLOG      8
+#define MAX_CTRL_CLIENTS    4
+#define CTRL_BUFF_SIZE      256
+
+typedef struct {
+    int fd;
+    size_t len;
+    char buff[CTRL_BUFF_SIZE];
+} ctrl_client_t;
+
+static volatile bool app_exit = false;
+static ctrl_client_t ctrl_clients[MAX_CTRL_CLIENTS];
+
+
+static void termSignalHandler(int signum)
+{
+    app_exit = true;
+}
+
+
+static void installTermSignalHandler()
+{
+    struct sigaction action;
+    memset(&action, 0, sizeof(struct sigaction));
+    action.sa_handler = termSignalHandler;
+    sigaction(SIGTERM, &action, NULL);
+    sigaction(SIGINT, &action, NULL);
+    signal(SIGPIPE, SIG_IGN);
+}
+
+
+static int openListener(uint16_t port)
+{
+    struct sockaddr_in serv_addr;
+    int one = 1;
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd == -1) {
+        RP_LOG(LOG_ERR, "Failed to create a socket (%s)", strerror(errno));
+        return -1;
+    }
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    memset(&serv_addr, 0, sizeof(serv_addr));
+    serv_addr.sin_family = AF_INET;
+    serv_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    serv_addr.sin_port = htons(port);
+
+    if (bind(fd, (struct sockaddr*)&serv_addr, sizeof(serv_addr)) == -1
+            || listen(fd, LISTEN_BACKLOG) == -1) {
+        RP_LOG(LOG_ERR, "Failed to listen on port %d (%s)", port, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+
+static void acceptControl(int listenfd)
+{
+    int fd = accept(listenfd, NULL, NULL);
+    if (fd < 0) {
+        return;
+    }
+    for (int i = 0; i < MAX_CTRL_CLIENTS; i++) {
+        if (ctrl_clients[i].fd < 0) {
+            ctrl_clients[i].fd = fd;
+            ctrl_clients[i].len = 0;
+            return;
+        }
+    }
+    RP_LOG(LOG_ERR, "Too many control connections");
+    close(fd);
+}
+
+
+static void acceptSubscriber(int listenfd)
+{
+    struct sockaddr_in cliaddr;
+    socklen_t clilen = sizeof(cliaddr);
+
+    int fd = accept(listenfd, (struct sockaddr *)&cliaddr, &clilen);
+    if (fd < 0) {
+        return;
+    }
+    if (sink_AddSubscriber(fd) != 0) {
+        RP_LOG(LOG_ERR, "Too many subscribers, rejecting %s", inet_ntoa(cliaddr.sin_addr));
+        close(fd);
+        return;
+    }
+    RP_LOG(LOG_INFO, "Subscriber %s connected", inet_ntoa(cliaddr.sin_addr));
+}
+
+
+/**
+ * Reads from a control connection and executes every complete line.
+ * @return false when the connection was closed.
+ */
+static bool handleControl(ctrl_client_t *client)
+{
+    ssize_t n = recv(client->fd, client->buff + client->len, CTRL_BUFF_SIZE - 1 - client->len, 0);
+    if (n <= 0) {
+        return false;
+    }
+    client->len += n;
+    client->buff[client->len] = '\0';
+
+    char *line = client->buff;
+    char *eol;
+    while ((eol = strchr(line, '\n')) != NULL) {
+        char reply[CTRL_BUFF_SIZE];
+
+        *eol = '\0';
+        if (eol > line && eol[-1] == '\r') {
+            eol[-1] = '\0';
+        }
+
+        control_Execute(line, reply, sizeof(reply) - 2);
+        strcat(reply, "\r\n");
+        if (send(client->fd, reply, strlen(reply), MSG_NOSIGNAL) < 0) {
+            return false;
+        }
+        line = eol + 1;
+    }
+
+    client->len -= line - client->buff;
+    memmove(client->buff, line, client->len);
+
+    // A line that does not fit into the buffer is a protocol error
+    return client->len < CTRL_BUFF_SIZE - 1;
+}
+
+
+int main(int argc, char *argv[])
+{
+    setlogmask (LOG_UPTO (LOG_INFO));
+    openlog ("streaming-server", LOG_CONS | LOG_PID | LOG_NDELAY, LOG_LOCAL1);
+#ifdef STREAM_DEBUG
+    rp_LogSetLevel(LOG_DEBUG);
+#endif
+
+    RP_LOG (LOG_NOTICE, "streaming-server started");
+
+    installTermSignalHandler();
+
+    int result = rp_Init();
+    if (result != RP_OK) {
+        RP_LOG(LOG_ERR, "Failed to initialize RP APP library: %s", rp_GetError(result));
+        return (EXIT_FAILURE);
+    }
+
+    control_Init();
+
+    int ctrlfd = openListener(RP_STREAM_CTRL_PORT);
+    int datafd = openListener(RP_STREAM_DATA_PORT);
+    if (ctrlfd < 0 || datafd < 0) {
+        perror("Failed to open listening sockets");
+        return (EXIT_FAILURE);
+    }
+
+    for (int i = 0; i < MAX_CTRL_CLIENTS; i++) {
+        ctrl_clients[i].fd = -1;
+    }
+
+    RP_LOG(LOG_INFO, "Control on port %d, data on port %d", RP_STREAM_CTRL_PORT, RP_STREAM_DATA_PORT);
+
+    while (!app_exit) {
+        struct pollfd fds[2 + MAX_CTRL_CLIENTS];
+        int nfds = 0;
+
+        fds[nfds++] = (struct pollfd){ .fd = ctrlfd, .events = POLLIN };
+        fds[nfds++] = (struct pollfd){ .fd = datafd, .events = POLLIN };
+        for (int i = 0; i < MAX_CTRL_CLIENTS; i++) {
+            fds[nfds++] = (struct pollfd){ .fd = ctrl_clients[i].fd, .events = POLLIN };
+        }
+
+        if (poll(fds, nfds, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            RP_LOG(LOG_ERR, "poll failed (%s)", strerror(errno));
+            break;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            acceptControl(ctrlfd);
+        }
+        if (fds[1].revents & POLLIN) {
+            acceptSubscriber(datafd);
+        }
+        for (int i = 0; i < MAX_CTRL_CLIENTS; i++) {
+            if (fds[2 + i].revents && !handleControl(&ctrl_clients[i])) {
+                close(ctrl_clients[i].fd);
+                ctrl_clients[i].fd = -1;
+            }
+        }
+    }
+
+    stream_Stop();
+    sink_CloseAll();
+
+    for (int i = 0; i < MAX_CTRL_CLIENTS; i++) {
+        if (ctrl_clients[i].fd >= 0) {
+            close(ctrl_clients[i].fd);
+        }
+    }
+    close(ctrlfd);
+    close(datafd);
+
+    result = rp_Release();
+    if (result != RP_OK) {
+        RP_LOG(LOG_ERR, "Failed to release RP App library: %s", rp_GetError(result));
+    }
+
+    RP_LOG(LOG_INFO, "streaming-server stopped.");
+
+    rp_LogClose();
+    closelog ();
+
+    return (EXIT_SUCCESS);
+}